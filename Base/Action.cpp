@@ -19,6 +19,7 @@
 
 #include "Base/Action.h"
 #include "Base/Sprite.h"
+#include "Utils/Counters.h"
 
 #include "Lua/LuaUtils.h"
 #include "Lua/Base/LuaShape.h"
@@ -91,6 +92,7 @@ bool LuaAction::execute(Shape* me, real t, real dt)
 
   lua_pushnumber(L, t);
   lua_pushnumber(L, dt);  
+  COUNT(LUA_CALLBACKS);
   lua_call(L, 3, 1);     
   bool ret = lua_toboolean(L,-1);
   lua_pop(L,1);
@@ -147,6 +149,7 @@ bool LuaCollisionAction::execute(Shape* me, Shape* other, Points2& points, real
   lua_pushnumber(L, t);
   lua_pushnumber(L, dt);  
   
+  COUNT(LUA_CALLBACKS);
   lua_call(L, 5, 1);     
   bool ret = lua_toboolean(L,-1);
   lua_pop(L,1);
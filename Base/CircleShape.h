@@ -28,6 +28,8 @@ public:
   // Accessors
   std::string typeName() const;
   Rect2 boundingBox() const;  
+  int   noConvexParts() const;
+  ConvexShape2 convexPart(int i) const;
   const Point2& center() const;
   real          radius() const;
     
@@ -0,0 +1,106 @@
+/*
+ *  ContactBuffer.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 19.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+#include "Base/ContactBuffer.h"
+#include "Base/Shape.h"
+
+#include <cassert>
+
+using namespace std;
+
+/*!
+    \class ContactBuffer ContactBuffer.h
+    \brief Collects collisions so they can be handled in one batch.
+
+    A ContactBuffer can be given anywhere a CollisionAction is accepted,
+    either to collide() or as the collision action of a sprite. Instead of
+    handling each collision as it is found, the shapes involved, their
+    intersection points and the time of collision are appended to the buffer.
+
+    This lets a script handle all collisions of a frame, for a group or a
+    class of shapes, with one call instead of one call per contact. Shapes are
+    retained until the buffer is cleared.
+*/
+
+// Constructors
+ContactBuffer::ContactBuffer()
+{
+}
+
+ContactBuffer::~ContactBuffer()
+{
+  clear();
+}
+
+// Accessors
+const Contacts& ContactBuffer::contacts() const
+{
+  return iContacts;
+}
+
+const Contact& ContactBuffer::contact(uint32 i) const
+{
+  assert(i < iContacts.size());
+  return iContacts[i];
+}
+
+/*! Intersection points of all contacts. See Contact::firstPoint */
+const Points2& ContactBuffer::points() const
+{
+  return iPoints;
+}
+
+// Request
+uint32 ContactBuffer::size() const
+{
+  return iContacts.size();
+}
+
+bool ContactBuffer::empty() const
+{
+  return iContacts.empty();
+}
+
+// Calculations
+/*! Appends intersection points of contact \a i to \a points */
+void ContactBuffer::contactPoints(uint32 i, Points2& points) const
+{
+  const Contact& c = contact(i);
+  Points2::const_iterator first = iPoints.begin()+c.firstPoint;
+  points.insert(points.end(), first, first+c.noPoints);
+}
+
+// Operations
+/*! Records collision between \a me and \a other. Always returns true */
+bool ContactBuffer::execute(Shape* me, Shape* other, Points2& points, real t, real dt)
+{
+  Contact c;
+  c.me = me;
+  c.other = other;
+  c.firstPoint = iPoints.size();
+  c.noPoints = points.size();
+  c.time = t;
+  c.deltaTime = dt;
+  iContacts.push_back(c);
+  iPoints.insert(iPoints.end(), points.begin(), points.end());
+
+  if (me) me->retain();
+  if (other) other->retain();
+  return true;
+}
+
+/*! Removes all contacts, keeping allocated memory for next frame */
+void ContactBuffer::clear()
+{
+  for (Contacts::iterator it = iContacts.begin(); it != iContacts.end(); ++it) {
+    if (it->me) it->me->release();
+    if (it->other) it->other->release();
+  }
+  iContacts.clear();
+  iPoints.clear();
+}
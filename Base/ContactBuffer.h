@@ -0,0 +1,54 @@
+/*
+ *  ContactBuffer.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 19.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+#pragma once
+
+#include "Base/Action.h"
+
+#include <vector>
+
+/*! One collision recorded by ContactBuffer */
+struct Contact
+{
+  Shape*  me;
+  Shape*  other;
+  uint32  firstPoint;   // Index of first intersection point in ContactBuffer::points()
+  uint32  noPoints;
+  real    time;
+  real    deltaTime;
+};
+
+typedef std::vector<Contact> Contacts;
+
+class ContactBuffer : public CollisionAction
+{
+public:
+  // Constructors
+  ContactBuffer();
+  virtual ~ContactBuffer();
+
+  // Accessors
+  const Contacts& contacts() const;
+  const Contact&  contact(uint32 i) const;
+  const Points2&  points() const;
+
+  // Request
+  uint32  size() const;
+  bool    empty() const;
+
+  // Calculations
+  void    contactPoints(uint32 i, Points2& points) const;
+
+  // Operations
+  bool    execute(Shape* me, Shape* other, Points2& points, real start_time, real delta_time);
+  void    clear();
+
+private:
+  Contacts  iContacts;
+  Points2   iPoints;
+};
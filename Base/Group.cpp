@@ -19,8 +19,10 @@
 
 #include "Base/Group.h"
 #include "Timing.h"
+#include "World.h"
 #include "Base/Action.h"
 #include "Base/ShapeIterator.h"
+#include "Utils/Profiler.h"
 
 #include <iostream>
 #include <cassert>
@@ -39,20 +41,23 @@ using namespace std;
     can have Shapes added and removed at any time. The downside of this is that
     the structure can be as efficient in handling collision, because one can't create
     an optimized hierarchical structure.
+    
+    Shapes are updated and collided in the order they were added, not in
+    order of their addresses, so a replay updates them in the same order
+    as the recording.
 */
 
 // Gloal functions
-static Group gRenderGroup;
-
+/*! Render group of current world */
 Group* renderGroup()
 {
-  return &gRenderGroup;
+  return World::current()->renderGroup();
 }
 
 // Constructors
-Group::Group() : iCurShape(0)
+Group::Group() : iNextOrder(0)
 {
-
+  iCurShape = iShapes.end();
 }
 
 Group::~Group()
@@ -75,7 +80,7 @@ int Group::noShapes() const
 
 ShapeIterator* Group::iterator() const
 {
-  ShapeIterator* itr = new SetShapeIterator(iShapes);
+  ShapeIterator* itr = new MapValueIterator<uint32, Shape*>(iShapes);
   itr->autorelease();
   return itr;
 }
@@ -88,7 +93,7 @@ Rect2 Group::boundingBox() const
 // Request
 bool Group::contains(Shape* shape) const
 {
-  return iShapes.find(shape) != iShapes.end();
+  return iOrder.find(shape) != iOrder.end();
 }
 
 bool Group::isSimple() const
@@ -103,11 +108,12 @@ void Group::addKid(Shape* shape)
   
   if (!contains(shape)) {
     shape->retain();
-    iCurShape = iShapes.insert(shape).first;
-    if (iShapes.size() == 0)
+    iOrder[shape] = iNextOrder;
+    iCurShape = iShapes.insert(make_pair(iNextOrder++, shape)).first;
+    if (iShapes.size() == 1)
       iBBox = shape->boundingBox();
     else
-      iBBox.surround(shape->boundingBox());
+      iBBox = iBBox.surround(shape->boundingBox());
     shape->addListener(this); // Be notified of deletes
   }
 }
@@ -117,8 +123,7 @@ void Group::removeKid(Shape* shape)
   assert(shape != 0);
   
   if (contains(shape)) {
-    if (*iCurShape == shape) nextShape();
-    iShapes.erase(shape);
+    erase(shape);
     shape->release();
     shape->removeListener(this);    
   }
@@ -129,16 +134,17 @@ void Group::removeKid(Shape* shape)
 */
 void Group::update(real start_time, real delta_time)
 {
+  PROFILE_ZONE("shape update");
   if (iShapes.size() == 0)
     return;
     
-  set<Shape*>::iterator shape = iShapes.begin();
-  (*shape)->update(start_time, delta_time);
-  Rect2 bbox = (*shape)->boundingBox();
+  Shapes::iterator shape = iShapes.begin();
+  shape->second->update(start_time, delta_time);
+  Rect2 bbox = shape->second->boundingBox();
  
   for (++shape; shape != iShapes.end(); ++shape) {
-    (*shape)->update(start_time, delta_time);
-    bbox.surround((*shape)->boundingBox());
+    shape->second->update(start_time, delta_time);
+    bbox.surround(shape->second->boundingBox());
   }
   iBBox = bbox;
 }
@@ -148,6 +154,7 @@ void Group::update(real start_time, real delta_time)
 */
 void Group::doPlanning(real start_time, real delta_time)
 {
+  PROFILE_ZONE("planning");
   Shape* shape = nextShape();
   if (shape)
     shape->doPlanning(start_time, delta_time);
@@ -167,8 +174,11 @@ struct CompareShapeDepth : public binary_function<Shape*, Shape*, bool>
 */
 void Group::draw(const Rect2& r) const
 {
-  vector<Shape*> shapes(iShapes.begin(), iShapes.end());
-  sort(shapes.begin(), shapes.end(), CompareShapeDepth());
+  vector<Shape*> shapes;
+  shapes.reserve(iShapes.size());
+  for (Shapes::const_iterator it = iShapes.begin(); it != iShapes.end(); ++it)
+    shapes.push_back(it->second);
+  stable_sort(shapes.begin(), shapes.end(), CompareShapeDepth());
   typedef vector<Shape*>::iterator iterator;
   
   for (iterator shape = shapes.begin(); shape != shapes.end(); ++shape) {
@@ -179,12 +189,13 @@ void Group::draw(const Rect2& r) const
 void Group::clear()
 {
   // Stop listening to shapes
-  for_each(iShapes.begin(), iShapes.end(),
-    bind2nd(mem_fun(&Shape::removeListener),
-            this));
-  for_each(iShapes.begin(), iShapes.end(),
-    mem_fun(&SharedObject::release));  
+  for (Shapes::iterator it = iShapes.begin(); it != iShapes.end(); ++it) {
+    it->second->removeListener(this);
+    it->second->release();
+  }
   iShapes.clear();
+  iOrder.clear();
+  iCurShape = iShapes.end();
 }
 
 /*! 
@@ -196,7 +207,7 @@ Shape* Group::nextShape()
 {
   if (iShapes.empty())
     return 0;
-  Shape* s = *iCurShape;
+  Shape* s = iCurShape->second;
   if (++iCurShape == iShapes.end())
     iCurShape = iShapes.begin();
   return s;
@@ -205,11 +216,13 @@ Shape* Group::nextShape()
 
 bool Group::collide(Shape* other, real t, real dt, CollisionAction* command)
 {
+  PROFILE_ZONE("collision");
   bool is_col = false;
-  set<Shape*>::iterator it;  
+  real now = World::current()->seconds();
+  Shapes::iterator it;  
   for (it = iShapes.begin(); it != iShapes.end(); ++it) {
-    Shape* shape = *it;
-    if (secondsPassed() > t+dt)
+    Shape* shape = it->second;
+    if (now > t+dt)
       break;
       
     if (shape == other)
@@ -224,11 +237,12 @@ bool Group::collide(Shape* other, real t, real dt, CollisionAction* command)
 bool Group::inside(const Point2& p, real t, real dt, Action* command)
 {
   bool is_col = false;
-  set<Shape*>::iterator it;  
+  real now = World::current()->seconds();
+  Shapes::iterator it;  
   for (it = iShapes.begin(); it != iShapes.end(); ++it) {
-    Shape* shape = *it;
+    Shape* shape = it->second;
 
-    if (secondsPassed() > t+dt)
+    if (now > t+dt)
       break;
       
     if(shape->inside(p, t, dt, command))
@@ -240,11 +254,23 @@ bool Group::inside(const Point2& p, real t, real dt, Action* command)
 // Event handling
 void Group::shapeDestroyed(Shape* shape) 
 {
-  if (*iCurShape == shape) nextShape();  
-  iShapes.erase(shape);
+  if (contains(shape))
+    erase(shape);
 }
 
 void Group::shapeKilled(Shape* shape) 
 {
   removeKid(shape);
 }
+
+// Helper functions
+/*! Takes \a shape out of group without releasing it */
+void Group::erase(Shape* shape)
+{
+  map<Shape*, uint32>::iterator order = iOrder.find(shape);
+  assert(order != iOrder.end());
+  if (iCurShape->second == shape) nextShape();
+  if (iCurShape->second == shape) iCurShape = iShapes.end();  // Was the only shape
+  iShapes.erase(order->second);
+  iOrder.erase(order);
+}
@@ -62,8 +62,14 @@ public:
   void shapeKilled(Shape* shape);
         
 private:
-  std::set<Shape*> iShapes;
-  std::set<Shape*>::iterator iCurShape;
+  typedef std::map<uint32, Shape*> Shapes;
+
+  void erase(Shape* shape);
+
+  Shapes  iShapes;      // Keyed on order added, so iteration order is the same every run
+  std::map<Shape*, uint32> iOrder;
+  Shapes::iterator iCurShape;
+  uint32  iNextOrder;
   
   Rect2 iBBox;
 };
\ No newline at end of file
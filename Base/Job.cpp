@@ -0,0 +1,340 @@
+/*
+ *  Job.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+#include "Base/Job.h"
+
+#include "World.h"
+#include "Utils/Profiler.h"
+
+#include <Core/AutoreleasePool.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <cassert>
+
+using namespace std;
+
+// Guards state of all jobs. It is only held for a few instructions at a time
+static pthread_mutex_t gJobLock = PTHREAD_MUTEX_INITIALIZER;
+
+/*!
+    \class Job Job.h
+    \brief Work done on a worker thread of a JobQueue, e.g. loading a level.
+
+    run() is called on a worker thread. It must not touch Lua or shapes which
+    the game may change while it runs, and should call setProgress() now and
+    then and return early if isCancelled(). The result is kept in the job.
+
+    publish() is called on the main thread at the next frame boundary after
+    run() has returned, and then the listener is told. That is where the
+    result is handed over to the world, so scripts never see half a result.
+    Neither is called for a cancelled job.
+*/
+
+// Constructors
+Job::Job()
+  : iProgress(0.0), iFinished(false), iPublished(false), iCancelled(false),
+    iSucceeded(false), iListener(0)
+{
+}
+
+Job::~Job()
+{
+  delete iListener;
+}
+
+// Accessors
+std::string Job::typeName() const
+{
+  return "Job";
+}
+
+/*! How far run() has come, from 0 to 1. May be called from any thread */
+real Job::progress() const
+{
+  pthread_mutex_lock(&gJobLock);
+  real progress = iProgress;
+  pthread_mutex_unlock(&gJobLock);
+  return progress;
+}
+
+void Job::setProgress(real progress)
+{
+  pthread_mutex_lock(&gJobLock);
+  iProgress = max(0.0, min(progress, 1.0));
+  pthread_mutex_unlock(&gJobLock);
+}
+
+/*! Listener is deleted with job */
+void Job::setListener(JobListener* listener)
+{
+  if (listener != iListener)
+    delete iListener;
+  iListener = listener;
+}
+
+JobListener* Job::listener() const
+{
+  return iListener;
+}
+
+// Request
+/*! True when run() has returned. Result may not have been published yet */
+bool Job::isFinished() const
+{
+  pthread_mutex_lock(&gJobLock);
+  bool finished = iFinished;
+  pthread_mutex_unlock(&gJobLock);
+  return finished;
+}
+
+/*! True when job has been published, or dropped if it was cancelled */
+bool Job::isPublished() const
+{
+  return iPublished;
+}
+
+bool Job::isCancelled() const
+{
+  pthread_mutex_lock(&gJobLock);
+  bool cancelled = iCancelled;
+  pthread_mutex_unlock(&gJobLock);
+  return cancelled;
+}
+
+/*! True if run() returned true */
+bool Job::succeeded() const
+{
+  pthread_mutex_lock(&gJobLock);
+  bool succeeded = iSucceeded;
+  pthread_mutex_unlock(&gJobLock);
+  return succeeded;
+}
+
+// Operations
+/*! Asks run() to stop. Result of a cancelled job is never published */
+void Job::cancel()
+{
+  pthread_mutex_lock(&gJobLock);
+  iCancelled = true;
+  pthread_mutex_unlock(&gJobLock);
+}
+
+/*! Hands result over to the world. Called on main thread */
+void Job::publish()
+{
+}
+
+void Job::setFinished(bool succeeded)
+{
+  pthread_mutex_lock(&gJobLock);
+  iFinished = true;
+  iSucceeded = succeeded;
+  if (succeeded)
+    iProgress = 1.0;
+  pthread_mutex_unlock(&gJobLock);
+}
+
+void Job::setPublished()
+{
+  iPublished = true;
+}
+
+/*!
+    \class JobQueue Job.h
+    \brief Runs jobs on worker threads and publishes them on the main thread.
+
+    Jobs run in the order they were added, on up to noThreads() threads which
+    are started when the first job is added. publish() should be called once
+    per frame on the main thread, World::update() does it before the scripts
+    run. It publishes every job which has finished since last time, in the
+    order they finished.
+
+    Worker threads make the world of the queue current, and have their own
+    autorelease pool while a job runs.
+*/
+
+// Constructors
+JobQueue::JobQueue(World* world, int noThreads)
+  : iWorld(world), iNoThreads(max(noThreads, 1)), iSize(0), iQuit(false)
+{
+  pthread_mutex_init(&iLock, 0);
+  pthread_cond_init(&iWork, 0);
+  pthread_cond_init(&iDone, 0);
+}
+
+/*! Cancels jobs and waits for those running to return */
+JobQueue::~JobQueue()
+{
+  cancel();
+  stopWorkers();
+
+  pthread_mutex_lock(&iLock);
+  for_each(iPending.begin(), iPending.end(), mem_fun(&Job::release));
+  for_each(iFinished.begin(), iFinished.end(), mem_fun(&Job::release));
+  iPending.clear();
+  iFinished.clear();
+  pthread_mutex_unlock(&iLock);
+
+  pthread_cond_destroy(&iDone);
+  pthread_cond_destroy(&iWork);
+  pthread_mutex_destroy(&iLock);
+}
+
+// Accessors
+int JobQueue::noThreads() const
+{
+  return iNoThreads;
+}
+
+// Request
+/*! Number of jobs added but not yet published */
+uint32 JobQueue::size() const
+{
+  pthread_mutex_lock(&iLock);
+  uint32 size = iSize;
+  pthread_mutex_unlock(&iLock);
+  return size;
+}
+
+bool JobQueue::empty() const
+{
+  return size() == 0;
+}
+
+// Operations
+/*! Queues \a job to run on a worker thread. Job is retained until published */
+void JobQueue::add(Job* job)
+{
+  assert(job != 0);
+  job->retain();
+
+  pthread_mutex_lock(&iLock);
+  iPending.push_back(job);
+  ++iSize;
+  while (int(iThreads.size()) < iNoThreads && !iQuit) {
+    pthread_t thread;
+    if (pthread_create(&thread, 0, runWorker, this) != 0)
+      break;
+    iThreads.push_back(thread);
+  }
+  bool no_threads = iThreads.empty();
+  pthread_cond_signal(&iWork);
+  pthread_mutex_unlock(&iLock);
+
+  if (no_threads) {
+    cerr << "Error could not start job thread, running job on calling thread" << endl;
+    work(false);
+  }
+}
+
+/*!
+  Publishes finished jobs and tells their listeners, then deletes listeners
+  and releases jobs. Must be called on main thread. Returns number of jobs
+  published.
+*/
+uint32 JobQueue::publish()
+{
+  pthread_mutex_lock(&iLock);
+  vector<Job*> finished;
+  finished.swap(iFinished);
+  iSize -= finished.size();
+  pthread_mutex_unlock(&iLock);
+
+  uint32 published = 0;
+  for (vector<Job*>::iterator it = finished.begin(); it != finished.end(); ++it) {
+    Job* job = *it;
+    job->setPublished();
+    if (!job->isCancelled()) {
+      PROFILE_ZONE("publish job");
+      job->publish();
+      if (job->listener())
+        job->listener()->jobFinished(job);
+      ++published;
+    }
+    job->setListener(0);
+    job->release();
+  }
+  return published;
+}
+
+/*! Blocks until every job added has run. They still need to be published */
+void JobQueue::wait()
+{
+  pthread_mutex_lock(&iLock);
+  if (iThreads.empty()) {
+    pthread_mutex_unlock(&iLock);
+    return;
+  }
+  while (!iPending.empty() || !iRunning.empty())
+    pthread_cond_wait(&iDone, &iLock);
+  pthread_mutex_unlock(&iLock);
+}
+
+/*! Cancels every job not yet published */
+void JobQueue::cancel()
+{
+  pthread_mutex_lock(&iLock);
+  for_each(iPending.begin(), iPending.end(), mem_fun(&Job::cancel));
+  for_each(iRunning.begin(), iRunning.end(), mem_fun(&Job::cancel));
+  for_each(iFinished.begin(), iFinished.end(), mem_fun(&Job::cancel));
+  pthread_mutex_unlock(&iLock);
+}
+
+void* JobQueue::runWorker(void* data)
+{
+  JobQueue* queue = (JobQueue*)data;
+  if (queue->iWorld)
+    queue->iWorld->makeCurrent();
+  queue->work(true);
+  return 0;
+}
+
+/*! Runs jobs until queue is empty, or until it is destroyed if \a wait_for_jobs */
+void JobQueue::work(bool wait_for_jobs)
+{
+  pthread_mutex_lock(&iLock);
+  for (;;) {
+    while (iPending.empty() && !iQuit && wait_for_jobs)
+      pthread_cond_wait(&iWork, &iLock);
+    if (iPending.empty() || iQuit)
+      break;
+
+    Job* job = iPending.front();
+    iPending.pop_front();
+    iRunning.push_back(job);
+    pthread_mutex_unlock(&iLock);
+
+    bool ok = false;
+    if (!job->isCancelled()) {
+      AutoreleasePool::begin();
+      ok = job->run();
+      AutoreleasePool::end();
+    }
+    job->setFinished(ok);
+
+    pthread_mutex_lock(&iLock);
+    iRunning.erase(find(iRunning.begin(), iRunning.end(), job));
+    iFinished.push_back(job);
+    pthread_cond_broadcast(&iDone);
+  }
+  pthread_mutex_unlock(&iLock);
+}
+
+void JobQueue::stopWorkers()
+{
+  pthread_mutex_lock(&iLock);
+  iQuit = true;
+  pthread_cond_broadcast(&iWork);
+  vector<pthread_t> threads;
+  threads.swap(iThreads);
+  pthread_mutex_unlock(&iLock);
+
+  for (vector<pthread_t>::iterator it = threads.begin(); it != threads.end(); ++it)
+    pthread_join(*it, 0);
+}
@@ -0,0 +1,106 @@
+/*
+ *  Job.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+#pragma once
+
+#include "Types.h"
+
+#include <Core/SharedObject.hpp>
+
+#include <pthread.h>
+#include <vector>
+#include <deque>
+
+class Job;
+class World;
+
+/*! Told on the main thread when a job has been published */
+class JobListener
+{
+public:
+  virtual ~JobListener() {}
+  virtual void jobFinished(Job* job) = 0;
+};
+
+class Job : public SharedObject
+{
+public:
+  // Constructors
+  Job();
+  virtual ~Job();
+
+  // Accessors
+  std::string typeName() const;
+  real  progress() const;
+  void  setListener(JobListener* listener);
+  JobListener* listener() const;
+
+  // Request
+  bool  isFinished() const;
+  bool  isPublished() const;
+  bool  isCancelled() const;
+  bool  succeeded() const;
+
+  // Operations
+  void  cancel();
+  virtual bool run() = 0;
+  virtual void publish();
+
+protected:
+  void  setProgress(real progress);
+
+private:
+  friend class JobQueue;
+  void  setFinished(bool succeeded);
+  void  setPublished();
+
+private:
+  real  iProgress;
+  bool  iFinished, iPublished, iCancelled, iSucceeded;
+  JobListener* iListener;
+};
+
+class JobQueue : public SharedObject
+{
+public:
+  // Constructors
+  JobQueue(World* world = 0, int noThreads = 1);
+  virtual ~JobQueue();
+
+  // Accessors
+  int     noThreads() const;
+
+  // Request
+  uint32  size() const;
+  bool    empty() const;
+
+  // Operations
+  void    add(Job* job);
+  uint32  publish();
+  void    wait();
+  void    cancel();
+
+private:
+  static void* runWorker(void* data);
+  void    work(bool wait_for_jobs);
+  void    stopWorkers();
+
+private:
+  World*  iWorld;
+  int     iNoThreads;
+  std::vector<pthread_t> iThreads;
+  std::deque<Job*>  iPending;
+  std::vector<Job*> iRunning;
+  std::vector<Job*> iFinished;
+  uint32  iSize;
+  bool    iQuit;
+
+  mutable pthread_mutex_t iLock;
+  pthread_cond_t  iWork;      // Signaled when a job is added or workers should quit
+  pthread_cond_t  iDone;      // Signaled when a job has run
+};
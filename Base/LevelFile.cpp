@@ -0,0 +1,474 @@
+/*
+ *  LevelFile.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+#include "Base/LevelFile.h"
+#include "Base/Sprite.h"
+#include "Base/ShapeGroup.h"
+#include "Base/ShapeIterator.h"
+#include "Utils/Algorithms.h"
+#include "Utils/MappedFile.h"
+
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <cstdio>
+
+using namespace std;
+
+/*!
+    \class LevelFile LevelFile.h
+    \brief Binary level with obstacles, their bounding volume hierarchy and a roadmap.
+
+    Levels written as Lua scripts create every obstacle polygon through the
+    Lua API and then build the bounding volume hierarchy of the obstacles
+    with ShapeGroup at startup. A level file stores the result of all that
+    instead: obstacle polygons and colors, the hierarchy as it was built and
+    optionally the probabilistic roadmap found for the level.
+
+    save() is the exporter. It takes the obstacles of a loaded level,
+    normally the ShapeGroup used for collision detection. load() memory maps
+    the file, checks it and points straight into the mapping, so nothing is
+    parsed and pages are only read when used. Hierarchy and roadmap refer to
+    obstacles and nodes by index, so the file has no pointers to fix up.
+
+    Like TrajectoryTable the file stores native doubles and is meant as a
+    cache on the machine that wrote it, not as a portable format. Version
+    is bumped whenever layout changes, and load() refuses older files.
+*/
+
+static const char  gMagic[4] = {'L', 'L', 'V', 'L'};
+static const int   gVersion = 1;
+
+/*!
+  Layout of file header. Followed by the sections below in order, each
+  starting at a multiple of 8 bytes.
+*/
+struct LevelFileHeader
+{
+  char  magic[4];
+  int   version;
+  int   pointSize;        // sizeof(Point2), sizeof(LevelNode) and sizeof(RoadmapNode) of writer
+  int   nodeSize;
+  int   roadmapNodeSize;
+  int   noObstacles;
+  int   noPoints;
+  int   noNodes;
+  int   root;
+  int   noRoadmapNodes;
+  int   noNeighbors;
+  int   reserved;
+  real  box[4];           // xmin, ymin, xmax, ymax. Plain reals keep header trivially copyable
+};
+
+enum LevelSection {
+  POLYGON_OFFSETS,
+  COLORS,
+  POINTS,
+  NODES,
+  ROADMAP_NODES,
+  NEIGHBOR_OFFSETS,
+  NEIGHBORS,
+  NO_SECTIONS
+};
+
+// Helper functions
+static size_t align(size_t offset)
+{
+  return (offset+7) & ~size_t(7);
+}
+
+/*!
+  Put start of each section in \a offsets, and end of last section in
+  offsets[NO_SECTIONS]. Counts in \a h must not be negative.
+*/
+static void layout(const LevelFileHeader& h, size_t offsets[NO_SECTIONS+1])
+{
+  size_t sizes[NO_SECTIONS];
+  sizes[POLYGON_OFFSETS]  = (size_t(h.noObstacles)+1)*sizeof(uint32);
+  sizes[COLORS]           = size_t(h.noObstacles)*3*sizeof(real);
+  sizes[POINTS]           = size_t(h.noPoints)*sizeof(Point2);
+  sizes[NODES]            = size_t(h.noNodes)*sizeof(LevelNode);
+  sizes[ROADMAP_NODES]    = size_t(h.noRoadmapNodes)*sizeof(RoadmapNode);
+  sizes[NEIGHBOR_OFFSETS] = (size_t(h.noRoadmapNodes)+1)*sizeof(uint32);
+  sizes[NEIGHBORS]        = size_t(h.noNeighbors)*sizeof(uint32);
+
+  offsets[0] = align(sizeof(LevelFileHeader));
+  for (int i = 0; i < NO_SECTIONS; ++i)
+    offsets[i+1] = align(offsets[i]+sizes[i]);
+}
+
+/*! True if \a n+1 \a offsets start at 0, never decrease and end at \a total */
+static bool validOffsets(const uint32* offsets, int n, uint32 total)
+{
+  if (offsets[0] != 0 || offsets[n] != total)
+    return false;
+  for (int i = 0; i < n; ++i)
+    if (offsets[i] > offsets[i+1])
+      return false;
+  return true;
+}
+
+/*! True if \a child is an obstacle or a node stored before node \a parent */
+static bool validChild(int child, int parent, int no_obstacles)
+{
+  return child < 0 ? -(child+1) < no_obstacles : child < parent;
+}
+
+static Rect2 boundingBox(int ref, const vector<LevelNode>& nodes, const vector<Shape*>& leaves)
+{
+  return ref < 0 ? leaves[-(ref+1)]->boundingBox() : nodes[ref].box;
+}
+
+static bool flatten(Shape* shape, vector<LevelNode>& nodes, vector<Shape*>& leaves, int& ref);
+
+/*!
+  Store hierarchy of \a begin to \a end in \a nodes. Children are stored
+  before their parents. \a ref is set to root and false is returned if
+  there were no simple shapes.
+*/
+static bool flatten(vector<Shape*>::iterator begin, vector<Shape*>::iterator end, vector<LevelNode>& nodes, vector<Shape*>& leaves, int& ref)
+{
+  int n = end-begin;
+  if (n == 0)
+    return false;
+  if (n == 1)
+    return flatten(*begin, nodes, leaves, ref);
+
+  int left, right;
+  bool has_left = flatten(begin, begin+n/2, nodes, leaves, left);
+  bool has_right = flatten(begin+n/2, end, nodes, leaves, right);
+  if (!has_left || !has_right) {
+    ref = has_left ? left : right;
+    return has_left || has_right;
+  }
+
+  LevelNode node;
+  node.box = boundingBox(left, nodes, leaves).surround(boundingBox(right, nodes, leaves));
+  node.left = left;
+  node.right = right;
+  nodes.push_back(node);
+  ref = nodes.size()-1;
+  return true;
+}
+
+static bool flatten(Shape* shape, vector<LevelNode>& nodes, vector<Shape*>& leaves, int& ref)
+{
+  if (shape->isSimple()) {
+    leaves.push_back(shape);
+    ref = -int(leaves.size());
+    return true;
+  }
+
+  vector<Shape*> kids;
+  MutableVectorShapeIterator dest(kids);
+  Util::insert(shape->iterator(), &dest);
+  return flatten(kids.begin(), kids.end(), nodes, leaves, ref);
+}
+
+/*! Write \a size bytes at \a offset, padding with zeros from \a pos */
+static bool writeSection(FILE* file, size_t& pos, size_t offset, const void* data, size_t size)
+{
+  static const char zeros[8] = {0};
+  assert(offset >= pos && offset-pos < sizeof(zeros));
+  if (offset > pos && fwrite(zeros, 1, offset-pos, file) != offset-pos)
+    return false;
+  pos = offset+size;
+  return size == 0 || fwrite(data, 1, size, file) == size;
+}
+
+/*! Build ShapeGroup for \a ref. Returned shape is retained */
+static Shape* buildHierarchy(const LevelFile& level, int ref, const vector<Shape*>& obstacles)
+{
+  if (ref < 0) {
+    Shape* shape = obstacles[-(ref+1)];
+    shape->retain();
+    return shape;
+  }
+
+  const LevelNode& node = level.node(ref);
+  Shape* left = buildHierarchy(level, node.left, obstacles);
+  Shape* right = buildHierarchy(level, node.right, obstacles);
+  Shape* group = new ShapeGroup(left, right, node.box);
+  left->release();
+  right->release();
+  return group;
+}
+
+// Constructors
+LevelFile::LevelFile()
+  : iNoObstacles(0), iNoNodes(0), iRoot(0), iNoRoadmapNodes(0), iFile(0)
+{
+}
+
+LevelFile::~LevelFile()
+{
+  delete iFile;
+}
+
+/*!
+  Load level saved with save(). Returns 0 if file is missing, damaged or
+  was not written by a compatible version of the engine. Data is memory
+  mapped, not copied.
+*/
+LevelFile* LevelFile::load(const std::string& path)
+{
+  MappedFile* file = new MappedFile;
+  if (!file->open(path) || file->size() < sizeof(LevelFileHeader)) {
+    delete file;
+    return 0;
+  }
+
+  LevelFileHeader header;
+  memcpy(&header, file->data(), sizeof(header));
+
+  bool ok = memcmp(header.magic, gMagic, sizeof(gMagic)) == 0 &&
+            header.version == gVersion &&
+            header.pointSize == int(sizeof(Point2)) &&
+            header.nodeSize == int(sizeof(LevelNode)) &&
+            header.roadmapNodeSize == int(sizeof(RoadmapNode)) &&
+            header.noObstacles >= 0 && header.noPoints >= 0 && header.noNodes >= 0 &&
+            header.noRoadmapNodes >= 0 && header.noNeighbors >= 0 &&
+            (header.noObstacles == 0 || validChild(header.root, header.noNodes, header.noObstacles));
+
+  size_t offsets[NO_SECTIONS+1];
+  if (ok) {
+    layout(header, offsets);
+    ok = file->size() == offsets[NO_SECTIONS];
+  }
+  if (!ok) {
+    delete file;
+    return 0;
+  }
+
+  const char* data = file->data();
+  LevelFile* level = new LevelFile;
+  level->iBox = Rect2(header.box[0], header.box[1], header.box[2], header.box[3]);
+  level->iNoObstacles = header.noObstacles;
+  level->iNoNodes = header.noNodes;
+  level->iRoot = header.root;
+  level->iNoRoadmapNodes = header.noRoadmapNodes;
+  level->iFile = file;
+  level->iPolygonOffsets = (const uint32*)(data+offsets[POLYGON_OFFSETS]);
+  level->iColors = (const real*)(data+offsets[COLORS]);
+  level->iPoints = (const Point2*)(data+offsets[POINTS]);
+  level->iNodes = (const LevelNode*)(data+offsets[NODES]);
+  level->iRoadmapNodes = (const RoadmapNode*)(data+offsets[ROADMAP_NODES]);
+  level->iNeighborOffsets = (const uint32*)(data+offsets[NEIGHBOR_OFFSETS]);
+  level->iNeighbors = (const uint32*)(data+offsets[NEIGHBORS]);
+
+  // Indices are used without checks later, so check them all once here
+  ok = validOffsets(level->iPolygonOffsets, header.noObstacles, header.noPoints) &&
+       validOffsets(level->iNeighborOffsets, header.noRoadmapNodes, header.noNeighbors);
+  for (int i = 0; ok && i < header.noNodes; ++i) {
+    const LevelNode& node = level->iNodes[i];
+    ok = validChild(node.left, i, header.noObstacles) && validChild(node.right, i, header.noObstacles);
+  }
+  for (int i = 0; ok && i < header.noNeighbors; ++i)
+    ok = level->iNeighbors[i] < uint32(header.noRoadmapNodes);
+
+  if (!ok) {
+    level->release();
+    return 0;
+  }
+  return level;
+}
+
+// Accessors
+std::string LevelFile::typeName() const
+{
+  return "LevelFile";
+}
+
+/*! Bounding box of all obstacles */
+Rect2 LevelFile::boundingBox() const
+{
+  return iBox;
+}
+
+int LevelFile::noObstacles() const
+{
+  return iNoObstacles;
+}
+
+/*! Collision polygon of \a obstacle in world coordinates */
+Polygon2 LevelFile::polygon(int obstacle) const
+{
+  assert(obstacle >= 0 && obstacle < iNoObstacles);
+  return Polygon2(iPoints+iPolygonOffsets[obstacle], iPoints+iPolygonOffsets[obstacle+1]);
+}
+
+/*! Red, green and blue components of color of \a obstacle */
+const real* LevelFile::color(int obstacle) const
+{
+  assert(obstacle >= 0 && obstacle < iNoObstacles);
+  return iColors+3*obstacle;
+}
+
+/*! Number of nodes in bounding volume hierarchy */
+int LevelFile::noNodes() const
+{
+  return iNoNodes;
+}
+
+/*!
+  Root of bounding volume hierarchy, referring to a node or an obstacle like
+  the children of LevelNode. Only valid when there are obstacles.
+*/
+int LevelFile::root() const
+{
+  return iRoot;
+}
+
+/*! Children of a node are always stored before it */
+const LevelNode& LevelFile::node(int index) const
+{
+  assert(index >= 0 && index < iNoNodes);
+  return iNodes[index];
+}
+
+int LevelFile::noRoadmapNodes() const
+{
+  return iNoRoadmapNodes;
+}
+
+const RoadmapNode& LevelFile::roadmapNode(int index) const
+{
+  assert(index >= 0 && index < iNoRoadmapNodes);
+  return iRoadmapNodes[index];
+}
+
+int LevelFile::noNeighbors(int index) const
+{
+  assert(index >= 0 && index < iNoRoadmapNodes);
+  return iNeighborOffsets[index+1]-iNeighborOffsets[index];
+}
+
+/*! Indices of the noNeighbors() nodes connected to roadmap node \a index */
+const uint32* LevelFile::neighbors(int index) const
+{
+  assert(index >= 0 && index < iNoRoadmapNodes);
+  return iNeighbors+iNeighborOffsets[index];
+}
+
+// Calculations
+/*!
+  Groups \a obstacles in the stored bounding volume hierarchy, without
+  rebuilding it. obstacles[i] should be a shape created for polygon(i).
+  Returns 0 if there are no obstacles. Returned shape is retained, so
+  caller must release it.
+*/
+Shape* LevelFile::createObstacles(const vector<Shape*>& obstacles) const
+{
+  if (int(obstacles.size()) != iNoObstacles) {
+    cerr << "Error level has " << iNoObstacles << " obstacles but got " << obstacles.size() << " shapes" << endl;
+    return 0;
+  }
+  if (iNoObstacles == 0)
+    return 0;
+  return buildHierarchy(*this, iRoot, obstacles);
+}
+
+// Operations
+/*!
+  Write level to binary file at \a path. Load it again with load().
+  Every simple shape in \a obstacles must be a Sprite. Its collision polygon
+  and view color is stored. The hierarchy of \a obstacles is stored as is,
+  so pass a ShapeGroup to get a balanced one. Groups with more than two
+  kids are split in halves in iteration order.
+
+  \a nodes and \a neighbors is an optional roadmap. neighbors[i] holds
+  indices of nodes connected to nodes[i].
+*/
+bool LevelFile::save(const std::string& path, Shape* obstacles, const RoadmapNodes& nodes, const RoadmapNeighbors& neighbors)
+{
+  assert(obstacles != 0);
+  assert(neighbors.empty() || neighbors.size() == nodes.size());
+
+  vector<LevelNode> tree;
+  vector<Shape*> leaves;
+  int root = 0;
+  if (!flatten(obstacles, tree, leaves, root))
+    root = 0;
+
+  vector<uint32> polygon_offsets(1, 0);
+  vector<real>   colors;
+  Points2        points;
+  vector<Shape*>::iterator s;
+  for (s = leaves.begin(); s != leaves.end(); ++s) {
+    Sprite* sprite = dynamic_cast<Sprite*>(*s);
+    if (sprite == 0) {
+      cerr << "Error level obstacles must be sprites, got " << (*s)->typeName() << endl;
+      return false;
+    }
+    const Polygon2& poly = sprite->collisionPolygon();
+    points.insert(points.end(), poly.begin(), poly.end());
+    polygon_offsets.push_back(points.size());
+
+    static const real white[3] = {1.0, 1.0, 1.0};
+    const real* color = sprite->view() ? sprite->view()->color() : white;
+    colors.insert(colors.end(), color, color+3);
+  }
+
+  vector<uint32> neighbor_offsets(1, 0);
+  vector<uint32> edges;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    if (i < neighbors.size())
+      edges.insert(edges.end(), neighbors[i].begin(), neighbors[i].end());
+    neighbor_offsets.push_back(edges.size());
+  }
+  for (size_t i = 0; i < edges.size(); ++i) {
+    if (edges[i] >= nodes.size()) {
+      cerr << "Error roadmap neighbor " << edges[i] << " is not a node" << endl;
+      return false;
+    }
+  }
+
+  LevelFileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, gMagic, sizeof(gMagic));
+  header.version = gVersion;
+  header.pointSize = sizeof(Point2);
+  header.nodeSize = sizeof(LevelNode);
+  header.roadmapNodeSize = sizeof(RoadmapNode);
+  header.noObstacles = leaves.size();
+  header.noPoints = points.size();
+  header.noNodes = tree.size();
+  header.root = root;
+  header.noRoadmapNodes = nodes.size();
+  header.noNeighbors = edges.size();
+  Rect2 box = obstacles->boundingBox();
+  header.box[0] = box.xmin();
+  header.box[1] = box.ymin();
+  header.box[2] = box.xmax();
+  header.box[3] = box.ymax();
+
+  size_t offsets[NO_SECTIONS+1];
+  layout(header, offsets);
+
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == 0)
+    return false;
+
+  size_t pos = 0;
+  bool ok = writeSection(file, pos, 0, &header, sizeof(header)) &&
+    writeSection(file, pos, offsets[POLYGON_OFFSETS], &polygon_offsets[0], polygon_offsets.size()*sizeof(uint32)) &&
+    writeSection(file, pos, offsets[COLORS], colors.empty() ? 0 : &colors[0], colors.size()*sizeof(real)) &&
+    writeSection(file, pos, offsets[POINTS], points.empty() ? 0 : &points[0], points.size()*sizeof(Point2)) &&
+    writeSection(file, pos, offsets[NODES], tree.empty() ? 0 : &tree[0], tree.size()*sizeof(LevelNode)) &&
+    writeSection(file, pos, offsets[ROADMAP_NODES], nodes.empty() ? 0 : &nodes[0], nodes.size()*sizeof(RoadmapNode)) &&
+    writeSection(file, pos, offsets[NEIGHBOR_OFFSETS], &neighbor_offsets[0], neighbor_offsets.size()*sizeof(uint32)) &&
+    writeSection(file, pos, offsets[NEIGHBORS], edges.empty() ? 0 : &edges[0], edges.size()*sizeof(uint32)) &&
+    writeSection(file, pos, offsets[NO_SECTIONS], 0, 0);
+  return fclose(file) == 0 && ok;
+}
+
+/*! Start reading the whole level file in, so accessors do not page fault */
+void LevelFile::prefetch() const
+{
+  iFile->prefetch();
+}
@@ -0,0 +1,93 @@
+/*
+ *  LevelFile.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+#pragma once
+
+#include "Types.h"
+
+#include <Core/SharedObject.hpp>
+#include <Geometry/Polygon2.hpp>
+
+#include <vector>
+#include <string>
+
+class MappedFile;
+class Shape;
+
+/*!
+  Node in bounding volume hierarchy of level obstacles. A child which is
+  zero or larger is index of another node, a negative child \c c is
+  obstacle \c -(c+1).
+*/
+struct LevelNode
+{
+  Rect2 box;
+  int   left, right;
+};
+
+/*! Node of probabilistic roadmap, a free disc */
+struct RoadmapNode
+{
+  Point2  position;
+  real    radius;
+};
+
+typedef std::vector<RoadmapNode> RoadmapNodes;
+typedef std::vector< std::vector<uint32> > RoadmapNeighbors;
+
+class LevelFile : public SharedObject
+{
+public:
+  // Constructors
+  virtual ~LevelFile();
+
+  static LevelFile* load(const std::string& path);
+
+  // Accessors
+  std::string typeName() const;
+  Rect2       boundingBox() const;
+  int         noObstacles() const;
+  Polygon2    polygon(int obstacle) const;
+  const real* color(int obstacle) const;
+
+  int   noNodes() const;
+  int   root() const;
+  const LevelNode& node(int index) const;
+
+  int   noRoadmapNodes() const;
+  const RoadmapNode& roadmapNode(int index) const;
+  int   noNeighbors(int index) const;
+  const uint32* neighbors(int index) const;
+
+  // Calculations
+  Shape* createObstacles(const std::vector<Shape*>& obstacles) const;
+
+  // Operations
+  static bool save(const std::string& path, Shape* obstacles,
+                   const RoadmapNodes& nodes = RoadmapNodes(),
+                   const RoadmapNeighbors& neighbors = RoadmapNeighbors());
+  void        prefetch() const;
+
+private:
+  LevelFile();
+
+private:
+  Rect2 iBox;
+  int   iNoObstacles, iNoNodes, iRoot, iNoRoadmapNodes;
+
+  // All point into iFile
+  const uint32*       iPolygonOffsets;  // iNoObstacles+1 indices into iPoints
+  const real*         iColors;          // 3 per obstacle
+  const Point2*       iPoints;
+  const LevelNode*    iNodes;
+  const RoadmapNode*  iRoadmapNodes;
+  const uint32*       iNeighborOffsets; // iNoRoadmapNodes+1 indices into iNeighbors
+  const uint32*       iNeighbors;
+
+  MappedFile*   iFile;
+};
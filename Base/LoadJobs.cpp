@@ -0,0 +1,420 @@
+/*
+ *  LoadJobs.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+#include "Base/LoadJobs.h"
+
+#include "Base/Action.h"
+#include "Base/Shape.h"
+#include "Base/ShapeGroup.h"
+#include "Base/SegmentShape2.h"
+#include "Base/Sprite.h"
+#include "Base/PolygonView.h"
+#include "Base/TrajectoryTable.h"
+#include "World.h"
+#include "Utils/Random.h"
+#include "Utils/Profiler.h"
+
+#include <algorithm>
+#include <deque>
+#include <cmath>
+#include <cassert>
+
+using namespace std;
+
+const real MAX_RADIUS = 100.0;  // maximum disc radius, as in prm.lua
+const real MIN_RADIUS = 1.0;    // minimum disc radius
+
+// Jobs must not call Lua, which a missing action makes shapes do
+class IgnoreInside : public Action
+{
+public:
+  bool execute(Shape*, real, real) { return true; }
+};
+
+class IgnoreCollision : public CollisionAction
+{
+public:
+  bool execute(Shape*, Shape*, Points2&, real, real) { return true; }
+};
+
+/*!
+  Copy of the obstacles in \a shapes, so a job never reads shapes the game
+  may move or release on the main thread. Sprites are replaced by sprites
+  at the origin with their current collision polygon. Other simple shapes
+  can not change once created so they are shared.
+*/
+static Shape* snapshotObstacles(Shape* shapes)
+{
+  assert(shapes != 0);
+  vector<Shape*> leaves;
+  gatherSimpleShapes(shapes, shapes->boundingBox(), leaves);
+  if (leaves.empty())
+    return new ShapeGroup;
+
+  vector<Shape*> copies;
+  copies.reserve(leaves.size());
+  for (vector<Shape*>::iterator it = leaves.begin(); it != leaves.end(); ++it) {
+    Sprite* sprite = dynamic_cast<Sprite*>(*it);
+    if (sprite == 0) {
+      copies.push_back(*it);
+      (*it)->retain();
+      continue;
+    }
+    View* view = new PolygonView(sprite->collisionPolygon());
+    copies.push_back(new Sprite(view));
+    view->release();
+  }
+  Shape* group = new ShapeGroup(copies.begin(), copies.end());
+  for_each(copies.begin(), copies.end(), mem_fun(&Shape::release));
+  return group;
+}
+
+/*!
+    \class LevelLoadJob LoadJobs.h
+    \brief Loads a LevelFile on a worker thread.
+
+    The file is memory mapped and the OS is asked to read it all in, so the
+    game does not page fault on it once the job is published. Obstacle shapes
+    must be created from the level on the main thread, e.g. with
+    LevelFile::createObstacles() once the job is published.
+*/
+
+// Constructors
+LevelLoadJob::LevelLoadJob(const string& path) : iPath(path), iLevel(0)
+{
+}
+
+LevelLoadJob::~LevelLoadJob()
+{
+  if (iLevel)
+    iLevel->release();
+}
+
+// Accessors
+string LevelLoadJob::typeName() const
+{
+  return "LevelLoadJob";
+}
+
+string LevelLoadJob::path() const
+{
+  return iPath;
+}
+
+/*! Level loaded, or 0 if job has not finished or file could not be loaded */
+LevelFile* LevelLoadJob::level() const
+{
+  return isFinished() ? iLevel : 0;
+}
+
+// Operations
+bool LevelLoadJob::run()
+{
+  PROFILE_ZONE("load level");
+  iLevel = LevelFile::load(iPath);
+  if (iLevel == 0)
+    return false;
+  setProgress(0.5);
+  iLevel->prefetch();
+  return !isCancelled();
+}
+
+/*!
+    \class RoadmapJob LoadJobs.h
+    \brief Builds a probabilistic roadmap on a worker thread.
+
+    Does what ProbablisticRoadMap:construct() in prm.lua does: samples are
+    stratified over \a bbox, those inside obstacles are dropped and all but
+    the last \a retractQuotient of them are retracted towards the medial
+    axis. Each sample outside the discs found so far gets the largest free
+    disc around it. Overlapping discs are connected when no obstacle is in
+    between, and only the largest connected component is kept.
+
+    A copy of the obstacles is taken when the job is created, so they may be
+    moved or released while it runs. Nearest obstacles are found with the
+    narrow phase of the current world at that time. Result is given as nodes()
+    and neighbors() which is what LevelFile::save() takes.
+*/
+
+// Constructors
+RoadmapJob::RoadmapJob(Shape* obstacles, const Rect2& bbox, int noSamples, real retractQuotient, uint32 seed)
+  : iObstacles(snapshotObstacles(obstacles)), iBBox(bbox), iNoSamples(noSamples),
+    iRetractQuotient(retractQuotient), iSeed(seed),
+    iFinder(iObstacles, bbox, World::current()->narrowPhase())
+{
+}
+
+RoadmapJob::~RoadmapJob()
+{
+  iObstacles->release();
+}
+
+// Accessors
+string RoadmapJob::typeName() const
+{
+  return "RoadmapJob";
+}
+
+const RoadmapNodes& RoadmapJob::nodes() const
+{
+  return iNodes;
+}
+
+const RoadmapNeighbors& RoadmapJob::neighbors() const
+{
+  return iNeighbors;
+}
+
+// Operations
+bool RoadmapJob::run()
+{
+  PROFILE_ZONE("build roadmap");
+  iNodes.clear();
+  iNeighbors.clear();
+
+  // Stratified samples, see Geometry.stratifiedSamples
+  Random random(iSeed);
+  int rows = static_cast<int>(floor(sqrt(real(max(iNoSamples, 0)))));
+  real cell_width  = iBBox.width()/max(rows, 1);
+  real cell_height = iBBox.height()/max(rows, 1);
+  IgnoreInside ignore;
+  Points2 samples;
+  samples.reserve(rows*rows);
+  for (int row = 0; row < rows; ++row) {
+    real y = iBBox.min().y() + row*cell_height;
+    for (int col = 0; col < rows; ++col) {
+      real x = iBBox.min().x() + col*cell_width;
+      Point2 c(x + random.uniform()*cell_width, y + random.uniform()*cell_height);
+      if (!iObstacles->inside(c, 0.0, 0.0, &ignore))
+        samples.push_back(c);
+    }
+    if (isCancelled())
+      return false;
+  }
+  setProgress(0.1);
+
+  // Samples are taken from the back, and all above halftime are retracted
+  real halftime = samples.size()*(1.0 - iRetractQuotient);
+  for (int i = int(samples.size())-1; i >= 0; --i) {
+    Point2 c = samples[i];
+    if (i+1 > halftime && !iFinder.retractSample(samples[i], c))
+      continue;
+
+    uint32 index;
+    if (iBBox.inside(c) && !insideRoadmap(c))
+      addNode(c, index);
+
+    if (i % 16 == 0) {
+      if (isCancelled())
+        return false;
+      setProgress(0.1 + 0.6*(samples.size()-i)/samples.size());
+    }
+  }
+  setProgress(0.7);
+
+  connectOverlappingDiscs();
+  if (isCancelled())
+    return false;
+  setProgress(0.8);
+
+  connectLooseEnds();
+  if (isCancelled())
+    return false;
+  setProgress(0.9);
+
+  removeSmallComponents();
+  return !isCancelled();
+}
+
+bool RoadmapJob::lineCollision(const Point2& p, const Point2& q) const
+{
+  SegmentShape2 seg(Segment2(p, q));
+  IgnoreCollision ignore;
+  return iObstacles->collide(&seg, 0.0, 1.0, &ignore);
+}
+
+bool RoadmapJob::insideRoadmap(const Point2& p) const
+{
+  for (RoadmapNodes::const_iterator it = iNodes.begin(); it != iNodes.end(); ++it) {
+    if ((p - it->position).squaredLength() < it->radius*it->radius)
+      return true;
+  }
+  return false;
+}
+
+/*!
+  Adds node at \a p with largest free disc around it, if it is large enough.
+  A retracted sample may have been moved into an obstacle, so that is checked.
+*/
+bool RoadmapJob::addNode(const Point2& p, uint32& index)
+{
+  IgnoreInside ignore;
+  if (iObstacles->inside(p, 0.0, 0.0, &ignore))
+    return false;
+
+  Point2 closest;
+  real radius = MAX_RADIUS;
+  if (iFinder.nearestObstacle(p, closest))
+    radius = min((closest - p).length(), MAX_RADIUS);
+  if (radius <= MIN_RADIUS)
+    return false;
+
+  RoadmapNode node;
+  node.position = p;
+  node.radius = radius;
+  index = iNodes.size();
+  iNodes.push_back(node);
+  iNeighbors.push_back(vector<uint32>());
+  return true;
+}
+
+void RoadmapJob::connect(uint32 a, uint32 b)
+{
+  iNeighbors[a].push_back(b);
+  iNeighbors[b].push_back(a);
+}
+
+static bool overlap(const RoadmapNode& a, const RoadmapNode& b)
+{
+  real r = a.radius + b.radius;
+  return (a.position - b.position).squaredLength() <= r*r;
+}
+
+void RoadmapJob::connectOverlappingDiscs()
+{
+  for (uint32 a = 0; a < iNodes.size() && !isCancelled(); ++a) {
+    for (uint32 b = a+1; b < iNodes.size(); ++b) {
+      if (overlap(iNodes[a], iNodes[b]) && !lineCollision(iNodes[a].position, iNodes[b].position))
+        connect(a, b);
+    }
+  }
+}
+
+/*! Tries to join nodes with less than two neighbors through a node between them */
+void RoadmapJob::connectLooseEnds()
+{
+  vector<uint32> ends;
+  for (uint32 a = 0; a < iNodes.size(); ++a) {
+    if (iNeighbors[a].size() < 2)
+      ends.push_back(a);
+  }
+
+  for (uint32 i = 0; i < ends.size() && !isCancelled(); ++i) {
+    for (uint32 j = i+1; j < ends.size(); ++j) {
+      RoadmapNode n = iNodes[ends[i]], m = iNodes[ends[j]];
+      vector<uint32>& n_neighbors = iNeighbors[ends[i]];
+      if ((m.position - n.position).length() >= (m.radius + n.radius)*1.25 ||
+          find(n_neighbors.begin(), n_neighbors.end(), ends[j]) != n_neighbors.end() ||
+          lineCollision(n.position, m.position))
+        continue;
+
+      uint32 mid;
+      if (!addNode(n.position + (m.position - n.position)*0.5, mid))
+        continue;
+      if (overlap(iNodes[mid], n) && overlap(iNodes[mid], m)) {
+        connect(mid, ends[i]);
+        connect(mid, ends[j]);
+      }
+    }
+  }
+}
+
+/*! Keeps largest connected component, with nodes in breadth first order */
+void RoadmapJob::removeSmallComponents()
+{
+  uint32 no_nodes = iNodes.size();
+  vector<int> component(no_nodes, -1);
+  vector<uint32> sizes;
+  for (uint32 start = 0; start < no_nodes; ++start) {
+    if (component[start] >= 0)
+      continue;
+    int c = sizes.size();
+    sizes.push_back(0);
+    deque<uint32> queue(1, start);
+    component[start] = c;
+    while (!queue.empty()) {
+      uint32 a = queue.front();
+      queue.pop_front();
+      ++sizes[c];
+      for (vector<uint32>::iterator it = iNeighbors[a].begin(); it != iNeighbors[a].end(); ++it) {
+        if (component[*it] < 0) {
+          component[*it] = c;
+          queue.push_back(*it);
+        }
+      }
+    }
+  }
+  if (sizes.empty())
+    return;
+
+  uint32 largest = max_element(sizes.begin(), sizes.end()) - sizes.begin();
+  uint32 start = find(component.begin(), component.end(), int(largest)) - component.begin();
+
+  // Number nodes in breadth first order, like cleanUp() in prm.lua
+  vector<int> mapping(no_nodes, -1);
+  vector<uint32> order(1, start);
+  mapping[start] = 0;
+  for (uint32 i = 0; i < order.size(); ++i) {
+    vector<uint32>& neighbors = iNeighbors[order[i]];
+    for (vector<uint32>::iterator it = neighbors.begin(); it != neighbors.end(); ++it) {
+      if (mapping[*it] < 0) {
+        mapping[*it] = order.size();
+        order.push_back(*it);
+      }
+    }
+  }
+
+  RoadmapNodes nodes(order.size());
+  RoadmapNeighbors neighbors(order.size());
+  for (uint32 i = 0; i < order.size(); ++i) {
+    nodes[i] = iNodes[order[i]];
+    vector<uint32>& old = iNeighbors[order[i]];
+    for (vector<uint32>::iterator it = old.begin(); it != old.end(); ++it)
+      neighbors[i].push_back(mapping[*it]);
+  }
+  iNodes.swap(nodes);
+  iNeighbors.swap(neighbors);
+}
+
+/*!
+    \class TrajectoryTableJob LoadJobs.h
+    \brief Precomputes a TrajectoryTable on a worker thread.
+*/
+
+// Constructors
+TrajectoryTableJob::TrajectoryTableJob(const MotionState& s0, real angvel_min, real angvel_max, int angvel_steps, real dt, int steps)
+  : iState(s0), iAngVelMin(angvel_min), iAngVelMax(angvel_max), iDt(dt),
+    iAngVelSteps(angvel_steps), iSteps(steps), iTable(0)
+{
+}
+
+TrajectoryTableJob::~TrajectoryTableJob()
+{
+  if (iTable)
+    iTable->release();
+}
+
+// Accessors
+string TrajectoryTableJob::typeName() const
+{
+  return "TrajectoryTableJob";
+}
+
+/*! Table computed, or 0 if job has not finished */
+TrajectoryTable* TrajectoryTableJob::table() const
+{
+  return isFinished() ? iTable : 0;
+}
+
+// Operations
+bool TrajectoryTableJob::run()
+{
+  PROFILE_ZONE("build trajectory table");
+  iTable = new TrajectoryTable(iState, iAngVelMin, iAngVelMax, iAngVelSteps, iDt, iSteps);
+  return true;
+}
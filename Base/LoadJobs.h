@@ -0,0 +1,96 @@
+/*
+ *  LoadJobs.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+#pragma once
+
+#include "Base/Job.h"
+#include "Base/LevelFile.h"
+#include "Base/MotionState.h"
+#include "Utils/RoadMap.h"
+
+#include <string>
+
+class Shape;
+class TrajectoryTable;
+
+class LevelLoadJob : public Job
+{
+public:
+  // Constructors
+  LevelLoadJob(const std::string& path);
+  virtual ~LevelLoadJob();
+
+  // Accessors
+  std::string typeName() const;
+  std::string path() const;
+  LevelFile*  level() const;
+
+  // Operations
+  bool run();
+
+private:
+  std::string iPath;
+  LevelFile*  iLevel;
+};
+
+class RoadmapJob : public Job
+{
+public:
+  // Constructors
+  RoadmapJob(Shape* obstacles, const Rect2& bbox, int noSamples, real retractQuotient, uint32 seed = 0);
+  virtual ~RoadmapJob();
+
+  // Accessors
+  std::string typeName() const;
+  const RoadmapNodes&     nodes() const;
+  const RoadmapNeighbors& neighbors() const;
+
+  // Operations
+  bool run();
+
+private:
+  bool  lineCollision(const Point2& p, const Point2& q) const;
+  bool  insideRoadmap(const Point2& p) const;
+  bool  addNode(const Point2& p, uint32& index);
+  void  connect(uint32 a, uint32 b);
+  void  connectOverlappingDiscs();
+  void  connectLooseEnds();
+  void  removeSmallComponents();
+
+private:
+  Shape*  iObstacles;
+  Rect2   iBBox;
+  int     iNoSamples;
+  real    iRetractQuotient;
+  uint32  iSeed;
+  ClosestPointFinder iFinder;
+
+  RoadmapNodes      iNodes;
+  RoadmapNeighbors  iNeighbors;
+};
+
+class TrajectoryTableJob : public Job
+{
+public:
+  // Constructors
+  TrajectoryTableJob(const MotionState& s0, real angvel_min, real angvel_max, int angvel_steps, real dt, int steps);
+  virtual ~TrajectoryTableJob();
+
+  // Accessors
+  std::string typeName() const;
+  TrajectoryTable* table() const;
+
+  // Operations
+  bool run();
+
+private:
+  MotionState iState;
+  real  iAngVelMin, iAngVelMax, iDt;
+  int   iAngVelSteps, iSteps;
+  TrajectoryTable* iTable;
+};
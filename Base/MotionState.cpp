@@ -167,6 +167,21 @@ void MotionState::getCollisionPolygon(const View* view, Polygon2& poly) const
   }  
 }
 
+/*! Convex parts of collision polygon of \a view where state is. Empty if polygon is convex */
+void MotionState::getCollisionParts(const View* view, std::vector<Polygon2>& parts) const
+{
+  parts.clear();
+  if (view != 0 && !view->collisionParts().empty()) {  
+    Matrix2 trans; getTransform(trans);
+    const Polygons2& viewParts = view->collisionParts();
+    parts.resize(viewParts.size());
+    for (uint32 i = 0; i < viewParts.size(); ++i) {
+      parts[i].resize(viewParts[i].size());
+      transform(viewParts[i].begin(), viewParts[i].end(), parts[i].begin(), trans);
+    }
+  }  
+}
+
 
 // Operations
 /*! 
@@ -53,6 +53,7 @@ public:
   // Calculations
   void  getTransform(Matrix2& trans) const;
   void  getCollisionPolygon(const View* view, Polygon2& poly) const;
+  void  getCollisionParts(const View* view, std::vector<Polygon2>& parts) const;
   
 	// Operations
   // void  integrate(real t, int steps, MotionState& s);
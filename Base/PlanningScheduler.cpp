@@ -0,0 +1,328 @@
+/*
+ *  PlanningScheduler.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 21.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+#include "Base/PlanningScheduler.h"
+#include "Base/Shape.h"
+
+#include "Timing.h"
+#include "World.h"
+#include "Utils/Profiler.h"
+
+#include <lua.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <cassert>
+
+using namespace std;
+
+/*!
+    \class PlanningTask PlanningScheduler.h
+    \brief Resumable unit of planning work run by PlanningScheduler.
+
+    resume() should do as much work as it can before \a deadline, given in
+    monotonicSeconds(), and then return. It returns true when the task is
+    finished and should be removed from the scheduler. Tasks with higher
+    priority are resumed first. While World::isDeterministic() a task should
+    bound its work by a count instead, or replays will not repeat.
+*/
+
+// Constructors
+PlanningTask::PlanningTask(int priority) : iPriority(priority)
+{
+}
+
+PlanningTask::~PlanningTask()
+{
+}
+
+// Accessors
+void PlanningTask::setPriority(int priority)
+{
+  iPriority = priority;
+}
+
+int PlanningTask::priority() const
+{
+  return iPriority;
+}
+
+/*!
+    \class ShapePlanningTask PlanningScheduler.h
+    \brief Calls doPlanning() on a shape each time it is resumed.
+
+    Lets the plan action of a sprite run in the slack of a frame. The shape is
+    not retained. The task finishes when the shape is killed or destroyed.
+*/
+
+// Constructors
+ShapePlanningTask::ShapePlanningTask(Shape* shape, int priority)
+  : PlanningTask(priority), iShape(shape), iAlive(true)
+{
+  assert(shape != 0);
+  iShape->addListener(this);
+}
+
+ShapePlanningTask::~ShapePlanningTask()
+{
+  if (iShape)
+    iShape->removeListener(this);
+}
+
+// Accessors
+Shape* ShapePlanningTask::shape() const
+{
+  return iShape;
+}
+
+// Operations
+/*! Plans with the time left until \a deadline as delta time */
+bool ShapePlanningTask::resume(real start_time, real deadline)
+{
+  if (iShape == 0 || !iAlive)
+    return true;
+  iShape->doPlanning(start_time, deadline-monotonicSeconds());
+  return false;
+}
+
+// Event handling
+void ShapePlanningTask::shapeDestroyed(Shape* /*shape*/)
+{
+  iShape = 0;
+}
+
+void ShapePlanningTask::shapeKilled(Shape* /*shape*/)
+{
+  iAlive = false;
+}
+
+/*!
+    \class LuaPlanningTask PlanningScheduler.h
+    \brief Runs a Lua function as a coroutine across several frames.
+
+    The function is called with the start time of the frame and the deadline
+    in monotonic seconds. When it runs out of time it calls coroutine.yield(),
+    which returns the start time and deadline of the next frame it is resumed
+    in. The task is finished when the function returns or raises an error.
+*/
+
+// Constructors
+LuaPlanningTask::LuaPlanningTask(lua_State* aL, int priority)
+  : PlanningTask(priority), L(aL), iThread(0), iThreadRef(LUA_NOREF)
+{
+  if (lua_isfunction(L, -1)) {
+    iThread = lua_newthread(L);
+    lua_pushvalue(L, -2);
+    lua_xmove(L, iThread, 1);
+    iThreadRef = luaL_ref(L, LUA_REGISTRYINDEX);
+  }
+  else {
+    luaL_error(L, "Expected a function object but got a '%s'", lua_typename(L, lua_type(L,-1)));
+  }
+}
+
+LuaPlanningTask::~LuaPlanningTask()
+{
+  luaL_unref(L, LUA_REGISTRYINDEX, iThreadRef);
+}
+
+// Operations
+bool LuaPlanningTask::resume(real start_time, real deadline)
+{
+  if (iThread == 0)
+    return true;
+
+  lua_pushnumber(iThread, start_time);
+  lua_pushnumber(iThread, deadline);
+  int status = lua_resume(iThread, 2);
+  if (status == LUA_YIELD) {
+    lua_settop(iThread, 0);
+    return false;
+  }
+  if (status != 0) {
+    cerr << "Error in planning task: "
+         << lua_tostring(iThread, -1) << endl;
+  }
+
+  // Let the thread be collected
+  luaL_unref(L, LUA_REGISTRYINDEX, iThreadRef);
+  iThreadRef = LUA_NOREF;
+  iThread = 0;
+  return true;
+}
+
+/*!
+    \class PlanningScheduler PlanningScheduler.h
+    \brief Runs planning tasks in the time left of each frame.
+
+    Group::doPlanning() plans for one shape per frame regardless of how long
+    that takes. A scheduler instead resumes tasks until the time budget for
+    the frame runs out, so planning uses the slack of each frame. Tasks are
+    resumed by priority, and among tasks of equal priority the one which has
+    waited longest goes first, so all tasks get their turn across frames.
+
+    Time is measured with monotonicSeconds(). Tasks can be added and removed
+    while the scheduler runs, e.g. from a Lua task.
+*/
+
+struct CompareScheduledTasks : public binary_function<ScheduledTask, ScheduledTask, bool>
+{
+  bool operator()(const ScheduledTask& first, const ScheduledTask& second) const {
+    if (first.task->priority() != second.task->priority())
+      return first.task->priority() > second.task->priority();
+    return first.lastRun < second.lastRun;
+  }
+};
+
+static bool isRemoved(const ScheduledTask& t)
+{
+  return t.task == 0;
+}
+
+// Constructors
+/*! \a budget is the default time budget per run in microseconds */
+PlanningScheduler::PlanningScheduler(int budget)
+  : iBudget(budget), iNoRuns(0), iRunning(false)
+{
+}
+
+PlanningScheduler::~PlanningScheduler()
+{
+  clear();
+}
+
+// Accessors
+/*! Default time budget used by run(), in microseconds */
+void PlanningScheduler::setBudget(int microseconds)
+{
+  iBudget = microseconds;
+}
+
+int PlanningScheduler::budget() const
+{
+  return iBudget;
+}
+
+// Request
+uint32 PlanningScheduler::size() const
+{
+  return iTasks.size() - count_if(iTasks.begin(), iTasks.end(), isRemoved);
+}
+
+bool PlanningScheduler::empty() const
+{
+  return size() == 0;
+}
+
+bool PlanningScheduler::contains(PlanningTask* task) const
+{
+  vector<ScheduledTask>::const_iterator it;
+  for (it = iTasks.begin(); it != iTasks.end(); ++it)
+    if (it->task == task)
+      return true;
+  return false;
+}
+
+// Operations
+void PlanningScheduler::add(PlanningTask* task)
+{
+  assert(task != 0);
+  if (contains(task))
+    return;
+  ScheduledTask t = { task, 0 };
+  iTasks.push_back(t);
+  task->retain();
+}
+
+void PlanningScheduler::remove(PlanningTask* task)
+{
+  if (task == 0)
+    return;
+  vector<ScheduledTask>::iterator it;
+  for (it = iTasks.begin(); it != iTasks.end(); ++it) {
+    if (it->task == task) {
+      task->release();
+      if (iRunning)
+        it->task = 0;   // Erased when run finishes
+      else
+        iTasks.erase(it);
+      return;
+    }
+  }
+}
+
+/*! Removes ShapePlanningTask for \a shape */
+void PlanningScheduler::remove(Shape* shape)
+{
+  vector<ScheduledTask>::iterator it;
+  for (it = iTasks.begin(); it != iTasks.end(); ++it) {
+    ShapePlanningTask* task = dynamic_cast<ShapePlanningTask*>(it->task);
+    if (task && task->shape() == shape) {
+      remove(task);
+      return;
+    }
+  }
+}
+
+void PlanningScheduler::clear()
+{
+  vector<ScheduledTask>::iterator it;
+  for (it = iTasks.begin(); it != iTasks.end(); ++it) {
+    if (it->task)
+      it->task->release();
+    it->task = 0;
+  }
+  if (!iRunning)
+    iTasks.clear();
+}
+
+/*! Resumes tasks for the default budget. Returns number of tasks resumed */
+uint32 PlanningScheduler::run(real start_time)
+{
+  return run(start_time, iBudget);
+}
+
+/*!
+  Resumes tasks until \a budget microseconds have passed or every task has
+  been resumed once. Finished tasks are removed. Tasks added while running
+  are first resumed in the next run. While recording or playing back a
+  replay every task is resumed, since which tasks fit in the budget depends
+  on the machine. Returns number of tasks resumed.
+*/
+uint32 PlanningScheduler::run(real start_time, int budget)
+{
+  assert(!iRunning);
+  PROFILE_ZONE("planning");
+  real deadline = monotonicSeconds() + budget*1e-6;
+  bool timed = !World::current()->isDeterministic();
+  ++iNoRuns;
+  stable_sort(iTasks.begin(), iTasks.end(), CompareScheduledTasks());
+
+  iRunning = true;
+  uint32 noResumed = 0;
+  uint32 n = iTasks.size();
+  for (uint32 i = 0; i < n && (!timed || monotonicSeconds() < deadline); ++i) {
+    PlanningTask* task = iTasks[i].task;
+    if (task == 0)
+      continue;
+    iTasks[i].lastRun = iNoRuns;
+    ++noResumed;
+
+    task->retain();   // Task might remove itself
+    bool finished = task->resume(start_time, deadline);
+    if (finished && iTasks[i].task == task) {
+      task->release();
+      iTasks[i].task = 0;
+    }
+    task->release();
+  }
+  iRunning = false;
+
+  iTasks.erase(remove_if(iTasks.begin(), iTasks.end(), isRemoved), iTasks.end());
+  return noResumed;
+}
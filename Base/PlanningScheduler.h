@@ -0,0 +1,113 @@
+/*
+ *  PlanningScheduler.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 21.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+#pragma once
+
+#include "Types.h"
+
+#include <Core/SharedObject.hpp>
+#include <Base/ShapeListener.h>
+
+#include <vector>
+
+class Shape;
+struct lua_State;
+
+class PlanningTask : public SharedObject
+{
+public:
+  // Constructors
+  PlanningTask(int priority = 0);
+  virtual ~PlanningTask();
+
+  // Accessors
+  void setPriority(int priority);
+  int  priority() const;
+
+  // Operations
+  virtual bool resume(real start_time, real deadline) = 0;
+
+private:
+  int iPriority;
+};
+
+class ShapePlanningTask : public PlanningTask, public ShapeListener
+{
+public:
+  // Constructors
+  ShapePlanningTask(Shape* shape, int priority = 0);
+  virtual ~ShapePlanningTask();
+
+  // Accessors
+  Shape* shape() const;
+
+  // Operations
+  bool resume(real start_time, real deadline);
+
+  // Event handling
+  void shapeDestroyed(Shape* shape);
+  void shapeKilled(Shape* shape);
+
+private:
+  Shape* iShape;
+  bool   iAlive;
+};
+
+class LuaPlanningTask : public PlanningTask
+{
+public:
+  // Constructors
+  LuaPlanningTask(lua_State* aL, int priority = 0);
+  virtual ~LuaPlanningTask();
+
+  // Operations
+  bool resume(real start_time, real deadline);
+
+private:
+  lua_State* L;
+  lua_State* iThread;
+  int iThreadRef;
+};
+
+/*! Task in PlanningScheduler with the run it was last resumed in */
+struct ScheduledTask
+{
+  PlanningTask* task;
+  uint32        lastRun;
+};
+
+class PlanningScheduler : public SharedObject
+{
+public:
+  // Constructors
+  PlanningScheduler(int budget = 2000);
+  virtual ~PlanningScheduler();
+
+  // Accessors
+  void setBudget(int microseconds);
+  int  budget() const;
+
+  // Request
+  uint32 size() const;
+  bool   empty() const;
+  bool   contains(PlanningTask* task) const;
+
+  // Operations
+  void   add(PlanningTask* task);
+  void   remove(PlanningTask* task);
+  void   remove(Shape* shape);
+  void   clear();
+  uint32 run(real start_time);
+  uint32 run(real start_time, int budget);
+
+private:
+  std::vector<ScheduledTask> iTasks;
+  int    iBudget;
+  uint32 iNoRuns;
+  bool   iRunning;
+};
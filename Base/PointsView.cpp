@@ -13,7 +13,6 @@
 
 #include <Geometry/Vector2.hpp>
 
-#include <OpenGL/gl.h>
 #include <algorithm>
 
 #include <iostream>
@@ -52,9 +51,9 @@ PointsView::PointsView()
 
 PointsView::~PointsView()
 {
-  cout << hex << "0x" << (int)this << " PointsView removed" << endl;  // DEBUG  
 }
 
+#ifndef HEADLESS
 static void drawPoint(const Point2& p) {
   gltVertex(p);
 }
@@ -72,4 +71,9 @@ void PointsView::draw(const Point2& pos, real rot, int) const
       for_each(iPoints.begin(), iPoints.end(), drawPoint);    
     glEnd();
   glPopMatrix();  
-}
\ No newline at end of file
+}
+#else
+void PointsView::draw(const Point2&, real, int) const
+{
+}
+#endif
\ No newline at end of file
@@ -41,6 +41,7 @@ GLenum PolygonView::drawStyle() const
 }
 
 // Calculations
+#ifndef HEADLESS
 void PolygonView::draw(const Point2& pos, real rot, int) const
 {
   glPushMatrix();
@@ -54,6 +55,11 @@ void PolygonView::draw(const Point2& pos, real rot, int) const
     glEnd();
   glPopMatrix(); 
 }
+#else
+void PolygonView::draw(const Point2&, real, int) const
+{
+}
+#endif
 
 // Operations
 void PolygonView::init( const Polygon2& poly, GLenum style )
@@ -13,7 +13,7 @@
 
 #include <Geometry/Polygon2.hpp>
 
-#include <OpenGL/gl.h>
+#include <Utils/GLUtils.h>
 
 class PolygonView : public View
 {
@@ -11,14 +11,16 @@
 #include <Engine.h>
 #include <Base/Action.h>
 #include <Utils/PolygonUtils.h>
+#include <Utils/Profiler.h>
+#include <Utils/Counters.h>
 #include <Core/Core.h>
+#include "World.h"
 
 #include <iostream>
+#include <cassert>
 
-#ifndef UNIT_TEST
+#if !defined(UNIT_TEST) && !defined(HEADLESS)
 #include "Utils/GLUtils.h"
-
-#include <OpenGL/gl.h>
 #endif
 
 using namespace std;
@@ -55,16 +57,36 @@ Rect2 RectShape2::boundingBox() const
   return iRect;
 }
   
+int RectShape2::noConvexParts() const
+{
+  return 1;
+}
+
+ConvexShape2 RectShape2::convexPart(int i) const
+{
+  assert(i == 0);
+  return ConvexShape2(iRect);
+}
+
 // Request
 bool RectShape2::collide(Shape* other, real t, real dt, CollisionAction* command)
 {
+  COUNT(BROADPHASE_TESTS);
   if (!boundingBox().intersect(other->boundingBox()))
     return false;
   if (!other->isSimple())
     return other->collide(this, t, dt, command);
 
+  PROFILE_ZONE("narrow phase");
+  COUNT(NARROWPHASE_TESTS);
   Points2 points;
-  bool is_colliding = other->intersection(iRect, points);
+  bool is_colliding;
+  if (World::current()->narrowPhase() == GJK_NARROW_PHASE && other->noConvexParts() > 0)
+    is_colliding = convexIntersection(this, other, points);
+  else
+    is_colliding = other->intersection(iRect, points);
+  if (is_colliding)
+    COUNT(CONTACTS);
   if (is_colliding && command != 0) 
     command->execute(this, other, points, t, dt);
   return is_colliding;  
@@ -106,7 +128,7 @@ bool RectShape2::intersection(const Polygon2& poly, Points2& ) const
 */
 void RectShape2::draw(const Rect2& ) const
 {
-#ifndef UNIT_TEST
+#if !defined(UNIT_TEST) && !defined(HEADLESS)
   glBegin(GL_LINES);    
     gltVertex(iRect);
   glEnd();
@@ -11,14 +11,16 @@
 #include <Engine.h>
 #include <Base/Action.h>
 #include <Utils/PolygonUtils.h>
+#include <Utils/Profiler.h>
+#include <Utils/Counters.h>
 #include <Core/Core.h>
+#include "World.h"
 
 #include <iostream>
+#include <cassert>
 
-#ifndef UNIT_TEST
+#if !defined(UNIT_TEST) && !defined(HEADLESS)
 #include "Utils/GLUtils.h"
-
-#include <OpenGL/gl.h>
 #endif
 
 using namespace std;
@@ -55,16 +57,36 @@ Rect2 SegmentShape2::boundingBox() const
   return Rect2(iSeg.left(), iSeg.right());
 }
   
+int SegmentShape2::noConvexParts() const
+{
+  return 1;
+}
+
+ConvexShape2 SegmentShape2::convexPart(int i) const
+{
+  assert(i == 0);
+  return ConvexShape2(iSeg);
+}
+
 // Request
 bool SegmentShape2::collide(Shape* other, real t, real dt, CollisionAction* command)
 {
+  COUNT(BROADPHASE_TESTS);
   if (!boundingBox().intersect(other->boundingBox()))
     return false;
   if (!other->isSimple())
     return other->collide(this, t, dt, command);
 
+  PROFILE_ZONE("narrow phase");
+  COUNT(NARROWPHASE_TESTS);
   Points2 points;
-  bool is_colliding = other->intersection(iSeg, points);
+  bool is_colliding;
+  if (World::current()->narrowPhase() == GJK_NARROW_PHASE && other->noConvexParts() > 0)
+    is_colliding = convexIntersection(this, other, points);
+  else
+    is_colliding = other->intersection(iSeg, points);
+  if (is_colliding)
+    COUNT(CONTACTS);
   if (is_colliding && command != 0) 
     command->execute(this, other, points, t, dt);
   return is_colliding;  
@@ -106,7 +128,7 @@ bool SegmentShape2::intersection(const Polygon2& poly, Points2& ) const
 */
 void SegmentShape2::draw(const Rect2& ) const
 {
-#ifndef UNIT_TEST
+#if !defined(UNIT_TEST) && !defined(HEADLESS)
   glColor3f(1.0f, 0.0f, 0.0f);	
   glBegin(GL_LINES);      
     gltVertex(iSeg);
@@ -27,6 +27,8 @@ public:
   // Accessors
   std::string typeName() const;
   Rect2 boundingBox() const;  
+  int   noConvexParts() const;
+  ConvexShape2 convexPart(int i) const;
     
   // Request
   bool collide(Shape* other, real t, real dt, CollisionAction* command = 0);  
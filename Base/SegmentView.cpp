@@ -11,7 +11,6 @@
 #include "Utils/PolygonUtils.h"
 #include "Utils/GLUtils.h"
 
-#include <OpenGL/gl.h>
 
 #include <algorithm>
 
@@ -48,6 +47,7 @@ bool SegmentView::arrowVisible() const
 
 
 // Operations
+#ifndef HEADLESS
 static void drawSegment(const Segment2& s) {
   gltVertex(s);  
 }
@@ -83,6 +83,11 @@ void SegmentView::draw(const Point2& pos, real rot, int) const
     }
   glPopMatrix(); 
 }
+#else
+void SegmentView::draw(const Point2&, real, int) const
+{
+}
+#endif
 
 // Operations
 void SegmentView::addSegment(const Segment2& aSeg)
@@ -24,6 +24,7 @@
 
 #include <algorithm>
 #include <functional>
+#include <limits>
 
 using namespace std;
 
@@ -45,13 +46,94 @@ using namespace std;
 static int  gNextDepth = 0;
  
 // Helper functions
+/*! 
+  Appends to \a shapes all simple shapes in tree \a root with a bounding box 
+  intersecting \a region. Lets you do one tree query and then test many 
+  polygons against the few shapes found. 
+  
+  Calling boundingBox() also makes sprites update their cached collision 
+  polygon, so it is safe for several threads to call intersection() on the 
+  gathered shapes afterwards.
+*/
+void gatherSimpleShapes(Shape* root, const Rect2& region, vector<Shape*>& shapes)
+{
+  if (!root->boundingBox().intersect(region))
+    return;
+  
+  if (root->isSimple()) {
+    shapes.push_back(root);
+    return;
+  }
+  
+  ShapeIterator* it = root->iterator();
+  for (it->first(); !it->done(); it->next())
+    gatherSimpleShapes(it->value(), region, shapes);  
+}
+
+/*!
+  True if a convex part of \a a overlaps a convex part of \a b, found with GJK.
+  Appends a contact point for each pair of parts that overlap. Each pair is
+  started from the simplex \a a cached for it, if any. Both shapes must have
+  convex parts.
+*/
+bool convexIntersection(const Shape* a, const Shape* b, Points2& points)
+{
+  int na = a->noConvexParts();
+  int nb = b->noConvexParts();
+  assert(na > 0 && nb > 0);
+
+  Rect2 box = b->boundingBox();
+  bool hit = false;
+  for (int i = 0; i < na; ++i) {
+    ConvexShape2 part = a->convexPart(i);
+    Rect2 part_box = part.boundingBox();
+    if (na > 1 && !part_box.intersect(box))
+      continue;
+    for (int j = 0; j < nb; ++j) {
+      ConvexShape2 other_part = b->convexPart(j);
+      if (nb > 1 && !part_box.intersect(other_part.boundingBox()))
+        continue;
+
+      Vector2 normal;
+      real    depth;
+      Point2  point;
+      if (gjkPenetration(part, other_part, normal, depth, point, a->simplexCache(b, i, j))) {
+        points.push_back(point);
+        hit = true;
+      }
+    }
+  }
+  return hit;
+}
+
+/*!
+  Distance from \a convex to the nearest convex part of \a shape, found with
+  GJK. \a closest is set to the nearest point on \a shape if given. Shape
+  must have convex parts.
+*/
+real convexDistance(const Shape* shape, const ConvexShape2& convex, Point2* closest)
+{
+  int n = shape->noConvexParts();
+  assert(n > 0);
+
+  real best = numeric_limits<real>::max();
+  for (int i = 0; i < n; ++i) {
+    Point2 p;
+    real dist = gjkDistance(shape->convexPart(i), convex, 0, &p);
+    if (dist < best) {
+      best = dist;
+      if (closest) *closest = p;
+    }
+  }
+  return best;
+}
 
 // Constructors
 Shape::Shape()
 {
   // This way the last created shapes is always drawn  on top of the
-  // first created ones
-  iDepth = gNextDepth--;  
+  // first created ones. Worlds on other threads create shapes too
+  iDepth = __sync_fetch_and_sub(&gNextDepth, 1);
 }
 
 Shape::~Shape()
@@ -82,6 +164,29 @@ ShapeIterator* Shape::iterator() const
   return &nullIterator;
 }
 
+/*! Number of convex parts the GJK narrow phase can test, 0 if shape has none */
+int Shape::noConvexParts() const
+{
+  return 0;
+}
+
+/*! Convex part \a i of shape. Only valid until the shape moves */
+ConvexShape2 Shape::convexPart(int /*i*/) const
+{
+  assert(false);
+  cerr << "Error: convexPart() not supported for this class" << endl;
+  return ConvexShape2();
+}
+
+/*! 
+  Simplex left by GJK when part \a part of this shape was last tested against
+  part \a otherPart of \a other. 0 if shape does not keep simplices.
+*/
+SimplexCache2* Shape::simplexCache(const Shape* /*other*/, int /*part*/, int /*otherPart*/) const
+{
+  return 0;
+}
+
 void Shape::setDepth(int aDepth)
 {
 	iDepth = aDepth;
@@ -107,7 +212,7 @@ bool Shape::isSimple() const
   on subclasses which define a simple shape. Hierarcical structures
   should return false as well as they should not handle this intersection test.
 */
-bool Shape::intersection(const Circle& c, Points2& points) const
+bool Shape::intersection(const Circle& /*c*/, Points2& /*points*/) const
 {
   assert(false);
   cerr << "Error: intersect(const Circle& c) not supported for this class" << endl;
@@ -122,7 +227,7 @@ bool Shape::intersection(const Circle& c, Points2& points) const
   should return false as well as they should not handle this intersection test.
 */
 
-bool Shape::intersection(const Rect2& r, Points2& points) const
+bool Shape::intersection(const Rect2& /*r*/, Points2& /*points*/) const
 {
   assert(false);  
   cerr << "Error: intersect(const Rect2& r) not supported for this class" << endl;  
@@ -136,14 +241,14 @@ bool Shape::intersection(const Rect2& r, Points2& points) const
   on subclasses which define a simple shape. Hierarcical structures
   should return false as well as they should not handle this intersection test.
 */
-bool Shape::intersection(const Segment2& s, Points2& points) const
+bool Shape::intersection(const Segment2& /*s*/, Points2& /*points*/) const
 {
   assert(false);  
   cerr << "Error: intersect(const Segment2& s) not supported for this class" << endl;    
   return false;  
 }
 
-bool Shape::intersection(const Polygon2& poly, Points2& points) const
+bool Shape::intersection(const Polygon2& /*poly*/, Points2& /*points*/) const
 {
   assert(false);  
   cerr << "Error: intersect(const Polygon2& poly, points) not supported for this class" << endl;    
@@ -155,18 +260,18 @@ bool Shape::intersection(const Polygon2& poly, Points2& points) const
   to be outside \a r then code does not need to draw object. This is a performance measure.
   Default implementation is to do nothing (draw nothing).
 */
-void Shape::draw(const Rect2& r) const
+void Shape::draw(const Rect2& /*r*/) const
 {
   
 }
 
 // Operations
-void Shape::addKid(Shape* shape)
+void Shape::addKid(Shape* /*shape*/)
 {
   // Do nothing
 }
 
-void Shape::removeKid(Shape* shape)
+void Shape::removeKid(Shape* /*shape*/)
 {
   // Do nothing  
 }
@@ -178,7 +283,7 @@ void Shape::removeKid(Shape* shape)
   Default implementation doesn't do anythning since some objects might
   be static and not moveable.
 */
-void Shape::update(real start_time, real delta_time)
+void Shape::update(real /*start_time*/, real /*delta_time*/)
 {
   // Do nothing
 }
@@ -194,7 +299,7 @@ void Shape::update(real start_time, real delta_time)
   If you implement your own collide method in a subclass, you should call 
   handleCollision on each involved shape to let the shape handle the collision. 
 */
-void Shape::handleCollision(Shape* other, Points2& points, real start_time, real delta_time)
+void Shape::handleCollision(Shape* /*other*/, Points2& /*points*/, real /*start_time*/, real /*delta_time*/)
 {
   // Do nothing
 }
@@ -206,7 +311,7 @@ void Shape::handleCollision(Shape* other, Points2& points, real start_time, real
   
   Default implementation is to do nothing. 
 */
-void Shape::doPlanning(real start_time, real delta_time)
+void Shape::doPlanning(real /*start_time*/, real /*delta_time*/)
 {
   // Do nothing
 }
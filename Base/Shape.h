@@ -24,6 +24,7 @@
 #include <Geometry/Circle.hpp>
 #include <Geometry/Segment2.hpp>
 #include <Geometry/Polygon2.hpp>
+#include <Geometry/Gjk2.hpp>
 
 #include <Core/SharedObject.hpp>
 
@@ -31,9 +32,16 @@
 #include <Base/ShapeListener.h>
 
 #include <set>
+#include <vector>
 
 class CollisionAction;
 class Action;
+class Shape;
+
+// Functions
+void gatherSimpleShapes(Shape* root, const Rect2& region, std::vector<Shape*>& shapes);
+bool convexIntersection(const Shape* a, const Shape* b, Points2& points);
+real convexDistance(const Shape* shape, const ConvexShape2& convex, Point2* closest = 0);
 
 class Shape : public SharedObject
 {
@@ -47,6 +55,9 @@ public:
   virtual Rect2 boundingBox() const = 0;  
   virtual int   noShapes() const;  
   virtual ShapeIterator* iterator() const;
+  virtual int   noConvexParts() const;
+  virtual ConvexShape2 convexPart(int i) const;
+  virtual SimplexCache2* simplexCache(const Shape* other, int part, int otherPart) const;
 
 	void setDepth(int aDepth);
 	int depth() const;
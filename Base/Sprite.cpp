@@ -25,7 +25,10 @@
 #include "Utils/Algorithms.h"
 #include "Types.h"
 #include "Utils/PolygonUtils.h"
+#include "Utils/Profiler.h"
+#include "Utils/Counters.h"
 #include "Timing.h"
+#include "World.h"
 
 #ifndef UNIT_TEST
 #include <Utils/GLUtils.h>
@@ -71,7 +74,6 @@ Sprite::Sprite(const Point2& aPos, real aDeg, real aSpeed)
 
 Sprite::~Sprite()
 {
-  cout << hex << "0x" << (int)this << " sprite removed" << endl;  // DEBUG  
   iUpdateAction->release();
   iCollisionAction->release();
   iInsideAction->release();
@@ -90,6 +92,7 @@ void Sprite::init(const Point2& pos, real deg, real speed)
   iVisible = true;
   iName = "noname";
   iPolygon = Polygon2(gPoints, gPoints+4); 
+  iUpdateStep = 0;
 
   iState = new MotionState(pos, deg, speed);
 
@@ -118,6 +121,7 @@ void Sprite::setPosition(const Point2& aPosition)
 {
   iPrevPosition = iState->position();  
   iState->setPosition(aPosition);
+  iUpdateStep = 0;  // Jumps are not interpolated
   touch(); // indicate that collison poly needs to be recalculated
 }
 
@@ -231,6 +235,69 @@ const Polygon2& Sprite::collisionPolygon() const
   return iPolygon;
 }
 
+/*! Convex parts of collision polygon, empty if it is convex. \see View::collisionParts */
+const Polygons2& Sprite::collisionParts() const
+{
+  if (iNeedUpdate) {
+    updateCache();
+  }
+  return iParts;
+}
+
+/*! One part per convex part of collision polygon, or the whole polygon if it is convex */
+int Sprite::noConvexParts() const
+{
+  const Polygons2& parts = collisionParts();
+  return parts.empty() ? 1 : parts.size();
+}
+
+ConvexShape2 Sprite::convexPart(int i) const
+{
+  const Polygons2& parts = collisionParts();
+  if (parts.empty()) {
+    assert(i == 0);
+    return ConvexShape2(iPolygon);
+  }
+  return ConvexShape2(parts[i]);
+}
+
+/*!
+  Keeps a simplex for each pair of parts tested this step or the step before.
+  Older ones are dropped, so pairs which stop overlapping in the broad phase
+  are forgotten. Only pairs of sprites are kept, other shapes are usually
+  static or made for a single query, often on a worker thread.
+*/
+SimplexCache2* Sprite::simplexCache(const Shape* other, int part, int otherPart) const
+{
+  if (dynamic_cast<const Sprite*>(other) == 0)
+    return 0;
+    
+  uint32 step = World::current()->noSteps();
+  PairSimplex* found = 0;
+  for (uint32 i = 0; i < iSimplices.size(); ) {
+    PairSimplex& pair = iSimplices[i];
+    if (pair.step + 1 < step) {
+      pair = iSimplices.back();
+      iSimplices.pop_back();
+      continue;
+    }
+    if (pair.other == other && pair.part == part && pair.otherPart == otherPart)
+      found = &pair;
+    ++i;
+  }
+  
+  if (found == 0) {
+    PairSimplex pair;
+    pair.other = other;
+    pair.part = part;
+    pair.otherPart = otherPart;
+    iSimplices.push_back(pair);
+    found = &iSimplices.back();
+  }
+  found->step = step;
+  return &found->cache;
+}
+
 void Sprite::setView(View* aView)
 {
   if (iView != aView) {
@@ -361,13 +428,32 @@ bool Sprite::collide(Shape* other, real t, real dt, CollisionAction* command)
 {
   assert( other != 0);
   
+  COUNT(BROADPHASE_TESTS);
   if (!boundingBox().intersect(other->boundingBox()))
     return false;
   if (!other->isSimple())
     return other->collide(this, t, dt, command);
 
+  PROFILE_ZONE("narrow phase");
+  COUNT(NARROWPHASE_TESTS);
+  // GJK tests convex parts of both shapes. Otherwise other sprites test
+  // polygons with separating axes, which needs convex parts, while other
+  // shapes test against the edges, which works for any polygon
+  const Polygons2& parts = collisionParts();
   Points2 points; // Intersection points  
-  if (other->intersection(collisionPolygon(), points)) {
+  bool hit = false;
+  if (World::current()->narrowPhase() == GJK_NARROW_PHASE && other->noConvexParts() > 0)
+    hit = convexIntersection(this, other, points);
+  else if (parts.empty() || dynamic_cast<Sprite*>(other) == 0)
+    hit = other->intersection(collisionPolygon(), points);
+  else {
+    Rect2 box = other->boundingBox();
+    for (uint32 i = 0; i < parts.size(); ++i)
+      if (iPartBoxes[i].intersect(box) && other->intersection(parts[i], points))
+        hit = true;
+  }
+  if (hit) {
+    COUNT(CONTACTS);
     if (command) command->execute(this, other, points, t, dt);
     else {
       handleCollision(other, points, t, dt);
@@ -384,7 +470,12 @@ bool Sprite::inside(const Point2& p, real t, real dt,  Action* command)
   if (!boundingBox().inside(p))
     return false;
       
-  bool is_inside = collisionPolygon().inside(p);
+  const Polygons2& parts = collisionParts();
+  bool is_inside = false;
+  if (parts.empty())
+    is_inside = collisionPolygon().inside(p);
+  for (uint32 i = 0; i < parts.size() && !is_inside; ++i)
+    is_inside = iPartBoxes[i].inside(p) && parts[i].inside(p);
   if (is_inside && command != 0)
     command->execute(this, t, dt);
   else if (is_inside && iInsideAction != 0)
@@ -405,7 +496,7 @@ bool Sprite::intersection(const Circle& c, Points2& points) const
   Does not return intersection points.
   \return true if we have an intersection
 */
-bool Sprite::intersection(const Rect2& r, Points2& points) const
+bool Sprite::intersection(const Rect2& r, Points2& /*points*/) const
 {
   return collisionPolygon().intersect(r);  
 }
@@ -414,28 +505,46 @@ bool Sprite::intersection(const Rect2& r, Points2& points) const
   Does not return intersection points.
   \return true if we have an intersection
 */
-bool Sprite::intersection(const Segment2& s, Points2& points) const
+bool Sprite::intersection(const Segment2& s, Points2& /*points*/) const
 {
   return collisionPolygon().intersect(s);  
 }
 
 /*!
+  Tested with separating axes, so a concave sprite tests its convex parts
+  overlapping \a poly instead, which must be convex.
+  
   \param points this is not actually used.
   \todo add code to return intersected points
 */
-bool Sprite::intersection(const Polygon2& poly, Points2& points) const
-{
-
-  return collisionPolygon().intersect(poly);  
+bool Sprite::intersection(const Polygon2& poly, Points2& /*points*/) const
+{
+  const Polygons2& parts = collisionParts();
+  if (parts.empty())
+    return collisionPolygon().intersect(poly);  
+  Rect2 box = poly.boundingBox();
+  for (uint32 i = 0; i < parts.size(); ++i)
+    if (iPartBoxes[i].intersect(box) && parts[i].intersect(poly))
+      return true;
+  return false;
 }
 
 /*!
-  Draws sprite if it is visible and has a view intersecting \a r
+  Draws sprite if it is visible and has a view intersecting \a r.
+  
+  If sprite was updated in the last step of its world, it is drawn between
+  its previous and current position as given by renderInterpolation(), so
+  motion is smooth when frames are rendered more often than the game is
+  updated.
 */
 void Sprite::draw(const Rect2& r) const
 {  
-	if (iVisible && iView != 0 && r.intersect(boundingBox()))
-    iView->draw(position(), rotation(), iCurSubViewIndex);
+	if (iVisible && iView != 0 && r.intersect(boundingBox())) {
+    Point2 pos = position();
+    if (iUpdateStep != 0 && iUpdateStep == World::current()->noSteps())
+      pos = iPrevPosition + (pos-iPrevPosition)*renderInterpolation();
+    iView->draw(pos, rotation(), iCurSubViewIndex);
+  }
 }
 
 #pragma mark Operations
@@ -452,6 +561,7 @@ bool Sprite::touched() const
 void Sprite::update(real start_time, real delta_time)
 {
   iPrevPosition = position();  
+  iUpdateStep = World::current()->noSteps()+1;  // Step counted once it finishes
   advance(delta_time);
   touch();
   
@@ -466,11 +576,18 @@ void Sprite::advance(real dt)
   iState->advance(dt);
 }
 
-/*! Call when view changes */
+/*!
+  Call when view changes. Concave views have convex parts, each with its
+  own bounding box, so only parts overlapping the other shape are tested.
+*/
 void Sprite::updateCache() const
 {
   iState->getCollisionPolygon(iView, iPolygon);
   iBBox = iPolygon.boundingBox();
+  iState->getCollisionParts(iView, iParts);
+  iPartBoxes.resize(iParts.size());
+  for (uint32 i = 0; i < iParts.size(); ++i)
+    iPartBoxes[i] = iParts[i].boundingBox();
   iNeedUpdate = false;
 }
 
@@ -77,6 +77,10 @@ public:
   
   const Polygon2& collisionPolygon() const;
   Polygon2& collisionPolygon();   
+  const Polygons2& collisionParts() const;
+  int   noConvexParts() const;
+  ConvexShape2 convexPart(int i) const;
+  SimplexCache2* simplexCache(const Shape* other, int part, int otherPart) const;
   
   void  setView(View* aView);
   View* view();
@@ -135,6 +139,15 @@ private:
   void  updateCache() const;
   
 private:
+  /*! GJK simplex of a pair of parts, see simplexCache() */
+  struct PairSimplex
+  {
+    const Shape*  other;
+    int           part, otherPart;
+    uint32        step;     // World::noSteps() when last used
+    SimplexCache2 cache;
+  };
+  
   std::string  iName;
 	bool	  iVisible;
 	View*   iView;
@@ -148,8 +161,12 @@ private:
   
   // Cached values
   Point2              iPrevPosition;
+  uint32              iUpdateStep;  // World::noSteps() when last updated
   MotionState*        iState;
   mutable Polygon2    iPolygon;     // Collision polygon
   mutable bool        iNeedUpdate;  // indicate whether collision poly needs update
   mutable Rect2       iBBox;        // Bounding box
+  mutable Polygons2   iParts;       // Convex parts of collision polygon, empty if it is convex
+  mutable std::vector<Rect2> iPartBoxes;  // Bounding box of each part
+  mutable std::vector<PairSimplex> iSimplices;  // Of pairs tested last and this step
 };
\ No newline at end of file
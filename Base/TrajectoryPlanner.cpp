@@ -0,0 +1,357 @@
+/*
+ *  TrajectoryPlanner.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 16.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+#include "Base/TrajectoryPlanner.h"
+#include "Base/TrajectoryTable.h"
+#include "Base/MotionState.h"
+#include "Base/Shape.h"
+#include "Base/View.h"
+#include "Geometry/Polygon2.hpp"
+#include "Utils/PolygonUtils.h"
+#include "Timing.h"
+#include "World.h"
+
+#include <queue>
+#include <cmath>
+#include <cassert>
+
+using namespace std;
+
+/*!
+    \class TrajectoryPlanner TrajectoryPlanner.h
+    \brief Kinodynamic planner searching a tree of precomputed trajectories.
+
+    Native version of Geometry.rrtSearch() in script/rrt.lua. Expanding a state
+    gives one successor per trajectory in TrajectoryTable starting with the 
+    angular velocity of the state. The candidate with best effective value 
+    is expanded next. Candidates are kept in a priority queue and states are
+    kept in a pool referring to their parent by index. 
+    
+    All successors of a state are checked for collision in one call to
+    TrajectoryTable::sweepCollisions(), which sweeps the collision polygon
+    of the view along each trajectory rather than only testing end states.
+    
+    Value of a state is accumulated like in Geometry.makeEval():
+    
+      value(s) = value(parent) + goodness(parent, s)*discount^(depth-1)
+      effective(s) = value(s) + optimism*discount^depth/(1-discount)
+      
+    Search stops when 'max_depth' is reached everywhere or time runs out.
+*/
+
+// PlanState
+Direction2 PlanState::direction() const
+{
+  return Vector2(rad(rotation));
+}
+
+// Goodness functions
+SeekGoodness::SeekGoodness(const Point2& target) : iTarget(target)
+{
+}
+
+/*! Same as function returned from Geometry.makeSeek() */
+real SeekGoodness::goodness(const PlanState& s0, const PlanState& s1) const
+{
+  Vector2 dir_target = (iTarget-s1.position).unit();
+  Vector2 dir_path = (s1.position-s0.position).unit();
+  return 0.25*(1.0 + s1.direction().dot(dir_target))*(1.0 + dir_path.dot(dir_target));
+}
+
+FlankGoodness::FlankGoodness(const Point2& enemy_pos, const Direction2& enemy_dir, real distance)
+  : iEnemyPos(enemy_pos), iEnemyDir(enemy_dir), iDistance(distance)
+{
+}
+
+/*! Same as function returned from Geometry.makeFlank() */
+real FlankGoodness::goodness(const PlanState&, const PlanState& s1) const
+{
+  Vector2 d = iEnemyPos-s1.position;
+  if (d.length() > iDistance)
+    return 0.0;
+  return 0.5*(1.0 + iEnemyDir.dot(d.unit()));
+}
+
+real AvoidCollisionGoodness::goodness(const PlanState&, const PlanState& s1) const
+{
+  return s1.collides ? -1.0 : 0.0;
+}
+
+CombinedGoodness::CombinedGoodness() : iTotalWeight(0.0)
+{
+}
+
+CombinedGoodness::~CombinedGoodness()
+{
+  for (size_t i = 0; i < iBehaviors.size(); ++i)
+    iBehaviors[i].second->release();
+}
+
+/*! Weighted average of all added goodness functions */
+real CombinedGoodness::goodness(const PlanState& s0, const PlanState& s1) const
+{
+  if (iTotalWeight == 0.0)
+    return 0.0;
+    
+  real sum = 0.0;
+  for (size_t i = 0; i < iBehaviors.size(); ++i)
+    sum += iBehaviors[i].first*iBehaviors[i].second->goodness(s0, s1);
+  return sum/iTotalWeight;
+}
+
+void CombinedGoodness::add(real weight, PlanGoodness* goodness)
+{
+  assert(goodness != 0);
+  goodness->retain();
+  iBehaviors.push_back(make_pair(weight, goodness));
+  iTotalWeight += weight;
+}
+
+// Constructors
+TrajectoryPlanner::TrajectoryPlanner(TrajectoryTable* table, View* view, Shape* obstacles)
+  : iTable(table), iView(view), iObstacles(obstacles), iGoodness(0), 
+    iDiscount(0.5), iOptimism(0.0), iMaxExpansions(64), iNoExpanded(0)
+{
+  assert(table != 0);
+  iTable->retain();
+  if (iView) iView->retain();
+  if (iObstacles) iObstacles->retain();
+}
+
+TrajectoryPlanner::~TrajectoryPlanner()
+{
+  iTable->release();
+  if (iView) iView->release();
+  if (iObstacles) iObstacles->release();
+  if (iGoodness) iGoodness->release();
+}
+
+// Accessors
+std::string TrajectoryPlanner::typeName() const
+{
+  return "TrajectoryPlanner";
+}
+
+void TrajectoryPlanner::setGoodness(PlanGoodness* goodness)
+{
+  if (goodness != iGoodness) {
+    if (iGoodness) iGoodness->release();
+    iGoodness = goodness;
+    if (iGoodness) iGoodness->retain();
+  }
+}
+
+PlanGoodness* TrajectoryPlanner::goodness() const
+{
+  return iGoodness;
+}
+
+void TrajectoryPlanner::setObstacles(Shape* obstacles)
+{
+  if (obstacles != iObstacles) {
+    if (iObstacles) iObstacles->release();
+    iObstacles = obstacles;
+    if (iObstacles) iObstacles->retain();
+  }
+}
+
+/*! View whose collision polygon is checked against obstacles */
+void TrajectoryPlanner::setView(View* view)
+{
+  if (view != iView) {
+    if (iView) iView->release();
+    iView = view;
+    if (iView) iView->retain();
+  }
+}
+
+void TrajectoryPlanner::setDiscount(real discount)
+{
+  assert(discount > 0.0 && discount < 1.0);
+  iDiscount = discount;
+}
+
+real TrajectoryPlanner::discount() const
+{
+  return iDiscount;
+}
+
+void TrajectoryPlanner::setOptimism(real optimism)
+{
+  iOptimism = optimism;
+}
+
+real TrajectoryPlanner::optimism() const
+{
+  return iOptimism;
+}
+
+/*!
+  Number of states expanded per search while the world records or plays
+  back a replay, see World::isDeterministic(). A time limit would make the
+  search depend on how fast the machine is, so the replay would not repeat.
+*/
+void TrajectoryPlanner::setMaxExpansions(int n)
+{
+  assert(n > 0);
+  iMaxExpansions = n;
+}
+
+int TrajectoryPlanner::maxExpansions() const
+{
+  return iMaxExpansions;
+}
+
+/*! All states visited in last search. First state is root */
+const PlanStates& TrajectoryPlanner::states() const
+{
+  return iStates;
+}
+
+int TrajectoryPlanner::noExpanded() const
+{
+  return iNoExpanded;
+}
+
+// Calculations
+/*!
+  Search for best path from \a s0. Stops when all states up to \a max_depth
+  have been expanded or when \a delta_time seconds have passed. The time
+  limit is measured with monotonicSeconds() from the call, since \a start_time
+  is simulation time when called from a step. While recording or playing
+  back a replay maxExpansions() states are expanded instead.
+  Best path is put in \a path, not including \a s0.
+  \return false if no state better than \a s0 was found.
+*/
+bool TrajectoryPlanner::plan(const MotionState& s0, int max_depth, real, real delta_time, PlanStates& path)
+{
+  typedef pair<real, int> Candidate;
+  priority_queue<Candidate> candidates;
+  
+  iStates.clear();
+  iNoExpanded = 0;
+  
+  PlanState root;
+  root.position = s0.position();
+  root.rotation = s0.rotation();
+  root.angVelocity = s0.angularVelocity();
+  root.angAcceleration = s0.angularAcceleration();
+  root.parent = -1;
+  root.depth = 0;
+  root.value = 0.0;
+  root.collides = false;
+  iStates.push_back(root);
+  candidates.push(Candidate(0.0, 0));
+  
+  int  best = 0;
+  real best_value = 0.0;
+  real end_time = monotonicSeconds()+delta_time;
+  bool timed = !World::current()->isDeterministic();
+  
+  while (!candidates.empty() &&
+         (timed ? monotonicSeconds() < end_time : iNoExpanded < iMaxExpansions)) {
+    int index = candidates.top().second;
+    candidates.pop();
+    if (iStates[index].depth >= max_depth)
+      continue;
+      
+    int first = iStates.size();
+    expand(index);
+    
+    for (int i = first; i < int(iStates.size()); ++i) {
+      real value = evaluate(iStates[i]);
+      candidates.push(Candidate(value, i));
+      if (value > best_value) {
+        best_value = value;
+        best = i;
+      }
+    }
+  }
+  
+  path.clear();
+  for (int i = best; i > 0; i = iStates[i].parent)
+    path.push_back(iStates[i]);
+  reverse(path.begin(), path.end());
+  
+  return !path.empty();
+}
+
+void TrajectoryPlanner::getMotionState(const PlanState& s, MotionState& state) const
+{
+  state.setPosition(s.position);
+  state.setRotation(s.rotation);
+  state.setAngularVelocity(s.angVelocity);
+  state.setAngularAcceleration(s.angAcceleration);
+  state.setSpeed(iTable->speed());
+}
+
+// Private
+/*! Sets value of \a s and returns its effective value */
+real TrajectoryPlanner::evaluate(PlanState& s) const
+{
+  const PlanState& parent = iStates[s.parent];
+  real g = iGoodness != 0 ? iGoodness->goodness(parent, s) : 0.0;
+  s.value = parent.value + g*pow(iDiscount, s.depth-1);
+  return s.value + iOptimism*pow(iDiscount, s.depth)/(1.0-iDiscount);
+}
+
+/*! Add all successors of state at \a index to pool */
+void TrajectoryPlanner::expand(int index)
+{
+  ++iNoExpanded;
+  PlanState parent = iStates[index]; // Copy since pool may be reallocated
+  
+  real a = rad(parent.rotation);
+  real c = cos(a), s = sin(a);
+  int  n = iTable->size();
+  const Trajectory* trajs = iTable->trajectories(parent.angVelocity);
+  
+  int first = iStates.size();
+  for (int i = 0; i < n; ++i) {
+    const Trajectory& t = trajs[i];
+    PlanState succ;
+    succ.position = parent.position + Vector2(c*t.position.x()-s*t.position.y(), s*t.position.x()+c*t.position.y());
+    succ.rotation = parent.rotation + t.rotation;
+    succ.angVelocity = t.angVelocity;
+    succ.angAcceleration = t.angAcceleration;
+    succ.parent = index;
+    succ.depth = parent.depth+1;
+    succ.value = 0.0;
+    succ.collides = false;
+    iStates.push_back(succ);
+  }
+  
+  checkCollisions(parent, first);
+}
+
+/*! 
+  Collision check trajectories from \a parent to states added from \a first,
+  sweeping collision polygon along each of them in one call.
+*/
+void TrajectoryPlanner::checkCollisions(const PlanState& parent, int first)
+{
+  if (iView == 0 || iObstacles == 0 || iView->collisionPolygon().size() == 0)
+    return;
+    
+  MotionState s0;
+  s0.setPosition(parent.position);
+  s0.setRotation(parent.rotation);
+  s0.setAngularVelocity(parent.angVelocity);
+  
+  // View keeps the convex parts of a concave polygon, so they are not found
+  // again for every expansion. A convex polygon is its own single part
+  const Polygons2* parts = &iView->collisionParts();
+  if (parts->empty()) {
+    iConvexParts.resize(1);
+    iConvexParts[0] = iView->collisionPolygon();
+    parts = &iConvexParts;
+  }
+  iTable->sweepCollisions(s0, *parts, iObstacles, iHitTimes);
+  for (int i = first; i < int(iStates.size()); ++i)
+    iStates[i].collides = iHitTimes[i-first] != REAL_MAX;
+}
@@ -0,0 +1,141 @@
+/*
+ *  TrajectoryPlanner.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 16.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+#pragma once
+
+#include "Types.h"
+
+#include <Core/SharedObject.hpp>
+#include <Geometry/Polygon2.hpp>
+
+#include <vector>
+
+class MotionState;
+class TrajectoryTable;
+class Shape;
+class View;
+
+/*! State in search tree. Kept in a pool and refers to parent by index */
+struct PlanState
+{
+  Point2  position;
+  real    rotation;
+  real    angVelocity;
+  real    angAcceleration;
+  
+  int     parent;   // Index of parent in pool, -1 for root
+  int     depth;
+  real    value;    // Accumulated discounted goodness from root
+  bool    collides; // True if sprite collides with obstacles in this state
+  
+  Direction2 direction() const;
+};
+
+typedef std::vector<PlanState> PlanStates;
+
+/*! 
+  Evaluates goodness of moving from state \a s0 to \a s1. Should be in range [-1, 1].
+  Subclass to plug in new behaviors.
+*/
+class PlanGoodness : public SharedObject
+{
+public:
+  virtual real goodness(const PlanState& s0, const PlanState& s1) const = 0;
+};
+
+class SeekGoodness : public PlanGoodness
+{
+public:
+  SeekGoodness(const Point2& target);
+  real goodness(const PlanState& s0, const PlanState& s1) const;
+  
+private:
+  Point2 iTarget;
+};
+
+class FlankGoodness : public PlanGoodness
+{
+public:
+  FlankGoodness(const Point2& enemy_pos, const Direction2& enemy_dir, real distance);
+  real goodness(const PlanState& s0, const PlanState& s1) const;
+  
+private:
+  Point2      iEnemyPos;
+  Direction2  iEnemyDir;
+  real        iDistance;
+};
+
+class AvoidCollisionGoodness : public PlanGoodness
+{
+public:
+  real goodness(const PlanState& s0, const PlanState& s1) const;
+};
+
+class CombinedGoodness : public PlanGoodness
+{
+public:
+  // Constructors
+  CombinedGoodness();
+  virtual ~CombinedGoodness();
+  
+  // Calculations
+  real goodness(const PlanState& s0, const PlanState& s1) const;
+  
+  // Operations
+  void add(real weight, PlanGoodness* goodness);
+  
+private:
+  std::vector<std::pair<real, PlanGoodness*> > iBehaviors;
+  real iTotalWeight;
+};
+
+class TrajectoryPlanner : public SharedObject
+{
+public:
+  // Constructors
+  TrajectoryPlanner(TrajectoryTable* table, View* view, Shape* obstacles);
+  virtual ~TrajectoryPlanner();
+  
+  // Accessors
+  std::string typeName() const;
+  void  setGoodness(PlanGoodness* goodness);
+  PlanGoodness* goodness() const;
+  void  setObstacles(Shape* obstacles);
+  void  setView(View* view);
+  void  setDiscount(real discount);
+  real  discount() const;
+  void  setOptimism(real optimism);
+  real  optimism() const;
+  void  setMaxExpansions(int n);
+  int   maxExpansions() const;
+  
+  const PlanStates& states() const;
+  int   noExpanded() const;
+  
+  // Calculations
+  bool  plan(const MotionState& s0, int max_depth, real start_time, real delta_time, PlanStates& path);
+  void  getMotionState(const PlanState& s, MotionState& state) const;
+  
+private:
+  real  evaluate(PlanState& s) const;
+  void  expand(int index);
+  void  checkCollisions(const PlanState& parent, int first);
+  
+private:
+  TrajectoryTable*  iTable;
+  View*             iView;
+  Shape*            iObstacles;
+  PlanGoodness*     iGoodness;
+  real              iDiscount, iOptimism;
+  int               iMaxExpansions;
+  
+  PlanStates        iStates;      // Pool of all states visited in last search
+  int               iNoExpanded;
+  std::vector<real> iHitTimes;
+  Polygons2         iConvexParts; // Collision polygon of a convex view
+};
@@ -0,0 +1,426 @@
+/*
+ *  TrajectoryTable.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 16.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+#include "Base/TrajectoryTable.h"
+#include "Base/MotionState.h"
+#include "Base/Shape.h"
+#include "Geometry/Polygon2.hpp"
+#include "Utils/PolygonUtils.h"
+#include "Utils/Parallel.h"
+#include "Utils/MappedFile.h"
+
+#include <cmath>
+#include <cassert>
+#include <cstring>
+#include <cstdio>
+
+using namespace std;
+
+/*!
+    \class TrajectoryTable TrajectoryTable.h
+    \brief Precomputed trajectories for every pair of start and end angular velocity.
+
+    Native version of Geometry.createTrajectories() in script/rrt.lua. Angular 
+    velocities from 'angvel_min' to 'angvel_max' are split into 'angvel_steps' 
+    intervals. For each pair of start and end angular velocity a motion state is 
+    integrated over 'steps' steps of 'dt' seconds, with the constant angular 
+    acceleration needed to go from start to end angular velocity.
+    
+    Trajectories are stored in a dense array so finding all trajectories 
+    for a given start angular velocity is a constant time lookup. Besides the 
+    end state, the pose after every integration step is stored so the area 
+    swept by a sprite following a trajectory can be found without integrating.
+    
+    Rows are built in parallel. A built table can be saved to a binary file 
+    with save() and memory mapped back with load(), so no integration is done 
+    at startup. The file stores native doubles and is meant as a cache on the 
+    machine that wrote it, not as a portable format.
+*/
+
+static const char  gMagic[4] = {'L', 'T', 'R', 'J'};
+static const int   gVersion = 1;
+
+/*! Layout of file header. Followed by trajectories and then samples */
+struct TrajectoryFileHeader
+{
+  char  magic[4];
+  int   version;
+  int   trajectorySize;   // sizeof(Trajectory) and sizeof(TrajectorySample) of writer
+  int   sampleSize;
+  int   size;
+  int   steps;
+  real  angvelMin;
+  real  angvelDelta;
+  real  dt;
+  real  speed;
+};
+
+/*! Integrates all trajectories starting with a given angular velocity */
+class BuildRowsTask : public RangeTask
+{
+public:
+  BuildRowsTask(const TrajectoryTable& table, Trajectory* trajs, TrajectorySample* samples)
+    : iTable(table), iTrajs(trajs), iSamples(samples) {}
+    
+  void run(int begin, int end)
+  {
+    int  n = iTable.size();
+    int  steps = iTable.noSteps();
+    real dt = iTable.timeStep();
+    real t = iTable.duration();
+    
+    for (int i = begin; i < end; ++i) {
+      for (int j = 0; j < n; ++j) {
+        real angvel_start = iTable.angularVelocity(i);
+        real angvel_end = iTable.angularVelocity(j);
+        
+        MotionState s;
+        s.setSpeed(iTable.speed());
+        s.setAngularVelocity(angvel_start);
+        s.setAngularAcceleration((angvel_end-angvel_start)/t);
+        
+        TrajectorySample* sample = iSamples+(i*n+j)*(steps+1);
+        for (int k = 0; k <= steps; ++k, ++sample) {
+          if (k > 0) 
+            s.advance(dt);
+          sample->position = s.position();
+          sample->rotation = s.rotation();
+        }
+        
+        Trajectory& traj = iTrajs[i*n+j];
+        traj.position = s.position();
+        traj.rotation = s.rotation();
+        traj.angVelocity = s.angularVelocity();
+        traj.angAcceleration = s.angularAcceleration();
+      }
+    }
+  }
+  
+private:
+  const TrajectoryTable&  iTable;
+  Trajectory*             iTrajs;
+  TrajectorySample*       iSamples;
+};
+
+// Constructors
+TrajectoryTable::TrajectoryTable()
+  : iSize(0), iDt(0.0), iSteps(0), iSpeed(0.0), iTrajectories(0), iSamples(0), iFile(0)
+{
+}
+
+TrajectoryTable::TrajectoryTable(const MotionState& s0, real angvel_min, real angvel_max, int angvel_steps, real dt, int steps)
+  : iDt(dt), iSteps(steps), iSpeed(s0.speed()), iFile(0)
+{
+  assert(angvel_steps > 0 && steps > 0);
+  setAngularVelocities(angvel_min, (angvel_max-angvel_min)/angvel_steps, angvel_steps+1);
+  
+  iBuiltTrajectories.resize(iSize*iSize);
+  iBuiltSamples.resize(iSize*iSize*noSamples());
+  
+  BuildRowsTask task(*this, &iBuiltTrajectories[0], &iBuiltSamples[0]);
+  parallelFor(0, iSize, task);
+  
+  iTrajectories = &iBuiltTrajectories[0];
+  iSamples = &iBuiltSamples[0];
+}
+
+TrajectoryTable::~TrajectoryTable()
+{
+  delete iFile;
+}
+
+/*! 
+  Load table saved with save(). Returns 0 if file is missing or was not 
+  written by a compatible version of the engine. Data is memory mapped, 
+  not copied.
+*/
+TrajectoryTable* TrajectoryTable::load(const std::string& path)
+{
+  MappedFile* file = new MappedFile;
+  if (!file->open(path) || file->size() < sizeof(TrajectoryFileHeader)) {
+    delete file;
+    return 0;
+  }
+  
+  TrajectoryFileHeader header;
+  memcpy(&header, file->data(), sizeof(header));
+  
+  // Zero or NaN delta would give an infinite scale in index()
+  bool ok = memcmp(header.magic, gMagic, sizeof(gMagic)) == 0 &&
+            header.version == gVersion &&
+            header.trajectorySize == int(sizeof(Trajectory)) &&
+            header.sampleSize == int(sizeof(TrajectorySample)) &&
+            header.size > 0 && header.steps > 0 &&
+            fabs(header.angvelDelta) > 0.0;
+
+  // Compare counts against what fits in file before multiplying, so sizes can't overflow
+  size_t n = 0;
+  if (ok) {
+    size_t bytes_per_trajectory = sizeof(Trajectory)+(size_t(header.steps)+1)*sizeof(TrajectorySample);
+    size_t max_n = (file->size()-sizeof(header))/bytes_per_trajectory;
+    ok = size_t(header.size) <= max_n/size_t(header.size);
+    if (ok) {
+      n = size_t(header.size)*header.size;
+      ok = file->size() == sizeof(header)+n*bytes_per_trajectory;
+    }
+  }
+  if (!ok) {
+    delete file;
+    return 0;
+  }
+  
+  TrajectoryTable* table = new TrajectoryTable;
+  table->setAngularVelocities(header.angvelMin, header.angvelDelta, header.size);
+  table->iDt = header.dt;
+  table->iSteps = header.steps;
+  table->iSpeed = header.speed;
+  table->iFile = file;
+  table->iTrajectories = (const Trajectory*)(file->data()+sizeof(header));
+  table->iSamples = (const TrajectorySample*)(table->iTrajectories+n);
+  return table;
+}
+
+// Accessors
+std::string TrajectoryTable::typeName() const
+{
+  return "TrajectoryTable";
+}
+
+/*! Number of different angular velocities. There are size()*size() trajectories */
+int TrajectoryTable::size() const
+{
+  return iSize;
+}
+
+real TrajectoryTable::minAngularVelocity() const
+{
+  return iAngVelMin;
+}
+
+real TrajectoryTable::maxAngularVelocity() const
+{
+  return angularVelocity(iSize-1);
+}
+
+real TrajectoryTable::angularVelocityDelta() const
+{
+  return iAngVelDelta;
+}
+
+real TrajectoryTable::angularVelocity(int index) const
+{
+  return iAngVelMin+index*iAngVelDelta;
+}
+
+real TrajectoryTable::timeStep() const
+{
+  return iDt;
+}
+
+int TrajectoryTable::noSteps() const
+{
+  return iSteps;
+}
+
+/*! Number of poses stored per trajectory, including start pose */
+int TrajectoryTable::noSamples() const
+{
+  return iSteps+1;
+}
+
+/*! Time it takes to follow a trajectory */
+real TrajectoryTable::duration() const
+{
+  return iDt*iSteps;
+}
+
+real TrajectoryTable::speed() const
+{
+  return iSpeed;
+}
+
+const Trajectory& TrajectoryTable::trajectory(int start, int end) const
+{
+  assert(start >= 0 && start < iSize && end >= 0 && end < iSize);
+  return iTrajectories[start*iSize+end];
+}
+
+/*! 
+  Returns the size() trajectories starting with angular velocity closest 
+  to \a angvel_start, ordered by end angular velocity.
+*/
+const Trajectory* TrajectoryTable::trajectories(real angvel_start) const
+{
+  return &iTrajectories[index(angvel_start)*iSize];
+}
+
+/*! Returns the noSamples() poses along trajectory */
+const TrajectorySample* TrajectoryTable::samples(int start, int end) const
+{
+  assert(start >= 0 && start < iSize && end >= 0 && end < iSize);
+  return iSamples+(start*iSize+end)*noSamples();
+}
+
+// Request
+/*! True if table was loaded from file */
+bool TrajectoryTable::isMapped() const
+{
+  return iFile != 0;
+}
+
+// Calculations
+/*! Index of angular velocity closest to \a angvel */
+int TrajectoryTable::index(real angvel) const
+{
+  int i = int(floor((angvel-iAngVelMin)*iAngVelScale+0.5));
+  return max(0, min(iSize-1, i));
+}
+
+/*! Puts in \a to the state we end up in by following \a t from state \a from */
+void TrajectoryTable::endState(const MotionState& from, const Trajectory& t, MotionState& to) const
+{
+  real a = rad(from.rotation());
+  real c = cos(a), s = sin(a);
+  const Point2& p = t.position;
+  
+  to.setPosition(from.position()+Vector2(c*p.x()-s*p.y(), s*p.x()+c*p.y()));
+  to.setRotation(from.rotation()+t.rotation);
+  to.setAngularVelocity(t.angVelocity);
+  to.setAngularAcceleration(t.angAcceleration);
+  to.setSpeed(iSpeed);
+}
+
+/*! 
+  Put in \a swept \a shape placed at every sample of trajectory from \a start
+  to \a end, when trajectory starts at \a pos with orientation \a rotation.
+*/
+void TrajectoryTable::sweep(const Point2& pos, real rotation, int start, int end, const Polygon2& shape, vector<Polygon2>& swept) const
+{
+  const TrajectorySample* sample = samples(start, end);
+  int  n = noSamples();
+  real a = rad(rotation);
+  real c = cos(a), s = sin(a);
+  
+  swept.resize(n);
+  for (int i = 0; i < n; ++i, ++sample) {
+    const Point2& p = sample->position;
+    Point2 world = pos + Vector2(c*p.x()-s*p.y(), s*p.x()+c*p.y());
+    Matrix2 trans = Matrix2::translate(world)*Matrix2::rotate(rad(rotation+sample->rotation));
+    swept[i].resize(shape.size());
+    transform(shape.begin(), shape.end(), swept[i].begin(), trans);
+  }
+}
+
+/*!
+  Collision check all trajectories starting from \a s0 in one call. \a shape is
+  swept along each trajectory and tested against \a obstacles at every sample.
+  A concave \a shape is tested as its convex parts, which are found on every
+  call. Callers sweeping the same shape repeatedly should pass the parts.
+  
+  \a hit_times gets one entry per end angular velocity, with time from start 
+  of trajectory to first colliding sample or REAL_MAX if there is no collision.
+  Returned mask has bit \c j set if trajectory ending with angular velocity 
+  \c j collides, for the first 32 end angular velocities.
+*/
+uint32 TrajectoryTable::sweepCollisions(const MotionState& s0, const Polygon2& shape, Shape* obstacles, vector<real>& hit_times) const
+{
+  // Intersection tests only work for convex polygons, so a concave shape
+  // is swept as its convex parts like Sprite::collide() does
+  Polygons2 parts;
+  if (!shape.isConvex())
+    shape.convexParts(parts);
+  if (parts.empty() && shape.size() > 0)
+    parts.push_back(shape);
+  return sweepCollisions(s0, parts, obstacles, hit_times);
+}
+
+/*!
+  Sweeps a shape given as its convex \a parts, such as View::collisionParts().
+  Obstacle tree is queried once per trajectory, with the bounding box of 
+  the whole sweep. See sweepCollisions() above for \a hit_times and result.
+*/
+uint32 TrajectoryTable::sweepCollisions(const MotionState& s0, const Polygons2& parts, Shape* obstacles, vector<real>& hit_times) const
+{
+  hit_times.assign(iSize, REAL_MAX);
+  if (obstacles == 0 || parts.empty())
+    return 0;
+    
+  int start = index(s0.angularVelocity());
+  uint32 mask = 0;
+  vector< vector<Polygon2> > swept(parts.size());
+  vector<Shape*> candidates;
+  Points2 points;
+  
+  for (int j = 0; j < iSize; ++j) {
+    for (size_t p = 0; p < parts.size(); ++p)
+      sweep(s0.position(), s0.rotation(), start, j, parts[p], swept[p]);
+    
+    Rect2 bbox = swept[0][0].boundingBox();
+    for (size_t p = 0; p < parts.size(); ++p)
+      for (size_t k = 0; k < swept[p].size(); ++k)
+        bbox = bbox.surround(swept[p][k].boundingBox());
+      
+    candidates.clear();
+    gatherSimpleShapes(obstacles, bbox, candidates);
+    if (candidates.empty())
+      continue;
+    
+    for (size_t k = 0; k < swept[0].size() && hit_times[j] == REAL_MAX; ++k) {
+      for (size_t p = 0; p < parts.size() && hit_times[j] == REAL_MAX; ++p) {
+        Rect2 box = swept[p][k].boundingBox();
+        vector<Shape*>::iterator o;
+        for (o = candidates.begin(); o != candidates.end(); ++o) {
+          if ((*o)->boundingBox().intersect(box) && (*o)->intersection(swept[p][k], points)) {
+            hit_times[j] = k*iDt;
+            if (j < 32) 
+              mask |= 1u << j;
+            break;
+          }
+        }
+      }
+    }
+  }
+  return mask;
+}
+
+// Operations
+/*! Write table to binary file at \a path. Load it again with load() */
+bool TrajectoryTable::save(const std::string& path) const
+{
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == 0)
+    return false;
+    
+  TrajectoryFileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, gMagic, sizeof(gMagic));
+  header.version = gVersion;
+  header.trajectorySize = sizeof(Trajectory);
+  header.sampleSize = sizeof(TrajectorySample);
+  header.size = iSize;
+  header.steps = iSteps;
+  header.angvelMin = iAngVelMin;
+  header.angvelDelta = iAngVelDelta;
+  header.dt = iDt;
+  header.speed = iSpeed;
+  
+  size_t n = size_t(iSize)*iSize;
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+            fwrite(iTrajectories, sizeof(Trajectory), n, file) == n &&
+            fwrite(iSamples, sizeof(TrajectorySample), n*noSamples(), file) == n*noSamples();
+  return fclose(file) == 0 && ok;
+}
+
+// Private
+void TrajectoryTable::setAngularVelocities(real angvel_min, real angvel_delta, int size)
+{
+  iAngVelMin = angvel_min;
+  iAngVelDelta = angvel_delta;
+  iAngVelScale = 1.0/angvel_delta;
+  iSize = size;
+}
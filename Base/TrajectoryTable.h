@@ -0,0 +1,102 @@
+/*
+ *  TrajectoryTable.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 16.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+#pragma once
+
+#include "Types.h"
+
+#include <Core/SharedObject.hpp>
+
+#include <vector>
+#include <string>
+
+class MotionState;
+class MappedFile;
+class Polygon2;
+class Shape;
+
+/*! 
+  End state of a trajectory, relative to the state it started from. Start 
+  position is origin and start orientation is along the x-axis.
+*/
+struct Trajectory
+{
+  Point2  position;
+  real    rotation;         // Change of orientation in degrees
+  real    angVelocity;      // Angular velocity at end
+  real    angAcceleration;  // Constant angular acceleration used over trajectory
+};
+
+/*! Pose along a trajectory, relative to its start like Trajectory */
+struct TrajectorySample
+{
+  Point2  position;
+  real    rotation;
+};
+
+typedef std::vector<Trajectory> Trajectories;
+typedef std::vector<TrajectorySample> TrajectorySamples;
+
+class TrajectoryTable : public SharedObject
+{
+public:
+  // Constructors
+  TrajectoryTable(const MotionState& s0, real angvel_min, real angvel_max, int angvel_steps, real dt, int steps);
+  virtual ~TrajectoryTable();
+  
+  static TrajectoryTable* load(const std::string& path);
+  
+  // Accessors
+  std::string typeName() const;
+  int   size() const;
+  real  minAngularVelocity() const;
+  real  maxAngularVelocity() const;
+  real  angularVelocityDelta() const;
+  real  angularVelocity(int index) const;
+  real  timeStep() const;
+  int   noSteps() const;
+  int   noSamples() const;
+  real  duration() const;
+  real  speed() const;
+  
+  const Trajectory& trajectory(int start, int end) const;
+  const Trajectory* trajectories(real angvel_start) const;
+  const TrajectorySample* samples(int start, int end) const;
+  
+  // Request
+  bool  isMapped() const;
+  
+  // Calculations
+  int   index(real angvel) const;
+  void  endState(const MotionState& from, const Trajectory& t, MotionState& to) const;
+  void  sweep(const Point2& pos, real rotation, int start, int end, const Polygon2& shape, std::vector<Polygon2>& swept) const;
+  uint32 sweepCollisions(const MotionState& s0, const Polygon2& shape, Shape* obstacles, std::vector<real>& hit_times) const;
+  uint32 sweepCollisions(const MotionState& s0, const std::vector<Polygon2>& parts, Shape* obstacles, std::vector<real>& hit_times) const;
+  
+  // Operations
+  bool  save(const std::string& path) const;
+  
+private:
+  TrajectoryTable();
+  void  setAngularVelocities(real angvel_min, real angvel_delta, int size);
+  
+private:
+  real  iAngVelMin, iAngVelDelta, iAngVelScale;
+  int   iSize;
+  real  iDt;
+  int   iSteps;
+  real  iSpeed;
+  
+  // Point into either the vectors below or into iFile
+  const Trajectory*       iTrajectories;  // iSize x iSize, row is start angular velocity
+  const TrajectorySample* iSamples;       // noSamples() per trajectory, same order as iTrajectories
+  
+  Trajectories      iBuiltTrajectories;
+  TrajectorySamples iBuiltSamples;
+  MappedFile*       iFile;
+};
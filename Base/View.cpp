@@ -61,13 +61,11 @@ View::View()
   setCollisionPolygon(poly);
  
   // cout << hex << "0x" << (int)this << " view created" << endl;  // DEBUG
-  setTag(gNextTag++); // DEBUG
+  setTag(__sync_fetch_and_add(&gNextTag, 1)); // DEBUG, atomic since views are made on several threads
 }
 
 View::~View()
 {
-  std::cout << "tag: " << tag() << std::endl;
-  std::cout << std::hex << "0x" << (int)this << " view removed" << std::endl;  // DEBUG
 }
 
 // Accessors
@@ -88,12 +86,19 @@ Point2 View::origin() const
 }
 
 /*!
+  Concave polygons are split into convex parts here, once for all sprites
+  sharing the view.
+  
   \see collisionPolygon
+  \see collisionParts
 */
 void View::setCollisionPolygon(const Polygon2& poly)
 {
   iPolygon = poly;
   iRadius = for_each(iPolygon.begin(), iPolygon.end(), Longest()).length;  
+  iParts.clear();
+  if (!iPolygon.isConvex())
+    iPolygon.convexParts(iParts);
 }
 
 /*!
@@ -108,11 +113,21 @@ const Polygon2& View::collisionPolygon() const
   return iPolygon;
 }
 
+/*! Call setCollisionPolygon() with polygon after changing it, so its parts are right */
 Polygon2& View::collisionPolygon()
 {
   return iPolygon;
 }
 
+/*!
+  Convex parts of a concave collision polygon, as intersection tests only
+  work for convex polygons. Empty if collision polygon is convex.
+*/
+const Polygons2& View::collisionParts() const
+{
+  return iParts;
+}
+
 
 real View::radius() const
 {
@@ -124,4 +139,10 @@ void View::setColor(real red, real green, real blue)
   iColor[0] = red;
   iColor[1] = green;
   iColor[2] = blue;    
+}
+
+/*! Red, green and blue components of color set with setColor() */
+const real* View::color() const
+{
+  return iColor;
 }
\ No newline at end of file
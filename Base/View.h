@@ -40,10 +40,12 @@ public:
 
   const Polygon2& collisionPolygon() const;
   Polygon2& collisionPolygon();	
+  const Polygons2& collisionParts() const;
 	
   real radius() const;
 	
   void setColor(real red, real green, real blue);
+  const real* color() const;
   	
 	// Request
 
@@ -54,6 +56,7 @@ private:
 	Point2    iOrigin;
   real      iRadius;
   Polygon2  iPolygon;	
+  Polygons2 iParts;       // Convex parts of iPolygon, empty if it is convex
   
 protected:
   real      iColor[3];
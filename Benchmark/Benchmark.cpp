@@ -0,0 +1,181 @@
+/*
+ *  Benchmark.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 24.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "Benchmark/Benchmark.h"
+
+#include "Timing.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+
+using namespace std;
+
+/*!
+    \class Benchmark Benchmark.h
+    \brief Times one operation, in nanoseconds per call.
+
+    Subclasses make their inputs in setUp() from the seeded random number
+    generator they are given, so every run times the same inputs. run()
+    performs the operation \a iterations times, cycling through the inputs,
+    and returns something computed from the results so the compiler can not
+    remove the work. A static instance of each subclass registers it:
+
+    \code
+    class RectIntersectBenchmark : public Benchmark { ... };
+    static RectIntersectBenchmark gRectIntersect;
+    \endcode
+
+    Scene benchmarks are registered once per scene size. The size is
+    appended to the name, e.g. "Group::update/1000", and tearDown() frees
+    the scene once it has been timed.
+*/
+
+static volatile uint32 gSink = 0;
+
+// Constructors
+Benchmark::Benchmark(const char* name, uint32 size) : iName(name), iSize(size)
+{
+  if (size > 0) {
+    stringstream label;
+    label << name << "/" << size;
+    iName = label.str();
+  }
+  all().push_back(this);
+}
+
+Benchmark::~Benchmark()
+{
+  Benchmarks& benchmarks = all();
+  benchmarks.erase(remove(benchmarks.begin(), benchmarks.end(), this), benchmarks.end());
+}
+
+// Accessors
+const char* Benchmark::name() const
+{
+  return iName.c_str();
+}
+
+/*! Number of shapes, segments etc. in scene, 0 if not a scene benchmark */
+uint32 Benchmark::size() const
+{
+  return iSize;
+}
+
+/*!
+  Items processed by one call, used to give throughput in items per second.
+  Benchmarks which update or collide a whole scene per call return size().
+*/
+uint32 Benchmark::itemsPerCall() const
+{
+  return 1;
+}
+
+// Operations
+/*! Frees what setUp() made. Called after the benchmark has been measured */
+void Benchmark::tearDown()
+{
+}
+
+/*!
+  Finds how many iterations take at least \a min_seconds, then times that
+  many iterations \a noSamples times. Returns nanoseconds per iteration of
+  the fastest sample, which is the one least disturbed by other processes.
+*/
+real Benchmark::measure(real min_seconds, int noSamples)
+{
+  uint32 iterations = 1;
+  real elapsed = 0.0;
+  for (;;) {
+    real start = monotonicSeconds();
+    gSink += run(iterations);
+    elapsed = monotonicSeconds()-start;
+    if (elapsed >= min_seconds || iterations >= (1u << 30))
+      break;
+    real factor = elapsed > 0.0 ? min(10.0, max(2.0, 1.2*min_seconds/elapsed)) : 10.0;
+    iterations = static_cast<uint32>(iterations*factor);
+  }
+
+  real best = elapsed/iterations;
+  for (int i = 1; i < noSamples; ++i) {
+    real start = monotonicSeconds();
+    gSink += run(iterations);
+    best = min(best, (monotonicSeconds()-start)/iterations);
+  }
+  return best*1e9;
+}
+
+// Static access
+/*! Registered benchmarks, in order of construction */
+Benchmarks& Benchmark::all()
+{
+  static Benchmarks benchmarks;
+  return benchmarks;
+}
+
+/*!
+  Reads results written by saveBenchmarkResults(). Only understands that
+  format: a "benchmarks" object mapping names to nanoseconds per call.
+*/
+bool loadBenchmarkResults(const std::string& path, BenchmarkResults& results)
+{
+  ifstream in(path.c_str());
+  if (!in)
+    return false;
+  stringstream buffer;
+  buffer << in.rdbuf();
+  string text = buffer.str();
+
+  string::size_type pos = text.find("\"benchmarks\"");
+  if (pos == string::npos || (pos = text.find('{', pos)) == string::npos)
+    return false;
+
+  results.clear();
+  for (;;) {
+    string::size_type begin = text.find_first_of("\"}", pos+1);
+    if (begin == string::npos)
+      return false;
+    if (text[begin] == '}')
+      return true;
+    string::size_type end = text.find('"', begin+1);
+    string::size_type colon = text.find(':', end);
+    if (end == string::npos || colon == string::npos)
+      return false;
+
+    const char* number = text.c_str()+colon+1;
+    char* number_end = 0;
+    real value = strtod(number, &number_end);
+    if (number_end == number)
+      return false;
+    results[text.substr(begin+1, end-begin-1)] = value;
+    pos = number_end-text.c_str();
+  }
+}
+
+/*! Writes \a results as JSON, nanoseconds per call by benchmark name */
+bool saveBenchmarkResults(const std::string& path, const BenchmarkResults& results)
+{
+  ofstream out(path.c_str());
+  if (!out)
+    return false;
+  out << "{" << endl
+      << "  \"unit\": \"ns/op\"," << endl
+      << "  \"benchmarks\": {" << endl;
+  out << fixed << setprecision(2);
+  BenchmarkResults::const_iterator it;
+  for (it = results.begin(); it != results.end(); ++it) {
+    out << "    \"" << it->first << "\": " << it->second;
+    BenchmarkResults::const_iterator next = it;
+    out << (++next != results.end() ? "," : "") << endl;
+  }
+  out << "  }" << endl << "}" << endl;
+  return out.good();
+}
@@ -0,0 +1,52 @@
+/*
+ *  Benchmark.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 24.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#pragma once
+
+#include "Types.h"
+
+#include <Utils/Random.h>
+
+#include <string>
+#include <vector>
+#include <map>
+
+class Benchmark;
+
+typedef std::vector<Benchmark*>        Benchmarks;
+typedef std::map<std::string, real>    BenchmarkResults;
+
+class Benchmark
+{
+public:
+  // Constructors
+  Benchmark(const char* name, uint32 size = 0);
+  virtual ~Benchmark();
+
+  // Accessors
+  const char*    name() const;
+  uint32         size() const;
+  virtual uint32 itemsPerCall() const;
+
+  // Operations
+  virtual void   setUp(Random& random) = 0;
+  virtual uint32 run(uint32 iterations) = 0;
+  virtual void   tearDown();
+  real           measure(real min_seconds, int noSamples);
+
+  // Static access
+  static Benchmarks& all();
+
+private:
+  std::string iName;
+  uint32      iSize;
+};
+
+bool loadBenchmarkResults(const std::string& path, BenchmarkResults& results);
+bool saveBenchmarkResults(const std::string& path, const BenchmarkResults& results);
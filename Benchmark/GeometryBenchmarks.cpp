@@ -0,0 +1,333 @@
+/*
+ *  GeometryBenchmarks.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 24.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "Benchmark/Benchmark.h"
+
+#include <Geometry/Polygon2.hpp>
+#include <Geometry/Circle.hpp>
+#include <Geometry/Segment2.hpp>
+#include <Geometry/Ray2.hpp>
+#include <Geometry/Rect2.hpp>
+#include <Geometry/Matrix2.hpp>
+#include <Geometry/Gjk2.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+/*!
+  \file GeometryBenchmarks.cpp
+  \brief Timing of the geometry primitives used in collision detection.
+
+  Inputs are scattered over a 20 by 20 area so roughly half of the pairs
+  tested overlap, which exercises both the early out and the full test.
+*/
+
+static const uint32 gNoInputs = 256;   // Power of two, so inputs cycle with a mask
+static const real   gArea = 20.0;
+
+static Point2 randomPoint(Random& random)
+{
+  return Point2(random.uniform()*gArea, random.uniform()*gArea);
+}
+
+/*! Convex polygon with \a min_n to \a max_n vertices, counter clockwise from its lowest vertex */
+static Polygon2 randomPolygon(Random& random, int min_n = 4, int max_n = 8)
+{
+  Point2 center = randomPoint(random);
+  real radius = 1.0 + random.uniform()*4.0;
+  int n = random.uniform(min_n, max_n);
+
+  vector<real> angles(n);
+  angles[0] = -0.5*M_PI;
+  for (int i = 1; i < n; ++i)
+    angles[i] = -0.5*M_PI + (0.05 + random.uniform()*0.9)*2.0*M_PI;
+  sort(angles.begin()+1, angles.end());
+
+  Polygon2 poly;
+  for (int i = 0; i < n; ++i)
+    poly.push_back(center + Vector2(cos(angles[i]), sin(angles[i]))*radius);
+  return poly;
+}
+
+static Segment2 randomSegment(Random& random)
+{
+  Point2 p = randomPoint(random);
+  return Segment2(p, p + Vector2(random.uniform()*2.0*M_PI)*(1.0 + random.uniform()*9.0));
+}
+
+static Rect2 randomRect(Random& random)
+{
+  Point2 p = randomPoint(random);
+  return Rect2(p, p + Vector2(0.5 + random.uniform()*4.5, 0.5 + random.uniform()*4.5));
+}
+
+class PolygonIntersectBenchmark : public Benchmark
+{
+public:
+  PolygonIntersectBenchmark(const char* name, int min_n = 4, int max_n = 8) 
+    : Benchmark(name), iMinN(min_n), iMaxN(max_n) {}
+
+  void setUp(Random& random) {
+    for (uint32 i = 0; i < gNoInputs; ++i)
+      iPolygons.push_back(randomPolygon(random, iMinN, iMaxN));
+  }
+
+  uint32 run(uint32 iterations) {
+    uint32 hits = 0;
+    for (uint32 i = 0; i < iterations; ++i)
+      hits += iPolygons[i & (gNoInputs-1)].intersect(iPolygons[(i*7+1) & (gNoInputs-1)]);
+    return hits;
+  }
+
+private:
+  int iMinN, iMaxN;
+  vector<Polygon2> iPolygons;
+};
+
+/*! Same pairs as PolygonIntersectBenchmark, tested with GJK */
+class GjkIntersectBenchmark : public Benchmark
+{
+public:
+  GjkIntersectBenchmark(const char* name, int min_n = 4, int max_n = 8) 
+    : Benchmark(name), iMinN(min_n), iMaxN(max_n) {}
+
+  void setUp(Random& random) {
+    for (uint32 i = 0; i < gNoInputs; ++i)
+      iPolygons.push_back(randomPolygon(random, iMinN, iMaxN));
+  }
+
+  uint32 run(uint32 iterations) {
+    uint32 hits = 0;
+    for (uint32 i = 0; i < iterations; ++i)
+      hits += gjkIntersect(iPolygons[i & (gNoInputs-1)], iPolygons[(i*7+1) & (gNoInputs-1)]);
+    return hits;
+  }
+
+private:
+  int iMinN, iMaxN;
+  vector<Polygon2> iPolygons;
+};
+
+/*! 
+  Distance of pairs which move a little between each test, like from one
+  frame to the next. With \a warm each pair starts from its last simplex.
+*/
+class GjkMovingBenchmark : public Benchmark
+{
+public:
+  GjkMovingBenchmark(const char* name, bool warm) : Benchmark(name), iWarm(warm) {}
+
+  void setUp(Random& random) {
+    for (uint32 i = 0; i < gNoInputs; ++i) {
+      iPolygons.push_back(randomPolygon(random, 8, 16));
+      iMoving.push_back(randomPolygon(random, 8, 16));
+      iVelocities.push_back(Vector2(random.uniform()*2.0*M_PI)*0.01);
+    }
+    iCaches.resize(gNoInputs);
+  }
+
+  uint32 run(uint32 iterations) {
+    real sum = 0.0;
+    for (uint32 i = 0; i < iterations; ++i) {
+      uint32 k = i & (gNoInputs-1);
+      Polygon2& moving = iMoving[k];
+      Vector2 v = ((i / gNoInputs) & 64) ? -iVelocities[k] : iVelocities[k];
+      for (PointIterator2 p = moving.begin(); p != moving.end(); ++p)
+        *p += v;
+      sum += gjkDistance(iPolygons[k], moving, iWarm ? &iCaches[k] : 0);
+    }
+    return static_cast<uint32>(sum);
+  }
+
+private:
+  bool iWarm;
+  vector<Polygon2> iPolygons, iMoving;
+  vector<Vector2>  iVelocities;
+  vector<SimplexCache2> iCaches;
+};
+
+class CirclePolygonBenchmark : public Benchmark
+{
+public:
+  CirclePolygonBenchmark() : Benchmark("Circle::intersection(Polygon2)") {}
+
+  void setUp(Random& random) {
+    for (uint32 i = 0; i < gNoInputs; ++i) {
+      iCircles.push_back(Circle(randomPoint(random), 0.5 + random.uniform()*4.5));
+      iPolygons.push_back(randomPolygon(random));
+    }
+  }
+
+  uint32 run(uint32 iterations) {
+    uint32 hits = 0;
+    Points2 points;
+    for (uint32 i = 0; i < iterations; ++i) {
+      points.clear();
+      hits += iCircles[i & (gNoInputs-1)].intersection(iPolygons[(i*7+1) & (gNoInputs-1)], points);
+    }
+    return hits;
+  }
+
+private:
+  vector<Circle>   iCircles;
+  vector<Polygon2> iPolygons;
+};
+
+class SegmentIntersectionBenchmark : public Benchmark
+{
+public:
+  SegmentIntersectionBenchmark() : Benchmark("Segment2::intersection(Segment2)") {}
+
+  void setUp(Random& random) {
+    for (uint32 i = 0; i < gNoInputs; ++i)
+      iSegments.push_back(randomSegment(random));
+  }
+
+  uint32 run(uint32 iterations) {
+    uint32 hits = 0;
+    Vector2 result;
+    for (uint32 i = 0; i < iterations; ++i)
+      hits += iSegments[i & (gNoInputs-1)].intersection(iSegments[(i*7+1) & (gNoInputs-1)], result);
+    return hits;
+  }
+
+private:
+  vector<Segment2> iSegments;
+};
+
+class RayPolygonBenchmark : public Benchmark
+{
+public:
+  RayPolygonBenchmark() : Benchmark("Ray2::noIntersections(Polygon2)") {}
+
+  void setUp(Random& random) {
+    for (uint32 i = 0; i < gNoInputs; ++i) {
+      iRays.push_back(Ray2(randomPoint(random), Vector2(random.uniform()*2.0*M_PI)));
+      iPolygons.push_back(randomPolygon(random));
+    }
+  }
+
+  uint32 run(uint32 iterations) {
+    uint32 count = 0;
+    for (uint32 i = 0; i < iterations; ++i)
+      count += iRays[i & (gNoInputs-1)].noIntersections(iPolygons[(i*7+1) & (gNoInputs-1)]);
+    return count;
+  }
+
+private:
+  vector<Ray2>     iRays;
+  vector<Polygon2> iPolygons;
+};
+
+class RectIntersectBenchmark : public Benchmark
+{
+public:
+  RectIntersectBenchmark() : Benchmark("Rect2::intersect(Rect2)") {}
+
+  void setUp(Random& random) {
+    for (uint32 i = 0; i < gNoInputs; ++i)
+      iRects.push_back(randomRect(random));
+  }
+
+  uint32 run(uint32 iterations) {
+    uint32 hits = 0;
+    for (uint32 i = 0; i < iterations; ++i)
+      hits += iRects[i & (gNoInputs-1)].intersect(iRects[(i*7+1) & (gNoInputs-1)]);
+    return hits;
+  }
+
+private:
+  vector<Rect2> iRects;
+};
+
+class MatrixTransformBenchmark : public Benchmark
+{
+public:
+  MatrixTransformBenchmark() : Benchmark("Matrix2*Vector2") {}
+
+  void setUp(Random& random) {
+    for (uint32 i = 0; i < gNoInputs; ++i) {
+      iMatrices.push_back(Matrix2::translate(randomPoint(random))*Matrix2::rotate(random.uniform()*2.0*M_PI));
+      iPoints.push_back(randomPoint(random));
+    }
+  }
+
+  uint32 run(uint32 iterations) {
+    real sum = 0.0;
+    for (uint32 i = 0; i < iterations; ++i)
+      sum += (iMatrices[i & (gNoInputs-1)]*iPoints[(i*7+1) & (gNoInputs-1)]).x();
+    return static_cast<uint32>(sum);
+  }
+
+private:
+  vector<Matrix2> iMatrices;
+  Points2         iPoints;
+};
+
+class MatrixComposeBenchmark : public Benchmark
+{
+public:
+  MatrixComposeBenchmark() : Benchmark("Matrix2*Matrix2") {}
+
+  void setUp(Random& random) {
+    for (uint32 i = 0; i < gNoInputs; ++i)
+      iMatrices.push_back(Matrix2::translate(randomPoint(random))*Matrix2::rotate(random.uniform()*2.0*M_PI));
+  }
+
+  uint32 run(uint32 iterations) {
+    real sum = 0.0;
+    for (uint32 i = 0; i < iterations; ++i)
+      sum += (iMatrices[i & (gNoInputs-1)]*iMatrices[(i*7+1) & (gNoInputs-1)]*Vector2(1.0, 1.0)).y();
+    return static_cast<uint32>(sum);
+  }
+
+private:
+  vector<Matrix2> iMatrices;
+};
+
+class MinkowskiSumBenchmark : public Benchmark
+{
+public:
+  MinkowskiSumBenchmark() : Benchmark("Polygon2::minkowskiSum") {}
+
+  void setUp(Random& random) {
+    for (uint32 i = 0; i < gNoInputs; ++i)
+      iPolygons.push_back(randomPolygon(random));
+  }
+
+  uint32 run(uint32 iterations) {
+    uint32 size = 0;
+    Polygon2 result;
+    for (uint32 i = 0; i < iterations; ++i) {
+      result.clear();
+      iPolygons[i & (gNoInputs-1)].minkowskiSum(iPolygons[(i*7+1) & (gNoInputs-1)], result);
+      size += result.size();
+    }
+    return size;
+  }
+
+private:
+  vector<Polygon2> iPolygons;
+};
+
+static PolygonIntersectBenchmark    gPolygonIntersect("Polygon2::intersect(Polygon2)");
+static PolygonIntersectBenchmark    gPolygonIntersectLarge("Polygon2::intersect(Polygon2) 32 vertices", 32, 32);
+static GjkIntersectBenchmark        gGjkIntersect("gjkIntersect(Polygon2, Polygon2)");
+static GjkIntersectBenchmark        gGjkIntersectLarge("gjkIntersect(Polygon2, Polygon2) 32 vertices", 32, 32);
+static GjkMovingBenchmark           gGjkCold("gjkDistance(Polygon2) moving", false);
+static GjkMovingBenchmark           gGjkWarm("gjkDistance(Polygon2) moving, warm started", true);
+static CirclePolygonBenchmark       gCirclePolygon;
+static SegmentIntersectionBenchmark gSegmentIntersection;
+static RayPolygonBenchmark          gRayPolygon;
+static RectIntersectBenchmark       gRectIntersect;
+static MatrixTransformBenchmark     gMatrixTransform;
+static MatrixComposeBenchmark       gMatrixCompose;
+static MinkowskiSumBenchmark        gMinkowskiSum;
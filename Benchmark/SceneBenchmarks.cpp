@@ -0,0 +1,641 @@
+/*
+ *  SceneBenchmarks.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 25.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "Benchmark/Benchmark.h"
+
+#include "Timing.h"
+
+#include <Base/Sprite.h>
+#include <Base/PolygonView.h>
+#include <Base/Group.h>
+#include <Base/ShapeGroup.h>
+#include <Base/Action.h>
+#include <Core/AutoreleasePool.hpp>
+
+#include <Geometry/TrapezoidalMap2.hpp>
+#include <Geometry/Graph2.hpp>
+#include <Geometry/Polygon2.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cmath>
+
+using namespace std;
+
+/*!
+  \file SceneBenchmarks.cpp
+  \brief Timing of whole synthetic scenes, at sizes from 100 to 100k.
+
+  Each benchmark is registered once for every size so throughput can be
+  charted over scene size with 'lusionbench -c chart.csv'. Sprites are
+  scattered with the same density at every size, so the work per sprite
+  stays the same if an operation scales linearly.
+
+  Benchmarks whose time grows quadratically with size, like colliding two
+  plain Groups, are only registered up to 10k so a full run finishes.
+
+  Obstacles for TrapezoidalMap2 and Graph2 are the polygons of
+  script/levels/level1.lua tiled until the scene has enough segments, and
+  the roadmap is built the way script/roadmap.lua does it. These must be
+  run from the directory containing script/.
+*/
+
+static const real gSpacing = 6.0;     // Average distance between sprites
+static const real gTileSize = 42.0;   // Level1 spans a bit over 40 units
+static const real gTimeStep = 0.02;
+static const real gNoTimeLimit = 1e9; // Group::collide gives up after t+dt
+
+/*! Side of square holding \a size sprites with the same density at all sizes */
+static real sceneSide(uint32 size)
+{
+  return sqrt(static_cast<real>(size))*gSpacing;
+}
+
+/*! Convex polygon with 3 to 6 vertices around origin, like the mixed views in maingame.lua */
+static Polygon2 randomConvexPolygon(Random& random)
+{
+  int n = random.uniform(3, 6);
+  real radius = 0.6 + random.uniform()*2.4;
+  Polygon2 poly;
+  for (int i = 0; i < n; ++i) {
+    real angle = (i + 0.2*random.uniform())*2.0*M_PI/n;
+    poly.push_back(Point2(cos(angle)*radius, sin(angle)*radius));
+  }
+  return poly;
+}
+
+/*! Rectangle obstacle placed like createRandomObstacles() in maingame.lua */
+static Sprite* randomObstacle(Random& random, real side)
+{
+  real w = random.uniform(2, 10)*0.6;
+  real h = random.uniform(2, 10)*0.6;
+  Polygon2 rect;
+  rect.push_back(Point2(-0.5*w, -0.5*h));
+  rect.push_back(Point2( 0.5*w, -0.5*h));
+  rect.push_back(Point2( 0.5*w,  0.5*h));
+  rect.push_back(Point2(-0.5*w,  0.5*h));
+
+  PolygonView* view = new PolygonView(rect);
+  Sprite* obstacle = new Sprite(view);
+  view->release();
+  obstacle->setPosition(Point2(random.uniform()*side, random.uniform()*side));
+  obstacle->setRotation(random.uniform(0, 360));
+  return obstacle;
+}
+
+/*! Moving sprite with one of \a views */
+static Sprite* randomActor(Random& random, const vector<View*>& views, real side)
+{
+  Sprite* actor = new Sprite(views[random.next() % views.size()]);
+  actor->setPosition(Point2(random.uniform()*side, random.uniform()*side));
+  actor->setRotation(random.uniform(0, 360));
+  actor->setVelocity(Vector2(random.uniform()*2.0*M_PI)*(1.0 + random.uniform()*4.0));
+  actor->setAngularVelocity(random.uniform()*90.0 - 45.0);
+  return actor;
+}
+
+static void releaseAll(vector<Shape*>& shapes)
+{
+  for (vector<Shape*>::iterator it = shapes.begin(); it != shapes.end(); ++it)
+    (*it)->release();
+  shapes.clear();
+}
+
+/*! Counts collisions instead of handling them, so the scene is not changed */
+class CountCollisions : public CollisionAction
+{
+public:
+  CountCollisions() : count(0) {}
+  bool execute(Shape*, Shape*, Points2&, real, real) {
+    ++count;
+    return true;
+  }
+
+  uint32 count;
+};
+
+/*!
+  Polygons of level file at \a path, made counter clockwise so the trapezoids
+  inside them can be found the way script/roadmap.lua does it.
+*/
+static vector<Polygon2> loadLevel(const char* path)
+{
+  vector<Polygon2> polygons;
+  ifstream in(path);
+  if (!in) {
+    cerr << "Error could not read level " << path << endl;
+    return polygons;
+  }
+
+  string line;
+  while (getline(in, line)) {
+    if (line.find("addObstacle(vec") != 0)
+      continue;
+    Polygon2 poly;
+    string::size_type pos = 0;
+    while ((pos = line.find("vec(", pos)) != string::npos) {
+      real x, y;
+      if (sscanf(line.c_str()+pos, "vec(%lf, %lf)", &x, &y) == 2)
+        poly.push_back(Point2(x, y)*(40.0/280.0) - Vector2(20.0, 20.0));   // Same scaling as level file
+      pos += 4;
+    }
+    real area = 0.0;
+    for (int i = 0; i < poly.size(); ++i)
+      area += poly[i].x()*poly[(i+1) % poly.size()].y() - poly[(i+1) % poly.size()].x()*poly[i].y();
+    if (area < 0.0)
+      reverse(poly.begin(), poly.end());
+    polygons.push_back(poly);
+  }
+  return polygons;
+}
+
+/*!
+  Tiles level obstacles in a square grid until there are at least \a size
+  segments. Each tile is jittered a little so segments in different tiles
+  do not line up exactly. Returns bounding box of all tiles.
+*/
+static Rect2 tiledLevel(Random& random, uint32 size, Segments2& segments)
+{
+  vector<Polygon2> level = loadLevel("script/levels/level1.lua");
+  uint32 noTileSegments = 0;
+  for (uint32 i = 0; i < level.size(); ++i)
+    noTileSegments += level[i].size();
+
+  uint32 noTiles = noTileSegments > 0 ? (size + noTileSegments - 1)/noTileSegments : 0;
+  uint32 noColumns = static_cast<uint32>(ceil(sqrt(static_cast<real>(noTiles))));
+  for (uint32 tile = 0; tile < noTiles; ++tile) {
+    Vector2 offset((tile % noColumns)*gTileSize + random.uniform()*0.01,
+                   (tile / noColumns)*gTileSize + random.uniform()*0.01);
+    for (uint32 i = 0; i < level.size(); ++i) {
+      const Polygon2& poly = level[i];
+      for (int j = 0; j < poly.size(); ++j)
+        segments.push_back(Segment2(poly[j] + offset, poly[(j+1) % poly.size()] + offset));
+    }
+  }
+  uint32 noRows = noColumns > 0 ? (noTiles + noColumns - 1)/noColumns : 0;
+  return Rect2(-21.0, -21.0, noColumns*gTileSize + 2.0, noRows*gTileSize + 2.0);
+}
+
+/*! Moves and rotates \a size sprites with mixed polygon views */
+class GroupUpdateBenchmark : public Benchmark
+{
+public:
+  GroupUpdateBenchmark(uint32 size) : Benchmark("Group::update", size), iGroup(0) {}
+
+  uint32 itemsPerCall() const { return size(); }
+
+  void setUp(Random& random) {
+    vector<View*> views;
+    for (int i = 0; i < 8; ++i)
+      views.push_back(new PolygonView(randomConvexPolygon(random)));
+
+    iGroup = new Group;
+    for (uint32 i = 0; i < size(); ++i) {
+      Sprite* actor = randomActor(random, views, sceneSide(size()));
+      iGroup->addKid(actor);
+      actor->release();
+    }
+    for (uint32 i = 0; i < views.size(); ++i)
+      views[i]->release();
+    iTime = 0.0;
+  }
+
+  uint32 run(uint32 iterations) {
+    for (uint32 i = 0; i < iterations; ++i) {
+      iGroup->update(iTime, gTimeStep);
+      iTime += gTimeStep;
+    }
+    return iGroup->noShapes();
+  }
+
+  void tearDown() {
+    iGroup->release();
+    iGroup = 0;
+  }
+
+private:
+  Group* iGroup;
+  real   iTime;
+};
+
+/*!
+  Collides \a size moving sprites with \a size static obstacles. Obstacles
+  are held in a Group, which tests every pair, or in a ShapeGroup, which
+  tests against its bounding volume hierarchy.
+*/
+class CollideBenchmark : public Benchmark
+{
+public:
+  CollideBenchmark(const char* name, uint32 size, bool hierarchy)
+    : Benchmark(name, size), iObstacles(0), iHierarchy(hierarchy) {}
+
+  uint32 itemsPerCall() const { return size(); }
+
+  void setUp(Random& random) {
+    vector<View*> views;
+    for (int i = 0; i < 8; ++i)
+      views.push_back(new PolygonView(randomConvexPolygon(random)));
+
+    real side = sceneSide(size());
+    for (uint32 i = 0; i < size(); ++i) {
+      iActors.push_back(randomActor(random, views, side));
+      iObstacleShapes.push_back(randomObstacle(random, side));
+    }
+    for (uint32 i = 0; i < views.size(); ++i)
+      views[i]->release();
+
+    AutoreleasePool::begin();
+    if (iHierarchy) {
+      vector<Shape*> shapes(iObstacleShapes);
+      iObstacles = new ShapeGroup(shapes.begin(), shapes.end());
+    }
+    else {
+      Group* group = new Group;
+      for (uint32 i = 0; i < iObstacleShapes.size(); ++i)
+        group->addKid(iObstacleShapes[i]);
+      iObstacles = group;
+    }
+    AutoreleasePool::end();
+  }
+
+  uint32 run(uint32 iterations) {
+    CountCollisions counter;
+    for (uint32 i = 0; i < iterations; ++i) {
+      real t = secondsPassed();
+      for (uint32 j = 0; j < iActors.size(); ++j)
+        iObstacles->collide(iActors[j], t, gNoTimeLimit, &counter);
+    }
+    return counter.count;
+  }
+
+  void tearDown() {
+    iObstacles->release();
+    iObstacles = 0;
+    releaseAll(iActors);
+    releaseAll(iObstacleShapes);
+  }
+
+private:
+  vector<Shape*> iActors;
+  vector<Shape*> iObstacleShapes;
+  Shape*         iObstacles;
+  bool           iHierarchy;
+};
+
+/*! Builds bounding volume hierarchy of \a size obstacles */
+class ShapeGroupBuildBenchmark : public Benchmark
+{
+public:
+  ShapeGroupBuildBenchmark(uint32 size) : Benchmark("ShapeGroup::ShapeGroup", size) {}
+
+  uint32 itemsPerCall() const { return size(); }
+
+  void setUp(Random& random) {
+    for (uint32 i = 0; i < size(); ++i)
+      iShapes.push_back(randomObstacle(random, sceneSide(size())));
+  }
+
+  uint32 run(uint32 iterations) {
+    uint32 sum = 0;
+    for (uint32 i = 0; i < iterations; ++i) {
+      AutoreleasePool::begin();   // Branches are autoreleased
+      vector<Shape*> shapes(iShapes);
+      ShapeGroup* group = new ShapeGroup(shapes.begin(), shapes.end());
+      sum += group->boundingBox().width() > 0.0;
+      group->release();
+      AutoreleasePool::end();
+    }
+    return sum;
+  }
+
+  void tearDown() {
+    releaseAll(iShapes);
+  }
+
+private:
+  vector<Shape*> iShapes;
+};
+
+/*! Point queries against bounding volume hierarchy of \a size obstacles */
+class ShapeGroupInsideBenchmark : public Benchmark
+{
+public:
+  ShapeGroupInsideBenchmark(uint32 size) : Benchmark("ShapeGroup::inside", size), iGroup(0) {}
+
+  void setUp(Random& random) {
+    real side = sceneSide(size());
+    vector<Shape*> shapes;
+    for (uint32 i = 0; i < size(); ++i)
+      shapes.push_back(randomObstacle(random, side));
+
+    AutoreleasePool::begin();
+    iGroup = new ShapeGroup(shapes.begin(), shapes.end());
+    AutoreleasePool::end();
+    releaseAll(shapes);
+
+    for (uint32 i = 0; i < gNoPoints; ++i)
+      iPoints.push_back(Point2(random.uniform()*side, random.uniform()*side));
+  }
+
+  uint32 run(uint32 iterations) {
+    uint32 count = 0;
+    real t = secondsPassed();
+    for (uint32 i = 0; i < iterations; ++i)
+      count += iGroup->inside(iPoints[i & (gNoPoints-1)], t, gNoTimeLimit);
+    return count;
+  }
+
+  void tearDown() {
+    iGroup->release();
+    iGroup = 0;
+    iPoints.clear();
+  }
+
+private:
+  static const uint32 gNoPoints = 1024;
+
+  ShapeGroup* iGroup;
+  Points2     iPoints;
+};
+
+/*! Builds trapezoidal map of \a size segments from tiled level obstacles */
+class TrapezoidalMapBuildBenchmark : public Benchmark
+{
+public:
+  TrapezoidalMapBuildBenchmark(uint32 size) : Benchmark("TrapezoidalMap2::TrapezoidalMap2", size) {}
+
+  uint32 itemsPerCall() const { return iSegments.size(); }
+
+  void setUp(Random& random) {
+    iBox = tiledLevel(random, size(), iSegments);
+  }
+
+  uint32 run(uint32 iterations) {
+    uint32 sum = 0;
+    for (uint32 i = 0; i < iterations; ++i) {
+      TrapezoidalMap2 map(iSegments.begin(), iSegments.end(), iBox);
+      sum += map.locate(iBox.center()) != 0;
+    }
+    return sum;
+  }
+
+  void tearDown() {
+    iSegments.clear();
+  }
+
+private:
+  Segments2 iSegments;
+  Rect2     iBox;
+};
+
+/*! Loads saved trapezoidal map of \a size segments, to compare with building it */
+class TrapezoidalMapLoadBenchmark : public Benchmark
+{
+public:
+  TrapezoidalMapLoadBenchmark(uint32 size) : Benchmark("TrapezoidalMap2::load", size), iPath("/tmp/lusionbench.ltm") {}
+
+  uint32 itemsPerCall() const { return iNoSegments; }
+
+  void setUp(Random& random) {
+    Segments2 segments;
+    Rect2 box = tiledLevel(random, size(), segments);
+    TrapezoidalMap2 map(segments.begin(), segments.end(), box);
+    map.save(iPath);
+    iNoSegments = segments.size();
+    iCenter = box.center();
+  }
+
+  uint32 run(uint32 iterations) {
+    uint32 sum = 0;
+    for (uint32 i = 0; i < iterations; ++i) {
+      TrapezoidalMap2* map = TrapezoidalMap2::load(iPath);
+      if (map == 0)
+        continue;
+      sum += map->locate(iCenter) != 0;
+      delete map;
+    }
+    return sum;
+  }
+
+  void tearDown() {
+    remove(iPath.c_str());
+  }
+
+private:
+  string  iPath;
+  uint32  iNoSegments;
+  Point2  iCenter;
+};
+
+/*! Point location in trapezoidal map of \a size segments */
+class TrapezoidalMapLocateBenchmark : public Benchmark
+{
+public:
+  TrapezoidalMapLocateBenchmark(uint32 size) : Benchmark("TrapezoidalMap2::locate", size), iMap(0) {}
+
+  void setUp(Random& random) {
+    Segments2 segments;
+    Rect2 box = tiledLevel(random, size(), segments);
+    iMap = new TrapezoidalMap2(segments.begin(), segments.end(), box);
+    for (uint32 i = 0; i < gNoPoints; ++i)
+      iPoints.push_back(box.min() + Vector2(random.uniform()*box.width(), random.uniform()*box.height()));
+  }
+
+  uint32 run(uint32 iterations) {
+    uint32 sum = 0;
+    for (uint32 i = 0; i < iterations; ++i)
+      sum += iMap->locate(iPoints[i & (gNoPoints-1)]) != 0;
+    return sum;
+  }
+
+  void tearDown() {
+    delete iMap;
+    iMap = 0;
+    iPoints.clear();
+  }
+
+private:
+  static const uint32 gNoPoints = 1024;
+
+  TrapezoidalMap2* iMap;
+  Points2          iPoints;
+};
+
+/*!
+  A* searches in roadmap of tiled level obstacles with \a size segments.
+  The roadmap is built like script/roadmap.lua does it: trapezoids inside
+  obstacles are removed and the rest are connected to their right neighbors.
+  Searches go between centers of random free trapezoids.
+*/
+class Graph2SearchBenchmark : public Benchmark
+{
+public:
+  Graph2SearchBenchmark(uint32 size) : Benchmark("Graph2::shortestPath", size), iMap(0), iGraph(0) {}
+
+  void setUp(Random& random) {
+    Segments2 segments;
+    Rect2 box = tiledLevel(random, size(), segments);
+    iMap = new TrapezoidalMap2(segments.begin(), segments.end(), box);
+
+    Trapezoids2 traps;
+    iMap->getTrapezoids(traps);
+    for (Trapezoids2::iterator it = traps.begin(); it != traps.end(); ++it) {
+      Segment2 bottom = (*it)->bottom();
+      if (bottom.source().x() < bottom.target().x())   // Inside counter clockwise obstacle
+        iMap->remove(*it);
+    }
+    int noVertices = iMap->assignUniqueTags();
+
+    traps.clear();
+    iMap->getTrapezoids(traps);
+    EdgePairs edges;
+    int tag = noVertices;
+    for (Trapezoids2::iterator it = traps.begin(); it != traps.end(); ++it) {
+      Trapezoid2* t = *it;
+      Trapezoids2 neighbors = t->rightNeighbors();
+      for (Trapezoids2::iterator n = neighbors.begin(); n != neighbors.end(); ++n)
+        if (*n != 0)
+          edges.push_back(roadmapEdge(t, *n, tag++));
+    }
+    iGraph = Graph2::create(noVertices, edges.begin(), edges.end());
+
+    for (uint32 i = 0; i < gNoQueries; ++i) {
+      iSources.push_back(traps[random.next() % traps.size()]);
+      iTargets.push_back(traps[random.next() % traps.size()]);
+    }
+  }
+
+  uint32 run(uint32 iterations) {
+    uint32 sum = 0;
+    for (uint32 i = 0; i < iterations; ++i) {
+      Points2 path;
+      uint32 query = i & (gNoQueries-1);
+      if (iGraph->shortestPath(iSources[query], iTargets[query], path))
+        sum += path.size();
+    }
+    return sum;
+  }
+
+  void tearDown() {
+    delete iGraph;
+    delete iMap;
+    iGraph = 0;
+    iMap = 0;
+    iSources.clear();
+    iTargets.clear();
+  }
+
+private:
+  static const uint32 gNoQueries = 64;
+
+  TrapezoidalMap2* iMap;
+  Graph2*          iGraph;
+  Trapezoids2      iSources, iTargets;
+};
+
+/*!
+  Destroys and puts back an obstacle in the roadmap of tiled level
+  obstacles with \a size segments, changing only the trapezoids and graph
+  edges along its sides. Trapezoids inside obstacles stay in the map, so
+  the obstacle can be removed again. Compare with building map and graph.
+*/
+class Graph2UpdateBenchmark : public Benchmark
+{
+public:
+  Graph2UpdateBenchmark(uint32 size) : Benchmark("Graph2::update", size), iMap(0), iGraph(0) {}
+
+  uint32 itemsPerCall() const { return 2*iObstacle.size(); }
+
+  void setUp(Random& random) {
+    Segments2 segments;
+    Rect2 box = tiledLevel(random, size(), segments);
+    iMap = new TrapezoidalMap2(segments.begin(), segments.end(), box);
+    int tag = iMap->assignUniqueTags();
+
+    Trapezoids2 traps;
+    iMap->getTrapezoids(traps);
+    EdgePairs edges;
+    for (Trapezoids2::iterator it = traps.begin(); it != traps.end(); ++it) {
+      Trapezoids2 neighbors = (*it)->rightNeighbors();
+      for (Trapezoids2::iterator n = neighbors.begin(); n != neighbors.end(); ++n)
+        if (*n != 0)
+          edges.push_back(roadmapEdge(*it, *n, tag++));
+    }
+    iGraph = Graph2::create(traps.size(), edges.begin(), edges.end());
+
+    // First obstacle of level is at the start of segments
+    vector<Polygon2> level = loadLevel("script/levels/level1.lua");
+    if (!level.empty())
+      iObstacle.assign(segments.begin(), segments.begin() + level[0].size());
+  }
+
+  uint32 run(uint32 iterations) {
+    uint32 sum = 0;
+    for (uint32 i = 0; i < iterations; ++i) {
+      Trapezoids2 created;
+      vector<int> deleted;
+      Segments2::iterator s;
+      for (s = iObstacle.begin(); s != iObstacle.end(); ++s)
+        iMap->remove(*s, &created, &deleted);
+      iGraph->update(deleted, created);
+      sum += created.size();
+
+      created.clear();
+      deleted.clear();
+      for (s = iObstacle.begin(); s != iObstacle.end(); ++s)
+        iMap->insert(*s, &created, &deleted);
+      iGraph->update(deleted, created);
+      sum += created.size();
+    }
+    return sum;
+  }
+
+  void tearDown() {
+    delete iGraph;
+    delete iMap;
+    iGraph = 0;
+    iMap = 0;
+    iObstacle.clear();
+  }
+
+private:
+  TrapezoidalMap2* iMap;
+  Graph2*          iGraph;
+  Segments2        iObstacle;
+};
+
+/*! Registers one instance of \a T for every scene size up to \a max_size */
+template <class T>
+static bool registerSizes(uint32 max_size)
+{
+  for (uint32 size = 100; size <= max_size; size *= 10)
+    new T(size);
+  return true;
+}
+
+static bool registerCollideSizes(const char* name, uint32 max_size, bool hierarchy)
+{
+  for (uint32 size = 100; size <= max_size; size *= 10)
+    new CollideBenchmark(name, size, hierarchy);
+  return true;
+}
+
+static bool gRegistered =
+  registerSizes<GroupUpdateBenchmark>(100000) &&
+  registerCollideSizes("Group::collide", 10000, false) &&   // Quadratic
+  registerCollideSizes("ShapeGroup::collide", 100000, true) &&
+  registerSizes<ShapeGroupBuildBenchmark>(100000) &&
+  registerSizes<ShapeGroupInsideBenchmark>(100000) &&
+  registerSizes<TrapezoidalMapBuildBenchmark>(100000) &&
+  registerSizes<TrapezoidalMapLoadBenchmark>(100000) &&
+  registerSizes<TrapezoidalMapLocateBenchmark>(100000) &&
+  registerSizes<Graph2SearchBenchmark>(100000) &&
+  registerSizes<Graph2UpdateBenchmark>(100000);
@@ -1,10 +1,13 @@
 #include "AutoreleasePool.hpp"
+#include "Utils/Counters.h"
 
 #include <algorithm>
 #include <assert.h>
 
 #include <iostream>
 
+#include <pthread.h>
+
 //#define DEBUG_MEMORY
 
 using namespace std;
@@ -39,9 +42,24 @@ using namespace std;
     
     Calling end() in a sub block will not release objects allocated or accessed
     in the outer block.    
+    
+    Each thread has its own stack of pools.
 */
 ////////////////////////////// Static member variables
-stack<AutoreleasePool*> AutoreleasePool::sPoolStack;
+typedef stack<AutoreleasePool*> PoolStack;
+
+static pthread_key_t  gPoolStackKey;
+static pthread_once_t gPoolStackOnce = PTHREAD_ONCE_INIT;
+
+static void deletePoolStack(void* pools)
+{
+  delete (PoolStack*)pools;
+}
+
+static void createPoolStackKey()
+{
+  pthread_key_create(&gPoolStackKey, deletePoolStack);
+}
   
 ////////////////////////////// Constructors
 AutoreleasePool::AutoreleasePool() 
@@ -75,6 +93,7 @@ AutoreleasePool::~AutoreleasePool()
 void  
 AutoreleasePool::add(SharedObject *aObj) 
 {
+  COUNT(AUTORELEASED);
   iPoolObjects.insert(aObj);
 }
 
@@ -96,20 +115,35 @@ AutoreleasePool::releasePool() {
 ////////////////////////////// Static access           
 void AutoreleasePool::begin()
 {
-   sPoolStack.push(new AutoreleasePool);
-   assert(sPoolStack.size() > 0);
+   PoolStack& pools = poolStack();
+   pools.push(new AutoreleasePool);
+   assert(pools.size() > 0);
 }   
 
 void AutoreleasePool::end()
 {   
-    assert(!sPoolStack.empty());
-    AutoreleasePool* pool = sPoolStack.top();    
-    sPoolStack.pop();
+    PoolStack& pools = poolStack();
+    assert(!pools.empty());
+    AutoreleasePool* pool = pools.top();    
+    pools.pop();
     pool->release();
 }
 
 AutoreleasePool *AutoreleasePool::currentPool()
 {
-    assert(!sPoolStack.empty());
-    return sPoolStack.top();
+    PoolStack& pools = poolStack();
+    assert(!pools.empty());
+    return pools.top();
+}
+
+/*! Pool stack of calling thread */
+PoolStack& AutoreleasePool::poolStack()
+{
+  pthread_once(&gPoolStackOnce, createPoolStackKey);
+  PoolStack* pools = (PoolStack*)pthread_getspecific(gPoolStackKey);
+  if (pools == 0) {
+    pools = new PoolStack;
+    pthread_setspecific(gPoolStackKey, pools);
+  }
+  return *pools;
 }
\ No newline at end of file
@@ -42,6 +42,7 @@ public:
   static AutoreleasePool *currentPool();
     
 private:
+  static std::stack<AutoreleasePool*>& poolStack();
+  
   SharedObjects                       iPoolObjects;  
-  static std::stack<AutoreleasePool*> sPoolStack;
 };
\ No newline at end of file
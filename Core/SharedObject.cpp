@@ -1,5 +1,6 @@
 #include "SharedObject.hpp"
 #include "AutoreleasePool.hpp"
+#include "Utils/Counters.h"
 
 #include <iostream>
 
@@ -37,6 +38,7 @@ using namespace std;
 ////////////////////////////// Constructors
 SharedObject::SharedObject() : iTag(0) , iRefCount(1) 
 {
+  COUNT(OBJECTS_CREATED);
   #ifdef DEBUG_MEMORY  
   cout << "0x" << hex << (int)this << " SharedObject created " << endl;
   // NOTE: Can't print typeName since that depends on virtual function
@@ -45,11 +47,15 @@ SharedObject::SharedObject() : iTag(0) , iRefCount(1)
 
 SharedObject::SharedObject(int aTag) : iTag(aTag) , iRefCount(1) 
 {
+  COUNT(OBJECTS_CREATED);
 
 }
 
 SharedObject::SharedObject(const SharedObject&)
-: iRefCount(1) {}
+: iRefCount(1) 
+{
+  COUNT(OBJECTS_CREATED);
+}
 
 SharedObject& 
 SharedObject::operator=(const SharedObject&) {
@@ -19,13 +19,16 @@
 
 #include "Engine.h"
 
+#ifndef HEADLESS
 #include <OpenGL/gl.h>
 #include <OpenGL/glu.h>
+#endif
 
 
 #include "Base/Sprite.h"
 #include "Lua/Base/LuaSprite.h"
 #include "LuaEngine.h"
+#include "World.h"
 //#include "Base/ImageView.h"
 #include "Base/Group.h"
 #include "Base/CircleShape.h"
@@ -34,6 +37,7 @@
 #include "Base/PolygonView.h"
 #include "Utils/PolygonUtils.h"
 #include "Utils/GLUtils.h"
+#include "Utils/Profiler.h"
 
 #include <Core/SharedObject.hpp>
 #include <Core/AutoreleasePool.hpp>
@@ -47,19 +51,12 @@
 using namespace std;
 
 // private member variables
-// Timer
-static int gStartTime = 0;
-
-static bool       gDone;
-
 // Viewport
 static int gViewportWidth = 640;
 static int gViewportHeight = 640;
 
-// View
-static Rect2  gView(-20.0, -20.0, 20.0, 20.0);
-
-static bool gGLInitialized = false;
+// World shown in the OpenGL viewport. Other worlds run headless
+static World* gGLWorld = 0;
 
 // private functions
 template <typename ForwardIterator>
@@ -80,7 +77,10 @@ inline void deleteAll(const Container &c)
 // Game related functions
 void renderFrame(real /*start_time*/)
 {
+    PROFILE_ZONE("render");
+#ifndef HEADLESS
     glClear(GL_COLOR_BUFFER_BIT);
+#endif
     renderGroup()->draw(worldView());
 }
 
@@ -90,9 +90,30 @@ void engineEndLoop(real secs)
   AutoreleasePool::currentPool()->releasePool();
 }
 
+/*! Runs the fixed time steps of the current world due at \a now. See World::advance() */
+uint32 engineAdvance(real now)
+{
+  return World::current()->advance(now);
+}
+
+/*! Sets projection to view of current world, if it is the one shown */
+static void updateProjection()
+{
+  if (World::current() != gGLWorld)
+    return;
+#ifndef HEADLESS
+  Rect2 view = worldView();
+  glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    gluOrtho2D(view.left(), view.right(), view.bottom(), view.top());  
+  glMatrixMode(GL_MODELVIEW);    
+#endif
+}
+
 
 static void initGL()
 {
+#ifndef HEADLESS
 #ifdef USE_TEXTURES
   glEnable( GL_TEXTURE_2D );                // Enable texture mapping
   glShadeModel( GL_SMOOTH );                // Enable smooth shading
@@ -103,18 +124,15 @@ static void initGL()
   glDisable( GL_DEPTH_TEST );  
 #endif
   glClearColor( 0.0, 0.0, 0.0, 1.0 );   // Black background  
+#endif
 
-  glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    gluOrtho2D(gView.left(), gView.right(), gView.bottom(), gView.top());  
-  glMatrixMode(GL_MODELVIEW);    
-
-  gGLInitialized  = true;
+  gGLWorld = World::current();
+  updateProjection();
 }
 
 void engineInit()
 {   
-  gDone = false;
+  World::current()->reset();
   initLua();  
   initGL();
 #ifdef USE_TEXTURES  
@@ -179,11 +197,11 @@ SegmentShape2* createSegment2(const Segment2& seg)
 
 // Accessors
 bool isDone() {
-  return gDone;
+  return World::current()->isDone();
 }
 
 void setDone(bool done) {
-  gDone = done;
+  World::current()->setDone(done);
 }
 
 void setViewportHeight(int height)
@@ -202,6 +220,7 @@ void setViewport(int width, int height)
   gViewportHeight = height;
 }
 
+#ifndef HEADLESS
 void setViewport(const QSize size)
 {
   gViewportWidth = size.width();
@@ -212,34 +231,26 @@ QSize getViewport()
 {
   return QSize(gViewportWidth, gViewportHeight);
 }
+#endif
 
 
 void setWorldView(const Rect2& rect)
 {
-  gView = rect;
-  
-  if (gGLInitialized) {
-    glMatrixMode(GL_PROJECTION);
-      glLoadIdentity();
-      gluOrtho2D(gView.left(), gView.right(), gView.bottom(), gView.top());  
-    glMatrixMode(GL_MODELVIEW);    
-  }
+  World::current()->setView(rect);
+  updateProjection();
 }
 
 void lookAt(const Point2& p)
 {
-  gView.moveCenter(p);
-  if (gGLInitialized) {
-    glMatrixMode(GL_PROJECTION);
-      glLoadIdentity();
-      gluOrtho2D(gView.left(), gView.right(), gView.bottom(), gView.top());  
-    glMatrixMode(GL_MODELVIEW);    
-  }
+  Rect2 view = worldView();
+  view.moveCenter(p);
+  World::current()->setView(view);
+  updateProjection();
 }
 
 Rect2 worldView()
 {
-  return gView;
+  return World::current()->view();
 }
 
 
@@ -253,10 +264,10 @@ int ticksLeft(int start_ticks)
 
 void startTimer()
 {
-  gStartTime = getTicks();
+  World::current()->setTimerStart(getTicks());
 }
 
 int stopTimer()
 {
-  return getTicks()-gStartTime;
+  return getTicks()-World::current()->timerStart();
 }
\ No newline at end of file
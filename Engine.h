@@ -27,7 +27,9 @@
 #include "Timing.h"
 #include "Types.h"
 
+#ifndef HEADLESS
 #include <QtCore/QSize>
+#endif
 
 class Shape;
 class Sprite;
@@ -54,8 +56,10 @@ void setDone(bool done);
 void setViewportHeight(int height);
 void setViewportWidth(int width);
 void setViewport(int width, int height);
+#ifndef HEADLESS
 void setViewport(const QSize size);
 QSize getViewport();
+#endif
 void setWorldView(const Rect2& rect);
 void lookAt(const Point2& p);
 Rect2 worldView();
@@ -70,3 +74,4 @@ bool stateOfKey(int key);
 // Operations
 void renderFrame(real start_time);
 void engineEndLoop(real start_time);
+uint32 engineAdvance(real now);
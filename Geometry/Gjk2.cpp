@@ -0,0 +1,549 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <Geometry/Gjk2.hpp>
+#include <Geometry/Circle.hpp>
+#include <Geometry/Segment2.hpp>
+#include <Geometry/Polygon2.hpp>
+#include <Utils/Counters.h>
+
+#include <vector>
+#include <limits>
+#include <cassert>
+
+using namespace std;
+
+/*!
+  \file Gjk2.cpp
+  \brief Distance and penetration of convex shapes with GJK and EPA.
+
+  GJK searches the Minkowski difference B - A for the point closest to the
+  origin, using only the support points of the shapes. Its distance is the
+  distance between the shapes, and the origin is inside when they overlap.
+  Each step costs a pass over the vertices of both shapes, and a handful of
+  steps is usually enough, so it is cheaper than testing every edge normal
+  of both polygons like separating axes do.
+
+  Circles and other rounded shapes are handled as a core (a point, segment
+  or polygon) with a radius. GJK runs on the cores and the radii are
+  subtracted afterwards, so circles need no vertices.
+
+  Pass the same SimplexCache2 for the same pair every frame and the search
+  starts from the simplex it ended with last time. For shapes which have
+  barely moved that is usually the answer, and GJK returns after one step.
+
+  When the cores overlap EPA expands the last simplex until it finds the
+  edge of the Minkowski difference nearest the origin, which gives the
+  penetration depth and the direction to push the shapes apart.
+*/
+
+static const real gEpsilon = 1e-12;       // Squared lengths below this are zero
+static const real gTolerance = 1e-9;      // Distances below this are zero
+static const int  gMaxIterations = 20;    // Steps beyond number of vertices
+
+/*! Point of the Minkowski difference B - A made from vertex a of A and b of B */
+struct SimplexVertex2
+{
+  Point2  pa, pb, w;  // w = pb - pa
+  real    u;          // Barycentric coordinate of closest point
+  int     a, b;
+};
+
+struct Simplex2
+{
+  SimplexVertex2 v[3];
+  int count;
+};
+
+// Helper functions
+static SimplexVertex2 makeVertex(const ConvexShape2& a, const ConvexShape2& b, int ia, int ib)
+{
+  SimplexVertex2 v;
+  v.a = ia;
+  v.b = ib;
+  v.pa = a.vertex(ia);
+  v.pb = b.vertex(ib);
+  v.w = v.pb - v.pa;
+  v.u = 1.0;
+  return v;
+}
+
+/*! Starts from cached simplex if it is still usable, else from first vertices */
+static void readCache(const ConvexShape2& a, const ConvexShape2& b, const SimplexCache2* cache, Simplex2& s)
+{
+  s.count = 0;
+  if (cache != 0 && cache->count > 0 && cache->count <= 3) {
+    for (int i = 0; i < cache->count; ++i) {
+      if (cache->a[i] >= a.size() || cache->b[i] >= b.size()) {
+        s.count = 0;
+        break;
+      }
+      s.v[s.count++] = makeVertex(a, b, cache->a[i], cache->b[i]);
+    }
+  }
+
+  // Shapes may have moved so that the old simplex has collapsed
+  if (s.count == 2 && (s.v[1].w - s.v[0].w).squaredLength() < gEpsilon)
+    s.count = 1;
+  if (s.count == 3 && fabs((s.v[1].w - s.v[0].w).cross(s.v[2].w - s.v[0].w)) < gEpsilon)
+    s.count = 1;
+
+  if (s.count == 0) {
+    s.v[0] = makeVertex(a, b, 0, 0);
+    s.count = 1;
+  }
+}
+
+static void writeCache(const Simplex2& s, SimplexCache2* cache)
+{
+  if (cache == 0)
+    return;
+  cache->count = s.count;
+  for (int i = 0; i < s.count; ++i) {
+    cache->a[i] = s.v[i].a;
+    cache->b[i] = s.v[i].b;
+  }
+}
+
+/*! Reduces segment to the part closest to origin */
+static void solve2(Simplex2& s)
+{
+  const Vector2& w1 = s.v[0].w;
+  const Vector2& w2 = s.v[1].w;
+  Vector2 e12 = w2 - w1;
+
+  real d12_2 = -w1.dot(e12);
+  if (d12_2 <= 0.0) {
+    s.v[0].u = 1.0;
+    s.count = 1;
+    return;
+  }
+
+  real d12_1 = w2.dot(e12);
+  if (d12_1 <= 0.0) {
+    s.v[0] = s.v[1];
+    s.v[0].u = 1.0;
+    s.count = 1;
+    return;
+  }
+
+  real inv = 1.0/(d12_1 + d12_2);
+  s.v[0].u = d12_1*inv;
+  s.v[1].u = d12_2*inv;
+  s.count = 2;
+}
+
+/*! Reduces triangle to the vertex, edge or whole triangle closest to origin */
+static void solve3(Simplex2& s)
+{
+  const Vector2 w1 = s.v[0].w;
+  const Vector2 w2 = s.v[1].w;
+  const Vector2 w3 = s.v[2].w;
+
+  Vector2 e12 = w2 - w1;
+  real d12_1 = w2.dot(e12);
+  real d12_2 = -w1.dot(e12);
+
+  Vector2 e13 = w3 - w1;
+  real d13_1 = w3.dot(e13);
+  real d13_2 = -w1.dot(e13);
+
+  Vector2 e23 = w3 - w2;
+  real d23_1 = w3.dot(e23);
+  real d23_2 = -w2.dot(e23);
+
+  real n123 = e12.cross(e13);
+  real d123_1 = n123*w2.cross(w3);
+  real d123_2 = n123*w3.cross(w1);
+  real d123_3 = n123*w1.cross(w2);
+
+  if (d12_2 <= 0.0 && d13_2 <= 0.0) {
+    s.v[0].u = 1.0;
+    s.count = 1;
+  }
+  else if (d12_1 > 0.0 && d12_2 > 0.0 && d123_3 <= 0.0) {
+    real inv = 1.0/(d12_1 + d12_2);
+    s.v[0].u = d12_1*inv;
+    s.v[1].u = d12_2*inv;
+    s.count = 2;
+  }
+  else if (d13_1 > 0.0 && d13_2 > 0.0 && d123_2 <= 0.0) {
+    real inv = 1.0/(d13_1 + d13_2);
+    s.v[0].u = d13_1*inv;
+    s.v[1] = s.v[2];
+    s.v[1].u = d13_2*inv;
+    s.count = 2;
+  }
+  else if (d12_1 <= 0.0 && d23_2 <= 0.0) {
+    s.v[0] = s.v[1];
+    s.v[0].u = 1.0;
+    s.count = 1;
+  }
+  else if (d13_1 <= 0.0 && d23_1 <= 0.0) {
+    s.v[0] = s.v[2];
+    s.v[0].u = 1.0;
+    s.count = 1;
+  }
+  else if (d23_1 > 0.0 && d23_2 > 0.0 && d123_1 <= 0.0) {
+    real inv = 1.0/(d23_1 + d23_2);
+    s.v[0] = s.v[2];
+    s.v[0].u = d23_2*inv;
+    s.v[1].u = d23_1*inv;
+    s.count = 2;
+  }
+  else {
+    real inv = 1.0/(d123_1 + d123_2 + d123_3);
+    s.v[0].u = d123_1*inv;
+    s.v[1].u = d123_2*inv;
+    s.v[2].u = d123_3*inv;
+    s.count = 3;
+  }
+}
+
+/*! Direction from simplex towards origin */
+static Vector2 searchDirection(const Simplex2& s)
+{
+  if (s.count == 1)
+    return -s.v[0].w;
+
+  Vector2 e12 = s.v[1].w - s.v[0].w;
+  if (e12.cross(-s.v[0].w) > 0.0)
+    return Vector2(-e12.y(), e12.x());
+  else
+    return Vector2(e12.y(), -e12.x());
+}
+
+/*! Closest points on cores of A and B */
+static void witnessPoints(const Simplex2& s, Point2& pa, Point2& pb)
+{
+  pa = Point2(0.0, 0.0);
+  pb = Point2(0.0, 0.0);
+  for (int i = 0; i < s.count; ++i) {
+    pa += s.v[i].u*s.v[i].pa;
+    pb += s.v[i].u*s.v[i].pb;
+  }
+  if (s.count == 3)
+    pb = pa;
+}
+
+/*!
+  Runs GJK on the cores of \a a and \a b. Gives up and returns false as soon
+  as the cores are known to be further apart than \a max_distance.
+*/
+static bool solve(const ConvexShape2& a, const ConvexShape2& b, SimplexCache2* cache, real max_distance, Simplex2& s)
+{
+  readCache(a, b, cache, s);
+
+  bool separated = false;
+  int max_iterations = gMaxIterations + a.size() + b.size();
+  for (int iter = 0; ; ++iter) {
+    COUNT(GJK_ITERATIONS);
+    int old_count = s.count;
+    int old_a[3], old_b[3];
+    for (int i = 0; i < s.count; ++i) {
+      old_a[i] = s.v[i].a;
+      old_b[i] = s.v[i].b;
+    }
+
+    if (s.count == 2)
+      solve2(s);
+    else if (s.count == 3)
+      solve3(s);
+
+    // Origin is inside triangle
+    if (s.count == 3 || iter >= max_iterations)
+      break;
+
+    Vector2 d = searchDirection(s);
+    if (d.squaredLength() < gEpsilon)
+      break;
+
+    SimplexVertex2 v = makeVertex(a, b, a.support(-d), b.support(d));
+
+    // All of B - A lies behind the plane through v facing d
+    real bound = -v.w.dot(d);
+    if (bound > 0.0 && bound*bound > max_distance*max_distance*d.squaredLength()) {
+      separated = true;
+      break;
+    }
+
+    // No progress when we get a vertex we had before
+    bool duplicate = false;
+    for (int i = 0; i < old_count; ++i)
+      if (v.a == old_a[i] && v.b == old_b[i])
+        duplicate = true;
+    if (duplicate)
+      break;
+
+    s.v[s.count++] = v;
+  }
+
+  writeCache(s, cache);
+  return !separated;
+}
+
+/*!
+  Expands triangle \a s containing origin until the edge of B - A nearest the
+  origin is found. \a n is the outward normal of that edge and \a depth its
+  distance from origin. \a pa and \a pb are the matching points on the cores.
+*/
+static bool expand(const ConvexShape2& a, const ConvexShape2& b, const Simplex2& s, Vector2& n, real& depth, Point2& pa, Point2& pb)
+{
+  assert(s.count == 3);
+  vector<SimplexVertex2> poly(s.v, s.v + 3);
+  if ((poly[1].w - poly[0].w).cross(poly[2].w - poly[0].w) < 0.0)
+    swap(poly[1], poly[2]);
+
+  int max_iterations = gMaxIterations + a.size() + b.size();
+  for (int iter = 0; iter <= max_iterations; ++iter) {
+    int best = -1;
+    real best_dist = numeric_limits<real>::max();
+    Vector2 best_n;
+    for (uint32 i = 0; i < poly.size(); ++i) {
+      Vector2 e = poly[(i+1) % poly.size()].w - poly[i].w;
+      real len = e.length();
+      if (len*len < gEpsilon)
+        continue;
+      Vector2 normal(e.y()/len, -e.x()/len);
+      real dist = normal.dot(poly[i].w);
+      if (dist < best_dist) {
+        best = i;
+        best_dist = dist;
+        best_n = normal;
+      }
+    }
+    if (best < 0)
+      return false;
+
+    int next = (best+1) % poly.size();
+    SimplexVertex2 v = makeVertex(a, b, a.support(-best_n), b.support(best_n));
+    bool known = (v.a == poly[best].a && v.b == poly[best].b) || (v.a == poly[next].a && v.b == poly[next].b);
+    if (known || v.w.dot(best_n) - best_dist < gTolerance || iter == max_iterations) {
+      Vector2 e = poly[next].w - poly[best].w;
+      real t = max(0.0, min(-poly[best].w.dot(e)/e.squaredLength(), 1.0));
+      pa = poly[best].pa + t*(poly[next].pa - poly[best].pa);
+      pb = poly[best].pb + t*(poly[next].pb - poly[best].pb);
+      n = best_n;
+      depth = best_dist;
+      return true;
+    }
+    poly.insert(poly.begin() + next, v);
+  }
+  return false;
+}
+
+/*! Support value of B - A in direction \a d */
+static real supportValue(const ConvexShape2& a, const ConvexShape2& b, const Vector2& d)
+{
+  return (b.vertex(b.support(d)) - a.vertex(a.support(-d))).dot(d);
+}
+
+/*! Direction from A to B when cores only touch, so GJK could not tell */
+static Vector2 touchingNormal(const ConvexShape2& a, const ConvexShape2& b, const Simplex2& s)
+{
+  if (s.count == 2) {
+    Vector2 e = s.v[1].w - s.v[0].w;
+    if (e.squaredLength() > gEpsilon) {
+      // Origin is on boundary of B - A, which is flat on the outward side
+      Vector2 n = Vector2(e.y(), -e.x()).unit();
+      if (supportValue(a, b, -n) < supportValue(a, b, n))
+        n = -n;
+      return -n;
+    }
+  }
+  Vector2 d = b.boundingBox().center() - a.boundingBox().center();
+  if (d.squaredLength() < gEpsilon)
+    return Vector2(1.0, 0.0);
+  return d.unit();
+}
+
+/*!
+    \class ConvexShape2 Gjk2.h
+    \brief Convex shape as seen by GJK, a polygon, segment or point with a radius.
+
+    A shape made from a polygon refers to the points of the polygon and must not
+    outlive it or be used after the polygon has been changed. The polygon must
+    be convex, see Polygon2::convexParts(). Other shapes keep their own copy.
+*/
+
+// Constructors
+ConvexShape2::ConvexShape2()
+  : iPoints(0), iSize(1), iRadius(0.0)
+{
+}
+
+ConvexShape2::ConvexShape2(const Polygon2& poly)
+  : iPoints(0), iSize(poly.size()), iRadius(0.0)
+{
+  assert(poly.size() > 0);
+  iPoints = &poly[0];
+}
+
+ConvexShape2::ConvexShape2(const Circle& circle)
+  : iPoints(0), iSize(1), iRadius(circle.radius())
+{
+  iCorners[0] = circle.center();
+}
+
+ConvexShape2::ConvexShape2(const Segment2& seg)
+  : iPoints(0), iSize(2), iRadius(0.0)
+{
+  iCorners[0] = seg.source();
+  iCorners[1] = seg.target();
+}
+
+ConvexShape2::ConvexShape2(const Rect2& rect)
+  : iPoints(0), iSize(4), iRadius(0.0)
+{
+  iCorners[0] = rect.min();
+  iCorners[1] = Point2(rect.xmax(), rect.ymin());
+  iCorners[2] = rect.max();
+  iCorners[3] = Point2(rect.xmin(), rect.ymax());
+}
+
+ConvexShape2::ConvexShape2(const Point2& p, real radius)
+  : iPoints(0), iSize(1), iRadius(radius)
+{
+  iCorners[0] = p;
+}
+
+// Accessors
+int ConvexShape2::size() const
+{
+  return iSize;
+}
+
+const Point2& ConvexShape2::vertex(int i) const
+{
+  assert(i >= 0 && i < iSize);
+  return iPoints ? iPoints[i] : iCorners[i];
+}
+
+/*! Distance the shape extends beyond its vertices */
+real ConvexShape2::radius() const
+{
+  return iRadius;
+}
+
+// Calculations
+/*! Index of vertex furthest in direction \a d */
+int ConvexShape2::support(const Vector2& d) const
+{
+  const Point2* points = iPoints ? iPoints : iCorners;
+  int best = 0;
+  real best_value = points[0].dot(d);
+  for (int i = 1; i < iSize; ++i) {
+    real value = points[i].dot(d);
+    if (value > best_value) {
+      best = i;
+      best_value = value;
+    }
+  }
+  return best;
+}
+
+Rect2 ConvexShape2::boundingBox() const
+{
+  Point2 pmin = vertex(0), pmax = vertex(0);
+  for (int i = 1; i < iSize; ++i) {
+    pmin = pmin.minComponents(vertex(i));
+    pmax = pmax.maxComponents(vertex(i));
+  }
+  Vector2 r(iRadius, iRadius);
+  return Rect2(pmin - r, pmax + r);
+}
+
+// Functions
+/*!
+  Distance between \a a and \a b, 0 if they overlap. \a pa and \a pb are set to
+  the closest points on each shape if given, or both to a point in the overlap.
+*/
+real gjkDistance(const ConvexShape2& a, const ConvexShape2& b, SimplexCache2* cache, Point2* pa, Point2* pb)
+{
+  Simplex2 s;
+  solve(a, b, cache, numeric_limits<real>::max(), s);
+
+  Point2 qa, qb;
+  witnessPoints(s, qa, qb);
+  real r = a.radius() + b.radius();
+  real dist = (qb - qa).length();
+  if (dist > r && dist > gTolerance) {
+    Vector2 n = (qb - qa)/dist;
+    qa += n*a.radius();
+    qb -= n*b.radius();
+  }
+  else {
+    qa = qb = 0.5*(qa + qb);
+  }
+
+  if (pa) *pa = qa;
+  if (pb) *pb = qb;
+  return max(dist - r, 0.0);
+}
+
+/*! True if \a a and \a b overlap or touch */
+bool gjkIntersect(const ConvexShape2& a, const ConvexShape2& b, SimplexCache2* cache)
+{
+  Simplex2 s;
+  real r = a.radius() + b.radius();
+  if (!solve(a, b, cache, r + gTolerance, s))
+    return false;
+  if (s.count == 3)
+    return true;
+
+  Point2 pa, pb;
+  witnessPoints(s, pa, pb);
+  return (pb - pa).length() <= r + gTolerance;
+}
+
+/*!
+  True if \a a and \a b overlap. Then \a normal is the direction to move \a b
+  by \a depth to separate them, and \a point lies midway between the deepest
+  points of each shape.
+*/
+bool gjkPenetration(const ConvexShape2& a, const ConvexShape2& b, Vector2& normal, real& depth, Point2& point, SimplexCache2* cache)
+{
+  Simplex2 s;
+  real r = a.radius() + b.radius();
+  if (!solve(a, b, cache, r + gTolerance, s))
+    return false;
+
+  Point2 pa, pb;
+  witnessPoints(s, pa, pb);
+  real dist = (pb - pa).length();
+  if (dist > r + gTolerance)
+    return false;
+
+  Vector2 n;
+  if (s.count < 3 && dist > gTolerance) {
+    normal = (pb - pa)/dist;
+    depth = r - dist;
+  }
+  else if (s.count == 3 && expand(a, b, s, n, depth, pa, pb)) {
+    normal = -n;
+    depth += r;
+  }
+  else {
+    normal = touchingNormal(a, b, s);
+    depth = r;
+  }
+
+  point = 0.5*((pa + normal*a.radius()) + (pb - normal*b.radius()));
+  return true;
+}
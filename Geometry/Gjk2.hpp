@@ -0,0 +1,70 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include <Core/Core.h>
+
+#include <Geometry/Vector2.hpp>
+#include <Geometry/Rect2.hpp>
+
+class Circle;
+class Segment2;
+class Polygon2;
+
+class ConvexShape2
+{
+public:
+  // Constructors
+  ConvexShape2();
+  ConvexShape2(const Polygon2& poly);
+  ConvexShape2(const Circle& circle);
+  ConvexShape2(const Segment2& seg);
+  ConvexShape2(const Rect2& rect);
+  ConvexShape2(const Point2& p, real radius = 0.0);
+
+  // Accessors
+  int           size() const;
+  const Point2& vertex(int i) const;
+  real          radius() const;
+
+  // Calculations
+  int   support(const Vector2& d) const;
+  Rect2 boundingBox() const;
+
+private:
+  const Point2* iPoints;      // Vertices of polygon, 0 when iCorners are used
+  Point2        iCorners[4];
+  int           iSize;
+  real          iRadius;
+};
+
+/*! Simplex found for a pair of shapes, used to start the next search */
+struct SimplexCache2
+{
+  SimplexCache2() : count(0) {}
+
+  int count;
+  int a[3], b[3];   // Vertex indices in first and second shape
+};
+
+// Functions
+real gjkDistance(const ConvexShape2& a, const ConvexShape2& b, SimplexCache2* cache = 0, Point2* pa = 0, Point2* pb = 0);
+bool gjkIntersect(const ConvexShape2& a, const ConvexShape2& b, SimplexCache2* cache = 0);
+bool gjkPenetration(const ConvexShape2& a, const ConvexShape2& b, Vector2& normal, real& depth, Point2& point, SimplexCache2* cache = 0);
@@ -18,6 +18,7 @@
 */
 
 #include <Geometry/Graph2.hpp>
+#include <Geometry/PathsCache2.hpp>
 
 /*!
     \class Graph2 Graph2.h
@@ -30,6 +31,7 @@
 #include <boost/graph/astar_search.hpp>
 
 #include <set>
+#include <limits>
 #include <algorithm>
 #include <iostream>
 #include <Geometry/IO.hpp>
@@ -37,27 +39,27 @@
 using namespace std;
 using namespace boost;
 
-EdgePair::EdgePair() : tag(0), u(0), v(0)
+EdgePair::EdgePair() : iTag(0), iU(0), iV(0)
 {
   
 }
 
 EdgePair::EdgePair(Trapezoid2* au, Trapezoid2* av, int atag, const Point2& apos)
-  : u(au), v(av), tag(atag), pos(apos)
+  : iTag(atag), iPos(apos), iU(au), iV(av)
 {
   
 }  
 
 EdgeData EdgePair::first() const
 {
-  assert(u != 0);
+  assert(iU != 0);
   
   EdgeData e;
-  e.trap = u;
-  e.upos = u->center();
-  e.vpos = pos;
-  e.utag = u->tag();
-  e.vtag = tag;
+  e.trap = iU;
+  e.upos = iU->center();
+  e.vpos = iPos;
+  e.utag = iU->tag();
+  e.vtag = iTag;
   e.weight = (e.vpos - e.upos).length();
   
   return e;
@@ -65,14 +67,14 @@ EdgeData EdgePair::first() const
 
 EdgeData EdgePair::second() const
 {
-  assert(v != 0);
+  assert(iV != 0);
   
   EdgeData e;
-  e.trap = v;
-  e.upos = pos;
-  e.vpos = v->center();
-  e.utag = tag;
-  e.vtag = v->tag();
+  e.trap = iV;
+  e.upos = iPos;
+  e.vpos = iV->center();
+  e.utag = iTag;
+  e.vtag = iV->tag();
   e.weight = (e.vpos - e.upos).length();
   
   return e;
@@ -85,17 +87,51 @@ EdgeData EdgePair::edge(int index) const
   return index == 0 ? first() : second();
 }
 
+// Accessors
+/*! Trapezoid at end \a index of edge, 0 or 1 */
+Trapezoid2* EdgePair::trapezoid(int index) const
+{
+  assert(index == 0 || index == 1);
+
+  return index == 0 ? iU : iV;
+}
+
+/*! Tag of vertex in middle of edge, on wall between the two trapezoids */
+int EdgePair::tag() const
+{
+  return iTag;
+}
+
+Point2 EdgePair::position() const
+{
+  return iPos;
+}
+
 bool EdgePair::operator==(const EdgePair& data) const
 {
-  return tag == data.tag;
+  return iTag == data.iTag;
+}
+
+// Helper functions
+/*!
+  Edge between neighbors 'left' and 'right' in a roadmap, like
+  Trapezoid:edgeData() in script/trapezoid.lua makes them. It goes
+  through the middle of the wall between them, given by the trapezoid
+  which has the whole wall as its side.
+*/
+EdgePair roadmapEdge(Trapezoid2* left, Trapezoid2* right, int tag)
+{
+  assert(left != 0 && right != 0);
+  bool at_end = left->right() == left->bottom().right() || left->right() == left->top().right();
+  return EdgePair(left, right, tag, at_end ? left->centerRight() : right->centerLeft());
 }
 
 /*! Property data stored in graph roadmap */
 struct EdgeProperty
 {
   EdgeProperty() : weight(0), trapezoid(0) {}
-  EdgeProperty(real aweight, Trapezoid2* atrapezoid) : weight(aweight), trapezoid(atrapezoid) {}
-  real weight;
+  EdgeProperty(::real aweight, Trapezoid2* atrapezoid) : weight(aweight), trapezoid(atrapezoid) {}
+  ::real weight;
   Trapezoid2* trapezoid;
 };
 
@@ -113,7 +149,7 @@ typedef Graph::out_edge_iterator  OutEdgeIterator;
 
 typedef vector<Vertex>  Vertices;
 typedef vector<Edge>    Edges;
-typedef vector<real>    Reals;
+typedef vector< ::real > Reals;
 
 // Helper functions
 
@@ -138,15 +174,15 @@ void printEndGraph()
 struct VizEdge 
 {
   VizEdge();
-  VizEdge(int asource, int atarget, real aweight);
-  VizEdge(int asource, int atarget, real aweight, const string& acolor);
+  VizEdge(int asource, int atarget, ::real aweight);
+  VizEdge(int asource, int atarget, ::real aweight, const string& acolor);
   VizEdge(Edge e, const Graph& g);
   VizEdge(Edge e, const Graph& g, const Vertices& p);  
   
   void print();
     
   int     u, v;
-  real    weight;
+  ::real    weight;
   string  color;
 };
 
@@ -155,13 +191,13 @@ VizEdge::VizEdge() : u(0), v(0), weight(0.0), color("")
   
 }
 
-VizEdge::VizEdge(int asource, int atarget, real aweight) 
+VizEdge::VizEdge(int asource, int atarget, ::real /*aweight*/) 
   : u(asource), v(atarget), weight(atarget), color("grey")
 {
   
 }
 
-VizEdge::VizEdge(int asource, int atarget, real aweight, const string& acolor) 
+VizEdge::VizEdge(int asource, int atarget, ::real aweight, const string& acolor) 
   : u(asource), v(atarget), weight(aweight), color(acolor)
 { 
   
@@ -180,7 +216,7 @@ VizEdge::VizEdge(Edge e, const Graph& g, const Vertices& p)
   u = source(e,g);
   v = target(e, g);
   weight = g[e].weight;
-  if (p[v] == u)
+  if (int(p[v]) == u)
     color = "black";
   else
     color = "grey";    
@@ -206,7 +242,7 @@ Trapezoid2* trapezoid(const Segment2& s)
   return (Trapezoid2*)s.data();
 }
 
-static bool pathFrom(const Graph& g, Vertex t, const Vertices& p, Polygon2& path)
+static bool pathFrom(const Graph& g, Vertex t, const Vertices& p, Points2& path)
 {
   while (t != p[t]) {
     path.push_back(g[t]);
@@ -220,31 +256,69 @@ static bool pathFrom(const Graph& g, Vertex t, const Vertices& p, Polygon2& path
 class PathsImp2 : public Paths2
 {
 public:
-  PathsImp2() : iG(0) {}
-  PathsImp2(size_t noVertices) : iG(0), iDistances(noVertices), iPredecessors(noVertices) {}
+  PathsImp2() : iG(0), iOwner(0), iRevision(0) {}
+  PathsImp2(size_t noVertices) : iG(0), iOwner(0), iRevision(0), iDistances(noVertices), iPredecessors(noVertices) {}
 
-  bool pathFrom(Vertex t, Polygon2& path) const {
-    assert(iG != 0);
-    return ::pathFrom(*iG, t, iPredecessors, path);
+  bool isStale() const {
+    assert(iOwner != 0);
+    return iOwner->revision() != iRevision;
   }
-    
-  bool pathFrom(Trapezoid2* target, Polygon2& path) const {
+
+  /*! 
+    Vertex of 'target'. False if the graph changed since the search, as
+    vertices may then have been added or reused for other trapezoids.
+  */
+  bool lookup(Trapezoid2* target, Vertex& t) const {
     assert(target != 0);
     assert(iG != 0);
+    if (isStale())
+      return false;
+    t = vertex(target->tag(), *iG);
+    return t < iPredecessors.size();
+  }
+
+  /*! 
+    False if there is no path from 'target' to the root. Dijkstra leaves such
+    vertices as their own predecessor, just like the root, but infinitely far.
+  */
+  bool reachableFrom(Trapezoid2* target) const {
+    Vertex t;
+    return lookup(target, t) && iDistances[t] < numeric_limits< ::real >::max();
+  }
+
+  bool pathFrom(Vertex t, Points2& path) const {
+    assert(iG != 0);
+    return ::pathFrom(*iG, t, iPredecessors, path);
+  }
     
-    Vertex t = vertex(target->tag(), *iG);
-    return pathFrom(t, path);
+  bool pathFrom(Trapezoid2* target, Points2& path) const {
+    Vertex t;
+    return reachableFrom(target) && lookup(target, t) && pathFrom(t, path);
+  }
+
+  /*! 
+    Gives the next point to move towards when at 'target' in constant time. 
+    Returns false if 'target' is the root of the tree, in which case 'waypoint'
+    is set to root position. Also false, with 'waypoint' untouched, if the
+    root can't be reached from 'target' or the paths are stale. Tell the
+    cases apart with reachableFrom().
+  */
+  bool nextFrom(Trapezoid2* target, Point2& waypoint) const {
+    Vertex t;
+    if (!reachableFrom(target) || !lookup(target, t))
+      return false;
+    waypoint = (*iG)[iPredecessors[t]];
+    return t != iPredecessors[t];
   }
   
-  real distanceFrom(Vertex t) const {
+  ::real distanceFrom(Vertex t) const {
     return iDistances[t];    
   }
   
-  real distanceFrom(Trapezoid2* target) const {
-    assert(target != 0);
-    assert(iG != 0);
-    Vertex t = vertex(target->tag(), *iG);
-        
+  ::real distanceFrom(Trapezoid2* target) const {
+    Vertex t;
+    if (!lookup(target, t))
+      return numeric_limits< ::real >::max();
     return distanceFrom(t);
   }
   
@@ -260,9 +334,10 @@ public:
   }
   
   void printPathFrom(Trapezoid2* goal) const {
-    assert(iG != 0);
+    Vertex t;
+    if (!lookup(goal, t))
+      return;
     Graph& g = *iG;
-    Vertex t = vertex(goal->tag(), g);
 
     set<Vertex> ps;
     while (t != iPredecessors[t]) {
@@ -292,6 +367,8 @@ public:
   }
 
   Graph*    iG;
+  const Graph2* iOwner;
+  int       iRevision;    // Of iOwner when search was done
   Reals     iDistances;
   Vertices  iPredecessors;  
 };
@@ -304,51 +381,159 @@ public:
   virtual ~GraphImp2();
 
   // Accessors
+  void    setPathsCacheCapacity(size_t capacity);
 
   // Request
+  int     revision() const;
 
   // Operations
+  void    invalidatePaths();
+  void    update(const vector<int>& removed, const Trapezoids2& added);
 
   // Calculations
   Paths2* shortestPaths(Trapezoid2* source) const;
-  bool    shortestPath(Trapezoid2* source, Trapezoid2* target, Polygon2& path) const;
-  bool    fixedLengthPath(Trapezoid2* source, Trapezoid2* target, real distance, Polygon2& path) const;
+  Paths2* cachedShortestPaths(Trapezoid2* goal) const;
+  bool    shortestPath(Trapezoid2* source, Trapezoid2* target, Points2& path) const;
+  bool    fixedLengthPath(Trapezoid2* source, Trapezoid2* target, ::real distance, Points2& path) const;
   bool    chokePoints(Trapezoid2* start_trap, const Trapezoids2& important_loc, ChokePoints& chokepoints) const;
   
   void    printGraph() const;
   
 private:
-  Graph *iGraph;
+  void    addEdge(const EdgePair& edge);
+  Vertex  newVertex();
+
+private:
+  Graph       *iGraph;
+  int          iRevision;
+  PathsCache2 *iPathsCache;
+  Vertices     iFreeVertices;   // Left without edges by update(), to be used again
 };
 
 GraphImp2::GraphImp2( size_t noVerticies, EdgePairs::iterator begin, EdgePairs::iterator end)
+  : iRevision(0)
 {
   iGraph = new Graph(noVerticies);
+  iPathsCache = new PathsCache2(this);
 
-  Graph& g = *iGraph;
-  
   // Add edges to the graph and set the vertex property to the position of the vertex
   EdgePairs::iterator i;
-  for (i = begin; i != end; ++i) {
-    for (int j=0; j<2; ++j) {
-      EdgeData d = i->edge(j);
-      Vertex u = vertex(d.utag, g);
-      Vertex v = vertex(d.vtag, g);
-
-      bool found;
-      Edge e;
-      tie(e, found) = add_edge( u, v, EdgeProperty(d.weight, d.trap), g);
-      g[u] = d.upos;
-      g[v] = d.vpos;          
-    }
-  }  
+  for (i = begin; i != end; ++i)
+    addEdge(*i);
 }
 
 GraphImp2::~GraphImp2()
 {
+  delete iPathsCache;
   delete iGraph;
 }
 
+// Accessors
+void GraphImp2::setPathsCacheCapacity(size_t capacity)
+{
+  iPathsCache->setCapacity(capacity);
+}
+
+// Request
+/*! Incremented every time the graph changes, so cached search results can be discarded */
+int GraphImp2::revision() const
+{
+  return iRevision;
+}
+
+// Operations
+void GraphImp2::invalidatePaths()
+{
+  iPathsCache->invalidate();
+}
+
+/*!
+  Changes the roadmap after segments have been inserted into or removed
+  from the trapezoidal map, see TrapezoidalMap2::remove(const Segment2&).
+  Vertices of trapezoids with tags in 'removed', and the vertices of their
+  edges, lose their edges. Trapezoids in 'added' which are in the map get
+  a vertex and are connected to their neighbors with roadmapEdge(). Their
+  tags are set to their vertex, reusing vertices left without edges.
+
+  Only the changed part of the graph is touched. Paths found before are
+  for the old graph, and the paths cache is emptied.
+*/
+void GraphImp2::update(const vector<int>& removed, const Trapezoids2& added)
+{
+  Graph& g = *iGraph;
+
+  // Trapezoid vertices are only connected to the vertices in the middle of their edges
+  set<Vertex> freed;
+  vector<int>::const_iterator r;
+  for (r = removed.begin(); r != removed.end(); ++r) {
+    if (*r < 0 || size_t(*r) >= num_vertices(g))
+      continue;
+    Vertex u = vertex(*r, g);
+    OutEdgeIterator ei, ee;
+    for (tie(ei, ee) = out_edges(u, g); ei != ee; ++ei)
+      freed.insert(target(*ei, g));
+    freed.insert(u);
+  }
+  for (set<Vertex>::iterator v = freed.begin(); v != freed.end(); ++v)
+    clear_vertex(*v, g);
+  iFreeVertices.insert(iFreeVertices.end(), freed.rbegin(), freed.rend());
+
+  set<Trapezoid2*> in_map;
+  Trapezoids2::const_iterator t;
+  for (t = added.begin(); t != added.end(); ++t) {
+    if ((*t)->node() == 0)
+      continue;
+    Vertex u = newVertex();
+    (*t)->setTag(u);
+    g[u] = (*t)->center();
+    in_map.insert(*t);
+  }
+
+  // Edges between two added trapezoids are added from the left one only
+  for (set<Trapezoid2*>::iterator a = in_map.begin(); a != in_map.end(); ++a) {
+    Trapezoids2 ns = (*a)->rightNeighbors();
+    for (Trapezoids2::iterator n = ns.begin(); n != ns.end(); ++n)
+      addEdge(roadmapEdge(*a, *n, newVertex()));
+    ns = (*a)->leftNeighbors();
+    for (Trapezoids2::iterator n = ns.begin(); n != ns.end(); ++n)
+      if (in_map.find(*n) == in_map.end())
+        addEdge(roadmapEdge(*n, *a, newVertex()));
+  }
+
+  // Removing edges counts as a change too, even when nothing was added
+  ++iRevision;
+  invalidatePaths();
+}
+
+void GraphImp2::addEdge(const EdgePair& edge)
+{
+  Graph& g = *iGraph;
+  for (int j=0; j<2; ++j) {
+    EdgeData d = edge.edge(j);
+    Vertex u = vertex(d.utag, g);
+    Vertex v = vertex(d.vtag, g);
+
+    bool found;
+    Edge e;
+    tie(e, found) = add_edge( u, v, EdgeProperty(d.weight, d.trap), g);
+    g[u] = d.upos;
+    g[v] = d.vpos;          
+  }
+  ++iRevision;
+}
+
+/*! Vertex left without edges by update(), or a new one */
+Vertex GraphImp2::newVertex()
+{
+  ++iRevision;
+  if (iFreeVertices.empty())
+    return add_vertex(*iGraph);
+
+  Vertex v = iFreeVertices.back();
+  iFreeVertices.pop_back();
+  return v;
+}
+
 Graph2* Graph2::create( size_t noVerticies, EdgePairs::iterator begin, EdgePairs::iterator end)
 {
   return new GraphImp2(noVerticies, begin, end);
@@ -376,23 +561,36 @@ Paths2* GraphImp2::shortestPaths(Trapezoid2* source) const
   Reals&   d = paths->iDistances;
   Vertices& p = paths->iPredecessors;
   paths->iG = iGraph;    
+  paths->iOwner = this;
+  paths->iRevision = iRevision;
   
   dijkstra(g, s, p, d);
     
   return paths;
 }
 
+/*!
+  Same as shortestPaths() except the paths tree is shared with all other callers
+  asking for the same 'goal', and owned by the graph. Retain it to keep it around
+  past the next change of the graph.
+*/
+Paths2* GraphImp2::cachedShortestPaths(Trapezoid2* goal) const
+{
+  assert(goal != 0);
+  return iPathsCache->shortestPaths(goal);
+}
+
 /*!
   Used by A* search algorithm to give an estimate of how far from the goal vertex
   a given vertex is. This functor compares the geometric distance between the vertices.
 */
 struct DistanceHeuristic
 {
-  DistanceHeuristic(Graph* agraph, Vertex agoal) : graph(agraph), goal(agoal)
+  DistanceHeuristic(Graph* agraph, Vertex agoal) : goal(agoal), graph(agraph)
   {    
   }
   
-  real operator()(Vertex v) 
+  ::real operator()(Vertex v) 
   {
     Graph& g = *graph;
     return (g[goal]-g[v]).length();
@@ -431,7 +629,7 @@ struct GoalVisitor : public boost::default_astar_visitor
   }
   
   template <class GraphType>
-  void examine_vertex(Vertex u, GraphType& g) {
+  void examine_vertex(Vertex u, GraphType& /*g*/) {
     if(u == goal)
       throw FoundGoalException();
   }
@@ -439,7 +637,7 @@ struct GoalVisitor : public boost::default_astar_visitor
   Vertex goal;
 };
 
-bool GraphImp2::shortestPath(Trapezoid2* source, Trapezoid2* target, Polygon2& path) const
+bool GraphImp2::shortestPath(Trapezoid2* source, Trapezoid2* target, Points2& path) const
 {
   assert(iGraph != 0);
   assert(source != 0 && target != 0);
@@ -481,7 +679,7 @@ bool GraphImp2::shortestPath(Trapezoid2* source, Trapezoid2* target, Polygon2& p
   return false;
 }
 
-bool GraphImp2::fixedLengthPath(Trapezoid2* source, Trapezoid2* target, real distance, Polygon2& path) const
+bool GraphImp2::fixedLengthPath(Trapezoid2* source, Trapezoid2* target, ::real distance, Points2& path) const
 {
   assert(iGraph != 0);
   assert(source != 0);
@@ -491,7 +689,7 @@ bool GraphImp2::fixedLengthPath(Trapezoid2* source, Trapezoid2* target, real dis
   Vertex vs, vc;  // 'vertex selected' and 'vertex candidate'
   Vertex s, t;    // source vertex and target vertex
   Edge es, ec;    //  'edge selected' and 'edge candidate'
-  real ds, dc;        // 'distance selected'
+  ::real ds, dc;        // 'distance selected'
   
   vs = s = vertex(source->tag(), g);
   t = vertex(target->tag(), g);
@@ -502,8 +700,8 @@ bool GraphImp2::fixedLengthPath(Trapezoid2* source, Trapezoid2* target, real dis
   dijkstra(g, t, p, d);
 
   // Check if the shortest path has the desired length or is too long
-  real cur_dist = d[s];
-  real accum_dist = 0.0;
+  ::real cur_dist = d[s];
+  ::real accum_dist = 0.0;
   
   if (cur_dist > distance)
     return false;
@@ -547,7 +745,7 @@ bool GraphImp2::fixedLengthPath(Trapezoid2* source, Trapezoid2* target, real dis
   return true;
 }
 
-static bool isSmall(Vertex vi, const Graph& g)
+static bool isSmall(Vertex /*vi*/, const Graph& /*g*/)
 {
   return false;
 }
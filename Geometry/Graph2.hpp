@@ -20,6 +20,7 @@
 #pragma once
 
 #include <Core/Core.h>
+#include <Core/SharedObject.hpp>
 #include <Geometry/Vector2.hpp>
 #include <Geometry/Trapezoid2.hpp>
 
@@ -50,22 +51,42 @@ public:
   EdgeData first() const;
   EdgeData second() const;
   EdgeData edge(int index) const;
+
+  // Accessors
+  Trapezoid2* trapezoid(int index) const;
+  int         tag() const;
+  Point2      position() const;
   
   // Operators
   bool operator==(const EdgePair& data) const;
   
 private:
-  int         tag;
-  Point2      pos;
-  Trapezoid2 *u, *v;
+  int         iTag;
+  Point2      iPos;
+  Trapezoid2 *iU, *iV;
 };
 
 typedef vector<EdgePair> EdgePairs;
 
-class Paths2 
+// Helper functions
+EdgePair roadmapEdge(Trapezoid2* left, Trapezoid2* right, int tag);
+
+/*! 
+  Shortest path tree produced by a single dijkstra search. Paths are reference counted 
+  so the same tree can be shared between a PathsCache2 and any number of agents.
+  
+  Once the graph changes the tree is stale: isStale() is true, no paths are
+  found and distances are infinite. Ask the graph for a new tree then.
+*/
+class Paths2 : public SharedObject
 {
 public:
+  virtual ~Paths2() {}
+  
+  virtual bool isStale() const = 0;
+  virtual bool reachableFrom(Trapezoid2* target) const = 0;
   virtual bool pathFrom(Trapezoid2* target, Points2& path) const = 0;
+  virtual bool nextFrom(Trapezoid2* target, Point2& waypoint) const = 0;
   virtual real distanceFrom(Trapezoid2* target) const = 0;  
   virtual void printPathFrom(Trapezoid2* trap) const = 0;
   virtual void printGraph() const = 0;    
@@ -80,13 +101,17 @@ public:
   
   // Creation
   static Graph2* create( size_t noVerticies, EdgePairs::iterator begin, EdgePairs::iterator end);
+  virtual ~Graph2() {}
   
   // Accessors
+  virtual void    setPathsCacheCapacity(size_t capacity) = 0;  
 
   // Request
+  virtual int     revision() const = 0;
 
   // Calculations
   virtual Paths2* shortestPaths(Trapezoid2* source) const = 0;
+  virtual Paths2* cachedShortestPaths(Trapezoid2* goal) const = 0;
   virtual bool    shortestPath(Trapezoid2* source, Trapezoid2* target, Points2& path) const = 0;  
   virtual bool    fixedLengthPath(Trapezoid2* source, Trapezoid2* target, real distance, Points2& path) const = 0;
   virtual bool    chokePoints(Trapezoid2* start_trap, const Trapezoids2& important_loc, ChokePoints& chokepoints) const = 0;
@@ -94,6 +119,7 @@ public:
   virtual void    printGraph() const = 0;
   
   // Operations
-    
+  virtual void    invalidatePaths() = 0;
+  virtual void    update(const vector<int>& removed, const Trapezoids2& added) = 0;
 };
 
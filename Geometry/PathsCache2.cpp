@@ -0,0 +1,132 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <Geometry/PathsCache2.hpp>
+#include <Geometry/Graph2.hpp>
+#include <Geometry/Trapezoid2.hpp>
+
+#include <cassert>
+
+/*!
+    \class PathsCache2 PathsCache2.h
+    \brief Keeps the shortest path trees for the most recently used goals.
+
+    Since the roadmap graph is undirected a dijkstra search started at a goal
+    gives the shortest path from every vertex to that goal. All agents heading
+    for the same goal can thus share one Paths2 object, and read their next
+    waypoint with Paths2::nextFrom() instead of doing a search each.
+    
+    Trees are keyed by the tag of the goal trapezoid and the least recently used
+    tree is evicted when the cache is full. The whole cache is flushed when
+    the revision of the graph changes.
+    
+    Paths returned are owned by the cache. Call retain() on them if they
+    need to outlive the next call to shortestPaths() or invalidate().
+*/
+
+// Constructors
+PathsCache2::PathsCache2(const Graph2* graph, size_t capacity) 
+  : iGraph(graph), iCapacity(capacity), iRevision(graph->revision())
+{
+  assert(iGraph != 0);
+  assert(iCapacity > 0);
+}
+
+PathsCache2::~PathsCache2()
+{
+  // Graph might be gone already, so don't ask it for its revision
+  evict(0);
+}
+
+// Accessors
+size_t PathsCache2::capacity() const
+{
+  return iCapacity;
+}
+
+void PathsCache2::setCapacity(size_t capacity)
+{
+  assert(capacity > 0);
+  iCapacity = capacity;
+  evict(iCapacity);
+}
+
+size_t PathsCache2::size() const
+{
+  return iEntries.size();
+}
+
+// Request
+bool PathsCache2::contains(Trapezoid2* goal) const
+{
+  assert(goal != 0);
+  return iRevision == iGraph->revision() && iIndex.find(goal->tag()) != iIndex.end();
+}
+
+// Calculations
+/*! 
+  Returns shortest path tree towards 'goal'. Only does a search if tree is 
+  not already cached. 
+*/
+Paths2* PathsCache2::shortestPaths(Trapezoid2* goal)
+{
+  assert(goal != 0);
+  validate();
+  
+  EntryIndex::iterator i = iIndex.find(goal->tag());
+  if (i != iIndex.end()) {
+    // Move to front so it is evicted last
+    iEntries.splice(iEntries.begin(), iEntries, i->second);
+    return iEntries.front().second;
+  }
+  
+  Paths2* paths = iGraph->shortestPaths(goal);
+  if (paths == 0)
+    return 0;
+    
+  evict(iCapacity-1);
+  iEntries.push_front(make_pair(goal->tag(), paths));
+  iIndex[goal->tag()] = iEntries.begin();
+  
+  return paths;
+}
+
+// Operations
+void PathsCache2::invalidate()
+{
+  evict(0);
+  iRevision = iGraph->revision();
+}
+
+// Private
+void PathsCache2::evict(size_t capacity)
+{
+  while (iEntries.size() > capacity) {
+    iIndex.erase(iEntries.back().first);
+    iEntries.back().second->release();
+    iEntries.pop_back();
+  }
+}
+
+/*! Flush cache if graph has changed since trees where computed */
+void PathsCache2::validate()
+{
+  if (iRevision != iGraph->revision())
+    invalidate();
+}
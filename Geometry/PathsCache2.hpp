@@ -0,0 +1,67 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include <Core/Core.h>
+
+#include <list>
+#include <map>
+
+using namespace std;
+
+class Graph2;
+class Paths2;
+class Trapezoid2;
+
+class PathsCache2
+{
+public:
+  // Constructors
+  PathsCache2(const Graph2* graph, size_t capacity = 8);
+  ~PathsCache2();
+
+  // Accessors
+  size_t  capacity() const;
+  void    setCapacity(size_t capacity);
+  size_t  size() const;
+
+  // Request
+  bool    contains(Trapezoid2* goal) const;
+
+  // Calculations
+  Paths2* shortestPaths(Trapezoid2* goal);
+
+  // Operations
+  void    invalidate();
+
+private:
+  typedef pair<int, Paths2*>          Entry;
+  typedef list<Entry>                 Entries;
+  typedef map<int, Entries::iterator> EntryIndex;
+
+  void    evict(size_t capacity);
+  void    validate();
+
+  const Graph2* iGraph;
+  size_t        iCapacity;
+  int           iRevision;
+  Entries       iEntries; // Most recently used first
+  EntryIndex    iIndex;
+};
@@ -11,6 +11,8 @@
 #include <Utils/PolygonUtils.h>
 
 #include <algorithm>
+#include <cmath>
+#include <iostream>
 
 using namespace std;
 
@@ -107,6 +109,37 @@ bool Polygon2::inside(const Point2& q) const
   return r.noIntersections(*this) == 1;
 }
 
+/*! Positive if path 'a', 'b', 'c' turns left at 'b', negative if it turns right */
+static real turn(const Point2& a, const Point2& b, const Point2& c)
+{
+  return (b-a).cross(c-b);
+}
+
+/*! 
+  True if every corner turns the same way and the corners turn one full
+  round in total, so star polygons are not convex. Straight corners are 
+  allowed, so the polygon can be used with intersect() and inside()
+*/
+bool Polygon2::isConvex() const
+{
+  int n = size();
+  int side = 0;
+  real total = 0.0;
+  for (int i = 0; i < n; ++i) {
+    const Point2& a = iPoints[(i+n-1) % n];
+    const Point2& b = iPoints[i];
+    const Point2& c = iPoints[(i+1) % n];
+    real t = turn(a, b, c);
+    total += atan2(t, (b-a).dot(c-b));
+    if (t == 0.0)
+      continue;
+    if (side != 0 && (t > 0.0) != (side > 0))
+      return false;
+    side = t > 0.0 ? 1 : -1;
+  }
+  return side == 0 || fabs(fabs(total) - 2.0*M_PI) < 1e-6;
+}
+
 // Calculations
 /*!
   Calculates bounding box for polygon
@@ -144,11 +177,11 @@ void Polygon2::minkowskiSum(const Polygon2& other, Polygon2& result) const
   int j = 0;
   int n = size() - 1;
   int m = other.size() - 1;
-  v[n+1] = v[1];
-  w[m+1] = w[1];
+  v[n+1] = v[0];
+  w[m+1] = w[0];
     
-  v[n+2] = v[2]; // Book bug: Must cover second since when j=m+1 or i=n+1, 
-  w[m+2] = w[2]; // the other one might not have been reached.
+  v[n+2] = v[1]; // Book bug: Must cover second since when j=m+1 or i=n+1, 
+  w[m+2] = w[1]; // the other one might not have been reached.
                  // j+1 and i+1 will be accesses which might
                  // potentially be m+2 or n+2.
     
@@ -183,6 +216,148 @@ void Polygon2::minkowskiSum(const Polygon2& other, Polygon2& result) const
   while (i != n + 1 || j != m + 1);
 }
 
+/*! True if corners 'v' of 'ps', going counter clockwise, make a convex polygon */
+static bool isConvexPart(const Points2& ps, const vector<int>& v)
+{
+  int n = v.size();
+  for (int i = 0; i < n; ++i)
+    if (turn(ps[v[(i+n-1) % n]], ps[v[i]], ps[v[(i+1) % n]]) < 0.0)
+      return false;
+  return true;
+}
+
+/*! True if corner 'i' of counter clockwise polygon 'v' can be clipped off as a triangle */
+static bool isEar(const Points2& ps, const vector<int>& v, int i)
+{
+  int n = v.size();
+  const Point2& a = ps[v[(i+n-1) % n]];
+  const Point2& b = ps[v[i]];
+  const Point2& c = ps[v[(i+1) % n]];
+  if (turn(a, b, c) <= 0.0)
+    return false;
+
+  for (int j = 0; j < n; ++j) {
+    if (j == i || j == (i+n-1) % n || j == (i+1) % n)
+      continue;
+    const Point2& p = ps[v[j]];
+    if (turn(a, b, p) >= 0.0 && turn(b, c, p) >= 0.0 && turn(c, a, p) >= 0.0)
+      return false;
+  }
+  return true;
+}
+
+/*! Index of part in 'parts' going from corner 'a' straight to 'b', or -1 */
+static int findEdge(const vector< vector<int> >& parts, int a, int b)
+{
+  for (int i = 0; i < int(parts.size()); ++i) {
+    const vector<int>& v = parts[i];
+    int n = v.size();
+    for (int j = 0; j < n; ++j)
+      if (v[j] == a && v[(j+1) % n] == b)
+        return i;
+  }
+  return -1;
+}
+
+/*! 
+  Joins part 'p' going from 'a' to 'b' and part 'q' going from 'b' to 'a'
+  into one part without diagonal 'a' 'b'. Only 'b' is needed to line them up.
+*/
+static void join(const vector<int>& p, const vector<int>& q, int b, vector<int>& result)
+{
+  int n = p.size(), m = q.size();
+  int i = find(p.begin(), p.end(), b) - p.begin();
+  for (int k = 0; k < n; ++k)
+    result.push_back(p[(i+k) % n]);   // 'b' to 'a'
+  int j = find(q.begin(), q.end(), b) - q.begin();
+  for (int k = 2; k < m; ++k)
+    result.push_back(q[(j+k) % m]);   // After 'a' and before 'b'
+}
+
+/*!
+  Splits polygon into convex parts with the Hertel-Mehlhorn algorithm.
+  The polygon is cut into triangles by clipping ears, and then each
+  diagonal is taken away again if the two parts on either side of it
+  make a convex part together. That gives at most four times as many
+  parts as needed, in O(n^2) time for n corners. Polygon must be simple,
+  but may go either way around. Parts go counter clockwise.
+
+  Used for collision polygons, as intersect() and inside() only work for
+  convex polygons. A convex polygon gives itself.
+*/
+void Polygon2::convexParts(Polygons2& parts) const
+{
+  parts.clear();
+  int n = size();
+  if (n < 4 || isConvex()) {
+    parts.push_back(*this);
+    return;
+  }
+
+  real area = 0.0;
+  for (int i = 0; i < n; ++i)
+    area += iPoints[i].cross(iPoints[(i+1) % n]);
+  vector<int> v(n);
+  for (int i = 0; i < n; ++i)
+    v[i] = area > 0.0 ? i : n-1-i;
+
+  // Ear clipping, each ear leaves a diagonal behind
+  vector< vector<int> > pieces;
+  vector< pair<int, int> > diagonals;
+  while (v.size() > 3) {
+    int m = v.size();
+    int ear = 0;
+    while (ear < m && !isEar(iPoints, v, ear))
+      ++ear;
+    if (ear == m) {
+      // Straight corners are not ears, but can be left out
+      for (ear = 0; ear < m; ++ear)
+        if (turn(iPoints[v[(ear+m-1) % m]], iPoints[v[ear]], iPoints[v[(ear+1) % m]]) == 0.0)
+          break;
+      if (ear == m) {
+        cerr << "Error could not split polygon into convex parts. It intersects itself" << endl;
+        parts.assign(1, *this);
+        return;
+      }
+      v.erase(v.begin()+ear);
+      continue;
+    }
+
+    vector<int> triangle(3);
+    triangle[0] = v[(ear+m-1) % m];
+    triangle[1] = v[ear];
+    triangle[2] = v[(ear+1) % m];
+    pieces.push_back(triangle);
+    diagonals.push_back(make_pair(triangle[2], triangle[0]));
+    v.erase(v.begin()+ear);
+  }
+  pieces.push_back(v);
+
+  // Take away diagonals not needed to keep parts convex
+  vector< pair<int, int> >::iterator d;
+  for (d = diagonals.begin(); d != diagonals.end(); ++d) {
+    int p = findEdge(pieces, d->first, d->second);
+    int q = findEdge(pieces, d->second, d->first);
+    if (p < 0 || q < 0 || p == q)
+      continue;
+    vector<int> joined;
+    join(pieces[p], pieces[q], d->second, joined);
+    if (isConvexPart(iPoints, joined)) {
+      pieces[p].swap(joined);
+      pieces[q].clear();
+    }
+  }
+
+  vector< vector<int> >::iterator it;
+  for (it = pieces.begin(); it != pieces.end(); ++it) {
+    if (it->empty())
+      continue;
+    parts.push_back(Polygon2());
+    for (vector<int>::iterator i = it->begin(); i != it->end(); ++i)
+      parts.back().push_back(iPoints[*i]);
+  }
+}
+
 // Operations
 void Polygon2::push_back(const Vector2& p)
 {
@@ -43,10 +43,12 @@ public:
   bool intersect(const Rect2& rect) const;
 
   bool inside(const Point2& q) const;
+  bool isConvex() const;
   
   // Calculations
   Rect2 boundingBox() const;
   void  minkowskiSum(const Polygon2& other, Polygon2& result) const;  
+  void  convexParts(std::vector<Polygon2>& parts) const;
   
   // Operations
   void push_back(const Vector2& p);
@@ -63,6 +65,8 @@ private:
   Points2 iPoints;
 };
 
+typedef std::vector<Polygon2> Polygons2;
+
 template<typename ForwardIterator>
 Polygon2::Polygon2(ForwardIterator first, ForwardIterator last) : iPoints(first, last)
 {
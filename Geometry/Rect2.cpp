@@ -13,6 +13,7 @@
 */
 
 #include <Geometry/Rect2.hpp>
+#include <Utils/Counters.h>
 
 // Constructors
 Rect2::Rect2() 
@@ -108,7 +109,8 @@ Rect2 Rect2::surround(const Vector2& aV) const
     \param aRect2 the Rect2 to test overlap with
  */
 bool Rect2::intersect(const Rect2 &aRect2) const {
-    
+    COUNT(RECT_TESTS);
+
     // d is distance and h is halfsize. Almost like intersection test for circles
     // halfsize coresponds to radius
     Vector2 d = (aRect2.center() - center()).abs();
@@ -126,7 +128,7 @@ bool Rect2::intersect(const Rect2 &aRect2) const {
 */
 bool Rect2::inside(const Point2& aP) const
 {
-  return min().isMin(aP) && max().isMax(aP) || (aP == min() || aP == max());
+  return (min().isMin(aP) && max().isMax(aP)) || (aP == min() || aP == max());
 }
 
 Rect2 Rect2::translated(real dx, real dy) const
@@ -1,5 +1,6 @@
 #include <Geometry/Segment2.hpp>
 #include <cmath>
+#include <stdint.h>
 
 #include <iostream>
 
@@ -80,12 +81,12 @@ real Segment2::ymax() const
 
 int Segment2::tag() const
 {
-  return (int)data();
+  return (int)(intptr_t)data();
 }
 
 void  Segment2::setTag(int tag)
 {
-  setData((void*)tag);
+  setData((void*)(intptr_t)tag);
 }
 
 /*! 
@@ -20,6 +20,7 @@
 #include <Geometry/Trapezoid2.hpp>
 
 #include <iostream>
+#include <cassert>
 
 using namespace std;
 
@@ -40,7 +41,7 @@ int opposite(Trapezoid2::Side side) {
 // Debug
 static int nextTag()
 {
-  return gTag++;
+  return __sync_fetch_and_add(&gTag, 1);  // Maps may be built on several threads
 }
 
 /*!
@@ -87,15 +88,9 @@ Trapezoid2::Trapezoid2(const Point2& p, const Point2& q, const Segment2& bottom,
   iTag = nextTag();
 }
 
+/*! Neighbors are not deleted, they are owned by the trapezoidal map */
 Trapezoid2::~Trapezoid2() 
 {
-  delete iNeighbor[0];
-  if (iNeighbor[1] != iNeighbor[0]) delete iNeighbor[1];
-  if (iNeighbor[0] != iNeighbor[2]) delete iNeighbor[2];
-  if (iNeighbor[3] != iNeighbor[2]) delete iNeighbor[3];
-  
-  // Debug
-  cout << "releasing trapezoid: " << iTag << endl;
 }
 
 // Accessors
@@ -449,9 +444,7 @@ real Trapezoid2::distance(Trapezoid2* t) const
 */
 Trapezoid2* Trapezoid2::clone(const Point2& p, const Point2& q, const Segment2& bottom, const Segment2& top) const
 {
-  cout << "CLONE: begin" << endl;
   Trapezoid2* t = new Trapezoid2(p, q, bottom, top);
-  cout << t->tag() << " is clone of " << this->tag() << endl;
   // t->setNeighbors(iNeighbor[0], iNeighbor[1], iNeighbor[2], iNeighbor[3]);
   // Trapezoids2 ts = t->neighbors();
   // Trapezoids2::iterator i;
@@ -471,7 +464,6 @@ Trapezoid2* Trapezoid2::clone(const Point2& p, const Point2& q, const Segment2&
       }
     }
   }
-  cout << "CLONE: end" << endl;  
   return t;
 }
 
@@ -488,15 +480,10 @@ void Trapezoid2::connect(int side, Trapezoid2* st)
   assert((side == 0 || side == 1) && ct != 0 && st != 0);
   
   if (ct->top() == st->top()) {
-    cout << "CONNECT: " << ct->tag() << " side " << side << " upper to "  << st->tag() << endl; // DEBUG
-    cout << "CONNECT: " << st->tag() << " side " << opposite(side) << " upper to "  << ct->tag() << endl; // DEBUG    
     ct->setNeighbor(side, 1, st);
     st->setNeighbor(opposite(side), 1, ct);
   }
   if (ct->bottom() == st->bottom()) {
-    cout << "CONNECT: " << ct->tag() << " side " << side << " lower to "  << st->tag() << endl; // DEBUG
-    cout << "CONNECT: " << st->tag() << " side " << opposite(side) << " loewr to "  << ct->tag() << endl; // DEBUG    
-
     ct->setNeighbor(side, 0, st);
     st->setNeighbor(opposite(side), 0, ct);
   }  
@@ -521,12 +508,14 @@ void Trapezoid2::cleanup(Trapezoids2::iterator begin, Trapezoids2::iterator end)
         t->setNeighbor(j, 0);                
       }      
 
-    for (j=0; j<4; j+=2)
-      if (t->neighbor(j) != t->neighbor(j+1))
+    for (j=0; j<4; j+=2) {
+      if (t->neighbor(j) != t->neighbor(j+1)) {
         if (t->neighbor(j) == 0)
           t->setNeighbor(j, t->neighbor(j+1));
         else if (t->neighbor(j+1) == 0)
           t->setNeighbor(j+1, t->neighbor(j));           
+      }
+    }
   } 
   // cout << "CLEANUP: end" << endl; // DEBUG       
 }
@@ -25,6 +25,7 @@
 #include <sstream>
 #include <stack>
 #include <map>
+#include <set>
 
 #include <cassert>
 
@@ -73,12 +74,12 @@ public:
     }
 
     // Request
-    virtual TrapezoidNode2* find(const Point2& p)
+    virtual TrapezoidNode2* find(const Point2& /*p*/)
     {
       return 0;
     } 
        
-    virtual TrapezoidNode2* find(const Segment2& s)
+    virtual TrapezoidNode2* find(const Segment2& /*s*/)
     {
       return 0;
     }
@@ -92,29 +93,18 @@ public:
     
     virtual void replaceWith(TrapezoidNode2* n)
     {
-      cout << "begin replace " << this->tag() << " with "; // DEBUG
-      if (n)
-        cout << n->tag() << endl; // DEBUG
-      else
-        cout << "NULL" << endl; // DEBUG
-        
       TrapezoidNodes2::iterator i;
       for (i = iParents.begin(); i != iParents.end(); ++i) {
         TrapezoidNode2* parent = *i;
-        if (parent->left() == this) {
-          cout << "changing left of " << parent->tag() << endl; // DEBUG
+        if (parent->left() == this)
           parent->setLeft(n);          
-        }
-        else if (parent->right() == this) {
-          cout << "changing right of " << parent->tag() << endl; // DEBUG
+        else if (parent->right() == this)
           parent->setRight(n);              
-        }
       }
       iKids[0] = 0;
       iKids[1] = 0;
       iParents.clear();
       delete this;
-      cout << "end replace with" << endl; // DEBUG
     }    
     
     // Accessors
@@ -122,6 +112,11 @@ public:
     {
       return iTrapezoid;
     }
+
+    TrapezoidNodeType type() const
+    {
+      return LEAF_NODE;
+    }
     
     // Debug
     virtual std::string description() const
@@ -228,6 +223,18 @@ Trapezoid2*  TrapezoidNode2::trapezoid() const
   return 0;
 }
 
+/*!
+  Fills in type and points of \a r. Children and trapezoid are references
+  to other objects, which the caller turns into indices.
+*/
+void TrapezoidNode2::getRecord(TrapezoidNodeRecord& r) const
+{
+  r.type = type();
+  r.kids[0] = r.kids[1] = -1;
+  r.trapezoid = -1;
+  r.points[0] = r.points[1] = Point2();
+}
+
 // Calculations
 TrapezoidNode2* TrapezoidNode2::locate(const Point2& p)
 {
@@ -247,9 +254,13 @@ TrapezoidNode2* TrapezoidNode2::locate(const Segment2& s)
   return node;
 }
 
+/*!
+  Trapezoids at the leafs below this node. Nodes are shared by several
+  parents, so each is visited once to get every trapezoid only once.
+*/
 void TrapezoidNode2::getTrapezoids(Trapezoids2& out) const
 {  
-  // copy(beginTrapezoid(), endTrapezoid(), back_inserter(out));
+  set<const TrapezoidNode2*> visited;
   TrapezoidNodes2 visit;
   if (this->left())
     visit.push_back(this->left());
@@ -259,6 +270,8 @@ void TrapezoidNode2::getTrapezoids(Trapezoids2& out) const
   while(!visit.empty()) {
     TrapezoidNode2* n = visit.back();
     visit.pop_back();    
+    if (!visited.insert(n).second)
+      continue;
     if (n->left() || n->right()) {
       if (n->left())
         visit.push_back(n->left());
@@ -310,6 +323,19 @@ public:
     // Constructors
     SegmentNode(const Segment2& s) { iSegment = s; }
     
+    // Accessors
+    TrapezoidNodeType type() const
+    {
+      return SEGMENT_NODE;
+    }
+
+    void getRecord(TrapezoidNodeRecord& r) const
+    {
+      TrapezoidNode2::getRecord(r);
+      r.points[0] = iSegment.source();
+      r.points[1] = iSegment.target();
+    }
+
     // Request
     virtual TrapezoidNode2* find(const Point2& p)
     {
@@ -333,7 +359,7 @@ public:
     }
         
     // Operations
-    void replaceWith(TrapezoidNode2* n)
+    void replaceWith(TrapezoidNode2* /*n*/)
     {
       cerr << "SegmentNode does not support replacing!" << endl;
     }
@@ -356,6 +382,18 @@ public:
     // Constructors
     PointNode(const Point2& p) { iPoint = p; }
 
+    // Accessors
+    TrapezoidNodeType type() const
+    {
+      return POINT_NODE;
+    }
+
+    void getRecord(TrapezoidNodeRecord& r) const
+    {
+      TrapezoidNode2::getRecord(r);
+      r.points[0] = iPoint;
+    }
+
     // Request
     virtual TrapezoidNode2* find(const Point2& p)
     {
@@ -371,7 +409,7 @@ public:
     }
     
     // Operations    
-    void replaceWith(TrapezoidNode2* n)
+    void replaceWith(TrapezoidNode2* /*n*/)
     {
       cerr << "PointNode does not support replacing!" << endl;
     }
@@ -406,6 +444,11 @@ public:
       return iKids[0]->trapezoid();
     }
 
+    TrapezoidNodeType type() const
+    {
+      return HEAD_NODE;
+    }
+
     // Request
     TrapezoidNode2* find(const Point2& p)
     {
@@ -428,7 +471,7 @@ public:
       return iKids[0]->locate(s);
     }
         
-    void replaceWith(TrapezoidNode2* n)
+    void replaceWith(TrapezoidNode2* /*n*/)
     {
       cerr << "HeadNode does not support replacing!" << endl;
     }
@@ -30,6 +30,25 @@
 #include <vector>
 #include <string>
 
+enum TrapezoidNodeType {
+  HEAD_NODE,
+  POINT_NODE,
+  SEGMENT_NODE,
+  LEAF_NODE
+};
+
+/**
+  Node stored in a file. Children and trapezoid are given as indices,
+  -1 when there is none.
+*/
+struct TrapezoidNodeRecord
+{
+  int     type;
+  int     kids[2];
+  int     trapezoid;
+  Point2  points[2];  // Point of point node, source and target of segment node
+};
+
 /**
   A node in a tree used a a search tree for trapezoids in a trapezoidal map.
 */
@@ -58,6 +77,8 @@ public:
     void setChild(int index, TrapezoidNode2* child);
         
     virtual Trapezoid2* trapezoid() const;    
+    virtual TrapezoidNodeType type() const = 0;
+    virtual void getRecord(TrapezoidNodeRecord& r) const;
         
     // Calculations
     virtual TrapezoidNode2* locate(const Point2& p);
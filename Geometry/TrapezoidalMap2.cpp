@@ -21,146 +21,412 @@
 #include <Geometry/TrapezoidNode2.hpp>
 #include <Geometry/IO.hpp>
 
+#include <Utils/Random.h>
+#include <Utils/MappedFile.h>
+
 #include <iostream>
 #include <algorithm>
-#include <ext/algorithm>
+#include <map>
+#include <set>
+#include <cstdio>
+#include <cstring>
+#include <cassert>
 
 using namespace std;
 
-// typedefs
-typedef map<Trapezoid2*, int> TrapezoidMap;
-
-// globas
-TrapezoidMap gRemovedTraps;
-
 /*!
     \class TrapezoidalMap2 TrapezoidalMap2.h
-    \brief 
+    \brief Trapezoidal decomposition of the space between line segments.
+
+    Built with the randomized incremental algorithm, so construction takes
+    expected O(n log n) time and locate() expected O(log n) time for n
+    segments. Segments may share endpoints but must not otherwise intersect.
+    Points are compared by x and then y, so vertical segments and points
+    sharing x coordinate need no special handling.
+
+    The map owns its trapezoids. They stay valid until the map is destroyed,
+    also those taken out with remove(), unless insert() or remove() of a
+    segment replaces them.
+
+    Segments can be inserted and removed after the map is built, e.g. when
+    an obstacle is destroyed or moves. Only the trapezoids along the segment
+    change, and the caller is told which, so the roadmap graph can be
+    changed in the same place with Graph2::update() instead of being built
+    again. The search structure keeps the nodes of removed segments, which
+    still tell their two sides apart correctly, so it grows a little with
+    every change and searches where obstacles keep moving get longer. When
+    the searches of insert() and remove() have taken more steps than the
+    map has trapezoids times gMaxStepsPerTrapezoid, the search structure is
+    built again for the same trapezoids, see rebuild().
+
+    Building the map and the roadmap graph on top of it is too slow to do
+    every time a level starts. save() writes the finished map: trapezoids,
+    their neighbors, the search structure and the edges of the roadmap
+    graph. Objects refer to each other by index in the file, so load()
+    maps the file once and recreates every object in a single linear pass,
+    turning indices back into pointers. No geometry is computed and
+    Graph2::create() on the loaded edges only adds vertices and edges.
+    Trapezoids taken out with remove() and segment data pointers are not
+    saved. Like LevelFile the file holds native doubles and is a cache for
+    the machine which wrote it.
 
     \mainclass
 
 */
 
-// Helper function
+static const char  gMagic[4] = {'L', 'T', 'Z', 'M'};
+static const int   gVersion = 1;
+
+// Search steps insert() and remove() may take per trapezoid before search structure is built again
+static const int   gMaxStepsPerTrapezoid = 256;
+
 /*!
-  'old_t' is a trapezoid that has just been deleted. 't' is a trapezoid
-  that was created before 'old_t' was deleted so it might have one of its
-  neighbors pointing to 'old_t' because it didn't "know" that 'old_t' would
-  be deleted in the future. 
-  
-  We call this method AFTER 't' has been properly connected to any new trapezoids
-  created from splitting 'old_t'.
+  Layout of file header. Followed by trapezoids, search structure nodes
+  and graph edges, each section starting at a multiple of 8 bytes.
 */
-static void merge(Trapezoid2* t, Trapezoid2* old_t)
+struct TrapezoidalMapHeader
 {
-  assert(t != 0 && old_t != 0);
-  
-  cout << "MERGE: start prev " << t->tag() << " old " << old_t->tag() << endl; // DEBUG
-  // iterate over the 4 neighbors of t
-  for (int side = 0; side<2; ++side) {
-    for (int i=0; i<2; ++i) {
-      if (t->neighbor(side, i) != old_t) 
-        continue;
-      Trapezoid2* neighbor = old_t->neighbor(side, i);
-      if (neighbor == 0)
-        t->setNeighbor(side, i, 0);
-      else {
-        Point2 npoint = neighbor->endPoint(opposite(side));
-        Point2 tpoint = t->endPoint(side);
-        // Make sure that there are no possibility that a new
-        // trapezoid will be created between 't' and the neighbor of 
-        // 'old_t'
-        if (tpoint.isMin(npoint)) 
-          t->setNeighbor(side, i, 0);
-        else
-          t->connect(side, neighbor);        
-      }
-    }    
-  }
-  cout << "MERGE: end" << endl;  // DEBUG
+  char  magic[4];
+  int   version;
+  int   trapezoidSize;  // sizeof(TrapezoidRecord), sizeof(TrapezoidNodeRecord) and sizeof(EdgeRecord) of writer
+  int   nodeSize;
+  int   edgeSize;
+  int   noTrapezoids;
+  int   noNodes;
+  int   noEdges;
+};
+
+/*! Trapezoid stored in file. Neighbors are indices, -1 when missing */
+struct TrapezoidRecord
+{
+  Point2  points[2];
+  Point2  bottom[2];
+  Point2  top[2];
+  int     neighbors[4];
+  int     tag;
+  int     reserved;
+};
+
+/*! EdgePair stored in file, with indices of its trapezoids */
+struct EdgeRecord
+{
+  int     trapezoids[2];
+  int     tag;
+  int     reserved;
+  Point2  position;
+};
+
+enum TrapezoidalMapSection {
+  TRAPEZOIDS,
+  NODES,
+  EDGES,
+  NO_SECTIONS
+};
+
+// Helper function
+static size_t align(size_t offset)
+{
+  return (offset+7) & ~size_t(7);
 }
 
-/*! 
-  Returns the index of other left or right neighbor. E.g. if index for upperRight is given then
-  index for lower right is returned and visa verca. 
+static void layout(const TrapezoidalMapHeader& h, size_t offsets[NO_SECTIONS+1])
+{
+  size_t sizes[NO_SECTIONS];
+  sizes[TRAPEZOIDS] = size_t(h.noTrapezoids)*sizeof(TrapezoidRecord);
+  sizes[NODES]      = size_t(h.noNodes)*sizeof(TrapezoidNodeRecord);
+  sizes[EDGES]      = size_t(h.noEdges)*sizeof(EdgeRecord);
+
+  offsets[0] = align(sizeof(TrapezoidalMapHeader));
+  for (int i = 0; i < NO_SECTIONS; ++i)
+    offsets[i+1] = align(offsets[i]+sizes[i]);
+}
+
+/*! Write \a size bytes at \a offset, padding with zeros from \a pos */
+static bool writeSection(FILE* file, size_t& pos, size_t offset, const void* data, size_t size)
+{
+  static const char zeros[8] = {0};
+  assert(offset >= pos && offset-pos < sizeof(zeros));
+  if (offset > pos && fwrite(zeros, 1, offset-pos, file) != offset-pos)
+    return false;
+  pos = offset+size;
+  return size == 0 || fwrite(data, 1, size, file) == size;
+}
+
+/*!
+  Nodes of search structure below and including \a root, children before
+  their parents so \a root comes last. Nodes are shared by several
+  parents, and the structure can be deep, so it is walked without recursion.
 */
-static int peer(int index)
+static void getNodes(TrapezoidNode2* root, TrapezoidNodes2& out)
 {
-  switch (index) {
-   case 0: return 1;
-   case 1: return 0;
-   case 2: return 3;
-   case 3: return 2;
+  set<TrapezoidNode2*> visited;
+  vector< pair<TrapezoidNode2*, bool> > visit; // Node and whether its children are done
+  visit.push_back(make_pair(root, false));
+  while (!visit.empty()) {
+    pair<TrapezoidNode2*, bool> v = visit.back();
+    visit.pop_back();
+    if (v.second) {
+      out.push_back(v.first);
+      continue;
+    }
+    if (!visited.insert(v.first).second)
+      continue;
+    visit.push_back(make_pair(v.first, true));
+    for (int i = 1; i >= 0; --i) {
+      TrapezoidNode2* kid = v.first->child(i);
+      if (kid != 0 && visited.find(kid) == visited.end())
+        visit.push_back(make_pair(kid, false));
+    }
   }
-  
-  cerr << __func__ << " bad index" << endl;
-  return -1;
 }
-              
+
+/*! True if \a index is -1 or refers to one of \a n objects */
+static bool validIndex(int index, int n)
+{
+  return index >= -1 && index < n;
+}
+
 /*!
-  'center_ts' are trapezoids in the center, meaning 'side_ts' trapezoids
-  are always placed relative to 'center_ts'. They exist on the side given by
-  'side' relative to 'center_ts'. 
-  
-  Example: if 'side' = LEFT then 'side_ts' trapezoids would exist on the left
-  border of 'center_ts' trapezoids.
+  True if node records form a search structure over \a no_trapezoids
+  trapezoids: children stored before parents, every node but the last used
+  as a child, the last a head node, and exactly one leaf per trapezoid.
 */
-static void connect(int side, Trapezoids2& center_ts, Trapezoids2& side_ts)
-{
-  Trapezoid2 *ct, *st; // Center and Side iterators
-  Trapezoids2::iterator i,j;
-  for (i = center_ts.begin(); i != center_ts.end(); ++i) {
-    ct = *i;
-    for (j = side_ts.begin(); j != side_ts.end(); ++j) {
-      st = *j;
-      ct->connect(side, st);
+static bool validNodes(const TrapezoidNodeRecord* nodes, int no_nodes, int no_trapezoids)
+{
+  if (no_nodes == 0)
+    return false;
+
+  vector<bool> used(no_nodes, false), has_leaf(no_trapezoids, false);
+  int no_leafs = 0;
+  for (int i = 0; i < no_nodes; ++i) {
+    const TrapezoidNodeRecord& r = nodes[i];
+    bool is_head = i == no_nodes-1;
+    if ((r.type == HEAD_NODE) != is_head)
+      return false;
+    for (int k = 0; k < 2; ++k) {
+      if (!validIndex(r.kids[k], i))
+        return false;
+      if (r.kids[k] >= 0)
+        used[r.kids[k]] = true;
+    }
+    switch (r.type) {
+    case HEAD_NODE:
+      if (r.kids[0] < 0 || r.kids[1] >= 0 || r.trapezoid >= 0)
+        return false;
+      break;
+    case LEAF_NODE:
+      if (r.kids[0] >= 0 || r.kids[1] >= 0 || r.trapezoid < 0 || r.trapezoid >= no_trapezoids || has_leaf[r.trapezoid])
+        return false;
+      has_leaf[r.trapezoid] = true;
+      ++no_leafs;
+      break;
+    case POINT_NODE:
+    case SEGMENT_NODE:
+      if (r.trapezoid >= 0)
+        return false;
+      break;
+    default:
+      return false;
     }
   }
+  return no_leafs == no_trapezoids && find(used.begin(), used.end()-1, false) == used.end()-1;
 }
 
 /*! 
-  Finds all trapezoids in trapezoidal map intersected by segment 'si'
-  The trapezoids are filled into range 't' to returned iterator.
+  Finds all trapezoids intersected by segment 'si', starting with 't' which
+  contains its left end. The trapezoids are filled into range 't' to returned iterator.
 */
 template <typename ForwardIterator>
 ForwardIterator
-followSegment(const TrapezoidalMap2* map,  const Segment2& si, ForwardIterator result)
+followSegment(Trapezoid2* t,  const Segment2& si, ForwardIterator result)
 {
-  // cout << "enter follow segment" << endl; // DEBUG
-  Vector2 p = si.left();
   Vector2 q = si.right();
   
-  Trapezoid2* t = map->locate(si);
   if (t == 0)
     return result;
     
-  // cout << "segment left endpoint " << si << " in trapezoid " << t->tag() << endl; // DEBUG
   *result = t; ++result;
   
   Vector2 rightp = t->right();
-  while (q.x() > rightp.x()) {
+  while (rightp.isMin(q)) {
     if (si.isBelow(rightp))
       t = t->lowerRight();
     else
       t = t->upperRight();
     if (t == 0) {
-      cout << __func__ << ": encountered NULL neighbor which should not happen" << endl;
+      cerr << __func__ << ": encountered NULL neighbor which should not happen" << endl;
       break;
     }
-    // cout << "next intersected trapezoid is "  << t->tag() << endl; // DEBUG    
     *result = t; ++result;      
     rightp = t->right(); 
   }
-  // cout << "exiting follow segment" << endl;   // DEBUG
   return result;
 }
 
+/*!
+  Connects 't' to the trapezoids in 'ts' sharing a vertical wall with it.
+  Neighbors across a wall always share top or bottom segment.
+*/
+static void link(Trapezoid2* t, const Trapezoids2& ts)
+{
+  Trapezoids2::const_iterator i;
+  for (i = ts.begin(); i != ts.end(); ++i) {
+    Trapezoid2* c = *i;
+    if (c == t)
+      continue;
+    if (t->right() == c->left())
+      t->connect(Trapezoid2::RIGHT, c);
+    if (t->left() == c->right())
+      t->connect(Trapezoid2::LEFT, c);
+  }
+}
+
+/*! Clears neighbor references from 't' to trapezoids in 'ts' */
+static void unlink(Trapezoid2* t, const Trapezoids2& ts)
+{
+  for (int i = 0; i < 4; ++i)
+    if (find(ts.begin(), ts.end(), t->neighbor(i)) != ts.end())
+      t->setNeighbor(i, 0);
+}
+
+/*!
+  Gives 'new_ts' leafs and connects them to each other and to the neighbors
+  of 'old_ts', which they replace. Neighbors no longer refer to 'old_ts'.
+*/
+static void relink(const Trapezoids2& old_ts, const Trapezoids2& new_ts)
+{
+  Trapezoids2 candidates(new_ts);
+  Trapezoids2::const_iterator it;
+  for (it = old_ts.begin(); it != old_ts.end(); ++it) {
+    Trapezoids2 ns;
+    (*it)->getNeighbors(ns);
+    for (Trapezoids2::iterator j = ns.begin(); j != ns.end(); ++j) {
+      if (find(old_ts.begin(), old_ts.end(), *j) != old_ts.end() ||
+          find(candidates.begin(), candidates.end(), *j) != candidates.end())
+        continue;
+      unlink(*j, old_ts);
+      candidates.push_back(*j);
+    }
+  }
+  for (it = new_ts.begin(); it != new_ts.end(); ++it) {
+    newNode(*it);
+    link(*it, candidates);
+  }
+}
+
+/*!
+  Deletes replaced trapezoids 'ts'. Those made by an earlier insert() or
+  remove() are taken out of 'created', the tags of the others are added
+  to 'deleted'.
+*/
+static void retire(const Trapezoids2& ts, Trapezoids2* created, vector<int>* deleted)
+{
+  Trapezoids2::const_iterator it;
+  for (it = ts.begin(); it != ts.end(); ++it) {
+    Trapezoids2::iterator c;
+    if (created != 0 && (c = find(created->begin(), created->end(), *it)) != created->end())
+      created->erase(c);
+    else if (deleted != 0)
+      deleted->push_back((*it)->tag());
+    delete *it;
+  }
+}
+
+/*! True if 'a' and 'b' have the same endpoints, in any order */
+static bool sameSegment(const Segment2& a, const Segment2& b)
+{
+  return a == b || (a.source() == b.target() && a.target() == b.source());
+}
+
+/*!
+  Trapezoid containing the left end of segment 's', found like
+  TrapezoidNode2::locate(s). At nodes of segment 'side', if given, the
+  search goes to the side of it given by 'above'. Adds the number of
+  nodes passed to 'steps'.
+*/
+static Trapezoid2* descend(TrapezoidNode2* head, const Segment2& s, const Segment2* side, bool above, int& steps)
+{
+  TrapezoidNode2* node = head->child(0);
+  while (node != 0 && node->type() != LEAF_NODE) {
+    TrapezoidNodeRecord r;
+    node->getRecord(r);
+    if (side != 0 && r.type == SEGMENT_NODE && sameSegment(Segment2(r.points[0], r.points[1]), *side))
+      node = above ? node->above() : node->below();
+    else
+      node = node->find(s);
+    ++steps;
+  }
+  return node != 0 ? node->trapezoid() : 0;
+}
+
+/*!
+  Trapezoids along segment 's' of the map, on the side of 's' given by
+  'above', from left to right. Returns false if 's' is not in the map or
+  trapezoids along it have been removed.
+*/
+static bool followSide(TrapezoidNode2* head, const Segment2& s, bool above, Trapezoids2& out, int& steps)
+{
+  Trapezoid2* t = descend(head, s, &s, above, steps);
+  while (t != 0 && sameSegment(above ? t->bottom() : t->top(), s)) {
+    out.push_back(t);
+    if (t->right() == s.right())
+      return true;
+    t = above ? t->lowerRight() : t->upperRight();
+  }
+  return false;
+}
+
+/*! Search structure telling apart trapezoids 'ts' from 'begin' to 'end', which lie side by side */
+static TrapezoidNode2* newSearchNode(const Trapezoids2& ts, int begin, int end)
+{
+  if (end-begin == 1)
+    return ts[begin]->node();
+
+  int mid = (begin+end)/2;
+  TrapezoidNode2* node = newNode(ts[mid]->left());
+  node->setLeft(newSearchNode(ts, begin, mid));
+  node->setRight(newSearchNode(ts, mid, end));
+  return node;
+}
+
+/*! Orders points by x and then y, like the map compares them */
+static bool lessPoints(const Point2* a, const Point2* b, int n)
+{
+  for (int i = 0; i < n; ++i)
+    if (a[i] != b[i])
+      return a[i].isMin(b[i]);
+  return false;
+}
+
+struct SegmentLess
+{
+  bool operator()(const Segment2& a, const Segment2& b) const
+  {
+    Point2 pa[2] = {a.source(), a.target()};
+    Point2 pb[2] = {b.source(), b.target()};
+    return lessPoints(pa, pb, 2);
+  }
+};
+
+/*! Orders trapezoids by corners, so a trapezoid equal to another is found */
+struct TrapezoidLess
+{
+  bool operator()(const Trapezoid2* a, const Trapezoid2* b) const
+  {
+    Point2 pa[6] = {a->left(), a->right(), a->bottom().source(), a->bottom().target(), a->top().source(), a->top().target()};
+    Point2 pb[6] = {b->left(), b->right(), b->bottom().source(), b->bottom().target(), b->top().source(), b->top().target()};
+    return lessPoints(pa, pb, 6);
+  }
+};
+
 Rect2 calcBoundingBox(Segments2::const_iterator begin, Segments2::const_iterator end)
 {
-  Segments2::const_iterator i;
-  real xmin, ymin, xmax, ymax;
-  
-  for(i = begin; i != end; ++i) {
+  if (begin == end)
+    return Rect2();
+
+  Segments2::const_iterator i = begin;
+  real xmin = i->xmin(), ymin = i->ymin(), xmax = i->xmax(), ymax = i->ymax();
+  for(++i; i != end; ++i) {
     xmin = (*i).xmin() < xmin ? (*i).xmin() : xmin;
     ymin = (*i).ymin() < ymin ? (*i).ymin() : ymin;    
     xmax = (*i).xmax() > xmax ? (*i).xmax() : xmax;
@@ -171,17 +437,19 @@ Rect2 calcBoundingBox(Segments2::const_iterator begin, Segments2::const_iterator
 }
 
 // Constructors
-TrapezoidalMap2::TrapezoidalMap2() : iT(0), iD(0), iDummy(0)
+TrapezoidalMap2::TrapezoidalMap2() : iT(0), iD(0), iNoTrapezoids(0), iSteps(0)
 {
   
 }
 
 TrapezoidalMap2::TrapezoidalMap2(Segments2::const_iterator begin, Segments2::const_iterator end, const Rect2& boundingBox) 
+  : iT(0), iD(0), iNoTrapezoids(0), iSteps(0)
 {
   init(begin, end, boundingBox);
 }
 
 TrapezoidalMap2::TrapezoidalMap2(Segments2::const_iterator begin, Segments2::const_iterator end) 
+  : iT(0), iD(0), iNoTrapezoids(0), iSteps(0)
 {
   Rect2 bbox = calcBoundingBox(begin, end);
   init(begin, end, bbox);
@@ -189,35 +457,32 @@ TrapezoidalMap2::TrapezoidalMap2(Segments2::const_iterator begin, Segments2::con
 
 TrapezoidalMap2::~TrapezoidalMap2()
 {
-  TrapezoidNode2::beginDelete();
-    delete iD; 
-  TrapezoidNode2::endDelete();
-  iD = 0; 
+  clear();
 }
 
 void TrapezoidalMap2::init(Segments2::const_iterator begin, Segments2::const_iterator end, const Rect2& bbox)
 {  
+  clear();
+
   // Create pseudo trapezoid for bounding box
   Segment2 bottom = Segment2(bbox.bottomRight(), bbox.bottomLeft());
   Segment2 top = Segment2(bbox.topRight(), bbox.topLeft());  
   iT = new Trapezoid2(bbox.bottomLeft(), bbox.topRight(), bottom, top);
-  iDummy = new Trapezoid2;
   iD = newNode(newNode(iT));  // We place a head node before root node, to more easily allow replacement of rootnode in algo
+  iNoTrapezoids = 1;
   
+  // Segments are inserted in random order, which gives the expected running
+  // time. Segments of polygons come in order and would make a deep search structure.
+  // Seed is fixed so the same segments always give the same map
   Segments2 r(begin, end);  
-  // Segments2 r(end-begin);
-  // random_sample(begin, end, r.begin(), r.end()); // create a random permutaton of set of line segments
-  // int index = 1;
+  Random random(r.size());
+  for (uint32 i = r.size(); i > 1; --i)
+    swap(r[i-1], r[random.next() % i]);
+
   Segments2::iterator i;
-  for(i = r.begin(); i != r.end(); ++i) {  
-    // (*i).setTag(index++); // DEBUG - to find back segment
-    // cout << "Segment " << (*i).tag() << " = " << *i << endl; // DEBUG
-    Trapezoids2 t;
-    followSegment(this, *i, back_inserter(t));
-    update(*i, t.begin(), t.end());
-  } 
-  
-  // iD->printTree();
+  for(i = r.begin(); i != r.end(); ++i)
+    insert(*i);
+  iSteps = 0;
 }
 
 // Calculations
@@ -248,260 +513,505 @@ Trapezoid2* TrapezoidalMap2::locate(const Segment2& s) const
  
 void TrapezoidalMap2::getTrapezoids(Trapezoids2& out) const
 {
-  iD->getTrapezoids(out);
+  if (iD)
+    iD->getTrapezoids(out);
 }
 
+/*!
+  Takes 't' out of the map, e.g. because it is inside an obstacle. Neighbors
+  no longer refer to it and locate() returns NULL for points inside it.
+*/
 void TrapezoidalMap2::remove(Trapezoid2* t)
 {
   assert(t != 0);
-  TrapezoidMap::iterator it = gRemovedTraps.find(t);
-  if (it == gRemovedTraps.end()) {
-    gRemovedTraps[t] = t->tag();
-    Trapezoids2 ts;
-    t->getNeighbors(ts);
-    t->cleanup(ts.begin(), ts.end());
+  if (t->node() == 0)
+    return;   // Already removed
+
+  Trapezoids2 ts;
+  t->getNeighbors(ts);
+  t->cleanup(ts.begin(), ts.end());
+
+  t->node()->replaceWith(0);    
+  t->setNode(0);
+  iRemoved.push_back(t);
+}
 
-    assert(t->node() != 0);
-    t->node()->replaceWith(0);    
+// Operations
+/*!
+  Inserts segment 's'. The trapezoids 's' crosses are replaced by new
+  trapezoids above and below 's', and by one to the left and right of 's' if
+  its endpoints are inside the first and last crossed trapezoid. A vertical
+  wall crossed by 's' is cut off on the side of 's' away from the point it
+  comes from, so the trapezoids on that side are merged into one.
+
+  New trapezoids are added to 'created' and tags of the replaced ones to
+  'deleted', see remove(const Segment2&). Returns false if 's' crosses
+  another segment or trapezoids which have been removed.
+*/
+bool TrapezoidalMap2::insert(const Segment2& s, Trapezoids2* created, vector<int>* deleted)
+{
+  Trapezoids2 crossed;
+  if (iD != 0)
+    followSegment(descend(iD, s, 0, false, iSteps), s, back_inserter(crossed));
+  if (crossed.empty() || crossed.back()->right().isMin(s.right())) {
+    cerr << "Error could not insert " << s << " into trapezoidal map. It intersects another segment" << endl;
+    return false;
+  }
+
+  Point2 p = s.left();
+  Point2 q = s.right();
+  Trapezoid2* first = crossed.front();
+  Trapezoid2* last = crossed.back();
+
+  Trapezoids2 ts;
+  Trapezoid2 *left = 0, *right = 0;
+  if (p != first->left()) {
+    left = new Trapezoid2(first->left(), p, first->bottom(), first->top());
+    ts.push_back(left);
   }
-  else {
-    cout << (*it).second << " trapezoid already removed! " << endl; // DEBUG
+  if (q != last->right()) {
+    right = new Trapezoid2(q, last->right(), last->bottom(), last->top());
+    ts.push_back(right);
   }
+
+  // Split crossed trapezoids into part above and below 's'
+  int n = crossed.size();
+  Trapezoids2 above(n), below(n);
+  Trapezoid2 *upper = 0, *lower = 0;
+  Point2 upper_left = p, lower_left = p;
+  for (int i = 0; i < n; ++i) {
+    Trapezoid2* t = crossed[i];
+    if (upper == 0) {
+      upper = new Trapezoid2(upper_left, q, s, t->top());
+      ts.push_back(upper);
+    }
+    if (lower == 0) {
+      lower = new Trapezoid2(lower_left, q, t->bottom(), s);
+      ts.push_back(lower);
+    }
+    above[i] = upper;
+    below[i] = lower;
+    if (i == n-1)
+      break;
+
+    // Wall to the right of 't' remains on the side of 's' where its point is
+    Point2 r = t->right();
+    if (s.isBelow(r)) {
+      upper->setRight(r);
+      upper = 0;
+      upper_left = r;
+    }
+    else {
+      lower->setRight(r);
+      lower = 0;
+      lower_left = r;
+    }
+  }
+
+  // Neighbors of the new trapezoids are among themselves and old neighbors of crossed
+  relink(crossed, ts);
+
+  // Update search structure
+  for (int i = 0; i < n; ++i) {
+    TrapezoidNode2* node = newNode(s);
+    node->setAbove(above[i]->node());
+    node->setBelow(below[i]->node());
+    if (i == n-1 && right) {
+      TrapezoidNode2* qnode = newNode(q);
+      qnode->setLeft(node);
+      qnode->setRight(right->node());
+      node = qnode;
+    }
+    if (i == 0 && left) {
+      TrapezoidNode2* pnode = newNode(p);
+      pnode->setLeft(left->node());
+      pnode->setRight(node);
+      node = pnode;
+    }
+    crossed[i]->node()->replaceWith(node);
+  }
+
+  retire(crossed, created, deleted);
+  if (created)
+    created->insert(created->end(), ts.begin(), ts.end());
+  iNoTrapezoids += ts.size()-n;
+  if (iSteps > gMaxStepsPerTrapezoid*iNoTrapezoids)
+    rebuild();
+  return true;
 }
 
 /*!
-  'begin' and 'end' denote the range of trapezoids that need to be replaced by
-  new trapezoids not intersected by segment 'si'
+  Removes segment 's', e.g. the side of an obstacle which has been
+  destroyed. The trapezoids above and below 's' are replaced by trapezoids
+  reaching across, as the walls which ended at 's' now go on to the segment
+  on the other side. An endpoint no other segment has loses its wall too.
+
+  New trapezoids are added to 'created' and the tags of the replaced ones
+  to 'deleted', which is what Graph2::update() needs. Passing the same
+  lists to several calls gives the change made by all of them, as a
+  trapezoid made by one call and replaced by a later one is taken out
+  of 'created' again.
+
+  Returns false if 's' is not in the map, or if trapezoids next to it have
+  been taken out with remove(Trapezoid2*). Leave the trapezoids inside
+  obstacles which may be removed in the map, they are not connected to
+  the trapezoids outside anyway.
 */
-void 
-TrapezoidalMap2::update(const Segment2& si, Trapezoids2::iterator begin, Trapezoids2::iterator end)
+bool TrapezoidalMap2::remove(const Segment2& s, Trapezoids2* created, vector<int>* deleted)
 {
-  // First find out which case we are dealing with
-  // If we have only one trapezoid intersected that is treated specially
-  if (end-begin == 1) {
-    updateSingle(si, *begin);
-    // cout << "single update:" << endl; // DEBUG
+  Trapezoids2 above, below;
+  if (iD == 0 || !followSide(iD, s, true, above, iSteps) || !followSide(iD, s, false, below, iSteps)) {
+    cerr << "Error could not remove " << s << " from trapezoidal map. It is not in the map" << endl;
+    return false;
   }
-  else if (end-begin > 1) {
-    updateMultiple(si, begin, end);
-    // cout << "multiple update:" << endl; // DEBUG
+
+  Point2 p = s.left();
+  Point2 q = s.right();
+
+  // Trapezoid left of 'p' spanning both sides means 'p' is an endpoint of 's' only
+  Trapezoid2* left = below.front()->lowerLeft();
+  if (left != 0 && (left != above.front()->upperLeft() || left->right() != p ||
+                    left->top() != above.front()->top() || left->bottom() != below.front()->bottom()))
+    left = 0;
+  Trapezoid2* right = below.back()->lowerRight();
+  if (right != 0 && (right != above.back()->upperRight() || right->left() != q ||
+                     right->top() != above.back()->top() || right->bottom() != below.back()->bottom()))
+    right = 0;
+
+  // Each wall along either side of 's' splits the trapezoids which replace them
+  Trapezoids2 ts;
+  map<Trapezoid2*, Trapezoids2> parts;   // Trapezoids replacing part of each old one
+  Point2 l = left ? left->left() : p;
+  for (int i = 0, j = 0; ; l = ts.back()->right()) {
+    Trapezoid2 *a = above[i], *b = below[j];
+    Point2 r = a->right().isMin(b->right()) ? a->right() : b->right();
+    bool at_end = r == q;
+    Trapezoid2* t = new Trapezoid2(l, at_end && right ? right->right() : r, b->bottom(), a->top());
+    ts.push_back(t);
+    parts[a].push_back(t);
+    parts[b].push_back(t);
+    if (at_end)
+      break;
+    if (r == a->right())
+      ++i;
+    if (r == b->right())
+      ++j;
+  }
+
+  Trapezoids2 old_ts(above);
+  old_ts.insert(old_ts.end(), below.begin(), below.end());
+  if (left) {
+    old_ts.push_back(left);
+    parts[left].push_back(ts.front());
+  }
+  if (right) {
+    old_ts.push_back(right);
+    parts[right].push_back(ts.back());
   }
+  relink(old_ts, ts);
+
+  // Nodes of 's' are kept, and lead to the new trapezoids through the old leafs
+  map<Trapezoid2*, Trapezoids2>::iterator it;
+  for (it = parts.begin(); it != parts.end(); ++it)
+    it->first->node()->replaceWith(newSearchNode(it->second, 0, it->second.size()));
+
+  retire(old_ts, created, deleted);
+  if (created)
+    created->insert(created->end(), ts.begin(), ts.end());
+  iNoTrapezoids += ts.size()-old_ts.size();
+  if (iSteps > gMaxStepsPerTrapezoid*iNoTrapezoids)
+    rebuild();
+  return true;
 }
 
-static TrapezoidNode2* endSplit(int side, const Segment2& si, Trapezoid2* ti, TrapezoidNode2* si_node, TrapezoidNode2* prev_node)
+int TrapezoidalMap2::assignUniqueTags()
 {
-  assert(ti != 0 && prev_node != 0 && si_node != 0 && (side == 0 || side == 1));
-  
-  // These are previously created trapezoids that we wish to connect to.
-  Trapezoids2 ts, ns;
-  si_node->getTrapezoids(ts);
-  assert(ts.size() == 2);
-  
-  // We have two cases:
-  
-  // 1) endpoint of 'si' intersects point defining the side of trapezoid. No new trapezoid will then
-  // be split off.
-  Point2 segp = si.side(side);
-  if (segp == ti->endPoint(side)) {
-    // 'ts' traps is where 'ti' used to be. Second argument is thus on 'side' of 'ts'.
-    // E.g. if 'side' = LEFT then second arguments is to the left of first argument.
-    ns = ti->neighbors(side);
-    connect(side, ts, ns);
-    return prev_node;    
+  // Give a unique tag to each created trapezoid
+  Trapezoids2 ts;
+  getTrapezoids(ts);
+  for (int i=0; i<int(ts.size()); ++i) {
+    ts[i]->setTag(i);
   }
   
-  // 2) We create a new trapezoid that covers area from endpoint of 'si' to end
-  // of old trapezoid.
-  Trapezoid2* new_t = new Trapezoid2(segp, ti->endPoint(side), ti->bottom(), ti->top());
-  cout << "endSplit: " << ti->tag() << " into " << new_t->tag() << " on side " << side << endl; // DEBUG
-
-  // Update trapezoid map 
-  Trapezoids2 new_ts;
-  new_ts.push_back(new_t);
-  connect(side, ts, new_ts); // If 'side' = LEFT then assume 'new_ts' to the left of 'ts'
-  ns = ti->neighbors(side);
-  connect(side, new_ts, ns);    
-  
-  // Update search structure
-  TrapezoidNode2* new_node = newNode(segp);
-  new_node->setChild(side, newNode(new_t));
-  new_node->setChild(opposite(side), prev_node);
-  
-  return new_node;
+  return ts.size();  
 }
 
 /*!
-  Split on the middle
+  Write map and \a edges of roadmap graph built on it to \a path. All
+  trapezoids of \a edges must be in the map. Trapezoid tags are saved, so
+  assignUniqueTags() should have been called when there are edges.
 */
-static TrapezoidNode2* midSplit(const Segment2& si, Trapezoid2* t, TrapezoidNode2* prev_node = 0)
+bool TrapezoidalMap2::save(const std::string& path, const EdgePairs& edges) const
 {
-  assert(t != 0);  
-  
-  Trapezoid2  *lower, *upper, *new_t;
-  
-  TrapezoidNode2* si_node = newNode(si);
-
-  Point2 leftp = t->left();
-  Point2 rightp = t->right();  
-  Segment2 bottom = t->bottom();
-  Segment2 top = t->top();
-
-  // Check trapezoid is crossed fully by 'si' or not
-  if (leftp.isMin(si.left()) && rightp.isMax(si.right())) {
-    lower = new Trapezoid2(si.left(), si.right(), t->bottom(), si);
-    upper = new Trapezoid2(si.left(), si.right(), si, t->top());
-
-    cout << "inside midSplit: " << t->tag() << " into " << lower->tag() << " and " << upper->tag() << endl; // DEBUG
-    // update search structure
-    si_node->setBelow(newNode(lower));
-    si_node->setAbove(newNode(upper));
-  }
-  else if (prev_node == 0) {    
-    // NOTE: righp is not set correctly. It will be updated correctly with next trapezoid contruction. If not then si.right() is correct
-    // This can only happen if we are at left side, and then si.left() is the left point
-    lower = t->clone(si.left(), si.right(), bottom, si);
-    upper = t->clone(si.left(), si.right(), si, top);
-    
-    cout << "midSplit: " << t->tag() << " into " << lower->tag() << " and " << upper->tag() << endl; // DEBUG
-        
-    si_node->setBelow(newNode(lower));    
-    si_node->setAbove(newNode(upper));
-  } 
-  else {
-    assert(prev_node != 0);
-    assert(prev_node->above() != 0); 
-    assert(prev_node->below() != 0);    
-    
-    TrapezoidNode2* above = prev_node->above();
-    TrapezoidNode2* below = prev_node->below();
-            
-    // Check if left point is below 'si'
-
-    /////////// LOWER /////////// 
-    if (si.isAbove(leftp)) {    
-      // New node at lower part
-      // NOTE: righp is not set correctly. It will be updated correctly with next trapezoid contruction. If not then si.right() is correct
-      new_t = t->clone(leftp, si.right(), bottom, si); // Retains the same neighbors as 't'
-      cout << "midSplit: " << t->tag() << " into lower " << new_t->tag() << " reusing " << above->trapezoid()->tag() << endl; // DEBUG
-      
-      new_t->connect(Trapezoid2::LEFT, below->trapezoid());
-      below->trapezoid()->setRight(leftp);
-
-      merge(above->trapezoid(), t);
-      
-      // Update search structure
-      si_node->setBelow(newNode(new_t));    // Lower was new
-      si_node->setAbove(above);  // while upper is merged with previous upper      
+  if (iD == 0)
+    return false;
+
+  Trapezoids2 ts;
+  getTrapezoids(ts);
+  map<Trapezoid2*, int> tindex;
+  for (size_t i = 0; i < ts.size(); ++i)
+    tindex[ts[i]] = i;
+
+  vector<TrapezoidRecord> traps(ts.size());
+  for (size_t i = 0; i < ts.size(); ++i) {
+    Trapezoid2* t = ts[i];
+    TrapezoidRecord& r = traps[i];
+    r = TrapezoidRecord();
+    r.points[0] = t->left();
+    r.points[1] = t->right();
+    r.bottom[0] = t->bottom().source();
+    r.bottom[1] = t->bottom().target();
+    r.top[0] = t->top().source();
+    r.top[1] = t->top().target();
+    for (int j = 0; j < 4; ++j) {
+      map<Trapezoid2*, int>::iterator n = tindex.find(t->neighbor(j));
+      r.neighbors[j] = n != tindex.end() ? n->second : -1;
     }
-    /////////// UPPER /////////// 
-    else if (si.isBelow(leftp)) {
-      // New node at upper part
-      // NOTE: righp is not set correctly. It will be updated correctly with next trapezoid contruction. If not then si.right() is correct
-      new_t = t->clone(leftp, si.right(), si, top);
-      cout << "midSplit: " << t->tag() << " into upper " << new_t->tag() << " reusing " << below->trapezoid()->tag() << endl; // DEBUG
-      new_t->connect(Trapezoid2::LEFT, above->trapezoid());
-      above->trapezoid()->setRight(leftp);
-  
-      merge(below->trapezoid(), t);
-        
-      // Update search structure      
-      si_node->setAbove(newNode(new_t));                // Upper was new
-      si_node->setBelow(below);  // while lower is merged with previous lower  
+    r.tag = t->tag();
+  }
+
+  TrapezoidNodes2 ns;
+  getNodes(iD, ns);
+  map<TrapezoidNode2*, int> nindex;
+  for (size_t i = 0; i < ns.size(); ++i)
+    nindex[ns[i]] = i;
+
+  vector<TrapezoidNodeRecord> nodes(ns.size());
+  for (size_t i = 0; i < ns.size(); ++i) {
+    TrapezoidNode2* n = ns[i];
+    TrapezoidNodeRecord& r = nodes[i];
+    r = TrapezoidNodeRecord();
+    n->getRecord(r);
+    for (int k = 0; k < 2; ++k)
+      r.kids[k] = n->child(k) != 0 ? nindex[n->child(k)] : -1;
+    if (r.type == LEAF_NODE)
+      r.trapezoid = tindex[n->trapezoid()];
+  }
+
+  vector<EdgeRecord> es(edges.size());
+  for (size_t i = 0; i < edges.size(); ++i) {
+    EdgeRecord& r = es[i];
+    r = EdgeRecord();
+    for (int k = 0; k < 2; ++k) {
+      map<Trapezoid2*, int>::iterator t = tindex.find(edges[i].trapezoid(k));
+      if (t == tindex.end()) {
+        cerr << "Error edge " << edges[i].tag() << " refers to trapezoid not in map" << endl;
+        return false;
+      }
+      r.trapezoids[k] = t->second;
     }
-    else {
-      cerr << __func__ << ": leftp has to be above or below segment 'si'" << endl;
-    }   
-   
-    // Cleanup - fix dangling references and NULL pointers
-    Trapezoids2 ts; 
-    ts.push_back(below->trapezoid());
-    ts.push_back(above->trapezoid());    
-    ts.push_back(new_t);
-    t->cleanup(ts.begin(), ts.end());     
+    r.tag = edges[i].tag();
+    r.position = edges[i].position();
   }
-  
-  return si_node;
+
+  TrapezoidalMapHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, gMagic, sizeof(gMagic));
+  header.version = gVersion;
+  header.trapezoidSize = sizeof(TrapezoidRecord);
+  header.nodeSize = sizeof(TrapezoidNodeRecord);
+  header.edgeSize = sizeof(EdgeRecord);
+  header.noTrapezoids = traps.size();
+  header.noNodes = nodes.size();
+  header.noEdges = es.size();
+
+  size_t offsets[NO_SECTIONS+1];
+  layout(header, offsets);
+
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == 0)
+    return false;
+
+  size_t pos = 0;
+  bool ok = writeSection(file, pos, 0, &header, sizeof(header)) &&
+    writeSection(file, pos, offsets[TRAPEZOIDS], traps.empty() ? 0 : &traps[0], traps.size()*sizeof(TrapezoidRecord)) &&
+    writeSection(file, pos, offsets[NODES], &nodes[0], nodes.size()*sizeof(TrapezoidNodeRecord)) &&
+    writeSection(file, pos, offsets[EDGES], es.empty() ? 0 : &es[0], es.size()*sizeof(EdgeRecord)) &&
+    writeSection(file, pos, offsets[NO_SECTIONS], 0, 0);
+  return fclose(file) == 0 && ok;
 }
 
-void 
-TrapezoidalMap2::updateMultiple(const Segment2& si, Trapezoids2::iterator begin, Trapezoids2::iterator end)
+/*!
+  Load map saved with save(). Roadmap edges are put in \a edges if given,
+  ready for Graph2::create() with one vertex per trapezoid. Returns 0 if
+  file is missing, damaged or written by an incompatible engine version.
+*/
+TrapezoidalMap2* TrapezoidalMap2::load(const std::string& path, EdgePairs* edges)
 {
-  cout << "entering update multipe" << endl; // DEBUG
-  
-  Trapezoids2 ts;
-  
-  TrapezoidNode2  *node, *si_node;
-  Trapezoid2* ti = *begin;
-  
-  cout << "entering first midSplit" << endl; // DEBUG  
-  si_node = midSplit(si, ti);
-  cout << "exiting first midSplit and entering first endSplit" << endl; // DEBUG    
-  node = endSplit(Trapezoid2::LEFT, si, ti, si_node, si_node);
-  cout << "exiting first endSplit" << endl; // DEBUG  
-  
-  // Fix any dangling references to old trapezoid and NULL pointers.
-  node->getTrapezoids(ts);  // Get trapezoids just created (want to make sure they have no NULL pointers)
-  ti->getNeighbors(ts);     // Get old neighbors, want to make sure none point to 'ti' anymore
-  ti->cleanup(ts.begin(), ts.end());
+  MappedFile file;
+  if (!file.open(path) || file.size() < sizeof(TrapezoidalMapHeader))
+    return 0;
+
+  TrapezoidalMapHeader header;
+  memcpy(&header, file.data(), sizeof(header));
+
+  bool ok = memcmp(header.magic, gMagic, sizeof(gMagic)) == 0 &&
+            header.version == gVersion &&
+            header.trapezoidSize == int(sizeof(TrapezoidRecord)) &&
+            header.nodeSize == int(sizeof(TrapezoidNodeRecord)) &&
+            header.edgeSize == int(sizeof(EdgeRecord)) &&
+            header.noTrapezoids >= 0 && header.noNodes >= 0 && header.noEdges >= 0;
+
+  size_t offsets[NO_SECTIONS+1];
+  if (ok) {
+    layout(header, offsets);
+    ok = file.size() == offsets[NO_SECTIONS];
+  }
+  if (!ok)
+    return 0;
+
+  const TrapezoidRecord* traps = (const TrapezoidRecord*)(file.data()+offsets[TRAPEZOIDS]);
+  const TrapezoidNodeRecord* nodes = (const TrapezoidNodeRecord*)(file.data()+offsets[NODES]);
+  const EdgeRecord* es = (const EdgeRecord*)(file.data()+offsets[EDGES]);
+
+  // Check every index before creating anything, so a damaged file can't leave half a map
+  int no_traps = header.noTrapezoids;
+  ok = validNodes(nodes, header.noNodes, no_traps);
+  for (int i = 0; ok && i < no_traps; ++i)
+    for (int j = 0; ok && j < 4; ++j)
+      ok = validIndex(traps[i].neighbors[j], no_traps);
+  for (int i = 0; ok && i < header.noEdges; ++i)
+    ok = es[i].trapezoids[0] >= 0 && es[i].trapezoids[1] >= 0 &&
+         validIndex(es[i].trapezoids[0], no_traps) && validIndex(es[i].trapezoids[1], no_traps);
+  if (!ok)
+    return 0;
+
+  Trapezoids2 ts(no_traps);
+  for (int i = 0; i < no_traps; ++i) {
+    const TrapezoidRecord& r = traps[i];
+    ts[i] = new Trapezoid2(r.points[0], r.points[1], Segment2(r.bottom[0], r.bottom[1]), Segment2(r.top[0], r.top[1]));
+    ts[i]->setTag(r.tag);
+  }
+  for (int i = 0; i < no_traps; ++i)
+    for (int j = 0; j < 4; ++j)
+      if (traps[i].neighbors[j] >= 0)
+        ts[i]->setNeighbor(j, ts[traps[i].neighbors[j]]);
+
+  TrapezoidNodes2 ns(header.noNodes);
+  for (int i = 0; i < header.noNodes; ++i) {
+    const TrapezoidNodeRecord& r = nodes[i];
+    switch (r.type) {
+    case HEAD_NODE:
+      ns[i] = newNode(ns[r.kids[0]]);
+      continue;
+    case LEAF_NODE:
+      ns[i] = newNode(ts[r.trapezoid]);
+      break;
+    case POINT_NODE:
+      ns[i] = newNode(r.points[0]);
+      break;
+    case SEGMENT_NODE:
+      ns[i] = newNode(Segment2(r.points[0], r.points[1]));
+      break;
+    }
+    for (int k = 0; k < 2; ++k)
+      if (r.kids[k] >= 0)
+        ns[i]->setChild(k, ns[r.kids[k]]);
+  }
 
-  ti->node()->replaceWith(node);  
-  
-  cout << "entering midSplit loop" << endl; // DEBUG    
-  Trapezoids2::iterator i;
-  for (i = begin+1; i != end-1; ++i ) {
-    ti  = *i;
-    si_node = midSplit(si, ti, si_node);
-    
-    // Fix any dangling references to old trapezoid and NULL pointers.
-    ts.clear();
-    si_node->getTrapezoids(ts); 
-    ti->getNeighbors(ts);       
-    sort(ts.begin(), ts.end());   // One of the childs of 'si_node'
-    unique(ts.begin(), ts.end()); // might be reused, so we make sure that there is no
-    ti->cleanup(ts.begin(), ts.end()); // overlap between 'ti' nighbors and 'si_node' children
-    
-    ti->node()->replaceWith(si_node);
+  if (edges) {
+    edges->clear();
+    edges->reserve(header.noEdges);
+    for (int i = 0; i < header.noEdges; ++i)
+      edges->push_back(EdgePair(ts[es[i].trapezoids[0]], ts[es[i].trapezoids[1]], es[i].tag, es[i].position));
   }
-  cout << "Exiting midsplit loop" << endl; // DEBUG      
-  ti = *i;
-  si_node = midSplit(si, ti, si_node);
-  node = endSplit(Trapezoid2::RIGHT, si, ti, si_node, si_node);
-  
-  // Fix any dangling references to old trapezoid and NULL pointers.
-  ts.clear();
-  node->getTrapezoids(ts);
-  ti->getNeighbors(ts);
-  ti->cleanup(ts.begin(), ts.end());
-  
-  ti->node()->replaceWith(node);
-  cout << "exiting update multipe" << endl; // DEBUG  
+
+  TrapezoidalMap2* tmap = new TrapezoidalMap2;
+  tmap->iD = ns.back();
+  tmap->iNoTrapezoids = no_traps;
+  return tmap;
 }
 
-void TrapezoidalMap2::updateSingle(const Segment2& si, Trapezoid2* t)
+/*! Deletes all trapezoids and the search structure */
+void TrapezoidalMap2::clear()
 {
-  TrapezoidNode2  *node, *si_node;
-  si_node = midSplit(si, t);
-  node = endSplit(Trapezoid2::RIGHT, si, t, si_node, si_node);
-  node = endSplit(Trapezoid2::LEFT, si, t, si_node, node);
+  if (iD == 0)
+    return;
 
-  // Fix any dangling references to old trapezoid and NULL pointers.
   Trapezoids2 ts;
-  node->getTrapezoids(ts);
-  t->getNeighbors(ts);
-  t->cleanup(ts.begin(), ts.end());
-  
-  assert(t->node() != 0);
-  t->node()->replaceWith(node);
+  getTrapezoids(ts);
+  ts.insert(ts.end(), iRemoved.begin(), iRemoved.end());
+  for (Trapezoids2::iterator i = ts.begin(); i != ts.end(); ++i)
+    delete *i;
+  iRemoved.clear();
+
+  TrapezoidNode2::beginDelete();
+    delete iD; 
+  TrapezoidNode2::endDelete();
+  iD = 0; 
+  iT = 0;
+  iNoTrapezoids = 0;
+  iSteps = 0;
 }
 
-int TrapezoidalMap2::assignUniqueTags()
+/*!
+  Builds the search structure again from the segments of the map. Called
+  when insert() and remove() have spent about as long searching past the
+  nodes of removed segments as building it takes. The segments give the
+  same trapezoids as before, and the old trapezoid objects are put at the
+  new leafs, so they and their tags stay valid, and so does the roadmap
+  graph built on them.
+*/
+void TrapezoidalMap2::rebuild()
 {
-  // Give a unique tag to each created trapezoid
+  iSteps = 0;
+
   Trapezoids2 ts;
   getTrapezoids(ts);
-  for (int i=0; i<ts.size(); ++i) {
-    ts[i]->setTag(i);
+  ts.insert(ts.end(), iRemoved.begin(), iRemoved.end());
+
+  // Every segment, also those of the bounding box, is top or bottom of a trapezoid
+  set<Segment2, SegmentLess> segments;
+  Trapezoids2::iterator it;
+  for (it = ts.begin(); it != ts.end(); ++it) {
+    segments.insert((*it)->bottom());
+    segments.insert((*it)->top());
   }
-  
-  return ts.size();  
+  real xmin = ts.front()->left().x(), ymin = ts.front()->left().y(), xmax = xmin, ymax = ymin;
+  set<Segment2, SegmentLess>::iterator si;
+  for (si = segments.begin(); si != segments.end(); ++si) {
+    xmin = min(xmin, si->xmin());
+    ymin = min(ymin, si->ymin());
+    xmax = max(xmax, si->xmax());
+    ymax = max(ymax, si->ymax());
+  }
+  Rect2 bbox(xmin, ymin, xmax, ymax);
+  segments.erase(Segment2(bbox.bottomRight(), bbox.bottomLeft()));
+  segments.erase(Segment2(bbox.topRight(), bbox.topLeft()));
+
+  Segments2 r(segments.begin(), segments.end());
+  TrapezoidalMap2 built(r.begin(), r.end(), bbox);
+  Trapezoids2 built_ts;
+  built.getTrapezoids(built_ts);
+
+  // Find the old trapezoid equal to each new one. Those without one are
+  // inside obstacles and were taken out before a load()
+  set<Trapezoid2*, TrapezoidLess> old_ts(ts.begin(), ts.end());
+  Trapezoids2 same(built_ts.size(), (Trapezoid2*)0);
+  uint32 no_same = 0;
+  for (uint32 i = 0; i < built_ts.size(); ++i) {
+    set<Trapezoid2*, TrapezoidLess>::iterator o = old_ts.find(built_ts[i]);
+    if (o != old_ts.end()) {
+      same[i] = *o;
+      ++no_same;
+    }
+  }
+  if (no_same != ts.size()) {
+    cerr << "Error could not build search structure of trapezoidal map again. Its segments give other trapezoids" << endl;
+    return;
+  }
+
+  for (uint32 i = 0; i < built_ts.size(); ++i) {
+    Trapezoid2* t = same[i];
+    built_ts[i]->node()->replaceWith(t != 0 && t->node() != 0 ? newNode(t) : 0);
+    delete built_ts[i];
+  }
+
+  TrapezoidNode2::beginDelete();
+    delete iD;
+  TrapezoidNode2::endDelete();
+  iD = built.iD;
+  built.iD = 0;
+  built.iT = 0;
 }
+
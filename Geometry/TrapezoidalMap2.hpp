@@ -24,7 +24,9 @@
 #include <Geometry/Segment2.hpp>
 #include <Geometry/Trapezoid2.hpp>
 #include <Geometry/Rect2.hpp>
+#include <Geometry/Graph2.hpp>
 #include <vector>
+#include <string>
 
 // Helper functions
 Rect2 calcBoundingBox(Segments2::const_iterator begin, Segments2::const_iterator end);
@@ -40,6 +42,8 @@ public:
   virtual ~TrapezoidalMap2();
   
   void init(Segments2::const_iterator begin, Segments2::const_iterator end, const Rect2& boundingBox);
+
+  static TrapezoidalMap2* load(const std::string& path, EdgePairs* edges = 0);
         
   // Calculate
   Trapezoid2* locate(const Point2& p) const;
@@ -48,16 +52,20 @@ public:
   void remove(Trapezoid2* t);
 
   // Operations  
+  bool insert(const Segment2& s, Trapezoids2* created = 0, std::vector<int>* deleted = 0);
+  bool remove(const Segment2& s, Trapezoids2* created = 0, std::vector<int>* deleted = 0);
   int  assignUniqueTags();
+  bool save(const std::string& path, const EdgePairs& edges = EdgePairs()) const;
   
 private:
   // Operations  
-  void update(const Segment2& si, Trapezoids2::iterator begin, Trapezoids2::iterator end);  
-  void updateMultiple(const Segment2& si, Trapezoids2::iterator begin, Trapezoids2::iterator end);
-  void updateSingle(const Segment2& si, Trapezoid2* t);
+  void clear();
+  void rebuild();
   
 private:
   Trapezoid2* iT;
   TrapezoidNode2* iD;
-  Trapezoid2* iDummy;
+  Trapezoids2 iRemoved;     // Taken out by remove(), deleted with map
+  int iNoTrapezoids;        // Also those taken out by remove()
+  int iSteps;               // Search steps of insert() and remove() since search structure was built
 };
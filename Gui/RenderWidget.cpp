@@ -21,12 +21,16 @@
 
 #include "Engine.h"
 #include "Timing.h"
+#include "World.h"
 
 #include "Lua/LuaEngine.h"
 
 #include <QtGui/QKeyEvent>
 #include <QtDebug>
 
+// Milliseconds between redraws. The game itself is updated every ticksPerFrame()
+static const int gRedrawInterval = 10;
+
 RenderWidget::RenderWidget(QWidget* parent)
   : QGLWidget(parent)
 {
@@ -44,7 +48,7 @@ void RenderWidget::initializeGL()
   // is why it needs to be called here
   engineInit();
 
-  startTimer(ticksPerFrame());     // 50-millisecond timer
+  startTimer(gRedrawInterval);
 }
 
 void RenderWidget::resizeGL(int w, int h)
@@ -62,19 +66,18 @@ void RenderWidget::paintGL()
 void RenderWidget::timerEvent ( QTimerEvent * event )
 {
   Q_UNUSED(event);
-  real secs = secondsPassed();
+  engineAdvance(secondsPassed());
   updateGL(); // calls paintGL() indirectly
-  engineEndLoop(secs);
 }
 
 void RenderWidget::keyPressEvent ( QKeyEvent * event )
 {
   unsigned int k = event->key();
-  luaSetEngineBoolean("keystate", k, true);
+  World::current()->keyEvent(k, true);
 }
 
 void RenderWidget::keyReleaseEvent ( QKeyEvent * event )
 {
   unsigned int k = event->key();
-  luaSetEngineBoolean("keystate", k, false);
+  World::current()->keyEvent(k, false);
 }
@@ -0,0 +1,204 @@
+/*
+ *  LuaContactBuffer.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 19.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "Lua/Base/LuaContactBuffer.h"
+#include "Lua/Base/LuaShape.h"
+#include "Lua/Geometry/LuaPointBuffer.h"
+#include "Lua/LuaUtils.h"
+
+#include "Base/ContactBuffer.h"
+
+#include <lua.hpp>
+#include <cassert>
+
+using namespace std;
+
+/*!
+  \file LuaContactBuffer.cpp
+  \brief Batched collision handling from Lua.
+
+  A contact buffer given as handler to collide() or setCollisionHandler()
+  records collisions instead of calling a Lua function for each of them.
+  At the end of the frame contacts:flush(handler) calls handler once with
+  the buffer, which it iterates natively:
+
+  \code
+  contacts:flush(function(contacts)
+    for i = 1,#contacts do
+      local me, other, t, dt = contacts:get(i)
+      local points = contacts:points(i, buffer)
+    end
+  end)
+  \endcode
+*/
+
+// Helper functions
+/*! Returns contact buffer at \a index or 0 if value is not a contact buffer */
+ContactBuffer *toContactBuffer(lua_State* L, int index)
+{
+  void *p = lua_touserdata(L, index);
+  if (p != 0 && lua_getmetatable(L, index)) {
+    luaL_getmetatable(L, "Lusion.ContactBuffer");
+    bool is_buffer = lua_rawequal(L, -1, -2);
+    lua_pop(L, 2);
+    if (is_buffer)
+      return *(ContactBuffer**)p;
+  }
+  return 0;
+}
+
+ContactBuffer *checkContactBuffer(lua_State* L, int index)
+{
+  ContactBuffer* v;
+  pullClassInstance(L, index, "Lusion.ContactBuffer", v);
+  return v;
+}
+
+/*! Converts 1 based Lua index at \a index to contact index */
+static uint32 checkContactIndex(lua_State* L, ContactBuffer* buffer, int index)
+{
+  int i = luaL_checkint(L, index);
+  luaL_argcheck(L, i >= 1 && i <= (int)buffer->size(), index, "contact index out of range");
+  return i-1;
+}
+
+// Functions exported to Lua
+// ContactBuffer:new()
+static int newContactBuffer(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1)
+    return luaL_error(L, "Got %d arguments expected 1 (class)", n);
+  luaL_checktype(L, 1, LUA_TTABLE);
+
+  ContactBuffer **b = (ContactBuffer **)lua_newuserdata(L, sizeof(ContactBuffer *));
+  *b = new ContactBuffer;
+  setObjectMetatable(L, "Lusion.ContactBuffer", 1);
+
+  return 1;
+}
+
+// __gc for ContactBuffer
+static int destroyContactBuffer(lua_State* L)
+{
+  ContactBuffer* buffer = 0;
+  checkUserData(L, "Lusion.ContactBuffer", buffer);
+  buffer->release();
+  return 0;
+}
+
+// Request
+static int size(lua_State *L)
+{
+  lua_pushinteger(L, checkContactBuffer(L)->size());
+  return 1;
+}
+
+// Accessors
+// contacts:get(i) returns me, other, start_time, delta_time
+static int getContact(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2)
+    return luaL_error(L, "Got %d arguments expected 2 (self, index)", n);
+
+  ContactBuffer* buffer = checkContactBuffer(L);
+  const Contact& c = buffer->contact(checkContactIndex(L, buffer, 2));
+  if (c.me)
+    retrieveShapeTable(L, c.me);
+  else
+    lua_pushnil(L);
+  if (c.other)
+    retrieveShapeTable(L, c.other);
+  else
+    lua_pushnil(L);
+  lua_pushnumber(L, c.time);
+  lua_pushnumber(L, c.deltaTime);
+  return 4;
+}
+
+// contacts:points(i, [buffer]) returns intersection points of contact i
+static int points(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2 && n != 3)
+    return luaL_error(L, "Got %d arguments expected 2 or 3 (self, index, [buffer])", n);
+
+  ContactBuffer* buffer = checkContactBuffer(L);
+  const Contact& c = buffer->contact(checkContactIndex(L, buffer, 2));
+  Points2::const_iterator first = buffer->points().begin()+c.firstPoint;
+  pushPoints(L, first, first+c.noPoints, n == 3 ? 3 : 0);
+  return 1;
+}
+
+// Operations
+static int clear(lua_State *L)
+{
+  checkContactBuffer(L)->clear();
+  return 0;
+}
+
+/*!
+  contacts:flush(handler) calls handler(contacts) if any contacts have been
+  recorded and then clears the buffer. Returns number of contacts handled.
+*/
+static int flush(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2)
+    return luaL_error(L, "Got %d arguments expected 2 (self, handler)", n);
+  ContactBuffer* buffer = checkContactBuffer(L);
+  luaL_checktype(L, 2, LUA_TFUNCTION);
+
+  uint32 count = buffer->size();
+  if (count > 0) {
+    lua_pushvalue(L, 2);
+    lua_pushvalue(L, 1);
+    lua_call(L, 1, 0);
+    buffer->clear();
+  }
+  lua_pushinteger(L, count);
+  return 1;
+}
+
+static const luaL_Reg gDestroyContactBufferFuncs[] = {
+  {"__gc", destroyContactBuffer},
+  {"__len", size},
+  {NULL, NULL}
+};
+
+static const luaL_Reg gContactBufferFuncs[] = {
+  {"new", newContactBuffer},
+  // Request
+  {"size", size},
+  // Accessors
+  {"get", getContact},
+  {"points", points},
+  // Operations
+  {"clear", clear},
+  {"flush", flush},
+  {NULL, NULL}
+};
+
+// Initialization
+void initLuaContactBuffer(lua_State *L)
+{
+  // Metatable to be used for userdata identification
+  luaL_newmetatable(L, "Lusion.ContactBuffer");
+  luaL_register(L, 0, gDestroyContactBufferFuncs);
+  luaL_register(L, 0, gContactBufferFuncs);
+  lua_pushcfunction(L, objectIndex);
+  lua_setfield(L,-2, "__index");
+  lua_pushcfunction(L, objectNewIndex);
+  lua_setfield(L,-2, "__newindex");
+
+  luaL_register(L, "ContactBuffer", gContactBufferFuncs);
+  lua_pushvalue(L,-1);
+  lua_setfield(L,-2, "__index");
+}
@@ -0,0 +1,17 @@
+/*
+ *  LuaContactBuffer.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 19.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#pragma once
+
+struct lua_State;
+class ContactBuffer;
+
+void initLuaContactBuffer(lua_State *L);
+ContactBuffer *toContactBuffer(lua_State* L, int index);
+ContactBuffer *checkContactBuffer(lua_State* L, int index=1);
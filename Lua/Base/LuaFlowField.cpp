@@ -0,0 +1,247 @@
+/*
+ *  LuaFlowField.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 12.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "Lua/Base/LuaFlowField.h"
+#include "Lua/Base/LuaShape.h"
+#include "Lua/LuaUtils.h"
+#include "Lua/Geometry/LuaVector2.h"
+#include "Lua/Geometry/LuaRect2.h"
+#include "Lua/Geometry/LuaPointBuffer.h"
+
+#include "Utils/FlowField.h"
+#include "Geometry/Polygon2.hpp"
+
+#include <lua.hpp>
+#include <cassert>
+#include <cmath>
+
+// Helper functions
+FlowField *checkFlowField(lua_State* L, int index)
+{
+  FlowField* v;
+  pullClassInstance(L, index, "Lusion.FlowField", v);
+  return v;
+}
+
+// Functions exported to Lua
+// FlowField:new(bbox, cell_size)
+static int newFlowField(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 3)
+    return luaL_error(L, "Got %d arguments expected 3 (class, boundingbox, cellsize)", n); 
+  luaL_checktype(L, 1, LUA_TTABLE); 
+
+  Rect2 area = Rect2_pull(L, 2);
+  real cell_size = luaL_checknumber(L, 3);
+  luaL_argcheck(L, cell_size > 0.0, 3, "cell size must be positive");
+  
+  pushClassInstance(L);
+    
+  FlowField **f = (FlowField **)lua_newuserdata(L, sizeof(FlowField *));
+  *f = new FlowField(area, cell_size);
+
+  setUserDataMetatable(L, "Lusion.FlowField");
+
+  return 1; 
+}
+
+// Accessors
+static int columns(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1) 
+    return luaL_error(L, "Got %d arguments expected 1 (self)", n); 
+    
+  FlowField* field = checkFlowField(L);
+  lua_pushinteger(L, field->columns());
+  return 1;
+}
+
+static int rows(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1) 
+    return luaL_error(L, "Got %d arguments expected 1 (self)", n); 
+    
+  FlowField* field = checkFlowField(L);
+  lua_pushinteger(L, field->rows());
+  return 1;
+}
+
+static int goal(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1) 
+    return luaL_error(L, "Got %d arguments expected 1 (self)", n); 
+    
+  FlowField* field = checkFlowField(L);
+  Vector2_push(L, field->goal());
+  return 1;
+}
+
+// Request
+static int isBlocked(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2) 
+    return luaL_error(L, "Got %d arguments expected 2 (self, point)", n); 
+    
+  FlowField* field = checkFlowField(L);
+  lua_pushboolean(L, field->isBlocked(Vector2_pull(L, 2)));
+  return 1;
+}
+
+// Calculations
+static int distance(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2) 
+    return luaL_error(L, "Got %d arguments expected 2 (self, point)", n); 
+    
+  FlowField* field = checkFlowField(L);
+  real d = field->distance(Vector2_pull(L, 2));
+  if (d == REAL_MAX)
+    lua_pushnumber(L, HUGE_VAL);  // So scripts can compare with math.huge
+  else
+    lua_pushnumber(L, d);
+  return 1;
+}
+
+static int direction(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2) 
+    return luaL_error(L, "Got %d arguments expected 2 (self, point)", n); 
+    
+  FlowField* field = checkFlowField(L);
+  Vector2_push(L, field->direction(Vector2_pull(L, 2)));
+  return 1;
+}
+
+/*! 
+  field:sample(points, [buffer]) returns array of directions for array of points. 
+  If 'points' and 'buffer' are point buffers no Lua values are created per point.
+*/
+static int sample(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2 && n != 3) 
+    return luaL_error(L, "Got %d arguments expected 2 or 3 (self, points, [buffer])", n); 
+    
+  FlowField* field = checkFlowField(L);
+  Points2 dirs;
+  Points2* buffer = toPointBuffer(L, 2);
+  if (buffer != 0) {
+    field->sample(*buffer, dirs);
+  }
+  else {
+    Polygon2 points;
+    getPolygon(L, 2, points);
+    field->sample(Points2(points.begin(), points.end()), dirs);
+  }
+  pushPoints(L, dirs, n == 3 ? 3 : 0);
+  return 1;
+}
+
+// Operations
+static int setGoal(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2) 
+    return luaL_error(L, "Got %d arguments expected 2 (self, point)", n); 
+    
+  FlowField* field = checkFlowField(L);
+  field->setGoal(Vector2_pull(L, 2));
+  return 0;
+}
+
+static int rasterize(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2) 
+    return luaL_error(L, "Got %d arguments expected 2 (self, obstacles)", n); 
+    
+  FlowField* field = checkFlowField(L);
+  field->rasterize(checkShape(L, 2));
+  return 0;
+}
+
+/*! field:update(obstacles, region) returns true if field changed */
+static int update(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 3) 
+    return luaL_error(L, "Got %d arguments expected 3 (self, obstacles, region)", n); 
+    
+  FlowField* field = checkFlowField(L);
+  lua_pushboolean(L, field->update(checkShape(L, 2), Rect2_pull(L, 3)));
+  return 1;
+}
+
+/*! field:steer(group, [speed]) returns number of sprites steered */
+static int steer(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2 && n != 3) 
+    return luaL_error(L, "Got %d arguments expected 2 or 3 (self, group, [speed])", n); 
+    
+  FlowField* field = checkFlowField(L);
+  real speed = n == 3 ? luaL_checknumber(L, 3) : 0.0;
+  lua_pushinteger(L, field->steer(checkShape(L, 2), speed));
+  return 1;
+}
+
+// __gc
+static int destroyFlowField(lua_State* L)
+{
+  FlowField* field = 0;
+  checkUserData(L, "Lusion.FlowField", field);
+  delete field;
+  return 0;
+}
+
+// functions that will show up in our Lua environment
+static const luaL_Reg gDestroyFlowFieldFuncs[] = {
+  {"__gc", destroyFlowField},  
+  {NULL, NULL}  
+};
+
+static const luaL_Reg gFlowFieldFuncs[] = {
+  {"new", newFlowField},
+  // Accessors
+  {"columns", columns},
+  {"rows", rows},
+  {"goal", goal},
+  // Request
+  {"isBlocked", isBlocked},
+  // Calculations
+  {"distance", distance},
+  {"direction", direction},
+  {"sample", sample},
+  // Operations
+  {"setGoal", setGoal},
+  {"rasterize", rasterize},
+  {"update", update},
+  {"steer", steer},
+  {NULL, NULL}
+};
+
+// Initialization
+void initLuaFlowField(lua_State *L)
+{    
+  // Metatable to be used for userdata identification
+  luaL_newmetatable(L, "Lusion.FlowField");
+  luaL_register(L, 0, gDestroyFlowFieldFuncs);      
+  luaL_register(L, 0, gFlowFieldFuncs);      
+  lua_pushvalue(L,-1);
+  lua_setfield(L,-2, "__index");  
+
+  luaL_register(L, "FlowField", gFlowFieldFuncs);  
+}
@@ -0,0 +1,16 @@
+/*
+ *  LuaFlowField.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 12.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#pragma once
+
+struct lua_State;
+class FlowField;
+
+void initLuaFlowField(lua_State *L);
+FlowField *checkFlowField(lua_State* L, int index=1);
@@ -0,0 +1,315 @@
+/*
+ *  LuaJob.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "Lua/Base/LuaJob.h"
+#include "Lua/Base/LuaShape.h"
+#include "Lua/Geometry/LuaVector2.h"
+#include "Lua/Geometry/LuaRect2.h"
+#include "Lua/Geometry/LuaMotionState.h"
+#include "Lua/LuaUtils.h"
+
+#include "Base/Job.h"
+#include "Base/LoadJobs.h"
+#include "Base/TrajectoryTable.h"
+#include "World.h"
+
+#include <lua.hpp>
+#include <iostream>
+#include <cassert>
+
+using namespace std;
+
+/*!
+  \file LuaJob.cpp
+  \brief Loading and building on worker threads from Lua.
+
+  Each function starts a job on the job queue of the current world and
+  returns it at once. The callback is called with the result at the start
+  of the first frame after the job is done, before Engine.update:
+
+  \code
+  job = Job:loadLevel("script/levels/level2.lvl", function(level)
+    if level then roadmap:fromArrays(level:roadmap()) end
+  end)
+
+  job = Job:buildRoadmap(obstacles, obstacles:boundingBox(), 25*25, 1,
+    function(node_data, neighbors)
+      roadmap:fromArrays(node_data, neighbors)
+    end)
+
+  print(job:progress())    -- 0 to 1
+  job:cancel()             -- callback is never called
+  \endcode
+
+  The callback of a cancelled job is never called. loadLevel() gives nil to
+  its callback if the level could not be loaded.
+*/
+
+/*! Calls Lua function with result of job. Function is at top of stack when made */
+class LuaJobListener : public JobListener
+{
+public:
+  LuaJobListener(lua_State* aL) : L(aL)
+  {
+    luaL_checktype(L, -1, LUA_TFUNCTION);
+    iFunctionRef = luaL_ref(L, LUA_REGISTRYINDEX);
+  }
+
+  ~LuaJobListener()
+  {
+    luaL_unref(L, LUA_REGISTRYINDEX, iFunctionRef);
+  }
+
+  void jobFinished(Job* job);
+
+private:
+  int   pushResult(Job* job);
+
+private:
+  lua_State* L;
+  int   iFunctionRef;
+};
+
+/*! Pushes \a object as instance of Lua class \a class_name, like a constructor does */
+static void pushInstance(lua_State *L, const char* class_name, const char* metatable, SharedObject* object)
+{
+  lua_newtable(L);
+  lua_getglobal(L, class_name);
+  lua_pushvalue(L, -1);
+  lua_setfield(L, -2, "__index");
+  lua_setmetatable(L, -2);
+
+  SharedObject **o = (SharedObject **)lua_newuserdata(L, sizeof(SharedObject *));
+  *o = object;
+  object->retain();
+
+  setUserDataMetatable(L, metatable);
+}
+
+/*! Pushes roadmap as 'node_data, neighbors' like LevelFile:roadmap() */
+static void pushRoadmap(lua_State *L, const RoadmapNodes& nodes, const RoadmapNeighbors& neighbors)
+{
+  lua_createtable(L, nodes.size(), 0);
+  for (uint32 i = 0; i < nodes.size(); ++i) {
+    lua_createtable(L, 2, 0);
+    Vector2_push(L, nodes[i].position);
+    lua_rawseti(L, -2, 1);
+    lua_pushnumber(L, nodes[i].radius);
+    lua_rawseti(L, -2, 2);
+    lua_rawseti(L, -2, i+1);
+  }
+
+  lua_createtable(L, neighbors.size(), 0);
+  for (uint32 i = 0; i < neighbors.size(); ++i) {
+    lua_createtable(L, neighbors[i].size(), 0);
+    for (uint32 j = 0; j < neighbors[i].size(); ++j) {
+      lua_pushinteger(L, neighbors[i][j]+1);
+      lua_rawseti(L, -2, j+1);
+    }
+    lua_rawseti(L, -2, i+1);
+  }
+}
+
+int LuaJobListener::pushResult(Job* job)
+{
+  if (LevelLoadJob* load = dynamic_cast<LevelLoadJob*>(job)) {
+    if (load->level() && job->succeeded())
+      pushInstance(L, "LevelFile", "Lusion.LevelFile", load->level());
+    else
+      lua_pushnil(L);
+    return 1;
+  }
+  if (RoadmapJob* build = dynamic_cast<RoadmapJob*>(job)) {
+    pushRoadmap(L, build->nodes(), build->neighbors());
+    return 2;
+  }
+  if (TrajectoryTableJob* build = dynamic_cast<TrajectoryTableJob*>(job)) {
+    pushInstance(L, "TrajectoryTable", "Lusion.TrajectoryTable", build->table());
+    return 1;
+  }
+  return 0;
+}
+
+void LuaJobListener::jobFinished(Job* job)
+{
+  lua_rawgeti(L, LUA_REGISTRYINDEX, iFunctionRef);
+  int no_results = pushResult(job);
+  if (lua_pcall(L, no_results, 0, 0) != 0) {
+    cerr << "Error in job callback: "
+         << lua_tostring(L, -1) << endl;
+    lua_pop(L, 1);
+  }
+}
+
+// Helper functions
+Job *checkJob(lua_State* L, int index)
+{
+  Job* v;
+  pullClassInstance(L, index, "Lusion.Job", v);
+  return v;
+}
+
+/*! Adds \a job to current world and pushes it. Callback is at \a callback unless 0 */
+static int addJob(lua_State *L, Job* job, int callback)
+{
+  if (callback != 0) {
+    lua_pushvalue(L, callback);
+    job->setListener(new LuaJobListener(L));
+  }
+  World::current()->jobs()->add(job);
+
+  Job **j = (Job **)lua_newuserdata(L, sizeof(Job *));
+  *j = job;
+  setObjectMetatable(L, "Lusion.Job", 1);
+
+  return 1;
+}
+
+// Functions exported to Lua
+// Job:loadLevel(path, [callback]) calls callback with LevelFile or nil
+static int loadLevel(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2 && n != 3)
+    return luaL_error(L, "Got %d arguments expected 2 or 3 (class, path, [callback])", n);
+  luaL_checktype(L, 1, LUA_TTABLE);
+  const char* path = luaL_checkstring(L, 2);
+  if (n == 3)
+    luaL_checktype(L, 3, LUA_TFUNCTION);
+
+  return addJob(L, new LevelLoadJob(path), n == 3 ? 3 : 0);
+}
+
+/*!
+  Job:buildRoadmap(obstacles, box, no_samples, retract_quotient, [callback])
+  calls callback with 'node_data, neighbors'. See ProbablisticRoadMap:construct()
+*/
+static int buildRoadmap(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 5 && n != 6)
+    return luaL_error(L, "Got %d arguments expected 5 or 6 (class, obstacles, box, no_samples, retract_quotient, [callback])", n);
+  luaL_checktype(L, 1, LUA_TTABLE);
+  Shape* obstacles = checkShape(L, 2);
+  Rect2 box = Rect2_pull(L, 3);
+  int no_samples = luaL_checkint(L, 4);
+  real retract_quotient = luaL_checknumber(L, 5);
+  luaL_argcheck(L, no_samples > 0, 4, "number of samples must be positive");
+  luaL_argcheck(L, retract_quotient >= 0.0 && retract_quotient <= 1.0, 5, "retract quotient must be between 0 and 1");
+  if (n == 6)
+    luaL_checktype(L, 6, LUA_TFUNCTION);
+
+  uint32 seed = World::current()->random().next();
+  return addJob(L, new RoadmapJob(obstacles, box, no_samples, retract_quotient, seed), n == 6 ? 6 : 0);
+}
+
+/*!
+  Job:buildTrajectoryTable(state, angvel_min, angvel_max, angvel_steps, dt, steps, [callback])
+  calls callback with TrajectoryTable. See TrajectoryTable:new()
+*/
+static int buildTrajectoryTable(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 7 && n != 8)
+    return luaL_error(L, "Got %d arguments expected 7 or 8 (class, state, angvel_min, angvel_max, angvel_steps, dt, steps, [callback])", n);
+  luaL_checktype(L, 1, LUA_TTABLE);
+
+  MotionState* s0 = checkMotionState(L, 2);
+  real angvel_min = luaL_checknumber(L, 3);
+  real angvel_max = luaL_checknumber(L, 4);
+  int  angvel_steps = luaL_checkinteger(L, 5);
+  real dt = luaL_checknumber(L, 6);
+  int  steps = luaL_checkinteger(L, 7);
+  luaL_argcheck(L, angvel_min < angvel_max, 4, "max angular velocity must be larger than min");
+  luaL_argcheck(L, angvel_steps > 0, 5, "number of angular velocity steps must be positive");
+  luaL_argcheck(L, steps > 0, 7, "number of integration steps must be positive");
+  if (n == 8)
+    luaL_checktype(L, 8, LUA_TFUNCTION);
+
+  return addJob(L, new TrajectoryTableJob(*s0, angvel_min, angvel_max, angvel_steps, dt, steps), n == 8 ? 8 : 0);
+}
+
+// __gc for Job
+static int destroyJob(lua_State* L)
+{
+  Job* job = 0;
+  checkUserData(L, "Lusion.Job", job);
+  job->release();
+  return 0;
+}
+
+// Accessors
+static int progress(lua_State *L)
+{
+  lua_pushnumber(L, checkJob(L)->progress());
+  return 1;
+}
+
+// Request
+static int isFinished(lua_State *L)
+{
+  lua_pushboolean(L, checkJob(L)->isFinished());
+  return 1;
+}
+
+static int isPublished(lua_State *L)
+{
+  lua_pushboolean(L, checkJob(L)->isPublished());
+  return 1;
+}
+
+static int isCancelled(lua_State *L)
+{
+  lua_pushboolean(L, checkJob(L)->isCancelled());
+  return 1;
+}
+
+// Operations
+static int cancel(lua_State *L)
+{
+  checkJob(L)->cancel();
+  return 0;
+}
+
+static const luaL_Reg gDestroyJobFuncs[] = {
+  {"__gc", destroyJob},
+  {NULL, NULL}
+};
+
+static const luaL_Reg gJobFuncs[] = {
+  {"loadLevel", loadLevel},
+  {"buildRoadmap", buildRoadmap},
+  {"buildTrajectoryTable", buildTrajectoryTable},
+  // Accessors
+  {"progress", progress},
+  // Request
+  {"isFinished", isFinished},
+  {"isPublished", isPublished},
+  {"isCancelled", isCancelled},
+  // Operations
+  {"cancel", cancel},
+  {NULL, NULL}
+};
+
+// Initialization
+void initLuaJob(lua_State *L)
+{
+  // Metatable to be used for userdata identification
+  luaL_newmetatable(L, "Lusion.Job");
+  luaL_register(L, 0, gDestroyJobFuncs);
+  luaL_register(L, 0, gJobFuncs);
+  lua_pushcfunction(L, objectIndex);
+  lua_setfield(L,-2, "__index");
+  lua_pushcfunction(L, objectNewIndex);
+  lua_setfield(L,-2, "__newindex");
+
+  luaL_register(L, "Job", gJobFuncs);
+  lua_pushvalue(L,-1);
+  lua_setfield(L,-2, "__index");
+}
@@ -0,0 +1,16 @@
+/*
+ *  LuaJob.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#pragma once
+
+struct lua_State;
+class Job;
+
+void initLuaJob(lua_State *L);
+Job *checkJob(lua_State* L, int index=1);
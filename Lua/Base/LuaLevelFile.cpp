@@ -0,0 +1,258 @@
+/*
+ *  LuaLevelFile.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "Lua/Base/LuaLevelFile.h"
+#include "Lua/Base/LuaShape.h"
+#include "Lua/Geometry/LuaVector2.h"
+#include "Lua/Geometry/LuaRect2.h"
+#include "Lua/LuaUtils.h"
+
+#include "Base/LevelFile.h"
+#include "Base/Shape.h"
+
+#include <lua.hpp>
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+
+/*!
+  \file LuaLevelFile.cpp
+  \brief Binary levels from Lua.
+
+  A level loaded from a Lua script is exported once, together with the
+  roadmap found for it, and loaded from the binary file afterwards:
+
+  \code
+  LevelFile:save("script/levels/level2.lvl", obstacles, roadmap:toArrays())
+
+  level = LevelFile:load("script/levels/level2.lvl")
+  if level then
+    obstacles = level:obstacles()   -- see engine.lua
+    roadmap:fromArrays(level:roadmap())
+  end
+  \endcode
+
+  Roadmaps are given as 'node_data, neighbors' where node_data[i] is
+  '{position, radius}' and neighbors[i] holds indices of the nodes
+  connected to node i.
+*/
+
+// Helper functions
+LevelFile *checkLevelFile(lua_State* L, int index)
+{
+  LevelFile* v;
+  pullClassInstance(L, index, "Lusion.LevelFile", v);
+  return v;
+}
+
+// Functions exported to Lua
+// LevelFile:load(path) returns level saved with save() or nil
+static int load(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2)
+    return luaL_error(L, "Got %d arguments expected 2 (class, path)", n);
+  luaL_checktype(L, 1, LUA_TTABLE);
+
+  LevelFile* level = LevelFile::load(luaL_checkstring(L, 2));
+  if (level == 0) {
+    lua_pushnil(L);
+    return 1;
+  }
+
+  pushClassInstance(L);
+
+  LevelFile **l = (LevelFile **)lua_newuserdata(L, sizeof(LevelFile *));
+  *l = level;
+
+  setUserDataMetatable(L, "Lusion.LevelFile");
+
+  return 1;
+}
+
+/*!
+  LevelFile:save(path, obstacles, [node_data, neighbors]) writes 'obstacles'
+  and optional roadmap to 'path'. Returns true on success.
+*/
+static int save(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 3 && n != 5)
+    return luaL_error(L, "Got %d arguments expected 3 or 5 (class, path, obstacles, [node_data, neighbors])", n);
+  luaL_checktype(L, 1, LUA_TTABLE);
+
+  const char* path = luaL_checkstring(L, 2);
+  Shape* obstacles = checkShape(L, 3);
+
+  RoadmapNodes nodes;
+  RoadmapNeighbors neighbors;
+  if (n == 5) {
+    luaL_checktype(L, 4, LUA_TTABLE);
+    luaL_checktype(L, 5, LUA_TTABLE);
+    int no_nodes = lua_objlen(L, 4);
+    nodes.resize(no_nodes);
+    neighbors.resize(no_nodes);
+    for (int i = 0; i < no_nodes; ++i) {
+      lua_rawgeti(L, 4, i+1);
+      luaL_checktype(L, -1, LUA_TTABLE);
+      lua_rawgeti(L, -1, 1);
+      nodes[i].position = Vector2_pull(L, -1);
+      lua_rawgeti(L, -2, 2);
+      nodes[i].radius = luaL_checknumber(L, -1);
+      lua_pop(L, 3);
+
+      lua_rawgeti(L, 5, i+1);
+      if (lua_istable(L, -1)) {
+        int no_neighbors = lua_objlen(L, -1);
+        for (int j = 1; j <= no_neighbors; ++j) {
+          lua_rawgeti(L, -1, j);
+          int neighbor = luaL_checkint(L, -1);
+          luaL_argcheck(L, neighbor >= 1 && neighbor <= no_nodes, 5, "neighbor is not a node");
+          neighbors[i].push_back(neighbor-1);
+          lua_pop(L, 1);
+        }
+      }
+      lua_pop(L, 1);
+    }
+  }
+
+  lua_pushboolean(L, LevelFile::save(path, obstacles, nodes, neighbors));
+  return 1;
+}
+
+// Accessors
+static int noObstacles(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1)
+    return luaL_error(L, "Got %d arguments expected 1 (self)", n);
+
+  lua_pushinteger(L, checkLevelFile(L)->noObstacles());
+  return 1;
+}
+
+static int boundingBox(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1)
+    return luaL_error(L, "Got %d arguments expected 1 (self)", n);
+
+  Rect2_push(L, checkLevelFile(L)->boundingBox());
+  return 1;
+}
+
+// level:polygon(i) returns collision polygon of i'th obstacle as array of points
+static int polygon(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2)
+    return luaL_error(L, "Got %d arguments expected 2 (self, index)", n);
+
+  LevelFile* level = checkLevelFile(L);
+  int i = luaL_checkint(L, 2);
+  luaL_argcheck(L, i >= 1 && i <= level->noObstacles(), 2, "no such obstacle");
+
+  Polygon2 p = level->polygon(i-1);
+  for_each(p.begin(), p.end(), PushValue<Point2>(L));
+  return 1;
+}
+
+// level:color(i) returns red, green and blue of i'th obstacle
+static int color(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2)
+    return luaL_error(L, "Got %d arguments expected 2 (self, index)", n);
+
+  LevelFile* level = checkLevelFile(L);
+  int i = luaL_checkint(L, 2);
+  luaL_argcheck(L, i >= 1 && i <= level->noObstacles(), 2, "no such obstacle");
+
+  const real* c = level->color(i-1);
+  lua_pushnumber(L, c[0]);
+  lua_pushnumber(L, c[1]);
+  lua_pushnumber(L, c[2]);
+  return 3;
+}
+
+// level:roadmap() returns 'node_data, neighbors' like save() takes them
+static int roadmap(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1)
+    return luaL_error(L, "Got %d arguments expected 1 (self)", n);
+
+  LevelFile* level = checkLevelFile(L);
+  int no_nodes = level->noRoadmapNodes();
+
+  lua_createtable(L, no_nodes, 0);
+  for (int i = 0; i < no_nodes; ++i) {
+    const RoadmapNode& node = level->roadmapNode(i);
+    lua_createtable(L, 2, 0);
+    Vector2_push(L, node.position);
+    lua_rawseti(L, -2, 1);
+    lua_pushnumber(L, node.radius);
+    lua_rawseti(L, -2, 2);
+    lua_rawseti(L, -2, i+1);
+  }
+
+  lua_createtable(L, no_nodes, 0);
+  for (int i = 0; i < no_nodes; ++i) {
+    int no_neighbors = level->noNeighbors(i);
+    const uint32* neighbors = level->neighbors(i);
+    lua_createtable(L, no_neighbors, 0);
+    for (int j = 0; j < no_neighbors; ++j) {
+      lua_pushinteger(L, neighbors[j]+1);
+      lua_rawseti(L, -2, j+1);
+    }
+    lua_rawseti(L, -2, i+1);
+  }
+  return 2;
+}
+
+// __gc
+static int destroyLevelFile(lua_State* L)
+{
+  LevelFile* level = 0;
+  checkUserData(L, "Lusion.LevelFile", level);
+  level->release();
+  return 0;
+}
+
+// functions that will show up in our Lua environment
+static const luaL_Reg gDestroyLevelFileFuncs[] = {
+  {"__gc", destroyLevelFile},
+  {NULL, NULL}
+};
+
+static const luaL_Reg gLevelFileFuncs[] = {
+  {"load", load},
+  {"save", save},
+  // Accessors
+  {"noObstacles", noObstacles},
+  {"boundingBox", boundingBox},
+  {"polygon", polygon},
+  {"color", color},
+  {"roadmap", roadmap},
+  {NULL, NULL}
+};
+
+// Initialization
+void initLuaLevelFile(lua_State *L)
+{
+  // Metatable to be used for userdata identification
+  luaL_newmetatable(L, "Lusion.LevelFile");
+  luaL_register(L, 0, gDestroyLevelFileFuncs);
+  luaL_register(L, 0, gLevelFileFuncs);
+  lua_pushvalue(L,-1);
+  lua_setfield(L,-2, "__index");
+
+  luaL_register(L, "LevelFile", gLevelFileFuncs);
+}
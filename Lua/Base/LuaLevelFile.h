@@ -0,0 +1,16 @@
+/*
+ *  LuaLevelFile.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#pragma once
+
+struct lua_State;
+class LevelFile;
+
+void initLuaLevelFile(lua_State *L);
+LevelFile *checkLevelFile(lua_State* L, int index=1);
@@ -0,0 +1,197 @@
+/*
+ *  LuaPlanningScheduler.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 21.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "Lua/Base/LuaPlanningScheduler.h"
+#include "Lua/Base/LuaShape.h"
+#include "Lua/LuaUtils.h"
+
+#include "Base/PlanningScheduler.h"
+
+#include <lua.hpp>
+#include <cassert>
+
+using namespace std;
+
+/*!
+  \file LuaPlanningScheduler.cpp
+  \brief Time sliced planning from Lua.
+
+  A scheduler runs planning for shapes and Lua coroutines in the time left
+  of each frame instead of one shape per frame:
+
+  \code
+  planner = PlanningScheduler:new(3000)   -- 3 ms per frame
+  planner:add(npc)                        -- calls npc:doPlanning(t, dt)
+  planner:add(function(t, deadline)
+    while not done do
+      if Engine.monotonicSeconds() > deadline then
+        t, deadline = coroutine.yield()
+      end
+      ...
+    end
+  end, 1)
+
+  function update(start_time)
+    planner:run(start_time)
+  end
+  \endcode
+
+  While Engine.isDeterministic() every task is resumed each run, and a task
+  should yield after a fixed amount of work rather than at the deadline, or
+  a replay will not repeat the recording.
+*/
+
+// Helper functions
+PlanningScheduler *checkPlanningScheduler(lua_State* L, int index)
+{
+  PlanningScheduler* v;
+  pullClassInstance(L, index, "Lusion.PlanningScheduler", v);
+  return v;
+}
+
+// Functions exported to Lua
+// PlanningScheduler:new([budget])
+static int newPlanningScheduler(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1 && n != 2)
+    return luaL_error(L, "Got %d arguments expected 1 or 2 (class, [budget])", n);
+  luaL_checktype(L, 1, LUA_TTABLE);
+
+  PlanningScheduler **s = (PlanningScheduler **)lua_newuserdata(L, sizeof(PlanningScheduler *));
+  *s = n == 2 ? new PlanningScheduler(luaL_checkint(L, 2)) : new PlanningScheduler;
+  setObjectMetatable(L, "Lusion.PlanningScheduler", 1);
+
+  return 1;
+}
+
+// __gc for PlanningScheduler
+static int destroyPlanningScheduler(lua_State* L)
+{
+  PlanningScheduler* scheduler = 0;
+  checkUserData(L, "Lusion.PlanningScheduler", scheduler);
+  scheduler->release();
+  return 0;
+}
+
+// Accessors
+static int setBudget(lua_State *L)
+{
+  checkPlanningScheduler(L)->setBudget(luaL_checkint(L, 2));
+  return 0;
+}
+
+static int budget(lua_State *L)
+{
+  lua_pushinteger(L, checkPlanningScheduler(L)->budget());
+  return 1;
+}
+
+// Request
+static int size(lua_State *L)
+{
+  lua_pushinteger(L, checkPlanningScheduler(L)->size());
+  return 1;
+}
+
+// Operations
+// scheduler:add(shape or function, [priority])
+static int add(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2 && n != 3)
+    return luaL_error(L, "Got %d arguments expected 2 or 3 (self, shape or function, [priority])", n);
+
+  PlanningScheduler* scheduler = checkPlanningScheduler(L);
+  int priority = n == 3 ? luaL_checkint(L, 3) : 0;
+
+  PlanningTask* task = 0;
+  if (lua_isfunction(L, 2)) {
+    lua_pushvalue(L, 2);
+    task = new LuaPlanningTask(L, priority);
+    lua_pop(L, 1);
+  }
+  else {
+    task = new ShapePlanningTask(checkShape(L, 2), priority);
+  }
+  scheduler->add(task);
+  task->release();
+  return 0;
+}
+
+// scheduler:remove(shape)
+static int removeShape(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2)
+    return luaL_error(L, "Got %d arguments expected 2 (self, shape)", n);
+  checkPlanningScheduler(L)->remove(checkShape(L, 2));
+  return 0;
+}
+
+static int clear(lua_State *L)
+{
+  checkPlanningScheduler(L)->clear();
+  return 0;
+}
+
+/*!
+  scheduler:run(start_time, [budget]) resumes tasks until budget microseconds
+  have passed. Returns number of tasks resumed.
+*/
+static int run(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2 && n != 3)
+    return luaL_error(L, "Got %d arguments expected 2 or 3 (self, start_time, [budget])", n);
+
+  PlanningScheduler* scheduler = checkPlanningScheduler(L);
+  real start_time = luaL_checknumber(L, 2);
+  uint32 count = n == 3 ? scheduler->run(start_time, luaL_checkint(L, 3)) : scheduler->run(start_time);
+  lua_pushinteger(L, count);
+  return 1;
+}
+
+static const luaL_Reg gDestroyPlanningSchedulerFuncs[] = {
+  {"__gc", destroyPlanningScheduler},
+  {"__len", size},
+  {NULL, NULL}
+};
+
+static const luaL_Reg gPlanningSchedulerFuncs[] = {
+  {"new", newPlanningScheduler},
+  // Accessors
+  {"setBudget", setBudget},
+  {"budget", budget},
+  // Request
+  {"size", size},
+  // Operations
+  {"add", add},
+  {"remove", removeShape},
+  {"clear", clear},
+  {"run", run},
+  {NULL, NULL}
+};
+
+// Initialization
+void initLuaPlanningScheduler(lua_State *L)
+{
+  // Metatable to be used for userdata identification
+  luaL_newmetatable(L, "Lusion.PlanningScheduler");
+  luaL_register(L, 0, gDestroyPlanningSchedulerFuncs);
+  luaL_register(L, 0, gPlanningSchedulerFuncs);
+  lua_pushcfunction(L, objectIndex);
+  lua_setfield(L,-2, "__index");
+  lua_pushcfunction(L, objectNewIndex);
+  lua_setfield(L,-2, "__newindex");
+
+  luaL_register(L, "PlanningScheduler", gPlanningSchedulerFuncs);
+  lua_pushvalue(L,-1);
+  lua_setfield(L,-2, "__index");
+}
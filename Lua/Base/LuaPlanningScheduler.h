@@ -0,0 +1,16 @@
+/*
+ *  LuaPlanningScheduler.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 21.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#pragma once
+
+struct lua_State;
+class PlanningScheduler;
+
+void initLuaPlanningScheduler(lua_State *L);
+PlanningScheduler *checkPlanningScheduler(lua_State* L, int index=1);
@@ -10,6 +10,8 @@
 #include "Lua/Base/LuaShape.h"
 
 #include "Lua/LuaUtils.h"
+#include "Lua/Base/LuaContactBuffer.h"
+#include "Lua/Base/LuaLevelFile.h"
 #include "Lua/Geometry/LuaMotionState.h"
 #include "Lua/Geometry/LuaRect2.h"
 #include "Lua/Geometry/LuaVector2.h"
@@ -17,9 +19,11 @@
 
 #include "Base/Sprite.h"
 #include "Base/ShapeGroup.h"
-#include "Timing.h"
+#include "World.h"
 #include "Base/Group.h"
 #include "Base/Action.h"
+#include "Base/ContactBuffer.h"
+#include "Base/LevelFile.h"
 
 #include "Base/CircleShape.h"
 #include "Base/RectShape2.h"
@@ -35,6 +39,10 @@
 #include <lua.hpp>
 #include <cassert>
 
+// Key in registry for the pointer to table mapping. Avoids a string lookup
+// each time a collision or action callback needs the table of a shape.
+static char gShapesKey;
+
 // Helper functions
 /*!
  Create a table to hold mapping between lua tables and pointers. The table has weak
@@ -50,6 +58,10 @@ void initShapeBookkeeping(lua_State* L)
   
   lua_pushvalue(L,-1);                    // Let the table be its own metatable
   lua_setmetatable(L, -2);    
+
+  lua_pushlightuserdata(L, &gShapesKey);
+  lua_pushvalue(L, -2);
+  lua_rawset(L, LUA_REGISTRYINDEX);
 }
 
 void registerShapeTable(lua_State* L, Shape* shape)
@@ -59,7 +71,11 @@ void registerShapeTable(lua_State* L, Shape* shape)
 
 void retrieveShapeTable(lua_State* L, Shape* shape)
 {
-  retrievePointer(L, shape, "Lusion.Shapes");  
+  lua_pushlightuserdata(L, &gShapesKey);
+  lua_rawget(L, LUA_REGISTRYINDEX);
+  lua_pushlightuserdata(L, shape);
+  lua_rawget(L, -2);
+  lua_remove(L, -2);
 }
 
 Shape *checkShape(lua_State* L, int index)
@@ -70,20 +86,48 @@ Shape *checkShape(lua_State* L, int index)
 }
 
 // Functions exported to Lua
+/*!
+  Shape:newShapeGroup(group) builds a bounding volume hierarchy of shapes in 'group'.
+  Shape:newShapeGroup(level, obstacles) groups array of shapes 'obstacles' in 
+  hierarchy stored in LevelFile 'level' instead, obstacles[i] being the
+  shape for level:polygon(i).
+*/
 static int newShapeGroup(lua_State *L) 
 {
   int n = lua_gettop(L);  // Number of arguments
-  if (n != 2)
-    return luaL_error(L, "Got %d arguments expected 2 (class, group)", n); 
+  if (n != 2 && n != 3)
+    return luaL_error(L, "Got %d arguments expected 2 or 3 (class, group or level, [obstacles])", n); 
   luaL_checktype(L, 1, LUA_TTABLE); 
 
+  Shape* shape = 0;
+  if (n == 3) {
+    LevelFile* level = checkLevelFile(L, 2);
+    luaL_checktype(L, 3, LUA_TTABLE);
+    std::vector<Shape*> obstacles(lua_objlen(L, 3));
+    for (size_t i = 0; i < obstacles.size(); ++i) {
+      lua_rawgeti(L, 3, i+1);
+      obstacles[i] = checkShape(L, -1);
+      lua_pop(L, 1);
+    }
+    shape = level->createObstacles(obstacles);
+    if (shape == 0)
+      return luaL_error(L, "Level has %d obstacles but got %d", level->noObstacles(), int(obstacles.size()));
+    if (shape->isSimple()) {  // Level with one obstacle needs no group
+      shape->release();
+      lua_rawgeti(L, 3, 1);
+      return 1;
+    }
+  }
+  else {
+    Group* group = checkGroup(L,2);
+    assert(group != 0);
+    shape = new ShapeGroup(group->iterator());
+  }
+  
   pushClassInstance(L);
     
   Shape **g = (Shape **)lua_newuserdata(L, sizeof(Shape *));
-  
-  Group* group = checkGroup(L,2);
-  assert(group != 0);
-  *g = new ShapeGroup(group->iterator());
+  *g = shape;
 
   setUserDataMetatable(L, "Lusion.Shape");
 
@@ -244,7 +288,7 @@ static int collide(lua_State *L)
 {
   int n = lua_gettop(L);  // Number of arguments
   if (n != 5 && n != 4 && n != 2)
-    return luaL_error(L, "Got %d arguments expected 5, 4 or 2 (self, shape [,start_time, delta_time [, function]])", n); 
+    return luaL_error(L, "Got %d arguments expected 5, 4 or 2 (self, shape [,start_time, delta_time [, function or contacts]])", n); 
     
   Shape* shape = checkShape(L,1); 
   Shape* other = checkShape(L,2);      
@@ -257,14 +301,17 @@ static int collide(lua_State *L)
     dt = luaL_checknumber(L, 4);    
   }
   else {
-    t = secondsPassed();
+    t = World::current()->seconds();
     dt = 1.0f;
   }
   
   bool ret = false;
   if (n <= 4)
     ret = shape->collide(other, t, dt);
-  else if (n == 5) {
+  else if (ContactBuffer* contacts = toContactBuffer(L, 5)) {
+    ret = shape->collide(other, t, dt, contacts);
+  }
+  else {
     lua_pushvalue(L,5);
     LuaCollisionAction cmd(L);
     ret = shape->collide(other, t, dt, &cmd);
@@ -292,7 +339,7 @@ static int inside(lua_State *L)
     dt = luaL_checknumber(L, 4);    
   }
   else {
-    t = secondsPassed();
+    t = World::current()->seconds();
     dt = 1.0f;
   }
   
@@ -13,10 +13,13 @@
 #include "Lua/Base/LuaShape.h"
 #include "Lua/Base/LuaSprite.h"
 #include "Lua/LuaUtils.h"
+#include "Lua/Base/LuaContactBuffer.h"
 #include "LuaEngine.h"
 #include "Engine.h"
+#include "World.h"
 #include "Base/Group.h"
 #include "Base/Action.h"
+#include "Base/ContactBuffer.h"
 #include "Base/Sprite.h"
 #include "Base/ShapeGroup.h"
 
@@ -532,6 +535,9 @@ static int setCollisionHandler(lua_State* L)
   if (lua_isnil(L, 2)) {
     sprite->setCollisionAction(0);
   }
+  else if (ContactBuffer* contacts = toContactBuffer(L, 2)) {
+    sprite->setCollisionAction(contacts);
+  }
   else {
     lua_pushvalue(L,2);
     CollisionAction* cmd = new LuaCollisionAction(L);
@@ -643,7 +649,7 @@ static int collide(lua_State* L)
 {
   int n = lua_gettop(L);
   if (n != 5 && n != 4 && n != 2)
-    return luaL_error(L, "Got %d arguments expected 5, 4 or 2 (self, shape [,start_time, delta_time [, function]])", n); 
+    return luaL_error(L, "Got %d arguments expected 5, 4 or 2 (self, shape [,start_time, delta_time [, function or contacts]])", n); 
   Sprite* sprite = checkSprite(L,1);
   Shape*  obj = checkShape(L,2);   
   assert(sprite != 0);    
@@ -655,14 +661,17 @@ static int collide(lua_State* L)
     dt = luaL_checknumber(L, 4);    
   }
   else {
-    t = secondsPassed();
+    t = World::current()->seconds();
     dt = 1.0f;
   }
   
   bool ret = false;
   if (n <= 4)
     ret = sprite->collide(obj, t, dt);
-  else if (n == 5) {
+  else if (ContactBuffer* contacts = toContactBuffer(L, 5)) {
+    ret = sprite->collide(obj, t, dt, contacts);
+  }
+  else {
     lua_pushvalue(L,5);
     LuaCollisionAction cmd(L);
     ret = sprite->collide(obj, t, dt, &cmd);
@@ -0,0 +1,250 @@
+/*
+ *  LuaTrajectoryPlanner.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 16.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "Lua/Base/LuaTrajectoryPlanner.h"
+#include "Lua/Base/LuaShape.h"
+#include "Lua/Geometry/LuaTrajectoryTable.h"
+#include "Lua/Geometry/LuaMotionState.h"
+#include "Lua/Geometry/LuaVector2.h"
+#include "Lua/LuaUtils.h"
+
+#include "Base/TrajectoryPlanner.h"
+#include "Base/MotionState.h"
+
+#include <lua.hpp>
+#include <cassert>
+
+// Helper functions
+TrajectoryPlanner *checkTrajectoryPlanner(lua_State* L, int index)
+{
+  TrajectoryPlanner* v;
+  pullClassInstance(L, index, "Lusion.TrajectoryPlanner", v);
+  return v;
+}
+
+/*! Push array of motion states corresponding to 'states'. */
+static void pushStates(lua_State *L, const TrajectoryPlanner* planner, const PlanStates& states, bool with_parent)
+{
+  lua_createtable(L, states.size(), 0);
+  for (size_t i = 0; i < states.size(); ++i) {
+    MotionState* mstate = new MotionState;
+    planner->getMotionState(states[i], *mstate);
+    MotionState_push(L, mstate);
+    mstate->release();
+    if (with_parent && states[i].parent >= 0) {
+      lua_pushinteger(L, states[i].parent+1);
+      lua_setfield(L, -2, "parent");
+    }
+    lua_rawseti(L, -2, i+1);
+  }
+}
+
+// Functions exported to Lua
+// TrajectoryPlanner:new(trajectory_table, view, obstacles)
+static int newTrajectoryPlanner(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 4)
+    return luaL_error(L, "Got %d arguments expected 4 (class, table, view, obstacles)", n); 
+  luaL_checktype(L, 1, LUA_TTABLE); 
+
+  TrajectoryTable* table = checkTrajectoryTable(L, 2);
+  View* view = checkView(L, 3);
+  Shape* obstacles = checkShape(L, 4);
+  
+  pushClassInstance(L);
+    
+  TrajectoryPlanner **p = (TrajectoryPlanner **)lua_newuserdata(L, sizeof(TrajectoryPlanner *));
+  *p = new TrajectoryPlanner(table, view, obstacles);
+
+  setUserDataMetatable(L, "Lusion.TrajectoryPlanner");
+
+  return 1; 
+}
+
+// Accessors
+static int setDiscount(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2) 
+    return luaL_error(L, "Got %d arguments expected 2 (self, discount)", n); 
+    
+  TrajectoryPlanner* planner = checkTrajectoryPlanner(L);
+  real discount = luaL_checknumber(L, 2);
+  luaL_argcheck(L, discount > 0.0 && discount < 1.0, 2, "discount must be in range (0, 1)");
+  planner->setDiscount(discount);
+  return 0;
+}
+
+static int setOptimism(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2) 
+    return luaL_error(L, "Got %d arguments expected 2 (self, optimism)", n); 
+    
+  checkTrajectoryPlanner(L)->setOptimism(luaL_checknumber(L, 2));
+  return 0;
+}
+
+static int setObstacles(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2) 
+    return luaL_error(L, "Got %d arguments expected 2 (self, obstacles)", n); 
+    
+  checkTrajectoryPlanner(L)->setObstacles(checkShape(L, 2));
+  return 0;
+}
+
+/*! 
+  planner:setScore{seek = {weight, target}, flank = {weight, enemy, distance}, avoid = {weight}}
+  Replaces the goodness functions written in Lua with native ones. 'enemy' is a MotionState.
+  All entries are optional. Weights are combined like in Geometry.combineBehavior().
+*/
+static int setScore(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2) 
+    return luaL_error(L, "Got %d arguments expected 2 (self, score)", n); 
+    
+  TrajectoryPlanner* planner = checkTrajectoryPlanner(L);
+  luaL_checktype(L, 2, LUA_TTABLE);
+  
+  CombinedGoodness* combined = new CombinedGoodness;
+  
+  lua_getfield(L, 2, "seek");
+  if (lua_istable(L, -1)) {
+    lua_rawgeti(L, -1, 1);
+    lua_rawgeti(L, -2, 2);
+    real weight = luaL_checknumber(L, -2);
+    PlanGoodness* g = new SeekGoodness(Vector2_pull(L, lua_gettop(L)));
+    combined->add(weight, g);
+    g->release();
+    lua_pop(L, 2);
+  }
+  lua_pop(L, 1);
+  
+  lua_getfield(L, 2, "flank");
+  if (lua_istable(L, -1)) {
+    lua_rawgeti(L, -1, 1);
+    lua_rawgeti(L, -2, 2);
+    lua_rawgeti(L, -3, 3);
+    real weight = luaL_checknumber(L, -3);
+    MotionState* enemy = checkMotionState(L, lua_gettop(L)-1);
+    real distance = luaL_checknumber(L, -1);
+    PlanGoodness* g = new FlankGoodness(enemy->position(), enemy->direction(), distance);
+    combined->add(weight, g);
+    g->release();
+    lua_pop(L, 3);
+  }
+  lua_pop(L, 1);
+  
+  lua_getfield(L, 2, "avoid");
+  if (lua_istable(L, -1)) {
+    lua_rawgeti(L, -1, 1);
+    real weight = luaL_checknumber(L, -1);
+    PlanGoodness* g = new AvoidCollisionGoodness;
+    combined->add(weight, g);
+    g->release();
+    lua_pop(L, 1);
+  }
+  lua_pop(L, 1);
+  
+  planner->setGoodness(combined);
+  combined->release();
+  return 0;
+}
+
+// Calculations
+// planner:plan(s0, max_depth, start_time, delta_time) returns array of states or nil
+static int plan(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 5) 
+    return luaL_error(L, "Got %d arguments expected 5 (self, state, max_depth, start_time, delta_time)", n); 
+    
+  TrajectoryPlanner* planner = checkTrajectoryPlanner(L);
+  MotionState* s0 = checkMotionState(L, 2);
+  int  max_depth = luaL_checkinteger(L, 3);
+  real start_time = luaL_checknumber(L, 4);
+  real delta_time = luaL_checknumber(L, 5);
+  
+  PlanStates path;
+  if (!planner->plan(*s0, max_depth, start_time, delta_time, path)) {
+    lua_pushnil(L);
+    return 1;
+  }
+  pushStates(L, planner, path, false);
+  return 1;
+}
+
+// planner:visited() returns all states visited in last search. Each state
+// has a 'parent' field with index of its parent in returned array.
+static int visited(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1) 
+    return luaL_error(L, "Got %d arguments expected 1 (self)", n); 
+    
+  TrajectoryPlanner* planner = checkTrajectoryPlanner(L);
+  pushStates(L, planner, planner->states(), true);
+  return 1;
+}
+
+static int noExpanded(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1) 
+    return luaL_error(L, "Got %d arguments expected 1 (self)", n); 
+    
+  lua_pushinteger(L, checkTrajectoryPlanner(L)->noExpanded());
+  return 1;
+}
+
+// __gc
+static int destroyTrajectoryPlanner(lua_State* L)
+{
+  TrajectoryPlanner* planner = 0;
+  checkUserData(L, "Lusion.TrajectoryPlanner", planner);
+  planner->release();
+  return 0;
+}
+
+// functions that will show up in our Lua environment
+static const luaL_Reg gDestroyTrajectoryPlannerFuncs[] = {
+  {"__gc", destroyTrajectoryPlanner},
+  {NULL, NULL}
+};
+
+static const luaL_Reg gTrajectoryPlannerFuncs[] = {
+  {"new", newTrajectoryPlanner},
+  // Accessors
+  {"setDiscount", setDiscount},
+  {"setOptimism", setOptimism},
+  {"setObstacles", setObstacles},
+  {"setScore", setScore},
+  {"noExpanded", noExpanded},
+  // Calculations
+  {"plan", plan},
+  {"visited", visited},
+  {NULL, NULL}
+};
+
+// Initialization
+void initLuaTrajectoryPlanner(lua_State *L)
+{    
+  // Metatable to be used for userdata identification
+  luaL_newmetatable(L, "Lusion.TrajectoryPlanner");
+  luaL_register(L, 0, gDestroyTrajectoryPlannerFuncs);      
+  luaL_register(L, 0, gTrajectoryPlannerFuncs);      
+  lua_pushvalue(L,-1);
+  lua_setfield(L,-2, "__index");  
+
+  luaL_register(L, "TrajectoryPlanner", gTrajectoryPlannerFuncs);  
+}
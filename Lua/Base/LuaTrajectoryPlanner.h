@@ -0,0 +1,16 @@
+/*
+ *  LuaTrajectoryPlanner.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 16.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#pragma once
+
+struct lua_State;
+class TrajectoryPlanner;
+
+void initLuaTrajectoryPlanner(lua_State *L);
+TrajectoryPlanner *checkTrajectoryPlanner(lua_State* L, int index=1);
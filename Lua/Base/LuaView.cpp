@@ -14,6 +14,7 @@
 #include "Lua/LuaUtils.h"
 #include "Lua/Geometry/LuaVector2.h"
 #include "Lua/Geometry/LuaSegment2.h"
+#include "Lua/Geometry/LuaPointBuffer.h"
 // #include "Lua/Geometry/LuaTrapezoid2.h"
 
 #include "Base/PolygonView.h"
@@ -92,7 +93,7 @@ static int newOutlineView(lua_State *L)
   else
     return luaL_error(L, "Argument 2 has to be a string or table of strings", n); 
     
-  if (n >= 3 && lua_istable(L,3)) {
+  if (n >= 3 && (lua_istable(L,3) || toPointBuffer(L,3))) {
     Polygon2 p;
     getPolygon(L, 3, p);
     if (n == 5)
@@ -260,14 +261,15 @@ static int setPolygon(lua_State *L)
   return 0;
 }
 
+// view:collisionPolygon([buffer])
 static int polygon(lua_State *L)
 {
   int n = lua_gettop(L);
-  if (n != 1)
-    return luaL_error(L, "Got %d arguments expected 1", n);  
+  if (n != 1 && n != 2)
+    return luaL_error(L, "Got %d arguments expected 1 or 2", n);  
   View* view = checkView(L);
-  Polygon2 p = view->collisionPolygon();
-  for_each(p.begin(), p.end(), PushValue<Point2>(L));
+  const Polygon2& p = view->collisionPolygon();
+  pushPoints(L, p.begin(), p.end(), n == 2 ? 2 : 0);
   return 1;
 }
 
@@ -20,6 +20,7 @@
 #include <iostream>
 
 #include <lua.hpp>
+#include <cassert>
 
 EdgePair EdgeData_pull(lua_State *L, int index)
 {
@@ -43,6 +44,23 @@ EdgePair EdgeData_pull(lua_State *L, int index)
   
   return EdgePair(u, v, tag, pos);  
 }
+
+/*! Push \a e as table with same fields as EdgeData.new() creates */
+void EdgeData_push(lua_State *L, const EdgePair& e)
+{
+  lua_newtable(L);
+  Trapezoid2_push(L, e.trapezoid(0));
+  lua_setfield(L, -2, "u");
+  Trapezoid2_push(L, e.trapezoid(1));
+  lua_setfield(L, -2, "v");
+  lua_pushinteger(L, e.tag());
+  lua_setfield(L, -2, "tag");
+  Vector2_push(L, e.position());
+  lua_setfield(L, -2, "pos");
+
+  lua_getglobal(L, "EdgeData");
+  lua_setmetatable(L, -2);
+}
   
 static void checkArguments(lua_State *L)
 {
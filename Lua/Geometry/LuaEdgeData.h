@@ -14,4 +14,5 @@ struct lua_State;
 
 void initLuaEdgeData(lua_State *L);
 
-EdgePair EdgeData_pull(lua_State *L, int index);
\ No newline at end of file
+EdgePair EdgeData_pull(lua_State *L, int index);
+void     EdgeData_push(lua_State *L, const EdgePair& e);
\ No newline at end of file
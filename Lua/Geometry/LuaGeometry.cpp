@@ -14,6 +14,8 @@
 #include <Geometry/Vector2.hpp>
 #include <Utils/PolygonUtils.h>
 #include <Lua/Geometry/LuaVector2.h>
+#include <Lua/Geometry/LuaRect2.h>
+#include <Lua/Geometry/LuaPointBuffer.h>
 
 #include <Geometry/Polygon2.hpp>
 
@@ -23,9 +25,34 @@
 #include <vector>
 #include <iterator>
 #include <algorithm>
+#include <cstdlib>
+#include <cmath>
 
 using namespace std;
 
+// Helpers
+static real randomReal(real min, real max)
+{
+  return min + (max - min)*(rand()/(RAND_MAX + 1.0));
+}
+
+/*!
+  Gets buffer to fill with samples. Either existing buffer at 'index' which is
+  reused and left on top of the stack, or a new one pushed on the stack.
+*/
+static Points2* sampleBuffer(lua_State *L, int index)
+{
+  Points2* buffer = 0;
+  if (lua_gettop(L) >= index) {
+    buffer = checkPointBuffer(L, index);
+    lua_pushvalue(L, index);
+    buffer->clear();
+  }
+  else
+    buffer = PointBuffer_push(L);
+  return buffer;
+}
+
 // Functions exported to Lua
 static int inside(lua_State *L) 
 {
@@ -40,9 +67,56 @@ static int inside(lua_State *L)
   return 1; 
 }
 
+/*!
+  Geometry.stratifiedSampleBuffer(n, box, [buffer]) is the native counterpart
+  of Geometry.stratifiedSamples. Samples are returned in a PointBuffer so
+  no Lua table or vector is created per sample.
+*/
+static int stratifiedSampleBuffer(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2 && n != 3)
+   return luaL_error(L, "Got %d arguments expected 2 or 3 (n, box, [buffer])", n); 
+
+  int rows = static_cast<int>(floor(sqrt(luaL_checknumber(L, 1))));
+  Rect2 box = Rect2_pull(L, 2);
+  Points2* samples = sampleBuffer(L, 3);
+  
+  real cell_width  = (box.max().x() - box.min().x())/rows;
+  real cell_height = (box.max().y() - box.min().y())/rows;
+  samples->reserve(rows*rows);
+  for (int row = 0; row < rows; ++row) {
+    real y1 = box.min().y() + row*cell_height;
+    for (int col = 0; col < rows; ++col) {
+      real x1 = box.min().x() + col*cell_width;
+      samples->push_back(Point2(randomReal(x1, x1+cell_width), randomReal(y1, y1+cell_height)));
+    }
+  }
+  return 1; 
+}
+
+/*! Geometry.randomSampleBuffer(n, box, [buffer]) picks n random points within box */
+static int randomSampleBuffer(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2 && n != 3)
+   return luaL_error(L, "Got %d arguments expected 2 or 3 (n, box, [buffer])", n); 
+
+  int count = luaL_checkint(L, 1);
+  Rect2 box = Rect2_pull(L, 2);
+  Points2* samples = sampleBuffer(L, 3);
+  
+  samples->reserve(count);
+  for (int i = 0; i < count; ++i)
+    samples->push_back(Point2(randomReal(box.min().x(), box.max().x()), randomReal(box.min().y(), box.max().y())));
+  return 1; 
+}
+
 // functions that will show up in our Lua environment
 static const luaL_Reg gGeometryFuncs[] = {
   {"inside", inside},  
+  {"stratifiedSampleBuffer", stratifiedSampleBuffer},  
+  {"randomSampleBuffer", randomSampleBuffer},  
   {NULL, NULL}
 };
 
@@ -12,6 +12,7 @@
 #include "Lua/Geometry/LuaTrapezoid2.h"
 #include "Lua/Geometry/LuaPaths2.h"
 #include "Lua/Geometry/LuaEdgeData.h"
+#include "Lua/Geometry/LuaPointBuffer.h"
 #include "Geometry/Graph2.hpp"
 
 #include <iostream>
@@ -89,25 +90,107 @@ static int shortestPaths(lua_State *L)
   return 1;
 }
 
+/*!
+  Like shortestPaths() but the result is shared with every other caller
+  asking for paths to the same goal trapezoid.
+*/
+static int cachedShortestPaths(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2) 
+    return luaL_error(L, "Got %d arguments expected 2 (self, trapezoid)", n); 
+    
+  Graph2* graph = checkGraph2(L);    
+  Trapezoid2* goal = checkTrapezoid2(L, 2);
+  
+  Paths2* paths = graph->cachedShortestPaths(goal);
+  
+  if (paths == 0)
+    lua_pushnil(L);
+  else {
+    paths->retain();  // Paths are owned by cache
+    Paths2_push(L, paths);
+  }
+      
+  return 1;
+}
+
 static int shortestPath(lua_State *L) 
 {
   int n = lua_gettop(L);  // Number of arguments
-  if (n != 3) 
-    return luaL_error(L, "Got %d arguments expected 2 (self, trapezoid, trapezoid)", n); 
+  if (n != 3 && n != 4) 
+    return luaL_error(L, "Got %d arguments expected 3 or 4 (self, trapezoid, trapezoid, [buffer])", n); 
     
   Graph2* graph = checkGraph2(L);    
   Trapezoid2* source = checkTrapezoid2(L, 2); assert(source != 0);
   Trapezoid2* target = checkTrapezoid2(L, 3); assert(target != 0); 
   
-  Polygon2 path;
+  Points2 path;
   if (graph->shortestPath(source, target, path))
-    for_each(path.begin(), path.end(), PushValue<Point2>(L));  
+    pushPoints(L, path, n == 4 ? 4 : 0);
   else
     lua_pushnil(L);
       
   return 1;
 }
 
+static int setPathsCacheCapacity(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2) 
+    return luaL_error(L, "Got %d arguments expected 2 (self, capacity)", n); 
+    
+  Graph2* graph = checkGraph2(L);    
+  int capacity = luaL_checkinteger(L, 2);
+  luaL_argcheck(L, capacity > 0, 2, "cache capacity must be at least 1");
+  graph->setPathsCacheCapacity(capacity);
+        
+  return 0;
+}
+
+static int invalidatePaths(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1) 
+    return luaL_error(L, "Got %d arguments expected 1 (self)", n); 
+    
+  Graph2* graph = checkGraph2(L);    
+  graph->invalidatePaths();
+        
+  return 0;
+}
+
+/*!
+  graph:update(deleted, created) changes graph after map:insert() or
+  map:removeSegments(), which return 'created, deleted'.
+*/
+static int update(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 3)
+    return luaL_error(L, "Got %d arguments expected 3 (self, deleted, created)", n);
+
+  Graph2* graph = checkGraph2(L);
+  luaL_checktype(L, 2, LUA_TTABLE);
+  luaL_checktype(L, 3, LUA_TTABLE);
+
+  vector<int> deleted;
+  for (int i = 1; i <= (int)lua_objlen(L, 2); ++i) {
+    lua_rawgeti(L, 2, i);
+    deleted.push_back(luaL_checkinteger(L, -1));
+    lua_pop(L, 1);
+  }
+  Trapezoids2 created;
+  for (int i = 1; i <= (int)lua_objlen(L, 3); ++i) {
+    lua_rawgeti(L, 3, i);
+    created.push_back(checkTrapezoid2(L, -1));
+    lua_pop(L, 1);
+  }
+  graph->update(deleted, created);
+
+  return 0;
+}
+
 static int printGraph(lua_State *L) 
 {
   int n = lua_gettop(L);  // Number of arguments
@@ -139,7 +222,11 @@ static const luaL_Reg gGraph2Funcs[] = {
   {"new", newGraph2},
   // Calculations
   {"shortestPaths", shortestPaths},
+  {"cachedShortestPaths", cachedShortestPaths},  
   {"shortestPath", shortestPath},  
+  {"setPathsCacheCapacity", setPathsCacheCapacity},  
+  {"invalidatePaths", invalidatePaths},  
+  {"update", update},
   {"printGraph", printGraph},  
   {NULL, NULL}
 };
@@ -9,9 +9,13 @@
 
 #pragma once
 
+#include <vector>
+
 struct lua_State;
 
 class Graph2;
+class EdgePair;
 
 void initLuaGraph2(lua_State *L);
 Graph2  *checkGraph2(lua_State* L, int index = 1);
+void    getEdgeDatas(lua_State* L, int t, std::vector<EdgePair>& d);
@@ -13,6 +13,7 @@
 #include "Engine.h"
 #include "Lua/LuaUtils.h"
 #include "Lua/Geometry/LuaVector2.h"
+#include "Lua/Geometry/LuaPointBuffer.h"
 
 #include <lua.hpp>
 #include <cassert>
@@ -27,16 +28,19 @@ MotionState  *checkMotionState(lua_State* L, int index)
   return v;
 }
 
+/*! 
+  Motion states are pushed as single level userdata, since planning creates
+  many of them. Scripts can still set fields like 'parent' on them.
+*/
 void MotionState_push(lua_State *L, MotionState* mstate)
 {
-  lua_newtable(L);
   lua_getglobal(L, "MotionState");
-  lua_setmetatable(L, -2);
     
   MotionState **s = (MotionState **)lua_newuserdata(L, sizeof(MotionState *));  
   *s = mstate;
   mstate->retain(); 
-  setUserDataMetatable(L, "Lusion.MotionState");  
+  setObjectMetatable(L, "Lusion.MotionState", -2);
+  lua_remove(L, -2);
 }
 
 // Functions exported to Lua
@@ -49,10 +53,6 @@ static int newMotionState(lua_State *L)
     return luaL_error(L, "Got %d arguments expected 5,4 or 1", n); 
   luaL_checktype(L, 1, LUA_TTABLE); 
   
-  // Create a table and set its metatable to first argument of 'new' function
-  // This way we can mimic inheritance  
-  pushClassInstance(L);
-  
   MotionState **s = (MotionState **)lua_newuserdata(L, sizeof(MotionState *));  
   
   if (n == 5) {
@@ -69,8 +69,10 @@ static int newMotionState(lua_State *L)
   }  
   else
     *s = new MotionState; 
-       
-  setUserDataMetatable(L, "Lusion.MotionState");
+  
+  // Environment of userdata is set to first argument of 'new' function
+  // This way we can mimic inheritance  
+  setObjectMetatable(L, "Lusion.MotionState", 1);
 
   return 1; 
 }
@@ -327,11 +329,12 @@ static int integrate(lua_State *L)
   return 0;
 }
 
+// state:integratePath(dt, steps, [buffer])
 static int integratePath(lua_State *L) 
 {
   int n = lua_gettop(L);  // Number of arguments
-  if (n != 3) 
-    return luaL_error(L, "Got %d arguments expected 3", n); 
+  if (n != 3 && n != 4) 
+    return luaL_error(L, "Got %d arguments expected 3 or 4", n); 
   MotionState* mstate = checkMotionState(L);
   Points2 path;
   mstate->integratePath(luaL_checknumber(L,2), luaL_checkint(L,3), path);
@@ -339,7 +342,7 @@ static int integratePath(lua_State *L)
   if (path.empty())
     lua_pushnil(L);
   else
-    for_each(path.begin(), path.end(), PushValue<Point2>(L));
+    pushPoints(L, path, n == 4 ? 4 : 0);
   return 1;
 }
 
@@ -463,8 +466,10 @@ void initLuaMotionState(lua_State *L)
   luaL_newmetatable(L, "Lusion.MotionState");
   luaL_register(L, 0, gDestroyMotionStateFuncs);      
   luaL_register(L, 0, gMotionStateFuncs);      
-  lua_pushvalue(L,-1);
+  lua_pushcfunction(L, objectIndex);
   lua_setfield(L,-2, "__index");  
+  lua_pushcfunction(L, objectNewIndex);
+  lua_setfield(L,-2, "__newindex");  
   
   luaL_register(L, "MotionState", gMotionStateFuncs);  
   lua_pushvalue(L,-1);
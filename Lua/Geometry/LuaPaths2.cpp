@@ -12,6 +12,7 @@
 
 #include "Lua/Geometry/LuaVector2.h"
 #include "Lua/Geometry/LuaSegment2.h"
+#include "Lua/Geometry/LuaPointBuffer.h"
 
 #include <Geometry/Graph2.hpp>
 
@@ -27,7 +28,7 @@
 /*! 
  We don't create paths specifically, so this is the only way to make a path. There is no 
  'new' class method on 'Paths'. Instead Graph:shortestPaths() will call this function to create
- a gc paths object.
+ a gc paths object. 'paths' should be retained by caller, it is released when collected.
 */
 void Paths2_push(lua_State *L, Paths2* paths)
 {
@@ -65,19 +66,41 @@ void pushTable(lua_State* L, Paths2* t)
 static int pathFrom(lua_State *L) 
 {
   int n = lua_gettop(L);  // Number of arguments
-  if (n != 2) 
-    return luaL_error(L, "Got %d arguments expected 2 (self, trapezoid)", n); 
+  if (n != 2 && n != 3) 
+    return luaL_error(L, "Got %d arguments expected 2 or 3 (self, trapezoid, [buffer])", n); 
     
   Paths2* paths = checkPaths2(L); assert(paths != 0);      
   Trapezoid2* trap = checkTrapezoid2(L,2); assert(trap != 0);
   
   Points2 poly;
   paths->pathFrom(trap, poly);
-  for_each(poly.begin(), poly.end(), PushValue<Point2>(L));
+  pushPoints(L, poly, n == 3 ? 3 : 0);
   
   return 1;  
 }
 
+static int nextFrom(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2) 
+    return luaL_error(L, "Got %d arguments expected 2 (self, trapezoid)", n); 
+    
+  Paths2* paths = checkPaths2(L); assert(paths != 0);      
+  Trapezoid2* trap = checkTrapezoid2(L,2); assert(trap != 0);
+  
+  // nil when there is no path, as the root gives false too
+  if (!paths->reachableFrom(trap)) {
+    lua_pushnil(L);
+    return 1;
+  }
+  Point2 waypoint;
+  bool more = paths->nextFrom(trap, waypoint);
+  Vector2_push(L, waypoint);
+  lua_pushboolean(L, more);
+  
+  return 2;  
+}
+
 static int distanceFrom(lua_State *L) 
 {
   int n = lua_gettop(L);  // Number of arguments
@@ -93,6 +116,19 @@ static int distanceFrom(lua_State *L)
   return 1;  
 }
 
+// Request
+static int isStale(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1) 
+    return luaL_error(L, "Got %d arguments expected 1 (self)", n); 
+    
+  Paths2* paths = checkPaths2(L); assert(paths != 0);      
+  lua_pushboolean(L, paths->isStale());
+  
+  return 1;  
+}
+
 static int printGraph(lua_State *L) 
 {
   int n = lua_gettop(L);  // Number of arguments
@@ -124,7 +160,7 @@ static int destroyPaths2(lua_State* L)
 {
   Paths2* paths = 0;
   checkUserData(L, "Lusion.Paths2", paths);
-  delete paths;
+  paths->release();
   return 0;
 }
 
@@ -137,9 +173,13 @@ static const luaL_Reg gDestroyPaths2Funcs[] = {
 static const luaL_Reg gPaths2Funcs[] = {
   // Accessors
   {"pathFrom", pathFrom},  
+  {"nextFrom", nextFrom},  
   {"distanceFrom", distanceFrom},    
   {"printPathFrom", printPathFrom},      
   {"printGraph", printGraph},      
+  
+  // Request
+  {"isStale", isStale},
   {NULL, NULL}
 };
 
@@ -0,0 +1,274 @@
+/*
+ *  LuaPointBuffer.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 18.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "Lua/Geometry/LuaPointBuffer.h"
+#include "Lua/Geometry/LuaVector2.h"
+#include "Lua/Geometry/LuaRect2.h"
+#include "Lua/LuaUtils.h"
+
+#include <lua.hpp>
+#include <new>
+#include <cassert>
+
+using namespace std;
+
+/*!
+  \file LuaPointBuffer.cpp
+  \brief Packed array of points shared between Lua and C++.
+  
+  A PointBuffer is a Points2 stored inline in userdata using placement new.
+  Functions taking polygons or point arrays accept it in place of a table
+  of vectors, and several functions returning points can fill a buffer 
+  given as last argument instead of creating a table. Then large point sets 
+  cross between Lua and C++ without creating a Lua value per point.
+  
+  Indices are 1 based like Lua arrays. buffer:get(i) returns coordinates as
+  two numbers so reading a buffer from Lua does not allocate either.
+*/
+
+// Helper functions
+/*! Returns buffer at \a index or 0 if it is not a point buffer */
+Points2* toPointBuffer(lua_State* L, int index)
+{
+  void *p = lua_touserdata(L, index);
+  if (p != 0 && lua_getmetatable(L, index)) {
+    luaL_getmetatable(L, "Lusion.PointBuffer");
+    bool is_buffer = lua_rawequal(L, -1, -2);
+    lua_pop(L, 2);
+    if (is_buffer)
+      return (Points2*)p;
+  }
+  return 0;
+}
+
+Points2* checkPointBuffer(lua_State* L, int index)
+{
+  return (Points2*)luaL_checkudata(L, index, "Lusion.PointBuffer");
+}
+
+/*! Push new empty buffer and return it so it can be filled */
+Points2* PointBuffer_push(lua_State *L)
+{
+  void* ud = lua_newuserdata(L, sizeof(Points2));
+  Points2* points = new (ud) Points2;
+  luaL_getmetatable(L, "Lusion.PointBuffer");
+  lua_setmetatable(L, -2);
+  return points;
+}
+
+void PointBuffer_push(lua_State *L, const Points2& points)
+{
+  *PointBuffer_push(L) = points;
+}
+
+/*!
+  Push \a points as a table of vectors, or if \a buffer_index refers to a point 
+  buffer, copy points into that buffer and push it. Used by functions which 
+  take an optional buffer as last argument.
+*/
+void pushPoints(lua_State *L, ConstPointIterator2 first, ConstPointIterator2 last, int buffer_index)
+{
+  Points2* buffer = buffer_index != 0 ? toPointBuffer(L, buffer_index) : 0;
+  if (buffer != 0) {
+    buffer->assign(first, last);
+    lua_pushvalue(L, buffer_index);
+  }
+  else {
+    for_each(first, last, PushValue<Point2>(L));
+  }
+}
+
+void pushPoints(lua_State *L, const Points2& points, int buffer_index)
+{
+  pushPoints(L, points.begin(), points.end(), buffer_index);
+}
+
+static int checkPointIndex(lua_State *L, const Points2* points, int arg)
+{
+  int i = luaL_checkinteger(L, arg);
+  luaL_argcheck(L, i >= 1 && i <= int(points->size()), arg, "index out of range");
+  return i-1;
+}
+
+// Functions exported to Lua
+// PointBuffer:new(), PointBuffer:new(n) or PointBuffer:new({vec(1,2), vec(3,4)})
+static int newPointBuffer(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1 && n != 2)
+    return luaL_error(L, "Got %d arguments expected 1 or 2 (class, [size or points])", n); 
+  luaL_checktype(L, 1, LUA_TTABLE); 
+
+  Points2* points = PointBuffer_push(L);
+  if (n == 2 && lua_isnumber(L, 2)) {
+    int size = lua_tointeger(L, 2);
+    luaL_argcheck(L, size >= 0, 2, "size can't be negative");
+    points->resize(size);
+  }
+  else if (n == 2) {
+    luaL_checktype(L, 2, LUA_TTABLE);
+    int size = lua_objlen(L, 2);
+    points->reserve(size);
+    for (int i = 1; i <= size; ++i) {
+      lua_rawgeti(L, 2, i);
+      points->push_back(Vector2_pull(L, lua_gettop(L)));
+      lua_pop(L, 1);
+    }
+  }
+  return 1; 
+}
+
+// Accessors
+static int size(lua_State *L) 
+{
+  lua_pushinteger(L, checkPointBuffer(L, 1)->size());
+  return 1;
+}
+
+// buffer:get(i) returns x, y
+static int getPoint(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2) 
+    return luaL_error(L, "Got %d arguments expected 2 (self, index)", n); 
+    
+  Points2* points = checkPointBuffer(L, 1);
+  const Point2& p = (*points)[checkPointIndex(L, points, 2)];
+  lua_pushnumber(L, p.x());
+  lua_pushnumber(L, p.y());
+  return 2;
+}
+
+// buffer:at(i) returns point as a vector
+static int at(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2) 
+    return luaL_error(L, "Got %d arguments expected 2 (self, index)", n); 
+    
+  Points2* points = checkPointBuffer(L, 1);
+  Vector2_push(L, (*points)[checkPointIndex(L, points, 2)]);
+  return 1;
+}
+
+// buffer:set(i, x, y) or buffer:set(i, v)
+static int setPoint(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 3 && n != 4) 
+    return luaL_error(L, "Got %d arguments expected 3 or 4 (self, index, x, y or vector)", n); 
+    
+  Points2* points = checkPointBuffer(L, 1);
+  Point2& p = (*points)[checkPointIndex(L, points, 2)];
+  if (n == 4)
+    p = Point2(luaL_checknumber(L, 3), luaL_checknumber(L, 4));
+  else
+    p = Vector2_pull(L, 3);
+  return 0;
+}
+
+static int boundingBox(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1) 
+    return luaL_error(L, "Got %d arguments expected 1 (self)", n); 
+    
+  Points2* points = checkPointBuffer(L, 1);
+  if (points->empty()) {
+    lua_pushnil(L);
+    return 1;
+  }
+  
+  Rect2 box(points->front(), points->front());
+  for (Points2::iterator p = points->begin(); p != points->end(); ++p)
+    box = box.surround(*p);
+  Rect2_push(L, box);
+  return 1;
+}
+
+// Operations
+// buffer:append(x, y) or buffer:append(v)
+static int append(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2 && n != 3) 
+    return luaL_error(L, "Got %d arguments expected 2 or 3 (self, x, y or vector)", n); 
+    
+  Points2* points = checkPointBuffer(L, 1);
+  if (n == 3)
+    points->push_back(Point2(luaL_checknumber(L, 2), luaL_checknumber(L, 3)));
+  else
+    points->push_back(Vector2_pull(L, 2));
+  return 0;
+}
+
+static int resize(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2) 
+    return luaL_error(L, "Got %d arguments expected 2 (self, size)", n); 
+    
+  int size = luaL_checkinteger(L, 2);
+  luaL_argcheck(L, size >= 0, 2, "size can't be negative");
+  checkPointBuffer(L, 1)->resize(size);
+  return 0;
+}
+
+static int clear(lua_State *L) 
+{
+  checkPointBuffer(L, 1)->clear();
+  return 0;
+}
+
+// buffer:toTable() returns points as table of vectors
+static int toTable(lua_State *L) 
+{
+  Points2* points = checkPointBuffer(L, 1);
+  for_each(points->begin(), points->end(), PushValue<Point2>(L));
+  return 1;
+}
+
+// __gc
+static int destroyPointBuffer(lua_State* L)
+{
+  Points2* points = checkPointBuffer(L, 1);
+  points->~Points2();
+  return 0;
+}
+
+// functions that will show up in our Lua environment
+static const luaL_Reg gPointBufferFuncs[] = {
+  {"new", newPointBuffer},
+  {"__gc", destroyPointBuffer},
+  {"__len", size},
+  // Accessors
+  {"size", size},
+  {"get", getPoint},
+  {"at", at},
+  {"set", setPoint},
+  {"boundingBox", boundingBox},
+  // Operations
+  {"append", append},
+  {"resize", resize},
+  {"clear", clear},
+  {"toTable", toTable},
+  {NULL, NULL}
+};
+
+// Initialization
+void initLuaPointBuffer(lua_State *L)
+{    
+  luaL_register(L, "PointBuffer", gPointBufferFuncs);  
+  lua_pushvalue(L,-1);
+  lua_setfield(L, -2, "__index");  
+  
+  // PointBuffer table is the metatable of buffer userdata
+  lua_pushvalue(L,-1);
+  lua_setfield(L, LUA_REGISTRYINDEX, "Lusion.PointBuffer");
+}
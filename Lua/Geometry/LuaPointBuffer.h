@@ -0,0 +1,23 @@
+/*
+ *  LuaPointBuffer.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 18.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#pragma once
+
+#include <Geometry/Vector2.hpp>
+
+struct lua_State;
+
+void      initLuaPointBuffer(lua_State *L);
+
+Points2*  toPointBuffer(lua_State* L, int index);
+Points2*  checkPointBuffer(lua_State* L, int index);
+Points2*  PointBuffer_push(lua_State *L);
+void      PointBuffer_push(lua_State *L, const Points2& points);
+void      pushPoints(lua_State *L, ConstPointIterator2 first, ConstPointIterator2 last, int buffer_index = 0);
+void      pushPoints(lua_State *L, const Points2& points, int buffer_index = 0);
@@ -16,25 +16,47 @@
 
 
 #include <iostream>
+#include <new>
+#include <cstring>
 
 #include <lua.hpp>
 
+/*!
+  Like vectors, rectangles are stored inline in userdata with the 'Rect' table
+  as metatable. 'min' and 'max' fields return copies, so changing the 
+  returned vector does not change the rectangle.
+*/
 void Rect2_push(lua_State *L, const Rect2& r)
 {
-  lua_newtable(L);
-  Vector2_push(L, r.min());
-  lua_setfield(L, -2, "min");
-  Vector2_push(L, r.max());
-  lua_setfield(L, -2, "max");  
-
-  lua_getglobal(L, "Rect");
+  void* ud = lua_newuserdata(L, sizeof(Rect2));
+  new (ud) Rect2(r);
+  luaL_getmetatable(L, "Lusion.Rect");
   lua_setmetatable(L, -2);
-  lua_getglobal(L, "Rect");
-  lua_setfield(L, -2, "__index");      
 }
 
+/*! Returns rectangle at \a index or 0 if it is not a rectangle userdata */
+static Rect2* toRect2(lua_State *L, int index)
+{
+  void *p = lua_touserdata(L, index);
+  if (p != 0 && lua_getmetatable(L, index)) {
+    luaL_getmetatable(L, "Lusion.Rect");
+    bool is_rect = lua_rawequal(L, -1, -2);
+    lua_pop(L, 2);
+    if (is_rect)
+      return (Rect2*)p;
+  }
+  return 0;
+}
+
+/*! Accepts rectangle userdata and tables with 'min' and 'max' fields */
 Rect2 Rect2_pull(lua_State *L, int index)
 {
+  Rect2* r = toRect2(L, index);
+  if (r != 0)
+    return *r;
+    
+  if (index < 0)
+    index = lua_gettop(L)+index+1;
   luaL_checktype(L, index, LUA_TTABLE);  
 
   lua_getfield(L, index, "min");
@@ -64,22 +86,50 @@ static int newRect2(lua_State *L)
     return luaL_error(L, "Got %d arguments expected 3 (self, min, max) or 5 (self, left, bottom, right, top)", n);
   luaL_checktype(L, 1, LUA_TTABLE); 
 
-  pushClassInstance(L);
-  
-  if (n == 3) {
-    lua_pushvalue(L, 2);
-    lua_setfield(L, -2, "min");
-    lua_pushvalue(L, 3);  
-    lua_setfield(L, -2, "max");     
-  }
-  else if (n == 5) {
-    Vector2_push(L, Vector2(luaL_checknumber(L,2), luaL_checknumber(L,3)));
-    lua_setfield(L, -2, "min");
-    Vector2_push(L, Vector2(luaL_checknumber(L,4), luaL_checknumber(L,5)));
-    lua_setfield(L, -2, "max");  
+  if (n == 3)
+    Rect2_push(L, Rect2(Vector2_pull(L, 2), Vector2_pull(L, 3)));
+  else 
+    Rect2_push(L, Rect2(Vector2(luaL_checknumber(L,2), luaL_checknumber(L,3)), 
+                        Vector2(luaL_checknumber(L,4), luaL_checknumber(L,5))));
+  return 1; 
+}
+
+// r.min and r.max, otherwise look up method in Rect table
+static int getField(lua_State *L) 
+{
+  Rect2* r = toRect2(L, 1);
+  const char* key = lua_type(L, 2) == LUA_TSTRING ? lua_tostring(L, 2) : 0;
+  if (r != 0 && key != 0) {
+    if (strcmp(key, "min") == 0) {
+      Vector2_push(L, r->min());
+      return 1;
+    }
+    if (strcmp(key, "max") == 0) {
+      Vector2_push(L, r->max());
+      return 1;
+    }
   }
+  lua_getmetatable(L, 1);
+  lua_pushvalue(L, 2);
+  lua_rawget(L, -2);
+  return 1;
+}
 
-  return 1; 
+// r.min = v and r.max = v. Rectangles have no other fields.
+static int setField(lua_State *L) 
+{
+  Rect2* r = toRect2(L, 1);
+  const char* key = lua_type(L, 2) == LUA_TSTRING ? lua_tostring(L, 2) : 0;
+  if (r == 0 || key == 0) 
+    return luaL_error(L, "Rect expected");
+    
+  if (strcmp(key, "min") == 0)
+    r->setMin(Vector2_pull(L, 3));
+  else if (strcmp(key, "max") == 0)
+    r->setMax(Vector2_pull(L, 3));
+  else
+    return luaL_error(L, "Rect has no field '%s'", key);
+  return 0;
 }
 
 // Accessors
@@ -88,7 +138,6 @@ static int x_coord(lua_State *L)
   int n = lua_gettop(L);  // Number of arguments
   if (n != 1)
     return luaL_error(L, "Got %d arguments expected 1 (self)", n);
-  luaL_checktype(L, 1, LUA_TTABLE); 
   Rect2 s = Rect2_pull(L, 1);
   lua_pushnumber(L, s.x());
   return 1; 
@@ -99,7 +148,6 @@ static int y_coord(lua_State *L)
   int n = lua_gettop(L);  // Number of arguments
   if (n != 1)
     return luaL_error(L, "Got %d arguments expected 1 (self)", n);
-  luaL_checktype(L, 1, LUA_TTABLE); 
   Rect2 s = Rect2_pull(L, 1);
   lua_pushnumber(L, s.y());
   return 1; 
@@ -110,7 +158,6 @@ static int width(lua_State *L)
   int n = lua_gettop(L);  // Number of arguments
   if (n != 1)
     return luaL_error(L, "Got %d arguments expected 1 (self)", n);
-  luaL_checktype(L, 1, LUA_TTABLE); 
   Rect2 s = Rect2_pull(L, 1);
   lua_pushnumber(L, s.width());
   return 1; 
@@ -121,7 +168,6 @@ static int height(lua_State *L)
   int n = lua_gettop(L);  // Number of arguments
   if (n != 1)
     return luaL_error(L, "Got %d arguments expected 1 (self)", n);
-  luaL_checktype(L, 1, LUA_TTABLE); 
   Rect2 s = Rect2_pull(L, 1);
   lua_pushnumber(L, s.height());
   return 1; 
@@ -133,7 +179,6 @@ static int xmin(lua_State *L)
   int n = lua_gettop(L);  // Number of arguments
   if (n != 1)
     return luaL_error(L, "Got %d arguments expected 1 (self)", n);
-  luaL_checktype(L, 1, LUA_TTABLE); 
   Rect2 s = Rect2_pull(L, 1);
   lua_pushnumber(L, s.xmin());
   return 1; 
@@ -144,7 +189,6 @@ static int xmax(lua_State *L)
   int n = lua_gettop(L);  // Number of arguments
   if (n != 1)
     return luaL_error(L, "Got %d arguments expected 1 (self)", n);
-  luaL_checktype(L, 1, LUA_TTABLE); 
   Rect2 s = Rect2_pull(L, 1);
   lua_pushnumber(L, s.xmax());
   return 1; 
@@ -155,7 +199,6 @@ static int ymin(lua_State *L)
   int n = lua_gettop(L);  // Number of arguments
   if (n != 1)
     return luaL_error(L, "Got %d arguments expected 1 (self)", n);
-  luaL_checktype(L, 1, LUA_TTABLE); 
   Rect2 s = Rect2_pull(L, 1);
   lua_pushnumber(L, s.ymin());
   return 1; 
@@ -166,7 +209,6 @@ static int ymax(lua_State *L)
   int n = lua_gettop(L);  // Number of arguments
   if (n != 1)
     return luaL_error(L, "Got %d arguments expected 1 (self)", n);
-  luaL_checktype(L, 1, LUA_TTABLE); 
   Rect2 s = Rect2_pull(L, 1);
   lua_pushnumber(L, s.ymax());
   return 1; 
@@ -177,7 +219,6 @@ static int bottomLeft(lua_State *L)
   int n = lua_gettop(L);  // Number of arguments
   if (n != 1)
     return luaL_error(L, "Got %d arguments expected 1 (self)", n);
-  luaL_checktype(L, 1, LUA_TTABLE); 
   Rect2 s = Rect2_pull(L, 1);
   Vector2_push(L, s.bottomLeft());
   return 1; 
@@ -188,7 +229,6 @@ static int topRight(lua_State *L)
   int n = lua_gettop(L);  // Number of arguments
   if (n != 1)
     return luaL_error(L, "Got %d arguments expected 1 (self)", n);
-  luaL_checktype(L, 1, LUA_TTABLE); 
   Rect2 s = Rect2_pull(L, 1);
   Vector2_push(L, s.topRight());
   return 1; 
@@ -199,7 +239,6 @@ static int bottomRight(lua_State *L)
   int n = lua_gettop(L);  // Number of arguments
   if (n != 1)
     return luaL_error(L, "Got %d arguments expected 1 (self)", n);
-  luaL_checktype(L, 1, LUA_TTABLE); 
   Rect2 s = Rect2_pull(L, 1);
   Vector2_push(L, s.bottomRight());
   return 1; 
@@ -210,7 +249,6 @@ static int topLeft(lua_State *L)
   int n = lua_gettop(L);  // Number of arguments
   if (n != 1)
     return luaL_error(L, "Got %d arguments expected 1 (self)", n);
-  luaL_checktype(L, 1, LUA_TTABLE); 
   Rect2 s = Rect2_pull(L, 1);
   Vector2_push(L, s.topLeft());
   return 1; 
@@ -221,7 +259,6 @@ static int halfSize(lua_State *L)
   int n = lua_gettop(L);  // Number of arguments
   if (n != 1)
     return luaL_error(L, "Got %d arguments expected 1 (self)", n);
-  luaL_checktype(L, 1, LUA_TTABLE); 
   Rect2 r = Rect2_pull(L, 1);
   Vector2 hsize = r.halfSize();
   Vector2_push(L, hsize);
@@ -290,6 +327,8 @@ static int inside(lua_State *L)
 // functions that will show up in our Lua environment
 static const luaL_Reg gRectFuncs[] = {
   {"new", newRect2},
+  {"__index", getField},
+  {"__newindex", setField},
   // Accessors
   {"x", x_coord},
   {"y", y_coord},
@@ -326,6 +365,8 @@ static const luaL_Reg gRectFuncs[] = {
 void initLuaRect2(lua_State *L)
 {    
   luaL_register(L, "Rect", gRectFuncs);  
+  
+  // Rect table is the metatable of rectangle userdata
   lua_pushvalue(L,-1);
-  lua_setfield(L, -2, "__index");  
+  lua_setfield(L, LUA_REGISTRYINDEX, "Lusion.Rect");
 }
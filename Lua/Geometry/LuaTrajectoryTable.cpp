@@ -0,0 +1,281 @@
+/*
+ *  LuaTrajectoryTable.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 16.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "Lua/Geometry/LuaTrajectoryTable.h"
+#include "Lua/Geometry/LuaMotionState.h"
+#include "Lua/Base/LuaShape.h"
+#include "Lua/LuaUtils.h"
+
+#include "Base/TrajectoryTable.h"
+#include "Base/MotionState.h"
+#include "Base/View.h"
+#include "Core/Core.h"
+
+#include <lua.hpp>
+#include <cassert>
+
+// Helper functions
+TrajectoryTable *checkTrajectoryTable(lua_State* L, int index)
+{
+  TrajectoryTable* v;
+  pullClassInstance(L, index, "Lusion.TrajectoryTable", v);
+  return v;
+}
+
+// Functions exported to Lua
+// TrajectoryTable:new(s0, angvel_min, angvel_max, angvel_steps, dt, steps)
+static int newTrajectoryTable(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 7)
+    return luaL_error(L, "Got %d arguments expected 7 (class, state, angvel_min, angvel_max, angvel_steps, dt, steps)", n); 
+  luaL_checktype(L, 1, LUA_TTABLE); 
+
+  MotionState* s0 = checkMotionState(L, 2);
+  real angvel_min = luaL_checknumber(L, 3);
+  real angvel_max = luaL_checknumber(L, 4);
+  int  angvel_steps = luaL_checkinteger(L, 5);
+  real dt = luaL_checknumber(L, 6);
+  int  steps = luaL_checkinteger(L, 7);
+  luaL_argcheck(L, angvel_min < angvel_max, 4, "max angular velocity must be larger than min");
+  luaL_argcheck(L, angvel_steps > 0, 5, "number of angular velocity steps must be positive");
+  luaL_argcheck(L, steps > 0, 7, "number of integration steps must be positive");
+  
+  pushClassInstance(L);
+    
+  TrajectoryTable **t = (TrajectoryTable **)lua_newuserdata(L, sizeof(TrajectoryTable *));
+  *t = new TrajectoryTable(*s0, angvel_min, angvel_max, angvel_steps, dt, steps);
+
+  setUserDataMetatable(L, "Lusion.TrajectoryTable");
+
+  return 1; 
+}
+
+// TrajectoryTable:load(path) returns table saved with save() or nil
+static int load(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2)
+    return luaL_error(L, "Got %d arguments expected 2 (class, path)", n); 
+  luaL_checktype(L, 1, LUA_TTABLE); 
+  
+  TrajectoryTable* table = TrajectoryTable::load(luaL_checkstring(L, 2));
+  if (table == 0) {
+    lua_pushnil(L);
+    return 1;
+  }
+  
+  pushClassInstance(L);
+    
+  TrajectoryTable **t = (TrajectoryTable **)lua_newuserdata(L, sizeof(TrajectoryTable *));
+  *t = table;
+
+  setUserDataMetatable(L, "Lusion.TrajectoryTable");
+
+  return 1; 
+}
+
+// Accessors
+static int size(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1) 
+    return luaL_error(L, "Got %d arguments expected 1 (self)", n); 
+    
+  lua_pushinteger(L, checkTrajectoryTable(L)->size());
+  return 1;
+}
+
+static int duration(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1) 
+    return luaL_error(L, "Got %d arguments expected 1 (self)", n); 
+    
+  lua_pushnumber(L, checkTrajectoryTable(L)->duration());
+  return 1;
+}
+
+static int minAngularVelocity(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1) 
+    return luaL_error(L, "Got %d arguments expected 1 (self)", n); 
+    
+  lua_pushnumber(L, checkTrajectoryTable(L)->minAngularVelocity());
+  return 1;
+}
+
+static int maxAngularVelocity(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1) 
+    return luaL_error(L, "Got %d arguments expected 1 (self)", n); 
+    
+  lua_pushnumber(L, checkTrajectoryTable(L)->maxAngularVelocity());
+  return 1;
+}
+
+static int timeStep(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1) 
+    return luaL_error(L, "Got %d arguments expected 1 (self)", n); 
+    
+  lua_pushnumber(L, checkTrajectoryTable(L)->timeStep());
+  return 1;
+}
+
+static int noSteps(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1) 
+    return luaL_error(L, "Got %d arguments expected 1 (self)", n); 
+    
+  lua_pushinteger(L, checkTrajectoryTable(L)->noSteps());
+  return 1;
+}
+
+static int speed(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 1) 
+    return luaL_error(L, "Got %d arguments expected 1 (self)", n); 
+    
+  lua_pushnumber(L, checkTrajectoryTable(L)->speed());
+  return 1;
+}
+
+static int angularVelocity(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2) 
+    return luaL_error(L, "Got %d arguments expected 2 (self, index)", n); 
+    
+  TrajectoryTable* table = checkTrajectoryTable(L);
+  int i = luaL_checkinteger(L, 2);
+  luaL_argcheck(L, i >= 0 && i < table->size(), 2, "index out of range");
+  lua_pushnumber(L, table->angularVelocity(i));
+  return 1;
+}
+
+// Calculations
+// table:endState(s0, angvel_end) returns state reached when following 
+// trajectory from 's0' ending with angular velocity 'angvel_end'
+static int endState(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 3) 
+    return luaL_error(L, "Got %d arguments expected 3 (self, state, angvel_end)", n); 
+    
+  TrajectoryTable* table = checkTrajectoryTable(L);
+  MotionState* from = checkMotionState(L, 2);
+  real angvel_end = luaL_checknumber(L, 3);
+  
+  const Trajectory& t = table->trajectory(table->index(from->angularVelocity()), table->index(angvel_end));
+  MotionState* mstate = new MotionState;
+  table->endState(*from, t, *mstate);
+  MotionState_push(L, mstate);
+  mstate->release();
+  
+  return 1;
+}
+
+// Operations
+// table:save(path) returns true if table was written to 'path'
+static int save(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2) 
+    return luaL_error(L, "Got %d arguments expected 2 (self, path)", n); 
+    
+  TrajectoryTable* table = checkTrajectoryTable(L);
+  lua_pushboolean(L, table->save(luaL_checkstring(L, 2)));
+  return 1;
+}
+
+/*! 
+  table:sweep(s0, view, obstacles) sweeps collision polygon of 'view' along all 
+  trajectories starting from 's0' and returns 'mask, times'. Bit j of 'mask' is set 
+  when trajectory ending with j'th angular velocity collides with 'obstacles'. 
+  times[j+1] is time of first collision along it or false.
+*/
+static int sweep(lua_State *L) 
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 4) 
+    return luaL_error(L, "Got %d arguments expected 4 (self, state, view, obstacles)", n); 
+    
+  TrajectoryTable* table = checkTrajectoryTable(L);
+  MotionState* s0 = checkMotionState(L, 2);
+  View* view = checkView(L, 3);
+  Shape* obstacles = checkShape(L, 4);
+  
+  std::vector<real> times;
+  uint32 mask = table->sweepCollisions(*s0, view->collisionPolygon(), obstacles, times);
+  
+  lua_pushnumber(L, mask);
+  lua_createtable(L, times.size(), 0);
+  for (size_t i = 0; i < times.size(); ++i) {
+    if (times[i] == REAL_MAX)
+      lua_pushboolean(L, false);
+    else
+      lua_pushnumber(L, times[i]);
+    lua_rawseti(L, -2, i+1);
+  }
+  return 2;
+}
+
+// __gc
+static int destroyTrajectoryTable(lua_State* L)
+{
+  TrajectoryTable* table = 0;
+  checkUserData(L, "Lusion.TrajectoryTable", table);
+  table->release();
+  return 0;
+}
+
+// functions that will show up in our Lua environment
+static const luaL_Reg gDestroyTrajectoryTableFuncs[] = {
+  {"__gc", destroyTrajectoryTable},
+  {NULL, NULL}
+};
+
+static const luaL_Reg gTrajectoryTableFuncs[] = {
+  {"new", newTrajectoryTable},
+  {"load", load},
+  // Accessors
+  {"size", size},
+  {"duration", duration},
+  {"minAngularVelocity", minAngularVelocity},
+  {"maxAngularVelocity", maxAngularVelocity},
+  {"timeStep", timeStep},
+  {"noSteps", noSteps},
+  {"speed", speed},
+  {"angularVelocity", angularVelocity},
+  // Calculations
+  {"endState", endState},
+  {"sweep", sweep},
+  // Operations
+  {"save", save},
+  {NULL, NULL}
+};
+
+// Initialization
+void initLuaTrajectoryTable(lua_State *L)
+{    
+  // Metatable to be used for userdata identification
+  luaL_newmetatable(L, "Lusion.TrajectoryTable");
+  luaL_register(L, 0, gDestroyTrajectoryTableFuncs);      
+  luaL_register(L, 0, gTrajectoryTableFuncs);      
+  lua_pushvalue(L,-1);
+  lua_setfield(L,-2, "__index");  
+
+  luaL_register(L, "TrajectoryTable", gTrajectoryTableFuncs);  
+}
@@ -0,0 +1,16 @@
+/*
+ *  LuaTrajectoryTable.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 16.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#pragma once
+
+struct lua_State;
+class TrajectoryTable;
+
+void initLuaTrajectoryTable(lua_State *L);
+TrajectoryTable *checkTrajectoryTable(lua_State* L, int index=1);
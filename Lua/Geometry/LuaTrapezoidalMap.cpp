@@ -16,6 +16,8 @@
 #include "Lua/Geometry/LuaVector2.h"
 #include "Lua/Geometry/LuaRect2.h"
 #include "Lua/Geometry/LuaTrapezoid2.h"
+#include "Lua/Geometry/LuaEdgeData.h"
+#include "Lua/Geometry/LuaGraph2.h"
 
 #include <iostream>
 
@@ -54,6 +56,40 @@ static int newTrapezoidalMap(lua_State *L)
   return 1; 
 }
 
+/*!
+  TrapezoidalMap:load(path) returns map saved with save() and array of
+  its roadmap edges, which Graph:new() takes. Returns nil if map could
+  not be loaded.
+*/
+static int load(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2)
+    return luaL_error(L, "Got %d arguments expected 2 (class, path)", n);
+  luaL_checktype(L, 1, LUA_TTABLE);
+
+  EdgePairs edges;
+  TrapezoidalMap2* tmap = TrapezoidalMap2::load(luaL_checkstring(L, 2), &edges);
+  if (tmap == 0) {
+    lua_pushnil(L);
+    return 1;
+  }
+
+  pushClassInstance(L);
+
+  TrapezoidalMap2 **g = (TrapezoidalMap2 **)lua_newuserdata(L, sizeof(TrapezoidalMap2 *));
+  *g = tmap;
+
+  setUserDataMetatable(L, "Lusion.TrapezoidalMap");
+
+  lua_createtable(L, edges.size(), 0);
+  for (size_t i = 0; i < edges.size(); ++i) {
+    EdgeData_push(L, edges[i]);
+    lua_rawseti(L, -2, i+1);
+  }
+  return 2;
+}
+
 static int locate(lua_State *L) 
 {
   int n = lua_gettop(L);  // Number of arguments
@@ -116,6 +152,77 @@ static int remove(lua_State *L)
   return 0;
 }
 
+/*! Pushes 'created, deleted' of insert() and remove() as arrays of trapezoids and of tags */
+static int pushChange(lua_State *L, const Trapezoids2& created, const vector<int>& deleted)
+{
+  for_each(created.begin(), created.end(), PushValue<Trapezoid2*>(L));
+  lua_createtable(L, deleted.size(), 0);
+  for (size_t i = 0; i < deleted.size(); ++i) {
+    lua_pushinteger(L, deleted[i]);
+    lua_rawseti(L, -2, i+1);
+  }
+  return 2;
+}
+
+/*!
+  map:insert(segments) inserts segments into map. Returns array of new
+  trapezoids and array of tags of trapezoids they replaced, for
+  Graph:update(). Trapezoids replaced must no longer be used.
+*/
+static int insert(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2)
+    return luaL_error(L, "Got %d arguments expected 2 (self, segments)", n);
+
+  TrapezoidalMap2* tmap = checkTrapezoidalMap(L);
+  assert(tmap != 0);
+  Segments2 segs;
+  getSegments(L, 2, segs);
+
+  Trapezoids2 created;
+  vector<int> deleted;
+  for (Segments2::iterator s = segs.begin(); s != segs.end(); ++s)
+    tmap->insert(*s, &created, &deleted);
+  return pushChange(L, created, deleted);
+}
+
+/*! map:removeSegments(segments) removes segments from map. Returns same as insert() */
+static int removeSegments(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2)
+    return luaL_error(L, "Got %d arguments expected 2 (self, segments)", n);
+
+  TrapezoidalMap2* tmap = checkTrapezoidalMap(L);
+  assert(tmap != 0);
+  Segments2 segs;
+  getSegments(L, 2, segs);
+
+  Trapezoids2 created;
+  vector<int> deleted;
+  for (Segments2::iterator s = segs.begin(); s != segs.end(); ++s)
+    tmap->remove(*s, &created, &deleted);
+  return pushChange(L, created, deleted);
+}
+
+// map:save(path, [edges]) writes map and roadmap edges to path. Returns true on success
+static int save(lua_State *L)
+{
+  int n = lua_gettop(L);  // Number of arguments
+  if (n != 2 && n != 3)
+    return luaL_error(L, "Got %d arguments expected 2 or 3 (self, path, [edges])", n);
+
+  TrapezoidalMap2* tmap = checkTrapezoidalMap(L);
+  assert(tmap != 0);
+  EdgePairs edges;
+  if (n == 3)
+    getEdgeDatas(L, 3, edges);
+
+  lua_pushboolean(L, tmap->save(luaL_checkstring(L, 2), edges));
+  return 1;
+}
+
 static int assignUniqueTags(lua_State* L)
 {
   int n = lua_gettop(L);
@@ -147,13 +254,17 @@ static const luaL_Reg gDestroyTrapezoidalMapFuncs[] = {
 
 static const luaL_Reg gTrapezoidalMapFuncs[] = {
   {"new", newTrapezoidalMap},
+  {"load", load},
   // Calculations
   {"locate", locate},
   {"calcBoundingBox", calcBoundingBox},   
   {"trapezoids", trapezoids},       
   // Operations
   {"remove", remove},         
+  {"insert", insert},
+  {"removeSegments", removeSegments},
   {"assignUniqueTags", assignUniqueTags},           
+  {"save", save},
   {NULL, NULL}
 };
 
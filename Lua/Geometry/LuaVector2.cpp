@@ -13,27 +13,49 @@
 #include <Geometry/IO.hpp>
 
 #include <iostream>
+#include <new>
+#include <cstring>
 
 #include <lua.hpp>
 
+/*!
+  Vectors are stored inline in userdata using placement new, with the 
+  'Vector' table as metatable. So creating one is a single allocation
+  and reading 'x' and 'y' needs no table lookup. Vector2 has a trivial 
+  destructor so no __gc is needed.
+*/
 void Vector2_push(lua_State *L, const Vector2& p)
 {
-  lua_newtable(L);            // a point structure
-  lua_pushstring(L, "x");     // value first and then key
-  lua_pushnumber(L, p.x());    
-  lua_settable(L, -3);        // value and key on top of stack so table is on 3rd slot below top
-  lua_pushstring(L, "y");
-  lua_pushnumber(L, p.y());             
-  lua_settable(L, -3);    
-
-  lua_getglobal(L, "Vector");
+  void* ud = lua_newuserdata(L, sizeof(Vector2));
+  new (ud) Vector2(p);
+  luaL_getmetatable(L, "Lusion.Vector");
   lua_setmetatable(L, -2);
-  lua_getglobal(L, "Vector");
-  lua_setfield(L, -2, "__index");      
 }
 
+/*! Returns vector at \a index or 0 if it is not a vector userdata */
+static Vector2* toVector2(lua_State *L, int index)
+{
+  void *p = lua_touserdata(L, index);
+  if (p != 0 && lua_getmetatable(L, index)) {
+    luaL_getmetatable(L, "Lusion.Vector");
+    bool is_vector = lua_rawequal(L, -1, -2);
+    lua_pop(L, 2);
+    if (is_vector)
+      return (Vector2*)p;
+  }
+  return 0;
+}
+
+/*! 
+  Accepts vector userdata and, for compatibility with scripts creating points
+  by hand, tables with 'x' and 'y' fields.
+*/
 Vector2 Vector2_pull(lua_State *L, int index)
 {
+  Vector2* v = toVector2(L, index);
+  if (v != 0)
+    return *v;
+    
   luaL_checktype(L, index, LUA_TTABLE);  // Make sure we got a table (a point is a table with pair of values)
   lua_getfield(L, index, "x"); // Get first value from table and put on top of stack
   real x = luaL_checknumber (L, -1);
@@ -60,13 +82,47 @@ static int newVector2(lua_State *L)
     return luaL_error(L, "Got %d arguments expected 3 (self, x, y)", n);
   luaL_checktype(L, 1, LUA_TTABLE); 
 
-  pushClassInstance(L);
+  Vector2_push(L, Vector2(luaL_checknumber(L, 2), luaL_checknumber(L, 3)));
+  return 1; 
+}
+
+// v.x and v.y, otherwise look up method in Vector table
+static int getField(lua_State *L) 
+{
+  Vector2* v = toVector2(L, 1);
+  size_t len = 0;
+  const char* key = lua_type(L, 2) == LUA_TSTRING ? lua_tolstring(L, 2, &len) : 0;
+  if (v != 0 && key != 0 && len == 1) {
+    if (key[0] == 'x') {
+      lua_pushnumber(L, v->x());
+      return 1;
+    }
+    if (key[0] == 'y') {
+      lua_pushnumber(L, v->y());
+      return 1;
+    }
+  }
+  lua_getmetatable(L, 1);
   lua_pushvalue(L, 2);
-  lua_setfield(L, -2, "x");
-  lua_pushvalue(L, 3);  
-  lua_setfield(L, -2, "y"); 
+  lua_rawget(L, -2);
+  return 1;
+}
 
-  return 1; 
+// v.x = 1 and v.y = 2. Vectors have no other fields.
+static int setField(lua_State *L) 
+{
+  Vector2* v = toVector2(L, 1);
+  const char* key = lua_type(L, 2) == LUA_TSTRING ? lua_tostring(L, 2) : 0;
+  if (v == 0 || key == 0) 
+    return luaL_error(L, "Vector expected");
+    
+  if (strcmp(key, "x") == 0)
+    v->setX(luaL_checknumber(L, 3));
+  else if (strcmp(key, "y") == 0)
+    v->setY(luaL_checknumber(L, 3));
+  else
+    return luaL_error(L, "Vector has no field '%s'", key);
+  return 0;
 }
 
 static int unit(lua_State *L) 
@@ -74,7 +130,6 @@ static int unit(lua_State *L)
   int n = lua_gettop(L);  // Number of arguments
   if (n != 1)
     return luaL_error(L, "Got %d arguments expected 1 (self)", n);
-  luaL_checktype(L, 1, LUA_TTABLE); 
   Vector2 v = Vector2_pull(L, 1);
   Vector2_push(L, v.unit());
   return 1; 
@@ -85,7 +140,6 @@ static int length(lua_State *L)
   int n = lua_gettop(L);  // Number of arguments
   if (n != 1)
     return luaL_error(L, "Got %d arguments expected 1 (self)", n);
-  luaL_checktype(L, 1, LUA_TTABLE); 
   Vector2 v = Vector2_pull(L, 1);
   lua_pushnumber(L, v.length());
   return 1; 
@@ -96,7 +150,6 @@ static int squaredLength(lua_State *L)
   int n = lua_gettop(L);  // Number of arguments
   if (n != 1)
     return luaL_error(L, "Got %d arguments expected 1 (self)", n);
-  luaL_checktype(L, 1, LUA_TTABLE); 
   Vector2 v = Vector2_pull(L, 1);
   lua_pushnumber(L, v.squaredLength());
   return 1; 
@@ -196,8 +249,6 @@ static int unaryMinus(lua_State *L)
     return luaL_error(L,"Got %d arguments expected 1 (self)", n);
     
   Vector2 v = Vector2_pull(L, 1);
-  Vector2 u = Vector2_pull(L, 2);  
-
   Vector2_push(L, -v);
   return 1; 
 }
@@ -205,6 +256,8 @@ static int unaryMinus(lua_State *L)
 // functions that will show up in our Lua environment
 static const luaL_Reg gVectorFuncs[] = {
   {"new", newVector2},
+  {"__index", getField},
+  {"__newindex", setField},
   // Calculations
   {"__add", add},
   {"__sub", sub},  
@@ -226,6 +279,8 @@ static const luaL_Reg gVectorFuncs[] = {
 void initLuaVector2(lua_State *L)
 {    
   luaL_register(L, "Vector", gVectorFuncs);  
+  
+  // Vector table is the metatable of vector userdata
   lua_pushvalue(L,-1);
-  lua_setfield(L, -2, "__index");  
+  lua_setfield(L, LUA_REGISTRYINDEX, "Lusion.Vector");
 }
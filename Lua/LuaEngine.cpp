@@ -10,15 +10,25 @@
 #include "LuaEngine.h"
 
 #include "Engine.h"
+#include "World.h"
 #include "Timing.h"
 #include "Utils/PolygonUtils.h"
 #include "Utils/GLUtils.h"
+#include "Utils/Profiler.h"
+#include "Utils/Counters.h"
 
 #include "Lua/Base/LuaSprite.h"
 #include "Lua/Base/LuaView.h"
 #include "Lua/Base/LuaShape.h"
+#include "Lua/Base/LuaFlowField.h"
+#include "Lua/Base/LuaTrajectoryPlanner.h"
+#include "Lua/Base/LuaContactBuffer.h"
+#include "Lua/Base/LuaPlanningScheduler.h"
+#include "Lua/Base/LuaLevelFile.h"
+#include "Lua/Base/LuaJob.h"
 
 #include "Lua/Geometry/LuaVector2.h"
+#include "Lua/Geometry/LuaPointBuffer.h"
 #include "Lua/Geometry/LuaSegment2.h"
 #include "Lua/Geometry/LuaRay2.h"
 #include "Lua/Geometry/LuaRect2.h"
@@ -31,6 +41,7 @@
 // #include "Lua/Geometry/LuaPaths2.h"
 // #include "Lua/Geometry/LuaGraph2.h"  // NOTE: Depends on CGAL
 #include "Lua/Geometry/LuaMotionState.h"
+#include "Lua/Geometry/LuaTrajectoryTable.h"
 #include "Lua/Geometry/LuaMatrix2.h"
 
 #include "Lua/LuaUtils.h"
@@ -47,18 +58,83 @@
 #include <iterator>
 #include <algorithm>
 #include <vector>
+#include <map>
 
 #include <cstring>
+#include <new>
 #include <cctype>
 
 #include <Geometry/IO.hpp>
 
 using namespace std;
 
-static lua_State *gLuaState;
 static const char* gEngineScript = "script/engine.lua";
 static const char* gStartupScript = "script/startup.lua";
-static const char* gGameScript = "script/game.lua";
+static string gGameScript = "script/game.lua";
+
+/*!
+  Lua functions called from C++ every frame or on every input event are
+  resolved once and kept as registry references. Caches are keyed on the
+  name, so a key built in a temporary buffer finds the same entry as
+  a literal.
+*/
+typedef map<string, int> CallbackRefs;
+
+/*!
+  A compiled key path like "Engine.player.rotation". The function at the start
+  of the path is resolved once. Names of the methods called along the path
+  are kept as interned Lua strings since the objects they are looked up on 
+  may change between calls.
+*/
+struct KeyPath {
+  int         function; // Registry ref to function at start of path e.g. Engine.player
+  vector<int> methods;  // Registry refs to names of getters following function
+  int         getter;   // Registry ref to name of last getter e.g. "rotation"
+  int         setter;   // Registry ref to name of last setter e.g. "setRotation"
+};
+typedef map<string, KeyPath> KeyPaths;
+
+/*!
+  Cached callbacks of one Lua state. Stored as userdata in the registry of
+  the state it belongs to, so each World has its own and they are destroyed
+  together with the state.
+*/
+struct LuaCallbacks {
+  CallbackRefs  getters;
+  CallbackRefs  setters;
+  KeyPaths      keyPaths;
+};
+
+// Registry key of LuaCallbacks
+static char gCallbacksKey;
+
+// Helper functions
+static int destroyCallbacks(lua_State* L)
+{
+  ((LuaCallbacks*)lua_touserdata(L, 1))->~LuaCallbacks();
+  return 0;
+}
+
+static void initCallbacks(lua_State* L)
+{
+  lua_pushlightuserdata(L, &gCallbacksKey);
+  new (lua_newuserdata(L, sizeof(LuaCallbacks))) LuaCallbacks;
+  lua_newtable(L);
+  lua_pushcfunction(L, destroyCallbacks);
+  lua_setfield(L, -2, "__gc");
+  lua_setmetatable(L, -2);
+  lua_rawset(L, LUA_REGISTRYINDEX);
+}
+
+static LuaCallbacks& callbacks(lua_State* L)
+{
+  lua_pushlightuserdata(L, &gCallbacksKey);
+  lua_rawget(L, LUA_REGISTRYINDEX);
+  LuaCallbacks* cbs = (LuaCallbacks*)lua_touserdata(L, -1);
+  lua_pop(L, 1);
+  assert(cbs != 0);
+  return *cbs;
+}
 
 // Functions exported to Lua
 static int renderFrame(lua_State* /*L*/) 
@@ -73,6 +149,44 @@ static int update(lua_State* /*L*/)
   return 0;
 }
 
+static int invalidateCallbacks(lua_State* /*L*/) 
+{
+  luaInvalidateCallbacks();
+  return 0;
+}
+
+/*!
+  Engine.handle(obj) returns the engine object wrapped by Lua object 'obj' as
+  light userdata. It is the handle expected by the C API in LusionAPI.h, which
+  scripts can call through FFI when running on LuaJIT. See script/ffi.lua.
+*/
+static int handle(lua_State* L)
+{
+  static const char* classes[] = {"Lusion.Shape", "Lusion.MotionState", "Lusion.ContactBuffer", 0};
+  
+  int n = lua_gettop(L);
+  if (n != 1)
+    return luaL_error(L, "Got %d arguments expected 1 (object)", n); 
+  if (lua_istable(L, 1))
+    lua_getfield(L, 1, "__self");
+  else
+    lua_pushvalue(L, 1);
+    
+  void** ud = (void**)lua_touserdata(L, -1);
+  if (ud != 0 && lua_getmetatable(L, -1)) {
+    for (const char** name = classes; *name != 0; ++name) {
+      luaL_getmetatable(L, *name);
+      bool is_class = lua_rawequal(L, -1, -2);
+      lua_pop(L, 1);
+      if (is_class) {
+        lua_pushlightuserdata(L, *ud);
+        return 1;
+      }
+    }
+  }
+  return luaL_argerror(L, 1, "shape, motion state or contact buffer expected");
+}
+
 static int ticks(lua_State* L)
 {
   lua_pushnumber(L, getTicks());
@@ -81,7 +195,60 @@ static int ticks(lua_State* L)
 
 static int seconds(lua_State* L)
 {
-  lua_pushnumber(L, secondsPassed());
+  lua_pushnumber(L, World::current()->seconds());
+  return 1;
+}
+
+static int monotonicSeconds(lua_State* L)
+{
+  lua_pushnumber(L, monotonicSeconds());
+  return 1;
+}
+
+// True while recording or playing back a replay. Planning should then
+// limit its searches by a count instead of Engine.monotonicSeconds()
+static int isDeterministic(lua_State* L)
+{
+  lua_pushboolean(L, World::current()->isDeterministic());
+  return 1;
+}
+
+static int simulationTime(lua_State* L)
+{
+  lua_pushnumber(L, World::current()->simulationTime());
+  return 1;
+}
+
+static int interpolation(lua_State* L)
+{
+  lua_pushnumber(L, World::current()->interpolation());
+  return 1;
+}
+
+static int setMaxCatchUpSteps(lua_State* L)
+{
+  int n = lua_gettop(L);
+  if (n != 1)
+    return luaL_error(L, "Got %d arguments expected 1", n);
+  World::current()->setMaxCatchUpSteps(luaL_checkinteger(L,1));
+  return 0;
+}
+
+// Engine.setNarrowPhase("sat" | "gjk")
+static int setNarrowPhase(lua_State* L)
+{
+  static const char* phases[] = {"sat", "gjk", NULL};
+  int n = lua_gettop(L);
+  if (n != 1)
+    return luaL_error(L, "Got %d arguments expected 1", n);
+  int phase = luaL_checkoption(L, 1, 0, phases);
+  World::current()->setNarrowPhase(phase == 1 ? GJK_NARROW_PHASE : SAT_NARROW_PHASE);
+  return 0;
+}
+
+static int narrowPhase(lua_State* L)
+{
+  lua_pushstring(L, World::current()->narrowPhase() == GJK_NARROW_PHASE ? "gjk" : "sat");
   return 1;
 }
 
@@ -106,6 +273,139 @@ static int secondsPerFrame(lua_State* L)
   return 1;
 }
 
+/*!
+  Replaces math.random so scripts draw numbers from World::random(), which
+  is seeded when the world starts and thus repeats in replays. Takes the
+  same arguments as the Lua version.
+*/
+static int mathRandom(lua_State* L)
+{
+  Random& random = World::current()->random();
+  int n = lua_gettop(L);
+  if (n == 0) {
+    lua_pushnumber(L, random.uniform());
+  }
+  else if (n == 1) {
+    int upper = luaL_checkint(L, 1);
+    luaL_argcheck(L, 1 <= upper, 1, "interval is empty");
+    lua_pushinteger(L, random.uniform(1, upper));
+  }
+  else if (n == 2) {
+    int lower = luaL_checkint(L, 1);
+    int upper = luaL_checkint(L, 2);
+    luaL_argcheck(L, lower <= upper, 2, "interval is empty");
+    lua_pushinteger(L, random.uniform(lower, upper));
+  }
+  else {
+    return luaL_error(L, "Got %d arguments expected 0, 1 or 2", n);
+  }
+  return 1;
+}
+
+static int mathRandomSeed(lua_State* L)
+{
+  int n = lua_gettop(L);
+  if (n != 1)
+    return luaL_error(L, "Got %d arguments expected 1", n);
+  World::current()->random().setSeed(static_cast<uint32>(luaL_checkint(L, 1)));
+  return 0;
+}
+
+static int setProfiling(lua_State* L)
+{
+  int n = lua_gettop(L);
+  if (n != 1)
+    return luaL_error(L, "Got %d arguments expected 1", n);
+  setProfilingEnabled(lua_toboolean(L, 1));
+  return 0;
+}
+
+static int isProfiling(lua_State* L)
+{
+  lua_pushboolean(L, isProfilingEnabled());
+  return 1;
+}
+
+/*!
+  Engine.profile() returns an array with a table for each profiled zone
+  with name, depth, calls, min, avg, p99 and max. Times are seconds per
+  frame over the last frames. Children follow their parent zone.
+*/
+static int profile(lua_State* L)
+{
+  ZoneStatsList stats;
+  profileStats(stats);
+  lua_createtable(L, stats.size(), 0);
+  for (uint32 i = 0; i < stats.size(); ++i) {
+    const ZoneStats& s = stats[i];
+    lua_createtable(L, 0, 7);
+    lua_pushstring(L, s.name.c_str());
+    lua_setfield(L, -2, "name");
+    lua_pushinteger(L, s.depth);
+    lua_setfield(L, -2, "depth");
+    lua_pushnumber(L, s.calls);
+    lua_setfield(L, -2, "calls");
+    lua_pushnumber(L, s.min);
+    lua_setfield(L, -2, "min");
+    lua_pushnumber(L, s.avg);
+    lua_setfield(L, -2, "avg");
+    lua_pushnumber(L, s.p99);
+    lua_setfield(L, -2, "p99");
+    lua_pushnumber(L, s.max);
+    lua_setfield(L, -2, "max");
+    lua_rawseti(L, -2, i+1);
+  }
+  return 1;
+}
+
+static int profileReport(lua_State* L)
+{
+  string report = profileReport();
+  lua_pushlstring(L, report.c_str(), report.size());
+  return 1;
+}
+
+static int resetProfile(lua_State* /*L*/)
+{
+  profileReset();
+  return 0;
+}
+
+static int saveProfileTrace(lua_State* L)
+{
+  int n = lua_gettop(L);
+  if (n != 1)
+    return luaL_error(L, "Got %d arguments expected 1 (path)", n);
+  lua_pushboolean(L, saveChromeTrace(luaL_checkstring(L, 1)));
+  return 1;
+}
+
+/*!
+  Engine.counters([total]) returns a table with the count of each hot path
+  counter in the last frame, e.g. counters.broadphase_tests, or since start
+  if total is true. Counts stay zero unless built with COUNTERS.
+*/
+static int counters(lua_State* L)
+{
+  CounterValues values;
+  if (lua_toboolean(L, 1))
+    totalCounters(values);
+  else
+    frameCounters(values);
+  lua_createtable(L, 0, NO_COUNTERS);
+  for (int i = 0; i < NO_COUNTERS; ++i) {
+    lua_pushnumber(L, values[i]);
+    lua_setfield(L, -2, counterName(i));
+  }
+  return 1;
+}
+
+static int resetCounters(lua_State* /*L*/)
+{
+  countersReset();
+  return 0;
+}
+
 static int ticksLeft(lua_State* L)
 {
   int n = lua_gettop(L);
@@ -193,7 +493,7 @@ static int nearestObstacle(lua_State* L)
   Rect2  r = Rect2_pull(L, 2);
   Point2 p = Vector2_pull(L, 3);
   Point2 result;
-  ClosestPointFinder finder(shape, r);
+  ClosestPointFinder finder(shape, r, World::current()->narrowPhase());
   if (finder.nearestObstacle(p, result))
     Vector2_push(L, result);
   else
@@ -216,7 +516,7 @@ static int equidistantVertex(lua_State* L)
   Point2 c1 = Vector2_pull(L, 3);
   Point2 c2 = Vector2_pull(L, 4);  
   Point2 c_v;
-  ClosestPointFinder finder(shape, r);
+  ClosestPointFinder finder(shape, r, World::current()->narrowPhase());
   if (finder.equidistantVertex(c1, c2, c_v))
     Vector2_push(L, c_v);
   else
@@ -234,7 +534,7 @@ static int retractSample(lua_State* L)
   Rect2  r = Rect2_pull(L, 2);
   Point2 c = Vector2_pull(L, 3);
   Point2 c_v;
-  ClosestPointFinder finder(shape, r);
+  ClosestPointFinder finder(shape, r, World::current()->narrowPhase());
   if (finder.retractSample(c, c_v))
     Vector2_push(L, c_v);
   else
@@ -273,6 +573,7 @@ static int performanceTest(lua_State* L)
   if (n != 1)
     return luaL_error(L, "Got %d arguments expected 1", n);    
   n = luaL_checkinteger(L,1);
+#ifndef HEADLESS
   int ticks;
   
   startTimer();
@@ -284,6 +585,7 @@ static int performanceTest(lua_State* L)
   gltPerformanceTest(n);
   ticks = stopTimer();
   cout << "Time to load 16 doubles " << n << " times is " << ticks << " ms" << endl; 
+#endif
   
   return 0;
 }
@@ -407,18 +709,41 @@ static const luaL_Reg gEngineFuncs[] = {
   {"lookAt", lookAt},            
   {"renderFrame", renderFrame},      
   {"update", update},        
+  {"invalidateCallbacks", invalidateCallbacks},        
+  {"handle", handle},        
   {"ticks", ticks},        
   {"seconds", seconds},          
+  {"monotonicSeconds", monotonicSeconds},
+  {"isDeterministic", isDeterministic},
+  {"simulationTime", simulationTime},
+  {"interpolation", interpolation},
+  {"setMaxCatchUpSteps", setMaxCatchUpSteps},
+  {"setNarrowPhase", setNarrowPhase},
+  {"narrowPhase", narrowPhase},
   {"ticksPerFrame", ticksPerFrame},          
   {"setTicksPerFrame", setTicksPerFrame},    
   {"secondsPerFrame", secondsPerFrame},                    
   {"ticksLeft", ticksLeft},          
+  {"setProfiling", setProfiling},
+  {"isProfiling", isProfiling},
+  {"profile", profile},
+  {"profileReport", profileReport},
+  {"resetProfile", resetProfile},
+  {"saveProfileTrace", saveProfileTrace},
+  {"counters", counters},
+  {"resetCounters", resetCounters},
   {"nearestObstacle", nearestObstacle},
   {"equidistantVertex", equidistantVertex},
   {"retractSample", retractSample},          
   {NULL, NULL}
 };
 
+static const luaL_Reg gMathFuncs[] = {
+  {"random", mathRandom},
+  {"randomseed", mathRandomSeed},
+  {NULL, NULL}
+};
+
 static const luaL_Reg gDebugFuncs[] = {
   {"isView", isView},  
   {"isSprite", isSprite},    
@@ -435,106 +760,146 @@ static const luaL_Reg gDebugFuncs[] = {
 // Initialization
 void initLua()
 {
-	gLuaState = lua_open();
-  luaL_openlibs(gLuaState);
+  lua_State *L = lua_open();
+  World::current()->setLuaState(L);
+  luaL_openlibs(L);
+  initCallbacks(L);
   
-  luaL_register(gLuaState, "Engine", gEngineFuncs);
-  luaL_register(gLuaState, "Debug", gDebugFuncs);
-
-  initLuaShape(gLuaState);  
-  initLuaSprite(gLuaState);
-  initLuaView(gLuaState);
+  luaL_register(L, "Engine", gEngineFuncs);
+  luaL_register(L, "Debug", gDebugFuncs);
+  luaL_register(L, "math", gMathFuncs);
+
+  initLuaShape(L);  
+  initLuaSprite(L);
+  initLuaView(L);
+  initLuaFlowField(L);
+  initLuaTrajectoryPlanner(L);
+  initLuaContactBuffer(L);
+  initLuaPlanningScheduler(L);
+  initLuaLevelFile(L);
+  initLuaJob(L);
     
-  initLuaVector2(gLuaState);
-  initLuaSegment2(gLuaState);  
-  initLuaRay2(gLuaState);  
-  initLuaRect2(gLuaState);  
-  initLuaCircle(gLuaState);    
-  //initLuaTrapezoidalMap(gLuaState);
-  initLuaGeometry(gLuaState);
-  //initLuaTrapezoid2(gLuaState);
-  // initLuaEdgeData(gLuaState);  // NOTE: Depends on CGAL
-  // initLuaPaths2(gLuaState);  
-  // initLuaGraph2(gLuaState);    // NOTE: Depends on CGAL
-  initLuaMotionState(gLuaState);  
-  initLuaMatrix2(gLuaState);    
+  initLuaVector2(L);
+  initLuaPointBuffer(L);
+  initLuaSegment2(L);  
+  initLuaRay2(L);  
+  initLuaRect2(L);  
+  initLuaCircle(L);    
+  //initLuaTrapezoidalMap(L);
+  initLuaGeometry(L);
+  //initLuaTrapezoid2(L);
+  // initLuaEdgeData(L);  // NOTE: Depends on CGAL
+  // initLuaPaths2(L);  
+  // initLuaGraph2(L);    // NOTE: Depends on CGAL
+  initLuaMotionState(L);  
+  initLuaTrajectoryTable(L);
+  initLuaMatrix2(L);    
     
-  if (luaL_dofile(gLuaState, gEngineScript)) {
+  if (luaL_dofile(L, gEngineScript)) {
     cerr << "Error when executing engine init script " 
-         << lua_tostring(gLuaState, -1) << endl;
+         << lua_tostring(L, -1) << endl;
   }        
-  else if (luaL_dofile(gLuaState, gStartupScript)) {
+  else if (luaL_dofile(L, gStartupScript)) {
     cerr << "Error when executing startup script " 
-         << lua_tostring(gLuaState, -1) << endl;
+         << lua_tostring(L, -1) << endl;
   }        
+  luaInvalidateCallbacks();
+}
+
+/*! Script run by initGame(). Defaults to script/game.lua */
+void setGameScript(const char* path)
+{
+  gGameScript = path;
 }
 
 void initGame()
 {
-  if (luaL_dofile(gLuaState, gGameScript)) {
+  if (luaL_dofile(luaState(), gGameScript.c_str())) {
     cerr << "Error when executing game init script " 
-         << lua_tostring(gLuaState, -1) << endl;
+         << lua_tostring(luaState(), -1) << endl;
   }          
+  luaInvalidateCallbacks();
 }
 
 
 void closeLua() 
 {
-    lua_close(gLuaState);
+  lua_close(luaState());
+  World::current()->setLuaState(0);
 }
 
 void debugLua()
 {
-  lua_getfield(gLuaState, LUA_GLOBALSINDEX, "debug");
-  lua_getfield(gLuaState, -1, "debug"); // Get functioned named "debug" from table lying at the top of the stack
-  lua_remove(gLuaState, -2);  // Remove element right below top of stack
-  lua_call(gLuaState, 0, 0); 
+  lua_getfield(luaState(), LUA_GLOBALSINDEX, "debug");
+  lua_getfield(luaState(), -1, "debug"); // Get functioned named "debug" from table lying at the top of the stack
+  lua_remove(luaState(), -2);  // Remove element right below top of stack
+  lua_call(luaState(), 0, 0); 
 }
 
-/*! Calls lua render callback with number of milliseconds since SDL was initialized */
-void luaRenderFrame(real start_time)
+static bool pcall(int nargs, int nresults)
 {
-  lua_State *L = luaState(); 
-  lua_getfield(L, LUA_GLOBALSINDEX, "Engine");
-  lua_getfield(L, -1, "renderFrame"); // Get functioned named "onCollision" from table lying at the top of the stack
-  lua_remove(L, -2);  // Remove element right below top of stack (Sprite table)
-  lua_pushnumber(L, start_time);
-  if (lua_pcall(L, 1, 0, 0)) {
-    cerr << "Error when rendering frame: " 
-         << lua_tostring(gLuaState, -1) << endl;
-  }    
+  PROFILE_ZONE("lua callback");
+  COUNT(LUA_CALLBACKS);
+  int error_code = lua_pcall(luaState(), nargs, nresults, 0);
+  if (error_code) {
+    cerr << "Error when calling pcall (set get property): "
+         << lua_tostring(luaState(), -1) << endl;
+  }
+  return error_code == 0;
 }
 
-/*! Calls lua update callback with number of milliseconds since SDL was initialized */
-void luaUpdate(real start_time)
+static string setterName(const string& key)
 {
-  lua_State *L = luaState(); 
-  lua_getglobal(L, "Engine");
-    
-  lua_getfield(L, -1, "update");
-  lua_remove(L, -2);  // Remove element right below top of stack (Sprite table)
-  lua_pushnumber(L, start_time);  
-  if (lua_pcall(L, 1, 0, 0)) {
-    cerr << "Error when calling update: " 
-         << lua_tostring(gLuaState, -1) << endl;
-  }
+  string name = "set" + key;
+  name[3] = (char)toupper(name[3]);
+  return name;
 }
 
-static bool pcall(int nargs, int nresults) 
+/*! Keeps a reference to the interned Lua string \a name */
+static int nameRef(lua_State* L, const string& name)
 {
-  int error_code = lua_pcall(gLuaState, nargs, nresults, 0);
-  if (error_code) {
-    cerr << "Error when calling pcall (set get property): " 
-         << lua_tostring(gLuaState, -1) << endl;
+  lua_pushlstring(L, name.c_str(), name.size());
+  return luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
+static void unrefAll(lua_State* L, CallbackRefs& refs)
+{
+  for (CallbackRefs::iterator it = refs.begin(); it != refs.end(); ++it)
+    luaL_unref(L, LUA_REGISTRYINDEX, it->second);
+  refs.clear();
+}
+
+/*!
+  Pushes function Engine[key], or Engine[setKey] if \a setter is true, on
+  stack. The function is only looked up the first time it is requested.
+  Nothing is cached until the function exists, so callbacks requested before
+  scripts are loaded are picked up once they are defined.
+*/
+static void pushEngineFunction(const char* key, bool setter = false)
+{
+  lua_State *L = luaState();
+  LuaCallbacks& cbs = callbacks(L);
+  CallbackRefs& cache = setter ? cbs.setters : cbs.getters;
+  CallbackRefs::const_iterator it = cache.find(key);
+  if (it != cache.end()) {
+    lua_rawgeti(L, LUA_REGISTRYINDEX, it->second);
+    return;
+  }
+
+  lua_getglobal(L, "Engine");
+  lua_getfield(L, -1, setter ? setterName(key).c_str() : key);
+  lua_remove(L, -2);  // Remove Engine table
+  if (lua_isfunction(L, -1)) {
+    lua_pushvalue(L, -1);
+    cache[key] = luaL_ref(L, LUA_REGISTRYINDEX);
   }
-  return error_code == 0;
 }
 
 static void splitKeyPath(const char* key_path, vector<string> & keys)
 {
   const char* begin = key_path;
   const char* end   = key_path + strlen(key_path);
-  
+
   const char *it = begin;
   const char *it_prev = begin;
 
@@ -543,81 +908,182 @@ static void splitKeyPath(const char* key_path, vector<string> & keys)
     string key(it_prev, it);
     keys.push_back(key);
     it_prev = it+1;
-  }  
+  }
+}
+
+/*!
+  Turns key path into cached references the first time it is seen. A key path
+  must have at least three components: a global table, a function on that
+  table and a property on the object returned by the function. Returns 0, and
+  caches nothing, if that function is not defined yet.
+*/
+static const KeyPath* compileKeyPath(const char* key_path)
+{
+  lua_State *L = luaState();
+  KeyPaths& paths = callbacks(L).keyPaths;
+  KeyPaths::const_iterator it = paths.find(key_path);
+  if (it != paths.end())
+    return &it->second;
+
+  vector<string> keys;
+  splitKeyPath(key_path, keys);
+  assert(keys.size() >= 3);
+
+  lua_getglobal(L, keys[0].c_str());
+  if (!lua_istable(L, -1)) {
+    lua_pop(L, 1);
+    return 0;
+  }
+  lua_getfield(L, -1, keys[1].c_str());
+  lua_remove(L, -2);
+  if (!lua_isfunction(L, -1)) {
+    lua_pop(L, 1);
+    return 0;
+  }
+
+  KeyPath path;
+  path.function = luaL_ref(L, LUA_REGISTRYINDEX);
+  for (size_t i = 2; i+1 < keys.size(); ++i)
+    path.methods.push_back(nameRef(L, keys[i]));
+  path.getter = nameRef(L, keys.back());
+  path.setter = nameRef(L, setterName(keys.back()));
+
+  return &(paths[key_path] = path);
+}
+
+/*!
+  Replaces object at top of stack with its method named by string at
+  registry ref \a name, followed by the object itself as 'self' argument.
+*/
+static void pushMethod(int name)
+{
+  lua_State *L = luaState();
+  lua_rawgeti(L, LUA_REGISTRYINDEX, name);
+  lua_gettable(L, -2);
+  lua_insert(L, -2); // swaps function and 'this' on stack, so function objects is at bottom
 }
 
 /*!
-  Will put value found by 
+  Will put object found by following \a path, excluding its last
+  component, on top of the stack.
 */
-static void fetchValue(vector<string> & keys)
-{
-  lua_State *L = luaState(); 
-  vector<string>::const_iterator it = keys.begin();
-  lua_getglobal(L, it->c_str());
-  ++it;
-  lua_getfield(L, -1, it->c_str());
-  ++it;
+static void fetchValue(const KeyPath& path)
+{
+  lua_State *L = luaState();
+  lua_rawgeti(L, LUA_REGISTRYINDEX, path.function);
   pcall(0, 1);
-  
-  while (it != keys.end()) {
-    lua_getfield(L, -1, it->c_str());
-    lua_insert(L, -2); // swaps function and 'this' on stack, so function objects is at bottom
+
+  for (vector<int>::const_iterator it = path.methods.begin(); it != path.methods.end(); ++it) {
+    pushMethod(*it);
     pcall(1, 1);
-    ++it;
-  }  
+  }
+}
+
+/*!
+  Releases all cached callbacks and key paths. Must be called if any of the
+  functions involved are replaced in Lua after they have been used from C++.
+  Called automatically after the engine and game scripts have been loaded.
+  In Lua code it is available as Engine.invalidateCallbacks().
+*/
+void luaInvalidateCallbacks()
+{
+  lua_State *L = luaState();
+  LuaCallbacks& cbs = callbacks(L);
+  unrefAll(L, cbs.getters);
+  unrefAll(L, cbs.setters);
+  for (KeyPaths::iterator it = cbs.keyPaths.begin(); it != cbs.keyPaths.end(); ++it) {
+    KeyPath& path = it->second;
+    luaL_unref(L, LUA_REGISTRYINDEX, path.function);
+    for (vector<int>::iterator m = path.methods.begin(); m != path.methods.end(); ++m)
+      luaL_unref(L, LUA_REGISTRYINDEX, *m);
+    luaL_unref(L, LUA_REGISTRYINDEX, path.getter);
+    luaL_unref(L, LUA_REGISTRYINDEX, path.setter);
+  }
+  cbs.keyPaths.clear();
+}
+
+/*! Calls lua render callback with number of milliseconds since SDL was initialized */
+void luaRenderFrame(real start_time)
+{
+  PROFILE_ZONE("lua render");
+  COUNT(LUA_CALLBACKS);
+  lua_State *L = luaState();
+  pushEngineFunction("renderFrame");
+  lua_pushnumber(L, start_time);
+  if (lua_pcall(L, 1, 0, 0)) {
+    cerr << "Error when rendering frame: "
+         << lua_tostring(luaState(), -1) << endl;
+  }
+}
+
+/*! Calls lua update callback with number of milliseconds since SDL was initialized */
+void luaUpdate(real start_time)
+{
+  PROFILE_ZONE("lua update");
+  COUNT(LUA_CALLBACKS);
+  lua_State *L = luaState();
+  pushEngineFunction("update");
+  lua_pushnumber(L, start_time);
+  if (lua_pcall(L, 1, 0, 0)) {
+    cerr << "Error when calling update: "
+         << lua_tostring(luaState(), -1) << endl;
+  }
 }
 
 /*!
   Sets a property on a lua object in the global lua state. The name of the property
-  can be given as a property path similar to keypaths in Cocoa. 
+  can be given as a property path similar to keypaths in Cocoa.
   \code
   luaSetNumberProperty("Engine.player.rotation", 180);
   \endcode
   is the same as calling:
-  
+
   Engine.player():setRotation(180)
-  
-  In lua code
+
+  In lua code. The key path is compiled on first use and cached.
 */
 void luaSetNumberProperty(const char* key_path, double value)
 {
-  lua_State *L = luaState(); 
-
-  vector<string> keys;
-  splitKeyPath(key_path, keys);
-  string key = keys.back();
-  keys.pop_back();
-  fetchValue(keys);
+  lua_State *L = luaState();
 
-  key = "set" + key;
-  key[3] = (char)toupper(key[3]);
-  lua_getfield(L, -1, key.c_str());
-  lua_insert(L, -2); // swaps function and 'this' on stack, so function objects is at bottom
-  lua_pushnumber(L, value);  
-  pcall(2, 0);      
+  const KeyPath* path = compileKeyPath(key_path);
+  if (path == 0) {
+    cerr << "Error can't set " << key_path << ", function not defined" << endl;
+    return;
+  }
+  fetchValue(*path);
+  pushMethod(path->setter);
+  lua_pushnumber(L, value);
+  pcall(2, 0);
 }
 
 /*!
   Gets a property on a lua object in the global lua state. The name of the property
   can be given as a property path similar to keypaths in Cocoa.
-  
+
   \code
   luaGetNumberProperty("Engine.player.rotation");
   \endcode
   is the same as calling:
-  
+
   Engine.player():rotation(180)
-  
-  In lua code    
+
+  In lua code
 */
 double luaGetNumberProperty(const char* key_path)
 {
-  lua_State *L = luaState(); 
+  lua_State *L = luaState();
 
-  vector<string> keys;
-  splitKeyPath(key_path, keys);
-  fetchValue(keys);
+  const KeyPath* path = compileKeyPath(key_path);
+  if (path == 0) {
+    cerr << "Error can't get " << key_path << ", function not defined" << endl;
+    return 0.0;
+  }
+  fetchValue(*path);
+  pushMethod(path->getter);
+  pcall(1, 1);
   real number = luaL_checknumber(L, -1);
+  lua_pop(L, 1);
   return number;
 }
 
@@ -625,59 +1091,54 @@ double luaGetNumberProperty(const char* key_path)
   Similar to luaSetNumberProperty but will not work for key paths.
   Instead it it works only on boolean properties found on the Engine
   global table in lua code.
-  
+
   \code
-  luaSetEngineBoolean("Engine.keystate", 12, true);
+  luaSetEngineBoolean("keystate", 12, true);
   \endcode
   is the same as calling:
-  
+
   Engine.setKeystate(12, true)
-  
-  In lua code    
+
+  In lua code
 */
 void luaSetEngineBoolean(const char* key, int int_key, bool value)
 {
-  lua_State *L = luaState(); 
-  lua_getglobal(L, "Engine");
-  string s(key);
-  s[0] = (char)toupper(s[0]);
-  s = "set"+s; 
-  lua_getfield(L, -1, s.c_str());
-  lua_remove(L, -2);  
+  lua_State *L = luaState();
+  pushEngineFunction(key, true);
   lua_pushnumber(L, int_key);
-  lua_pushboolean(L, value);    
-  pcall(2, 0);      
+  lua_pushboolean(L, value);
+  pcall(2, 0);
 }
 
 /*!
   Similar to luaGetNumberProperty but will not work for key paths.
   Instead it it works only on boolean properties found on the Engine
   global table in lua code.
-  
+
   \code
-  luaGetEngineBoolean("Engine.keystate", 12);
+  luaGetEngineBoolean("keystate", 12);
   \endcode
   is the same as calling:
-  
+
   Engine.keystate(12)
-  
+
   In lua code
 */
 bool luaGetEngineBoolean(const char* key, int int_key)
 {
-  lua_State *L = luaState(); 
-  lua_getglobal(L, "Engine");
-  lua_getfield(L, -1, key);
-  lua_remove(L, -2);  
+  lua_State *L = luaState();
+  pushEngineFunction(key);
   lua_pushnumber(L, int_key);
-  pcall(1, 1);      
+  pcall(1, 1);
   bool value = lua_toboolean(L, -1);
+  lua_pop(L, 1);
   return value;
 }
 
 
 // Accessors
+/*! Lua state of current world */
 lua_State* luaState()
 {
-  return gLuaState;
+  return World::current()->luaState();
 }
\ No newline at end of file
@@ -15,6 +15,7 @@ struct lua_State;
 
 void initLua();
 void initGame();
+void setGameScript(const char* path);
 void closeLua();
 void debugLua();
 
@@ -24,6 +25,7 @@ double luaGetNumberProperty(const char* key_path);
 void   luaSetEngineBoolean(const char* key, int int_key, bool value);
 bool   luaGetEngineBoolean(const char* key, int int_key);
 void   luaUpdate(real start_time);
+void   luaInvalidateCallbacks();
 
 // Accessors
 lua_State* luaState();
@@ -17,6 +17,7 @@
 #include "Lua/Geometry/LuaVector2.h"
 #include "Lua/Geometry/LuaSegment2.h"
 #include "Lua/Geometry/LuaRect2.h"
+#include "Lua/Geometry/LuaPointBuffer.h"
 
 #include <cassert>
 
@@ -77,9 +78,17 @@ SegmentView *checkSegmentView(lua_State* L, int index)
   Gets polygon from array of points stored at index t in 
   lua stack. We assume array is a table of the form
   {{x = 1, y = 2}, {x = 3, y = 4}}. Polygon is returned in p. 
+  Array can also be a PointBuffer, which is copied without any Lua calls.
 */
 void getPolygon(lua_State* L, int t, Polygon2& p) 
 {
+  Points2* buffer = toPointBuffer(L, t);
+  if (buffer != 0) {
+    for (Points2::iterator it = buffer->begin(); it != buffer->end(); ++it)
+      p.push_back(*it);
+    return;
+  }
+  
   luaL_checktype(L, t, LUA_TTABLE); // Make sure we get a table with points as first argument
   lua_pushnil(L); // first key (ready traversal of table)
   while (lua_next(L, t) != 0) { 
@@ -91,6 +100,14 @@ void getPolygon(lua_State* L, int t, Polygon2& p)
 
 void getSegments(lua_State* L, int t, Segments2& s) 
 {
+  // Point buffer holds segments as consecutive pairs of points
+  Points2* buffer = toPointBuffer(L, t);
+  if (buffer != 0) {
+    for (size_t i = 0; i+1 < buffer->size(); i += 2)
+      s.push_back(Segment2((*buffer)[i], (*buffer)[i+1]));
+    return;
+  }
+  
   luaL_checktype(L, t, LUA_TTABLE); // Make sure we get a table with points as first argument
   lua_pushnil(L); // first key (ready traversal of table)
   while (lua_next(L, t) != 0) { 
@@ -129,6 +146,72 @@ void pushClassInstance(lua_State* L)
   lua_setfield(L, 1, "__index");  
 }
 
+/*!
+  Single level alternative to pushClassInstance() followed by setUserDataMetatable().
+  Userdata holding object pointer on top of stack is used directly as the Lua object, 
+  instead of being stored in a table at key '__self'. This saves a table per object 
+  and a field lookup per method call.
+  
+  Metatable is set to \a tablename and the environment table of the userdata to
+  class table at \a class_index, normally argument 1 to 'new'. For method lookup 
+  and to let scripts store their own fields in objects, as they can with tables, 
+  metatable \a tablename should have objectIndex() as __index and objectNewIndex() 
+  as __newindex.
+*/
+void setObjectMetatable(lua_State *L, const char* tablename, int class_index)
+{
+  if (class_index < 0)
+    class_index = lua_gettop(L)+class_index+1;
+  luaL_getmetatable(L, tablename);
+  lua_setmetatable(L, -2);
+  lua_pushvalue(L, class_index);
+  lua_setfield(L, class_index, "__index");
+  lua_pushvalue(L, class_index);
+  lua_setfenv(L, -2);
+}
+
+// Key marking environment tables holding fields of one object
+static char gObjectFieldsKey;
+
+/*! __index for objects pushed with setObjectMetatable(). Looks in fields and then class */
+int objectIndex(lua_State *L)
+{
+  lua_getfenv(L, 1);
+  lua_pushvalue(L, 2);
+  lua_gettable(L, -2);
+  return 1;
+}
+
+/*! 
+  __newindex for objects pushed with setObjectMetatable(). First time a field is set, 
+  the object gets its own field table inheriting from the class, so objects 
+  without fields cost no extra table.
+*/
+int objectNewIndex(lua_State *L)
+{
+  lua_getfenv(L, 1);
+  lua_pushlightuserdata(L, &gObjectFieldsKey);
+  lua_rawget(L, -2);
+  bool has_fields = lua_toboolean(L, -1);
+  lua_pop(L, 1);
+  
+  if (!has_fields) {
+    lua_newtable(L);
+    lua_pushvalue(L, -2);     // class table
+    lua_setmetatable(L, -2);
+    lua_pushlightuserdata(L, &gObjectFieldsKey);
+    lua_pushboolean(L, true);
+    lua_rawset(L, -3);
+    lua_pushvalue(L, -1);
+    lua_setfenv(L, 1);
+  }
+  
+  lua_pushvalue(L, 2);
+  lua_pushvalue(L, 3);
+  lua_rawset(L, -3);
+  return 0;
+}
+
 /*!
   Push a table representing a point onto the top of the stack
   This table will have coordinates of the point at keys 'x' and 'y'.
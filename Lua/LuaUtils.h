@@ -29,20 +29,30 @@ template<class T>
 void checkUserData(lua_State* L, const char* classname, T*& data)
 {
   void *ud = luaL_checkudata(L, 1, classname);
-  std::string msg = std::string("`") + std::string(classname) + std::string("' expected");
-  luaL_argcheck(L, ud != 0, 1, msg.c_str());
+  if (ud == 0)
+    luaL_argerror(L, 1, lua_pushfstring(L, "`%s' expected", classname));
   data = *((T**)ud);      
 }
 
+/*!
+  Get C++ object wrapped by Lua object at \a index. Object is either a class 
+  instance table holding userdata at key '__self' or, for objects given their
+  metatable with setObjectMetatable(), the userdata itself.
+*/
 template<class T>
 void pullClassInstance(lua_State* L, int index, const char* classname, T*& data)
 {
   void* ud = 0;
-  luaL_checktype(L, index, LUA_TTABLE); 
-  lua_getfield(L, index, "__self");
+  if (lua_type(L, index) == LUA_TUSERDATA) {
+    lua_pushvalue(L, index);
+  }
+  else {
+    luaL_checktype(L, index, LUA_TTABLE); 
+    lua_getfield(L, index, "__self");
+  }
   ud = popUserData(L, index, classname);
-  std::string msg = std::string("`") + std::string(classname) + std::string("' expected");
-  luaL_argcheck(L, ud != 0, index, msg.c_str());  
+  if (ud == 0)
+    luaL_argerror(L, index, lua_pushfstring(L, "`%s' expected", classname));
   
   data = *((T**)ud);      
 }
@@ -112,6 +122,9 @@ void  getPolygon(lua_State* L, int t, Polygon2& p);
 void  getSegments(lua_State* L, int t, Segments2& s);
 void  getStrings(lua_State* L, int t, StringList& s);
 void  pushClassInstance(lua_State* L);
+void  setObjectMetatable(lua_State* L, const char* tablename, int class_index);
+int   objectIndex(lua_State* L);
+int   objectNewIndex(lua_State* L);
 void  pushTable(lua_State* L, const Point2& p);
 void  pushTable(lua_State* L, real num);
 void  pushTable(lua_State* L, const Segment2& p);
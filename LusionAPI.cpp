@@ -0,0 +1,353 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "LusionAPI.h"
+
+#include "Base/Shape.h"
+#include "Base/Sprite.h"
+#include "Base/Group.h"
+#include "Base/MotionState.h"
+#include "Base/ContactBuffer.h"
+
+#include <Geometry/Polygon2.hpp>
+#include <Geometry/Segment2.hpp>
+
+#include <cassert>
+
+using namespace std;
+
+// Conversions between handles and engine objects
+static inline Shape* toShape(LusionShape* s)                { return reinterpret_cast<Shape*>(s); }
+static inline Sprite* toSprite(LusionSprite* s)             { return reinterpret_cast<Sprite*>(s); }
+static inline Group* toGroup(LusionGroup* g)                { return reinterpret_cast<Group*>(g); }
+static inline MotionState* toState(LusionMotionState* s)    { return reinterpret_cast<MotionState*>(s); }
+static inline ContactBuffer* toContacts(LusionContactBuffer* c) { return reinterpret_cast<ContactBuffer*>(c); }
+static inline LusionShape* fromShape(Shape* s)              { return reinterpret_cast<LusionShape*>(s); }
+
+// Vector2 is laid out as two reals, just like LusionVector2
+static inline const Point2* toPoints(const LusionVector2* v) { return reinterpret_cast<const Point2*>(v); }
+
+static inline LusionVector2 fromVector(const Vector2& v)
+{
+  LusionVector2 r = { v.x(), v.y() };
+  return r;
+}
+
+static inline Vector2 toVector(const LusionVector2& v)
+{
+  return Vector2(v.x, v.y);
+}
+
+static inline Rect2 toRect(const LusionRect2& r)
+{
+  return Rect2(toVector(r.min), toVector(r.max));
+}
+
+// Shapes
+void lusionShapeRetain(LusionShape* shape)
+{
+  toShape(shape)->retain();
+}
+
+void lusionShapeRelease(LusionShape* shape)
+{
+  toShape(shape)->release();
+}
+
+LusionRect2 lusionShapeBoundingBox(LusionShape* shape)
+{
+  Rect2 box = toShape(shape)->boundingBox();
+  LusionRect2 r = { fromVector(box.min()), fromVector(box.max()) };
+  return r;
+}
+
+int lusionShapeNoShapes(LusionShape* shape)
+{
+  return toShape(shape)->noShapes();
+}
+
+int lusionShapeInside(LusionShape* shape, LusionVector2 p, double t, double dt)
+{
+  return toShape(shape)->inside(toVector(p), t, dt);
+}
+
+/*! Collide \a shape with \a other, recording contacts in \a contacts if it is not null */
+int lusionShapeCollide(LusionShape* shape, LusionShape* other, double t, double dt, LusionContactBuffer* contacts)
+{
+  return toShape(shape)->collide(toShape(other), t, dt, toContacts(contacts));
+}
+
+void lusionShapeUpdate(LusionShape* shape, double t, double dt)
+{
+  toShape(shape)->update(t, dt);
+}
+
+// Sprites
+LusionShape* lusionSpriteShape(LusionSprite* sprite)
+{
+  return fromShape(static_cast<Shape*>(toSprite(sprite)));
+}
+
+LusionVector2 lusionSpritePosition(LusionSprite* sprite)
+{
+  return fromVector(toSprite(sprite)->position());
+}
+
+void lusionSpriteSetPosition(LusionSprite* sprite, LusionVector2 pos)
+{
+  toSprite(sprite)->setPosition(toVector(pos));
+}
+
+LusionVector2 lusionSpritePrevPosition(LusionSprite* sprite)
+{
+  return fromVector(toSprite(sprite)->prevPosition());
+}
+
+LusionVector2 lusionSpriteVelocity(LusionSprite* sprite)
+{
+  return fromVector(toSprite(sprite)->velocity());
+}
+
+void lusionSpriteSetVelocity(LusionSprite* sprite, LusionVector2 v)
+{
+  toSprite(sprite)->setVelocity(toVector(v));
+}
+
+double lusionSpriteSpeed(LusionSprite* sprite)
+{
+  return toSprite(sprite)->speed();
+}
+
+void lusionSpriteSetSpeed(LusionSprite* sprite, double speed)
+{
+  toSprite(sprite)->setSpeed(speed);
+}
+
+LusionVector2 lusionSpriteDirection(LusionSprite* sprite)
+{
+  return fromVector(toSprite(sprite)->direction());
+}
+
+double lusionSpriteRotation(LusionSprite* sprite)
+{
+  return toSprite(sprite)->rotation();
+}
+
+void lusionSpriteSetRotation(LusionSprite* sprite, double deg)
+{
+  toSprite(sprite)->setRotation(deg);
+}
+
+double lusionSpriteAngularVelocity(LusionSprite* sprite)
+{
+  return toSprite(sprite)->angularVelocity();
+}
+
+void lusionSpriteSetAngularVelocity(LusionSprite* sprite, double deg)
+{
+  toSprite(sprite)->setAngularVelocity(deg);
+}
+
+/*! Motion state of sprite. Not retained, valid as long as sprite keeps it */
+LusionMotionState* lusionSpriteMotionState(LusionSprite* sprite)
+{
+  return reinterpret_cast<LusionMotionState*>(toSprite(sprite)->motionState());
+}
+
+void lusionSpriteAccelerate(LusionSprite* sprite, double acceleration)
+{
+  toSprite(sprite)->accelerate(acceleration);
+}
+
+void lusionSpriteRotate(LusionSprite* sprite, double deg)
+{
+  toSprite(sprite)->rotate(deg);
+}
+
+void lusionSpriteMove(LusionSprite* sprite, LusionVector2 movement)
+{
+  toSprite(sprite)->move(toVector(movement));
+}
+
+void lusionSpriteStop(LusionSprite* sprite)
+{
+  toSprite(sprite)->stop();
+}
+
+// Groups
+LusionShape* lusionGroupShape(LusionGroup* group)
+{
+  return fromShape(static_cast<Shape*>(toGroup(group)));
+}
+
+int lusionGroupContains(LusionGroup* group, LusionShape* shape)
+{
+  return toGroup(group)->contains(toShape(shape));
+}
+
+void lusionGroupAdd(LusionGroup* group, LusionShape* shape)
+{
+  toGroup(group)->addKid(toShape(shape));
+}
+
+void lusionGroupRemove(LusionGroup* group, LusionShape* shape)
+{
+  toGroup(group)->removeKid(toShape(shape));
+}
+
+// Motion states
+/*! Creates motion state owned by caller. Free with lusionMotionStateRelease() */
+LusionMotionState* lusionMotionStateNew(LusionVector2 pos, double dir, double speed)
+{
+  return reinterpret_cast<LusionMotionState*>(new MotionState(toVector(pos), dir, speed));
+}
+
+void lusionMotionStateRelease(LusionMotionState* state)
+{
+  toState(state)->release();
+}
+
+LusionVector2 lusionMotionStatePosition(LusionMotionState* state)
+{
+  return fromVector(toState(state)->position());
+}
+
+void lusionMotionStateSetPosition(LusionMotionState* state, LusionVector2 pos)
+{
+  toState(state)->setPosition(toVector(pos));
+}
+
+LusionVector2 lusionMotionStateVelocity(LusionMotionState* state)
+{
+  return fromVector(toState(state)->velocity());
+}
+
+double lusionMotionStateSpeed(LusionMotionState* state)
+{
+  return toState(state)->speed();
+}
+
+void lusionMotionStateSetSpeed(LusionMotionState* state, double speed)
+{
+  toState(state)->setSpeed(speed);
+}
+
+double lusionMotionStateRotation(LusionMotionState* state)
+{
+  return toState(state)->rotation();
+}
+
+void lusionMotionStateSetRotation(LusionMotionState* state, double deg)
+{
+  toState(state)->setRotation(deg);
+}
+
+double lusionMotionStateAngularVelocity(LusionMotionState* state)
+{
+  return toState(state)->angularVelocity();
+}
+
+void lusionMotionStateSetAngularVelocity(LusionMotionState* state, double deg)
+{
+  toState(state)->setAngularVelocity(deg);
+}
+
+void lusionMotionStateAdvance(LusionMotionState* state, double dt)
+{
+  toState(state)->advance(dt);
+}
+
+/*!
+  Writes at most \a max_points points of path integrated from \a state into
+  \a path. Returns number of points in path, which may be larger than
+  \a max_points.
+*/
+int lusionMotionStateIntegratePath(LusionMotionState* state, double dt, int steps, LusionVector2* path, int max_points)
+{
+  Points2 points;
+  toState(state)->integratePath(dt, steps, points);
+  int n = points.size();
+  for (int i = 0; i < n && i < max_points; ++i)
+    path[i] = fromVector(points[i]);
+  return n;
+}
+
+// Contact buffers
+unsigned int lusionContactBufferSize(LusionContactBuffer* contacts)
+{
+  return toContacts(contacts)->size();
+}
+
+/*! Contact \a i, 0 based. Points are found in lusionContactBufferPoints() */
+LusionContact lusionContactBufferGet(LusionContactBuffer* contacts, unsigned int i)
+{
+  const Contact& c = toContacts(contacts)->contact(i);
+  LusionContact r = { fromShape(c.me), fromShape(c.other), c.firstPoint, c.noPoints, c.time, c.deltaTime };
+  return r;
+}
+
+const LusionVector2* lusionContactBufferPoints(LusionContactBuffer* contacts)
+{
+  const Points2& points = toContacts(contacts)->points();
+  return points.empty() ? 0 : reinterpret_cast<const LusionVector2*>(&points[0]);
+}
+
+void lusionContactBufferClear(LusionContactBuffer* contacts)
+{
+  toContacts(contacts)->clear();
+}
+
+// Point buffers
+/*! \a points is a PointBuffer passed from Lua, which FFI passes as pointer to its Points2 */
+unsigned int lusionPointsSize(const LusionPoints* points)
+{
+  return reinterpret_cast<const Points2*>(points)->size();
+}
+
+LusionVector2* lusionPointsData(LusionPoints* points)
+{
+  Points2* p = reinterpret_cast<Points2*>(points);
+  return p->empty() ? 0 : reinterpret_cast<LusionVector2*>(&(*p)[0]);
+}
+
+// Geometry queries
+int lusionPolygonInside(const LusionVector2* poly, int n, LusionVector2 q)
+{
+  return Polygon2(toPoints(poly), toPoints(poly)+n).inside(toVector(q));
+}
+
+int lusionPolygonIntersectRect(const LusionVector2* poly, int n, LusionRect2 r)
+{
+  return Polygon2(toPoints(poly), toPoints(poly)+n).intersect(toRect(r));
+}
+
+int lusionPolygonIntersectPolygon(const LusionVector2* poly1, int n1, const LusionVector2* poly2, int n2)
+{
+  return Polygon2(toPoints(poly1), toPoints(poly1)+n1).intersect(Polygon2(toPoints(poly2), toPoints(poly2)+n2));
+}
+
+/*! Intersection of segments a1-a2 and b1-b2. Point is written to \a result if it is not null */
+int lusionSegmentIntersection(LusionVector2 a1, LusionVector2 a2, LusionVector2 b1, LusionVector2 b2, LusionVector2* result)
+{
+  Vector2 p;
+  bool hit = Segment2(toVector(a1), toVector(a2)).intersection(Segment2(toVector(b1), toVector(b2)), p);
+  if (hit && result != 0)
+    *result = fromVector(p);
+  return hit;
+}
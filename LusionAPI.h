@@ -0,0 +1,118 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+/*
+  Flat C interface to the engine core. Objects are passed as opaque handles,
+  which are the C++ objects themselves, and values as plain structs. The
+  handle of a Lua object is obtained with Engine.handle(obj).
+
+  Everything between the FFI markers below must be plain C declarations
+  without preprocessor directives, since script/ffi.lua reads it from this
+  file and hands it to LuaJIT's ffi.cdef().
+*/
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// FFI BEGIN
+typedef struct { double x, y; } LusionVector2;
+typedef struct { LusionVector2 min, max; } LusionRect2;
+
+typedef struct LusionShape LusionShape;
+typedef struct LusionSprite LusionSprite;
+typedef struct LusionGroup LusionGroup;
+typedef struct LusionMotionState LusionMotionState;
+typedef struct LusionContactBuffer LusionContactBuffer;
+typedef struct LusionPoints LusionPoints;
+
+typedef struct {
+  LusionShape*  me;
+  LusionShape*  other;
+  unsigned int  firstPoint;
+  unsigned int  noPoints;
+  double        time;
+  double        deltaTime;
+} LusionContact;
+
+void          lusionShapeRetain(LusionShape* shape);
+void          lusionShapeRelease(LusionShape* shape);
+LusionRect2   lusionShapeBoundingBox(LusionShape* shape);
+int           lusionShapeNoShapes(LusionShape* shape);
+int           lusionShapeInside(LusionShape* shape, LusionVector2 p, double t, double dt);
+int           lusionShapeCollide(LusionShape* shape, LusionShape* other, double t, double dt, LusionContactBuffer* contacts);
+void          lusionShapeUpdate(LusionShape* shape, double t, double dt);
+
+LusionShape*  lusionSpriteShape(LusionSprite* sprite);
+LusionVector2 lusionSpritePosition(LusionSprite* sprite);
+void          lusionSpriteSetPosition(LusionSprite* sprite, LusionVector2 pos);
+LusionVector2 lusionSpritePrevPosition(LusionSprite* sprite);
+LusionVector2 lusionSpriteVelocity(LusionSprite* sprite);
+void          lusionSpriteSetVelocity(LusionSprite* sprite, LusionVector2 v);
+double        lusionSpriteSpeed(LusionSprite* sprite);
+void          lusionSpriteSetSpeed(LusionSprite* sprite, double speed);
+LusionVector2 lusionSpriteDirection(LusionSprite* sprite);
+double        lusionSpriteRotation(LusionSprite* sprite);
+void          lusionSpriteSetRotation(LusionSprite* sprite, double deg);
+double        lusionSpriteAngularVelocity(LusionSprite* sprite);
+void          lusionSpriteSetAngularVelocity(LusionSprite* sprite, double deg);
+LusionMotionState* lusionSpriteMotionState(LusionSprite* sprite);
+void          lusionSpriteAccelerate(LusionSprite* sprite, double acceleration);
+void          lusionSpriteRotate(LusionSprite* sprite, double deg);
+void          lusionSpriteMove(LusionSprite* sprite, LusionVector2 movement);
+void          lusionSpriteStop(LusionSprite* sprite);
+
+LusionShape*  lusionGroupShape(LusionGroup* group);
+int           lusionGroupContains(LusionGroup* group, LusionShape* shape);
+void          lusionGroupAdd(LusionGroup* group, LusionShape* shape);
+void          lusionGroupRemove(LusionGroup* group, LusionShape* shape);
+
+LusionMotionState* lusionMotionStateNew(LusionVector2 pos, double dir, double speed);
+void          lusionMotionStateRelease(LusionMotionState* state);
+LusionVector2 lusionMotionStatePosition(LusionMotionState* state);
+void          lusionMotionStateSetPosition(LusionMotionState* state, LusionVector2 pos);
+LusionVector2 lusionMotionStateVelocity(LusionMotionState* state);
+double        lusionMotionStateSpeed(LusionMotionState* state);
+void          lusionMotionStateSetSpeed(LusionMotionState* state, double speed);
+double        lusionMotionStateRotation(LusionMotionState* state);
+void          lusionMotionStateSetRotation(LusionMotionState* state, double deg);
+double        lusionMotionStateAngularVelocity(LusionMotionState* state);
+void          lusionMotionStateSetAngularVelocity(LusionMotionState* state, double deg);
+void          lusionMotionStateAdvance(LusionMotionState* state, double dt);
+int           lusionMotionStateIntegratePath(LusionMotionState* state, double dt, int steps, LusionVector2* path, int max_points);
+
+unsigned int  lusionContactBufferSize(LusionContactBuffer* contacts);
+LusionContact lusionContactBufferGet(LusionContactBuffer* contacts, unsigned int i);
+const LusionVector2* lusionContactBufferPoints(LusionContactBuffer* contacts);
+void          lusionContactBufferClear(LusionContactBuffer* contacts);
+
+unsigned int  lusionPointsSize(const LusionPoints* points);
+LusionVector2* lusionPointsData(LusionPoints* points);
+
+int           lusionPolygonInside(const LusionVector2* poly, int n, LusionVector2 q);
+int           lusionPolygonIntersectRect(const LusionVector2* poly, int n, LusionRect2 r);
+int           lusionPolygonIntersectPolygon(const LusionVector2* poly1, int n1, const LusionVector2* poly2, int n2);
+int           lusionSegmentIntersection(LusionVector2 a1, LusionVector2 a2, LusionVector2 b1, LusionVector2 b2, LusionVector2* result);
+// FFI END
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,32 @@
+# #####################################################################
+# Microbenchmarks of engine primitives, see lusionbench.cpp for usage.
+# Build with 'qmake LusionBench.pro'
+# #####################################################################
+TEMPLATE = app
+TARGET = lusionbench
+CONFIG += console
+CONFIG -= qt app_bundle
+DEFINES += HEADLESS
+OBJECTS_DIR = ./build/headless/objects
+
+include(LusionCore.pri)
+
+# Roadmap scenes use the trapezoidal map and Graph2, which needs the Boost
+# Graph Library headers
+HEADERS += Geometry/Trapezoid2.hpp \
+    Geometry/TrapezoidNode2.hpp \
+    Geometry/TrapezoidalMap2.hpp \
+    Geometry/Graph2.hpp \
+    Geometry/PathsCache2.hpp
+SOURCES += Geometry/Trapezoid2.cpp \
+    Geometry/TrapezoidNode2.cpp \
+    Geometry/TrapezoidalMap2.cpp \
+    Geometry/Graph2.cpp \
+    Geometry/PathsCache2.cpp
+
+# Input
+HEADERS += Benchmark/Benchmark.h
+SOURCES += lusionbench.cpp \
+    Benchmark/Benchmark.cpp \
+    Benchmark/GeometryBenchmarks.cpp \
+    Benchmark/SceneBenchmarks.cpp
@@ -0,0 +1,195 @@
+# #####################################################################
+# Engine core shared by the GUI application and the headless targets.
+# Headless targets define HEADLESS, which leaves out all OpenGL and Qt code
+# #####################################################################
+# QMAKE_LFLAGS += -L/Library/Frameworks
+LIBS += -L./ \
+    -llua
+
+# Build against LuaJIT instead with 'qmake CONFIG+=luajit'. Scripts can then
+# call the C API in LusionAPI.h through FFI, see script/ffi.lua
+luajit {
+    LIBS -= -llua
+    CONFIG += link_pkgconfig
+    PKGCONFIG += luajit
+    unix:!macx:QMAKE_LFLAGS += -rdynamic
+}
+
+# Count collision tests and allocations per frame with 'qmake CONFIG+=counters',
+# see Utils/Counters.h. Off by default since the counting is on hot paths
+counters:DEFINES += COUNTERS
+
+# SharedObject::release() checks this != 0 so null objects can be released.
+# Newer GCC removes that check unless told not to
+*-g++*:QMAKE_CXXFLAGS += -fno-delete-null-pointer-checks
+
+# Headless targets build without warnings at -Wextra. Sources use Xcode's
+# '#pragma mark', which GCC does not know
+contains(DEFINES, HEADLESS):*-g++*:QMAKE_CXXFLAGS_WARN_ON += -Wextra -Wno-unknown-pragmas
+DEPENDPATH += . \
+    Base \
+    Core \
+    Geometry \
+    Lua \
+    Utils \
+    Lua/Base \
+    Lua/Geometry
+INCLUDEPATH += . \
+    Geometry \
+    Core \
+    Base \
+    Utils \
+    Lua/Base \
+    Lua \
+    Lua/Geometry
+
+# Input
+HEADERS += Engine.h \
+    LusionAPI.h \
+    Timing.h \
+    Types.h \
+    World.h \
+    Replay.h \
+    Base/Action.h \
+    Base/ContactBuffer.h \
+    Base/CircleShape.h \
+    Base/Group.h \
+    Base/MotionState.h \
+    Base/PlanningScheduler.h \
+    Base/LevelFile.h \
+    Base/Job.h \
+    Base/LoadJobs.h \
+    Base/TrajectoryTable.h \
+    Base/TrajectoryPlanner.h \
+    Base/PointsView.h \
+    Base/PolygonView.h \
+    Base/RectShape2.h \
+    Base/SegmentShape2.h \
+    Base/SegmentView.h \
+    Base/Shape.h \
+    Base/ShapeGroup.h \
+    Base/ShapeIterator.h \
+    Base/ShapeListener.h \
+    Base/Sprite.h \
+    Base/View.h \
+    Core/AutoreleasePool.hpp \
+    Core/Core.h \
+    Core/SharedObject.hpp \
+    Geometry/Circle.hpp \
+    Geometry/Gjk2.hpp \
+    Geometry/IO.hpp \
+    Geometry/Line2.hpp \
+    Geometry/Matrix2.hpp \
+    Geometry/Polygon2.hpp \
+    Geometry/QuadNode.h \
+    Geometry/Ray2.hpp \
+    Geometry/Rect2.hpp \
+    Geometry/Segment2.hpp \
+    Geometry/Vector2.hpp \
+    Lua/LuaEngine.h \
+    Lua/LuaUtils.h \
+    Utils/Algorithms.h \
+    Utils/Exception.h \
+    Utils/GLUtils.h \
+    Utils/Iterator.h \
+    Utils/PolygonUtils.h \
+    Utils/RoadMap.h \
+    Utils/FlowField.h \
+    Utils/Parallel.h \
+    Utils/MappedFile.h \
+    Utils/Random.h \
+    Utils/Profiler.h \
+    Utils/Counters.h \
+    Lua/Base/LuaShape.h \
+    Lua/Base/LuaFlowField.h \
+    Lua/Base/LuaTrajectoryPlanner.h \
+    Lua/Base/LuaContactBuffer.h \
+    Lua/Base/LuaPlanningScheduler.h \
+    Lua/Base/LuaLevelFile.h \
+    Lua/Base/LuaJob.h \
+    Lua/Base/LuaSprite.h \
+    Lua/Base/LuaView.h \
+    Lua/Geometry/LuaCGALGeometry.h \
+    Lua/Geometry/LuaCircle.h \
+    Lua/Geometry/LuaGeometry.h \
+    Lua/Geometry/LuaMatrix2.h \
+    Lua/Geometry/LuaMotionState.h \
+    Lua/Geometry/LuaTrajectoryTable.h \
+    Lua/Geometry/LuaRay2.h \
+    Lua/Geometry/LuaPointBuffer.h \
+    Lua/Geometry/LuaRect2.h \
+    Lua/Geometry/LuaSegment2.h \
+    Lua/Geometry/LuaVector2.h
+SOURCES += Engine.cpp \
+    LusionAPI.cpp \
+    Timing.cpp \
+    World.cpp \
+    Replay.cpp \
+    Base/Action.cpp \
+    Base/ContactBuffer.cpp \
+    Base/CircleShape.cpp \
+    Base/Group.cpp \
+    Base/MotionState.cpp \
+    Base/PlanningScheduler.cpp \
+    Base/LevelFile.cpp \
+    Base/Job.cpp \
+    Base/LoadJobs.cpp \
+    Base/TrajectoryTable.cpp \
+    Base/TrajectoryPlanner.cpp \
+    Base/PointsView.cpp \
+    Base/PolygonView.cpp \
+    Base/RectShape2.cpp \
+    Base/SegmentShape2.cpp \
+    Base/SegmentView.cpp \
+    Base/Shape.cpp \
+    Base/ShapeGroup.cpp \
+    Base/ShapeListener.cpp \
+    Base/Sprite.cpp \
+    Base/View.cpp \
+    Core/AutoreleasePool.cpp \
+    Core/SharedObject.cpp \
+    Geometry/Circle.cpp \
+    Geometry/Gjk2.cpp \
+    Geometry/IO.cpp \
+    Geometry/Line2.cpp \
+    Geometry/Matrix2.cpp \
+    Geometry/Polygon2.cpp \
+    Geometry/Ray2.cpp \
+    Geometry/Rect2.cpp \
+    Geometry/Segment2.cpp \
+    Geometry/Vector2.cpp \
+    Lua/LuaEngine.cpp \
+    Lua/LuaUtils.cpp \
+    Utils/Algorithms.cpp \
+    Utils/Exception.cpp \
+    Utils/Iterator.cpp \
+    Utils/PolygonUtils.cpp \
+    Utils/RoadMap.cpp \
+    Utils/FlowField.cpp \
+    Utils/Parallel.cpp \
+    Utils/MappedFile.cpp \
+    Utils/Random.cpp \
+    Utils/Profiler.cpp \
+    Utils/Counters.cpp \
+    Lua/Base/LuaShape.cpp \
+    Lua/Base/LuaFlowField.cpp \
+    Lua/Base/LuaTrajectoryPlanner.cpp \
+    Lua/Base/LuaContactBuffer.cpp \
+    Lua/Base/LuaPlanningScheduler.cpp \
+    Lua/Base/LuaLevelFile.cpp \
+    Lua/Base/LuaJob.cpp \
+    Lua/Base/LuaSprite.cpp \
+    Lua/Base/LuaView.cpp \
+    Lua/Geometry/LuaCircle.cpp \
+    Lua/Geometry/LuaGeometry.cpp \
+    Lua/Geometry/LuaMatrix2.cpp \
+    Lua/Geometry/LuaMotionState.cpp \
+    Lua/Geometry/LuaTrajectoryTable.cpp \
+    Lua/Geometry/LuaRay2.cpp \
+    Lua/Geometry/LuaPointBuffer.cpp \
+    Lua/Geometry/LuaRect2.cpp \
+    Lua/Geometry/LuaSegment2.cpp \
+    Lua/Geometry/LuaVector2.cpp
+
+# Drawing helpers need OpenGL
+!contains(DEFINES, HEADLESS):SOURCES += Utils/GLUtils.cpp
@@ -0,0 +1,12 @@
+# #####################################################################
+# Headless engine library without OpenGL or Qt, for embedding the
+# simulation in tools and servers. Build with 'qmake LusionCore.pro'
+# #####################################################################
+TEMPLATE = lib
+TARGET = lusioncore
+CONFIG += staticlib
+CONFIG -= qt
+DEFINES += HEADLESS
+OBJECTS_DIR = ./build/headless/objects
+
+include(LusionCore.pri)
@@ -0,0 +1,15 @@
+# #####################################################################
+# Command line driver stepping a headless world as fast as possible.
+# Build with 'qmake LusionSim.pro', see lusionsim.cpp for usage
+# #####################################################################
+TEMPLATE = app
+TARGET = lusionsim
+CONFIG += console
+CONFIG -= qt app_bundle
+DEFINES += HEADLESS
+OBJECTS_DIR = ./build/headless/objects
+
+include(LusionCore.pri)
+
+# Input
+SOURCES += lusionsim.cpp
@@ -0,0 +1,214 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+
+#include "Replay.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+
+using namespace std;
+
+/*!
+    \class Replay Replay.h
+    \brief Recorded input of a game session.
+
+    Game state only changes through fixed simulation steps, key events and
+    random numbers. So a session is captured by the random seed, the step
+    length and each key event tagged with the step it happened before.
+    Playing a replay in a World feeds the same events to the same steps:
+
+    \code
+    Replay* replay = new Replay;
+    world.record(replay);         // Before world.start()
+    ...
+    replay->save("session.lrp");
+
+    world.play(Replay::load("session.lrp"));
+    world.start();
+    world.run();                  // Done when replay ends
+    \endcode
+
+    Planning with a time budget depends on the speed of the machine. So
+    while recording or playing back, World::isDeterministic() is true and
+    TrajectoryPlanner and PlanningScheduler bound their work by counts
+    instead. Lua planning that watches Engine.monotonicSeconds() itself
+    must check Engine.isDeterministic() too, as script/rrt.lua does, or
+    the replay will diverge from the session.
+
+    The file is a header followed by one 8 byte record per key event, with
+    the pressed flag in the top bit of the key code.
+*/
+
+static const char  gMagic[4] = {'L', 'R', 'P', 'L'};
+static const int   gVersion = 1;
+static const uint32 gPressedBit = 0x80000000u;
+
+/*! Layout of file header. Followed by noEvents key event records */
+struct ReplayFileHeader
+{
+  char   magic[4];
+  int    version;
+  uint32 seed;
+  int    ticksPerFrame;
+  uint32 noSteps;
+  uint32 noEvents;
+};
+
+/*! Layout of key event in file */
+struct ReplayFileEvent
+{
+  uint32 step;
+  uint32 key;
+};
+
+// Constructors
+Replay::Replay() : iSeed(0), iTicksPerFrame(0), iNoSteps(0)
+{
+}
+
+Replay::~Replay()
+{
+}
+
+/*! Reads replay written by save(). Returns 0 if file is missing or corrupt */
+Replay* Replay::load(const std::string& path)
+{
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == 0)
+    return 0;
+
+  ReplayFileHeader header;
+  bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+            memcmp(header.magic, gMagic, sizeof(gMagic)) == 0 &&
+            header.version == gVersion;
+
+  Replay* replay = 0;
+  if (ok) {
+    replay = new Replay;
+    replay->iSeed = header.seed;
+    replay->iTicksPerFrame = header.ticksPerFrame;
+    replay->iNoSteps = header.noSteps;
+    replay->iKeyEvents.reserve(header.noEvents);
+
+    ReplayFileEvent e;
+    for (uint32 i = 0; ok && i < header.noEvents; ++i) {
+      ok = fread(&e, sizeof(e), 1, file) == 1 && e.step <= header.noSteps &&
+           (i == 0 || replay->iKeyEvents.back().step <= e.step);
+      if (ok)
+        replay->addKeyEvent(e.step, e.key & ~gPressedBit, (e.key & gPressedBit) != 0);
+    }
+    if (!ok) {
+      replay->release();
+      replay = 0;
+    }
+  }
+  fclose(file);
+  return replay;
+}
+
+// Accessors
+std::string Replay::typeName() const
+{
+  return "Replay";
+}
+
+/*! Seed of the world random number generator when session started */
+void Replay::setSeed(uint32 seed)
+{
+  iSeed = seed;
+}
+
+uint32 Replay::seed() const
+{
+  return iSeed;
+}
+
+/*! Milliseconds per simulation step */
+void Replay::setTicksPerFrame(int ticks)
+{
+  iTicksPerFrame = ticks;
+}
+
+int Replay::ticksPerFrame() const
+{
+  return iTicksPerFrame;
+}
+
+/*! Length of session in simulation steps */
+void Replay::setNoSteps(uint32 steps)
+{
+  iNoSteps = steps;
+}
+
+uint32 Replay::noSteps() const
+{
+  return iNoSteps;
+}
+
+/*! Key events ordered by step */
+const KeyEvents& Replay::keyEvents() const
+{
+  return iKeyEvents;
+}
+
+// Operations
+/*! Records \a key being pressed or released before step \a step is run */
+void Replay::addKeyEvent(uint32 step, int key, bool pressed)
+{
+  assert(iKeyEvents.empty() || iKeyEvents.back().step <= step);
+  KeyEvent e = { step, key, pressed };
+  iKeyEvents.push_back(e);
+}
+
+void Replay::clear()
+{
+  iSeed = 0;
+  iTicksPerFrame = 0;
+  iNoSteps = 0;
+  iKeyEvents.clear();
+}
+
+/*! Write replay to binary file at \a path. Read it again with load() */
+bool Replay::save(const std::string& path) const
+{
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == 0)
+    return false;
+
+  ReplayFileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, gMagic, sizeof(gMagic));
+  header.version = gVersion;
+  header.seed = iSeed;
+  header.ticksPerFrame = iTicksPerFrame;
+  header.noSteps = iNoSteps;
+  header.noEvents = iKeyEvents.size();
+
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  KeyEvents::const_iterator it;
+  for (it = iKeyEvents.begin(); ok && it != iKeyEvents.end(); ++it) {
+    ReplayFileEvent e = { it->step, uint32(it->key) & ~gPressedBit };
+    if (it->pressed)
+      e.key |= gPressedBit;
+    ok = fwrite(&e, sizeof(e), 1, file) == 1;
+  }
+  return fclose(file) == 0 && ok;
+}
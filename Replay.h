@@ -0,0 +1,71 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+
+#pragma once
+
+#include "Types.h"
+
+#include <Core/SharedObject.hpp>
+
+#include <vector>
+#include <string>
+
+/*! Key pressed or released before simulation step \a step */
+struct KeyEvent
+{
+  uint32 step;
+  int    key;
+  bool   pressed;
+};
+
+typedef std::vector<KeyEvent> KeyEvents;
+
+class Replay : public SharedObject
+{
+public:
+  // Constructors
+  Replay();
+  virtual ~Replay();
+
+  static Replay* load(const std::string& path);
+
+  // Accessors
+  std::string typeName() const;
+
+  void   setSeed(uint32 seed);
+  uint32 seed() const;
+  void   setTicksPerFrame(int ticks);
+  int    ticksPerFrame() const;
+  void   setNoSteps(uint32 steps);
+  uint32 noSteps() const;
+
+  const KeyEvents& keyEvents() const;
+
+  // Operations
+  void   addKeyEvent(uint32 step, int key, bool pressed);
+  void   clear();
+  bool   save(const std::string& path) const;
+
+private:
+  uint32    iSeed;
+  int       iTicksPerFrame;
+  uint32    iNoSteps;
+  KeyEvents iKeyEvents;
+};
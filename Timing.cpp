@@ -18,32 +18,71 @@
 */
 
 #include "Timing.h"
+#include "World.h"
 
 #include <cassert>
 #include <time.h>
 
-static int gTicksPerFrame = 30;  // milliseconds per frame
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#endif
+
+static const real gStartSeconds = monotonicSeconds();
 
 void setTicksPerFrame(int noTicks)
 {
-  gTicksPerFrame = noTicks;
+  World::current()->setTicksPerFrame(noTicks);
 }
 
 int ticksPerFrame()
 {
-  return gTicksPerFrame;
+  return World::current()->ticksPerFrame();
 }
 
 real secondsPerFrame()
 {
-  return gTicksPerFrame*(1.0/1000.0);
+  return ticksPerFrame()*(1.0/1000.0);
 }
 
+/*!
+  Wall clock seconds since the engine was started. Measured with
+  monotonicSeconds(), so unlike processor time it keeps running while the
+  process sleeps and is the same for all threads.
+*/
 real secondsPassed()
 {
-  return clock()*(1.0f/CLOCKS_PER_SEC);
+  return monotonicSeconds() - gStartSeconds;
+}
+
+/*!
+  Seconds from an arbitrary fixed point, from a clock which is never adjusted.
+  Suitable for measuring intervals and time budgets.
+*/
+real monotonicSeconds()
+{
+#ifdef __APPLE__
+  static mach_timebase_info_data_t timebase;
+  if (timebase.denom == 0)
+    mach_timebase_info(&timebase);
+  return mach_absolute_time()*(1e-9*timebase.numer/timebase.denom);
+#else
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec*1e-9;
+#endif
 }
 
+/*! Wall clock milliseconds since the engine was started */
 int getTicks() {
-  return clock()*(1000.0f/CLOCKS_PER_SEC);
+  return static_cast<int>(secondsPassed()*1000.0);
+}
+
+/*!
+  How far rendering is between the previous and the current simulation step
+  of the current world, from 0 to 1. Sprites are drawn this far from their
+  previous position towards their current one. See World::advance()
+*/
+real renderInterpolation()
+{
+  return World::current()->interpolation();
 }
@@ -23,4 +23,6 @@ int  ticksPerFrame();
 void setTicksPerFrame(int noTicks);
 real secondsPerFrame();
 real secondsPassed();
+real monotonicSeconds();
 int  getTicks();
+real renderInterpolation();
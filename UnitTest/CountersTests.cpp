@@ -0,0 +1,88 @@
+/*
+ *  CountersTests.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#define COUNTERS    // Count in this file even if engine is built without
+
+#include "CountersTests.h"
+
+#include "Utils/Counters.h"
+
+#include <pthread.h>
+
+using namespace std;
+
+static void* countContacts(void*)
+{
+  for (int i = 0; i < 1000; ++i)
+    COUNT(CONTACTS);
+  return 0;
+}
+
+CountersTests::CountersTests(TestInvocation *invocation)
+    : TestCase(invocation)
+{
+}
+
+
+CountersTests::~CountersTests()
+{
+}
+
+void CountersTests::testFrameCounts()
+{
+  countersReset();
+  
+  COUNT(BROADPHASE_TESTS);
+  COUNT(BROADPHASE_TESTS);
+  COUNT(NARROWPHASE_TESTS);
+  countersEndFrame();
+  
+  CounterValues counters;
+  frameCounters(counters);
+  CPTAssert(counters[BROADPHASE_TESTS] == 2);
+  CPTAssert(counters[NARROWPHASE_TESTS] == 1);
+  CPTAssert(counters[CONTACTS] == 0);
+  
+  // Only counts since last frame
+  COUNT(BROADPHASE_TESTS);
+  countersEndFrame();
+  frameCounters(counters);
+  CPTAssert(counters[BROADPHASE_TESTS] == 1);
+  CPTAssert(counters[NARROWPHASE_TESTS] == 0);
+  
+  totalCounters(counters);
+  CPTAssert(counters[BROADPHASE_TESTS] == 3);
+  CPTAssert(counters[NARROWPHASE_TESTS] == 1);
+  CPTAssert(counterReport().find("broadphase_tests") != string::npos);
+  
+  countersReset();
+  totalCounters(counters);
+  CPTAssert(counters[BROADPHASE_TESTS] == 0);
+}
+
+void CountersTests::testThreads()
+{
+  countersReset();
+  
+  // Counts of threads are kept after they exit
+  pthread_t threads[4];
+  for (int i = 0; i < 4; ++i)
+    pthread_create(&threads[i], 0, countContacts, 0);
+  for (int i = 0; i < 4; ++i)
+    pthread_join(threads[i], 0);
+  countContacts(0);
+  countersEndFrame();
+  
+  CounterValues counters;
+  frameCounters(counters);
+  CPTAssert(counters[CONTACTS] == 5000);
+}
+
+static CountersTests test1(TEST_INVOCATION(CountersTests, testFrameCounts));
+static CountersTests test2(TEST_INVOCATION(CountersTests, testThreads));
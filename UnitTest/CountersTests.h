@@ -0,0 +1,20 @@
+/*
+ *  CountersTests.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include <CPlusTest/CPlusTest.h>
+
+
+class CountersTests : public TestCase {
+public:
+  CountersTests(TestInvocation* invocation);
+  virtual ~CountersTests();
+    
+  void testFrameCounts();
+  void testThreads();
+};
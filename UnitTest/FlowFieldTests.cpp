@@ -0,0 +1,174 @@
+/*
+ *  FlowFieldTests.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 12.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "FlowFieldTests.h"
+
+#include "Utils/FlowField.h"
+
+#include "Base/Group.h"
+#include "Base/RectShape2.h"
+#include "Core/AutoreleasePool.hpp"
+
+#include <cmath>
+
+using namespace std;
+
+FlowFieldTests::FlowFieldTests(TestInvocation *invocation)
+    : TestCase(invocation)
+{
+}
+
+
+FlowFieldTests::~FlowFieldTests()
+{
+}
+
+void FlowFieldTests::testOpenField()
+{
+  AutoreleasePool::begin();
+  
+  RectShape2* far_away = new RectShape2(Rect2(Vector2(100.0, 100.0), Vector2(101.0, 101.0)));
+  FlowField field(Rect2(Vector2(0.0, 0.0), Vector2(10.0, 10.0)), 1.0);
+  CPTAssert(field.columns() == 10 && field.rows() == 10);
+  
+  field.rasterize(far_away);
+  field.setGoal(Point2(8.5, 5.5));
+  
+  CPTAssert(field.distance(Point2(8.5, 5.5)) == 0.0);
+  CPTAssert(fabs(field.distance(Point2(2.5, 5.5)) - 6.0) < 1e-6);
+  
+  Vector2 dir = field.direction(Point2(2.5, 5.5));
+  CPTAssert(dir.x() == 1.0 && dir.y() == 0.0);
+  CPTAssert(field.direction(Point2(8.5, 5.5)) == Vector2(0.0, 0.0));
+  CPTAssert(field.direction(Point2(-1.0, 5.0)) == Vector2(0.0, 0.0));
+  
+  // Structure of arrays sampling should agree with single lookups
+  real xs[] = {2.5, 8.2, 20.0};
+  real ys[] = {5.5, 1.5, 5.0};
+  real dxs[3], dys[3];
+  field.sample(xs, ys, 3, dxs, dys);
+  for (int i = 0; i < 3; ++i) {
+    Vector2 d = field.direction(Point2(xs[i], ys[i]));
+    CPTAssert(dxs[i] == d.x() && dys[i] == d.y());
+  }
+  
+  far_away->release();
+  AutoreleasePool::end();
+}
+
+void FlowFieldTests::testObstacles()
+{
+  AutoreleasePool::begin();
+
+  // Wall splitting field except for a gap at the top
+  RectShape2* wall = new RectShape2(Rect2(Vector2(4.2, 0.0), Vector2(5.8, 7.8)));
+  FlowField field(Rect2(Vector2(0.0, 0.0), Vector2(10.0, 10.0)), 1.0);
+  field.rasterize(wall);
+  field.setGoal(Point2(8.5, 1.5));
+  
+  CPTAssert(field.isBlocked(Point2(5.0, 3.0)));
+  CPTAssert(!field.isBlocked(Point2(5.0, 9.0)));
+  CPTAssert(!field.isReachable(Point2(5.0, 3.0)));
+  
+  // Have to go around the wall
+  CPTAssert(field.distance(Point2(1.5, 1.5)) > 7.0 + 6.0);
+  CPTAssert(field.direction(Point2(3.5, 1.5)).y() > 0.0);
+  
+  // Moving wall out of the way opens up a straight path
+  Rect2 old_box = wall->boundingBox();
+  wall->release();
+  wall = new RectShape2(Rect2(Vector2(20.0, 0.0), Vector2(21.0, 7.8)));
+  CPTAssert(field.update(wall, old_box));
+  CPTAssert(fabs(field.distance(Point2(1.5, 1.5)) - 7.0) < 1e-6);
+  CPTAssert(!field.update(wall, old_box));
+  
+  wall->release();
+  AutoreleasePool::end();
+}
+
+void FlowFieldTests::testBlockedGoal()
+{
+  AutoreleasePool::begin();
+
+  RectShape2* wall = new RectShape2(Rect2(Vector2(4.2, 4.2), Vector2(5.8, 5.8)));
+  FlowField field(Rect2(Vector2(0.0, 0.0), Vector2(10.0, 10.0)), 1.0);
+  field.rasterize(wall);
+  
+  // Goal inside an obstacle can't be reached from anywhere
+  field.setGoal(Point2(5.0, 5.0));
+  CPTAssert(field.isBlocked(Point2(5.0, 5.0)));
+  CPTAssert(!field.isReachable(Point2(5.0, 5.0)));
+  CPTAssert(!field.isReachable(Point2(1.5, 1.5)));
+  CPTAssert(field.direction(Point2(1.5, 1.5)) == Vector2(0.0, 0.0));
+  
+  field.setGoal(Point2(8.5, 8.5));
+  CPTAssert(field.isReachable(Point2(1.5, 1.5)));
+  
+  wall->release();
+  AutoreleasePool::end();
+}
+
+void FlowFieldTests::testIncrementalUpdate()
+{
+  AutoreleasePool::begin();
+  
+  // Wall with a gap which a door moves in and out of, on both sides of goal
+  Rect2 area(Vector2(0.0, 0.0), Vector2(20.0, 20.0));
+  Group* obstacles = new Group;
+  RectShape2* wall = new RectShape2(Rect2(Vector2(9.2, 0.0), Vector2(10.8, 14.8)));
+  obstacles->addKid(wall);
+  FlowField field(area, 1.0);
+  field.rasterize(obstacles);
+  field.setGoal(Point2(15.5, 3.5));
+  
+  Rect2 doors[] = {
+    Rect2(Vector2(9.2, 15.2), Vector2(10.8, 19.8)),   // Closes gap
+    Rect2(Vector2(9.2, 17.2), Vector2(10.8, 19.8)),   // Opens part of it
+    Rect2(Vector2(13.2, 2.2), Vector2(14.8, 4.8)),    // Next to goal
+    Rect2(Vector2(1.2, 1.2), Vector2(2.8, 2.8)),      // Far from goal
+    Rect2(Vector2(15.2, 3.2), Vector2(15.8, 3.8))     // On goal
+  };
+  RectShape2* door = 0;
+  for (int i = 0; i < 6; ++i) {
+    Rect2 region = door ? door->boundingBox() : doors[0];
+    if (door) {
+      obstacles->removeKid(door);
+      door->release();
+      door = 0;
+    }
+    if (i < 5) {
+      door = new RectShape2(doors[i]);
+      obstacles->addKid(door);
+      region = region.surround(doors[i]);
+    }
+    CPTAssert(field.update(obstacles, region));
+    
+    // Fields should be the same as when computed from scratch
+    FlowField full(area, 1.0);
+    full.rasterize(obstacles);
+    full.setGoal(field.goal());
+    for (int row = 0; row < full.rows(); ++row) {
+      for (int col = 0; col < full.columns(); ++col) {
+        Point2 p(col+0.5, row+0.5);
+        CPTAssert(field.isBlocked(p) == full.isBlocked(p));
+        CPTAssert(field.distance(p) == full.distance(p));
+        CPTAssert(field.direction(p) == full.direction(p));
+      }
+    }
+  }
+  
+  obstacles->release();
+  wall->release();
+  AutoreleasePool::end();
+}
+
+static FlowFieldTests test1(TEST_INVOCATION(FlowFieldTests, testOpenField));
+static FlowFieldTests test2(TEST_INVOCATION(FlowFieldTests, testObstacles));
+static FlowFieldTests test3(TEST_INVOCATION(FlowFieldTests, testBlockedGoal));
+static FlowFieldTests test4(TEST_INVOCATION(FlowFieldTests, testIncrementalUpdate));
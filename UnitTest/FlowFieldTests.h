@@ -0,0 +1,22 @@
+/*
+ *  FlowFieldTests.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 12.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include <CPlusTest/CPlusTest.h>
+
+
+class FlowFieldTests : public TestCase {
+public:
+  FlowFieldTests(TestInvocation* invocation);
+  virtual ~FlowFieldTests();
+    
+  void testOpenField();
+  void testObstacles();
+  void testBlockedGoal();
+  void testIncrementalUpdate();
+};
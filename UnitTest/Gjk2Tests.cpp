@@ -0,0 +1,163 @@
+/*
+ *  Gjk2Tests.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "Gjk2Tests.h"
+
+#include <Geometry/Gjk2.hpp>
+#include <Geometry/Polygon2.hpp>
+#include <Geometry/Circle.hpp>
+#include <Geometry/Segment2.hpp>
+#include <Geometry/Rect2.hpp>
+
+#include <cmath>
+
+using namespace std;
+
+static const real gEps = 1e-6;
+
+/*! Regular polygon with \a n corners and radius \a r around \a center */
+static Polygon2 regularPolygon(const Point2& center, real r, int n)
+{
+  Polygon2 poly;
+  for (int i = 0; i < n; ++i) {
+    real a = 2.0*M_PI*i/n;
+    poly.push_back(center + Vector2(r*cos(a), r*sin(a)));
+  }
+  return poly;
+}
+
+Gjk2Tests::Gjk2Tests(TestInvocation *invocation)
+    : TestCase(invocation)
+{
+}
+
+
+Gjk2Tests::~Gjk2Tests()
+{
+}
+
+void Gjk2Tests::testDistance()
+{
+  Polygon2 a(Rect2(0.0, 0.0, 1.0, 1.0));
+  Polygon2 b(Rect2(3.0, 0.5, 4.0, 1.5));
+  Point2 pa, pb;
+  CPTAssert(fabs(gjkDistance(a, b, 0, &pa, &pb) - 2.0) < gEps);
+  CPTAssert(fabs(pa.x() - 1.0) < gEps && fabs(pb.x() - 3.0) < gEps);
+  CPTAssert(pa.y() >= 0.5 - gEps && pa.y() <= 1.0 + gEps);
+  
+  // Corner to corner
+  Polygon2 c(Rect2(2.0, 2.0, 3.0, 3.0));
+  CPTAssert(fabs(gjkDistance(a, c, 0, &pa, &pb) - sqrt(2.0)) < gEps);
+  CPTAssert((pa - Point2(1.0, 1.0)).length() < gEps);
+  CPTAssert((pb - Point2(2.0, 2.0)).length() < gEps);
+  
+  // Circle
+  Circle circle(Point2(0.5, 4.0), 1.0);
+  CPTAssert(fabs(gjkDistance(a, circle, 0, &pa, &pb) - 2.0) < gEps);
+  CPTAssert((pb - Point2(0.5, 3.0)).length() < gEps);
+  CPTAssert(fabs(gjkDistance(circle, Circle(Point2(4.0, 4.0), 0.5)) - 2.0) < gEps);
+  
+  // Segment and rect
+  Segment2 seg(Point2(-1.0, 3.0), Point2(5.0, 3.0));
+  CPTAssert(fabs(gjkDistance(seg, Rect2(2.0, -1.0, 3.0, 1.0)) - 2.0) < gEps);
+  CPTAssert(fabs(gjkDistance(ConvexShape2(Point2(0.0, 0.0)), seg) - 3.0) < gEps);
+  
+  // Overlapping shapes have no distance
+  CPTAssert(gjkDistance(a, Rect2(0.5, 0.5, 2.0, 2.0)) == 0.0);
+  CPTAssert(gjkDistance(a, Circle(Point2(0.5, 0.5), 0.1)) == 0.0);
+  CPTAssert(gjkDistance(seg, Circle(Point2(0.0, 3.5), 1.0)) == 0.0);
+}
+
+void Gjk2Tests::testPenetration()
+{
+  Polygon2 a(Rect2(0.0, 0.0, 2.0, 2.0));
+  Polygon2 b(Rect2(1.5, 0.5, 3.5, 1.5));
+  Vector2 normal;
+  real depth;
+  Point2 point;
+  CPTAssert(gjkPenetration(a, b, normal, depth, point));
+  CPTAssert(fabs(depth - 0.5) < gEps);
+  CPTAssert((normal - Vector2(1.0, 0.0)).length() < gEps);
+  CPTAssert(a.inside(point) && b.inside(point));
+  
+  // Normal points from first to second shape
+  CPTAssert(gjkPenetration(b, a, normal, depth, point));
+  CPTAssert((normal - Vector2(-1.0, 0.0)).length() < gEps);
+  
+  // Circle overlapping top edge
+  Circle circle(Point2(1.0, 2.5), 1.0);
+  CPTAssert(gjkPenetration(a, circle, normal, depth, point));
+  CPTAssert(fabs(depth - 0.5) < gEps);
+  CPTAssert((normal - Vector2(0.0, 1.0)).length() < gEps);
+  
+  // Circle centre inside polygon
+  circle = Circle(Point2(1.0, 1.8), 0.5);
+  CPTAssert(gjkPenetration(a, circle, normal, depth, point));
+  CPTAssert(fabs(depth - 0.7) < gEps);
+  CPTAssert((normal - Vector2(0.0, 1.0)).length() < gEps);
+  
+  // Circles
+  CPTAssert(gjkPenetration(Circle(Point2(0.0, 0.0), 1.0), Circle(Point2(0.0, 1.5), 1.0), normal, depth, point));
+  CPTAssert(fabs(depth - 0.5) < gEps);
+  CPTAssert((normal - Vector2(0.0, 1.0)).length() < gEps);
+  CPTAssert((point - Point2(0.0, 0.75)).length() < gEps);
+  
+  CPTAssert(!gjkPenetration(a, Rect2(2.5, 0.0, 3.0, 1.0), normal, depth, point));
+  CPTAssert(!gjkPenetration(a, Circle(Point2(4.0, 1.0), 1.0), normal, depth, point));
+  CPTAssert(!gjkIntersect(a, Circle(Point2(4.0, 1.0), 1.0)));
+  CPTAssert(gjkIntersect(a, Circle(Point2(3.0, 1.0), 1.0)));
+}
+
+void Gjk2Tests::testAgreesWithSeparatingAxes()
+{
+  Polygon2 big = regularPolygon(Point2(0.0, 0.0), 5.0, 64);
+  for (int n = 3; n < 12; ++n) {
+    for (int i = 0; i < 50; ++i) {
+      real a = 0.37*i;
+      Point2 center = (3.0 + 0.1*i)*Vector2(cos(a), sin(a));
+      Polygon2 small = regularPolygon(center, 0.5 + 0.05*n, n);
+      CPTAssert(gjkIntersect(big, small) == big.intersect(small));
+      CPTAssert(gjkIntersect(small, big) == small.intersect(big));
+      CPTAssert((gjkDistance(big, small) == 0.0) == big.intersect(small));
+    }
+  }
+}
+
+void Gjk2Tests::testWarmStart()
+{
+  Polygon2 a = regularPolygon(Point2(0.0, 0.0), 2.0, 32);
+  SimplexCache2 cache;
+  for (int i = 0; i < 100; ++i) {
+    Polygon2 b = regularPolygon(Point2(4.5 - 0.01*i, 0.3), 1.0, 16);
+    real cold = gjkDistance(a, b);
+    real warm = gjkDistance(a, b, &cache);
+    CPTAssert(fabs(cold - warm) < gEps);
+    CPTAssert(cache.count > 0);
+    
+    Vector2 normal, warm_normal;
+    real depth, warm_depth;
+    Point2 point;
+    SimplexCache2 pen_cache = cache;
+    bool hit = gjkPenetration(a, b, normal, depth, point);
+    CPTAssert(hit == gjkPenetration(a, b, warm_normal, warm_depth, point, &pen_cache));
+    if (hit)
+      CPTAssert(fabs(depth - warm_depth) < gEps);
+  }
+  
+  // Cache made for other shapes must not be trusted
+  cache.count = 3;
+  cache.a[0] = cache.a[1] = cache.a[2] = 40;
+  cache.b[0] = cache.b[1] = cache.b[2] = 0;
+  CPTAssert(fabs(gjkDistance(a, Circle(Point2(5.0, 0.0), 1.0), &cache) - 2.0) < 1e-3);
+}
+
+static Gjk2Tests test1(TEST_INVOCATION(Gjk2Tests, testDistance));
+static Gjk2Tests test2(TEST_INVOCATION(Gjk2Tests, testPenetration));
+static Gjk2Tests test3(TEST_INVOCATION(Gjk2Tests, testAgreesWithSeparatingAxes));
+static Gjk2Tests test4(TEST_INVOCATION(Gjk2Tests, testWarmStart));
@@ -0,0 +1,22 @@
+/*
+ *  Gjk2Tests.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include <CPlusTest/CPlusTest.h>
+
+
+class Gjk2Tests : public TestCase {
+public:
+  Gjk2Tests(TestInvocation* invocation);
+  virtual ~Gjk2Tests();
+    
+  void testDistance();
+  void testPenetration();
+  void testAgreesWithSeparatingAxes();
+  void testWarmStart();
+};
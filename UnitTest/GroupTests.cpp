@@ -0,0 +1,64 @@
+/*
+ *  GroupTests.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "GroupTests.h"
+
+#include "Base/Group.h"
+#include "Base/RectShape2.h"
+#include "Core/AutoreleasePool.hpp"
+
+#include <vector>
+
+using namespace std;
+
+GroupTests::GroupTests(TestInvocation *invocation)
+    : TestCase(invocation)
+{
+}
+
+
+GroupTests::~GroupTests()
+{
+}
+
+void GroupTests::testOrder()
+{
+  AutoreleasePool::begin();
+  
+  // Shapes are visited in the order added, whatever their addresses
+  Group* group = new Group;
+  vector<Shape*> shapes;
+  for (int i = 0; i < 8; ++i) {
+    RectShape2* shape = new RectShape2(Rect2(Vector2(i, 0.0), Vector2(i+1.0, 1.0)));
+    shapes.push_back(shape);
+  }
+  for (int i = 7; i >= 0; --i)
+    group->addKid(shapes[i]);
+  group->removeKid(shapes[3]);
+  group->addKid(shapes[3]);
+  
+  int expected[] = {7, 6, 5, 4, 2, 1, 0, 3};
+  int n = 0;
+  ShapeIterator* it = group->iterator();
+  for (it->first(); !it->done(); it->next(), ++n)
+    CPTAssert(it->value() == shapes[expected[n]]);
+  CPTAssert(n == 8);
+  
+  // Round robin goes on from the last shape added
+  CPTAssert(group->nextShape() == shapes[3]);
+  CPTAssert(group->nextShape() == shapes[7]);
+  
+  group->release();
+  for (int i = 0; i < 8; ++i)
+    shapes[i]->release();
+  
+  AutoreleasePool::end();
+}
+
+static GroupTests test1(TEST_INVOCATION(GroupTests, testOrder));
@@ -0,0 +1,19 @@
+/*
+ *  GroupTests.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include <CPlusTest/CPlusTest.h>
+
+
+class GroupTests : public TestCase {
+public:
+  GroupTests(TestInvocation* invocation);
+  virtual ~GroupTests();
+    
+  void testOrder();
+};
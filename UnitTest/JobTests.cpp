@@ -0,0 +1,297 @@
+/*
+ *  JobTests.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "JobTests.h"
+
+#include "World.h"
+
+#include "Base/Job.h"
+#include "Base/LoadJobs.h"
+#include "Base/Sprite.h"
+#include "Base/ShapeGroup.h"
+
+#include "Core/AutoreleasePool.hpp"
+
+#include "MockView.h"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// Sums numbers and records on which thread it ran and when it was published
+class SumJob : public Job
+{
+public:
+  SumJob(int n) : iN(n), iSum(0), iRunThread(pthread_self()), iNoPublished(0) {}
+
+  bool run() {
+    iRunThread = pthread_self();
+    for (int i = 1; i <= iN && !isCancelled(); ++i) {
+      iSum += i;
+      setProgress(real(i)/iN);
+    }
+    return !isCancelled();
+  }
+
+  void publish() { ++iNoPublished; }
+
+  int iN, iSum;
+  pthread_t iRunThread;
+  int iNoPublished;
+};
+
+// Records jobs it is told about
+class RecordingListener : public JobListener
+{
+public:
+  RecordingListener(vector<Job*>& jobs) : iJobs(jobs) {}
+  void jobFinished(Job* job) { iJobs.push_back(job); }
+
+private:
+  vector<Job*>& iJobs;
+};
+
+/*! Sprite covering \a r */
+static Shape* wallSprite(const Rect2& r)
+{
+  MockView* view = new MockView(Polygon2(Rect2(0.0, 0.0, r.width(), r.height())));
+  Sprite* sprite = new Sprite(view);
+  sprite->setPosition(r.min());
+  view->release();
+  return sprite;
+}
+
+JobTests::JobTests(TestInvocation *invocation)
+  : TestCase(invocation)
+{
+}
+
+
+JobTests::~JobTests()
+{
+}
+
+void JobTests::testRunAndPublish()
+{
+  vector<Job*> told;
+  JobQueue* queue = new JobQueue(0, 2);
+  SumJob* jobs[3] = { new SumJob(10), new SumJob(1000), new SumJob(100) };
+  for (int i = 0; i < 3; ++i) {
+    jobs[i]->setListener(new RecordingListener(told));
+    queue->add(jobs[i]);
+  }
+  CPTAssert(queue->size() == 3);
+
+  queue->wait();
+  for (int i = 0; i < 3; ++i) {
+    CPTAssert(jobs[i]->isFinished());
+    CPTAssert(jobs[i]->succeeded());
+    CPTAssert(jobs[i]->progress() == 1.0);
+    CPTAssert(!pthread_equal(jobs[i]->iRunThread, pthread_self()));
+    CPTAssert(jobs[i]->iNoPublished == 0);
+    CPTAssert(!jobs[i]->isPublished());
+  }
+  CPTAssert(jobs[0]->iSum == 55 && jobs[1]->iSum == 500500 && jobs[2]->iSum == 5050);
+  CPTAssert(told.empty());
+
+  // Results are only handed over on the thread calling publish()
+  CPTAssert(queue->publish() == 3);
+  CPTAssert(queue->empty());
+  CPTAssert(told.size() == 3);
+  for (int i = 0; i < 3; ++i) {
+    CPTAssert(jobs[i]->isPublished());
+    CPTAssert(jobs[i]->iNoPublished == 1);
+    CPTAssert(jobs[i]->listener() == 0);
+  }
+  CPTAssert(queue->publish() == 0);
+
+  for (int i = 0; i < 3; ++i)
+    jobs[i]->release();
+  queue->release();
+}
+
+void JobTests::testCancel()
+{
+  vector<Job*> told;
+  JobQueue* queue = new JobQueue(0, 1);
+  SumJob* job = new SumJob(100);
+  job->setListener(new RecordingListener(told));
+  job->cancel();
+  queue->add(job);
+  queue->wait();
+
+  CPTAssert(job->isFinished());
+  CPTAssert(!job->succeeded());
+  CPTAssert(job->iSum == 0);
+  CPTAssert(queue->publish() == 0);
+  CPTAssert(job->isPublished());
+  CPTAssert(job->iNoPublished == 0);
+  CPTAssert(told.empty());
+  job->release();
+
+  // Jobs still queued when the queue goes away are never published
+  job = new SumJob(100);
+  queue->add(job);
+  queue->release();
+  CPTAssert(job->isCancelled());
+  CPTAssert(job->iNoPublished == 0);
+  job->release();
+}
+
+void JobTests::testWorldPublishes()
+{
+  World world;
+  CPTAssert(world.jobs() != 0);
+  CPTAssert(world.jobs()->noThreads() >= 1);
+
+  SumJob* job = new SumJob(10);
+  world.jobs()->add(job);
+  world.jobs()->wait();
+  CPTAssert(job->iNoPublished == 0);
+  world.jobs()->publish();
+  CPTAssert(job->iNoPublished == 1);
+  job->release();
+}
+
+void JobTests::testRoadmapJob()
+{
+  AutoreleasePool::begin();
+
+  // Level enclosed by walls, with a wall in the middle
+  Rect2 box(0.0, 0.0, 100.0, 100.0);
+  vector<Shape*> walls;
+  walls.push_back(wallSprite(Rect2(-10.0, -10.0, 110.0, 0.0)));
+  walls.push_back(wallSprite(Rect2(-10.0, 100.0, 110.0, 110.0)));
+  walls.push_back(wallSprite(Rect2(-10.0, 0.0, 0.0, 100.0)));
+  walls.push_back(wallSprite(Rect2(100.0, 0.0, 110.0, 100.0)));
+  walls.push_back(wallSprite(Rect2(40.0, 20.0, 60.0, 80.0)));
+  Shape* obstacles = new ShapeGroup(walls.begin(), walls.end());
+  for_each(walls.begin(), walls.end(), mem_fun(&Shape::release));
+
+  JobQueue* queue = new JobQueue(0, 1);
+  RoadmapJob* job = new RoadmapJob(obstacles, box, 10*10, 1.0, 7);
+  queue->add(job);
+  queue->wait();
+  CPTAssert(queue->publish() == 1);
+  CPTAssert(job->succeeded());
+
+  const RoadmapNodes& nodes = job->nodes();
+  const RoadmapNeighbors& neighbors = job->neighbors();
+  CPTAssert(!nodes.empty());
+  CPTAssert(nodes.size() == neighbors.size());
+  for (uint32 i = 0; i < nodes.size(); ++i) {
+    Point2 p = nodes[i].position;
+    CPTAssert(p.x() > 0.0 && p.x() < 100.0 && p.y() > 0.0 && p.y() < 100.0);
+    CPTAssert(!(p.x() > 40.0 && p.x() < 60.0 && p.y() > 20.0 && p.y() < 80.0));
+    CPTAssert(nodes[i].radius > 1.0 && nodes[i].radius <= 100.0);
+    for (uint32 j = 0; j < neighbors[i].size(); ++j) {
+      uint32 k = neighbors[i][j];
+      CPTAssert(k < nodes.size() && k != i);
+      CPTAssert(find(neighbors[k].begin(), neighbors[k].end(), i) != neighbors[k].end());
+    }
+  }
+
+  // Same seed gives same roadmap
+  RoadmapJob* again = new RoadmapJob(obstacles, box, 10*10, 1.0, 7);
+  queue->add(again);
+  queue->wait();
+  queue->publish();
+  CPTAssert(again->nodes().size() == nodes.size());
+  CPTAssert(again->nodes()[0].position == nodes[0].position);
+
+  again->release();
+  job->release();
+  queue->release();
+  obstacles->release();
+  AutoreleasePool::end();
+}
+
+void JobTests::testRoadmapJobGjk()
+{
+  AutoreleasePool::begin();
+
+  Rect2 box(0.0, 0.0, 100.0, 100.0);
+  Rect2 rects[] = {
+    Rect2(-10.0, -10.0, 110.0, 0.0), Rect2(-10.0, 100.0, 110.0, 110.0),
+    Rect2(-10.0, 0.0, 0.0, 100.0), Rect2(100.0, 0.0, 110.0, 100.0),
+    Rect2(40.0, 20.0, 60.0, 80.0)
+  };
+  vector<Shape*> walls;
+  for (int i = 0; i < 5; ++i)
+    walls.push_back(wallSprite(rects[i]));
+  Shape* obstacles = new ShapeGroup(walls.begin(), walls.end());
+  for_each(walls.begin(), walls.end(), mem_fun(&Shape::release));
+
+  // Narrow phase is the one of the world when the job is created
+  World::current()->setNarrowPhase(GJK_NARROW_PHASE);
+  RoadmapJob* job = new RoadmapJob(obstacles, box, 10*10, 1.0, 7);
+  World::current()->setNarrowPhase(SAT_NARROW_PHASE);
+
+  JobQueue* queue = new JobQueue(0, 1);
+  queue->add(job);
+  queue->wait();
+  queue->publish();
+  CPTAssert(job->succeeded());
+
+  // With GJK the radius is the exact distance to the nearest wall
+  const RoadmapNodes& nodes = job->nodes();
+  CPTAssert(!nodes.empty());
+  for (uint32 i = 0; i < nodes.size(); ++i) {
+    Point2 p = nodes[i].position;
+    real dist = 100.0;
+    for (int j = 0; j < 5; ++j) {
+      Vector2 d(max(max(rects[j].xmin() - p.x(), p.x() - rects[j].xmax()), 0.0),
+                max(max(rects[j].ymin() - p.y(), p.y() - rects[j].ymax()), 0.0));
+      dist = min(dist, d.length());
+    }
+    CPTAssert(fabs(nodes[i].radius - dist) < 1e-6);
+  }
+
+  job->release();
+  queue->release();
+  obstacles->release();
+  AutoreleasePool::end();
+}
+
+void JobTests::testRoadmapSnapshot()
+{
+  AutoreleasePool::begin();
+
+  Rect2 box(0.0, 0.0, 100.0, 100.0);
+  Sprite* wall = static_cast<Sprite*>(wallSprite(Rect2(40.0, 20.0, 60.0, 80.0)));
+  RoadmapJob* job = new RoadmapJob(wall, box, 10*10, 1.0, 7);
+
+  // Job must use obstacles as they were when it was created
+  wall->setPosition(Point2(200.0, 200.0));
+  wall->release();
+
+  JobQueue* queue = new JobQueue(0, 1);
+  queue->add(job);
+  queue->wait();
+  queue->publish();
+  CPTAssert(job->succeeded());
+  CPTAssert(!job->nodes().empty());
+  for (uint32 i = 0; i < job->nodes().size(); ++i) {
+    Point2 p = job->nodes()[i].position;
+    CPTAssert(!(p.x() > 40.0 && p.x() < 60.0 && p.y() > 20.0 && p.y() < 80.0));
+  }
+
+  job->release();
+  queue->release();
+  AutoreleasePool::end();
+}
+
+static JobTests test1(TEST_INVOCATION(JobTests, testRunAndPublish));
+static JobTests test2(TEST_INVOCATION(JobTests, testCancel));
+static JobTests test3(TEST_INVOCATION(JobTests, testWorldPublishes));
+static JobTests test4(TEST_INVOCATION(JobTests, testRoadmapJob));
+static JobTests test5(TEST_INVOCATION(JobTests, testRoadmapJobGjk));
+static JobTests test6(TEST_INVOCATION(JobTests, testRoadmapSnapshot));
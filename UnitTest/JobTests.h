@@ -0,0 +1,24 @@
+/*
+ *  JobTests.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include <CPlusTest/CPlusTest.h>
+
+
+class JobTests : public TestCase {
+public:
+  JobTests(TestInvocation* invocation);
+  virtual ~JobTests();
+    
+  void testRunAndPublish();
+  void testCancel();
+  void testWorldPublishes();
+  void testRoadmapJob();
+  void testRoadmapJobGjk();
+  void testRoadmapSnapshot();
+};
@@ -0,0 +1,166 @@
+/*
+ *  LevelFileTests.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "LevelFileTests.h"
+
+#include "Base/LevelFile.h"
+#include "Base/Sprite.h"
+#include "Base/ShapeGroup.h"
+
+#include "Core/AutoreleasePool.hpp"
+
+#include "MockView.h"
+
+#include <cstdio>
+#include <unistd.h>
+
+using namespace std;
+
+static const char* gPath = "/tmp/lusion_level_test.lvl";
+
+/*! Row of \a n unit squares one unit apart, grouped in a ShapeGroup. Reorders \a sprites */
+static Shape* createObstacles(int n, vector<Shape*>& sprites)
+{
+  Polygon2 square(Rect2(0.0, 0.0, 1.0, 1.0));
+  for (int i = 0; i < n; ++i) {
+    MockView* view = new MockView(square);
+    view->setColor(0.1*i, 0.5, 1.0);
+    Sprite* sprite = new Sprite(view);
+    sprite->setPosition(Point2(2.0*i, 0.0));
+    view->release();
+    sprites.push_back(sprite);
+  }
+  return new ShapeGroup(sprites.begin(), sprites.end());
+}
+
+LevelFileTests::LevelFileTests(TestInvocation *invocation)
+    : TestCase(invocation)
+{
+}
+
+
+LevelFileTests::~LevelFileTests()
+{
+}
+
+void LevelFileTests::testSaveAndLoad()
+{
+  AutoreleasePool::begin();
+  vector<Shape*> sprites;
+  Shape* obstacles = createObstacles(5, sprites);
+  
+  RoadmapNodes nodes(3);
+  RoadmapNeighbors neighbors(3);
+  for (int i = 0; i < 3; ++i) {
+    nodes[i].position = Point2(2.0*i+1.5, 0.5);
+    nodes[i].radius = 0.5;
+  }
+  neighbors[0].push_back(1);
+  neighbors[1].push_back(0);
+  neighbors[1].push_back(2);
+  neighbors[2].push_back(1);
+  
+  CPTAssert(LevelFile::save(gPath, obstacles, nodes, neighbors));
+  LevelFile* level = LevelFile::load(gPath);
+  CPTAssert(level != 0);
+  CPTAssert(level->noObstacles() == 5);
+  CPTAssert(level->boundingBox() == obstacles->boundingBox());
+
+  // Obstacles are stored in hierarchy order, so look them up by position
+  for (int i = 0; i < level->noObstacles(); ++i) {
+    Polygon2 poly = level->polygon(i);
+    CPTAssert(poly.size() == 4);
+    int j = int(poly.boundingBox().min().x()/2.0+0.5);
+    CPTAssert(j >= 0 && j < 5);
+    CPTAssert(poly.boundingBox() == Rect2(2.0*j, 0.0, 2.0*j+1.0, 1.0));
+    CPTAssert(level->color(i)[0] == 0.1*j);
+    CPTAssert(level->color(i)[2] == 1.0);
+  }
+  
+  CPTAssert(level->noRoadmapNodes() == 3);
+  CPTAssert(level->roadmapNode(2).position == Point2(5.5, 0.5));
+  CPTAssert(level->roadmapNode(2).radius == 0.5);
+  CPTAssert(level->noNeighbors(0) == 1);
+  CPTAssert(level->noNeighbors(1) == 2);
+  CPTAssert(level->neighbors(1)[0] == 0 && level->neighbors(1)[1] == 2);
+  level->release();
+  
+  // Truncated and foreign files are rejected
+  FILE* file = fopen(gPath, "r+b");
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fclose(file);
+  CPTAssert(truncate(gPath, size-8) == 0);
+  CPTAssert(LevelFile::load(gPath) == 0);
+  
+  file = fopen(gPath, "wb");
+  fputs("not a level file", file);
+  fclose(file);
+  CPTAssert(LevelFile::load(gPath) == 0);
+  
+  remove(gPath);
+  CPTAssert(LevelFile::load(gPath) == 0);
+  
+  obstacles->release();
+  for (size_t i = 0; i < sprites.size(); ++i)
+    sprites[i]->release();
+  AutoreleasePool::end();
+}
+
+void LevelFileTests::testHierarchy()
+{
+  AutoreleasePool::begin();
+  vector<Shape*> sprites;
+  Shape* obstacles = createObstacles(7, sprites);
+  CPTAssert(LevelFile::save(gPath, obstacles));
+  obstacles->release();
+  
+  LevelFile* level = LevelFile::load(gPath);
+  CPTAssert(level != 0);
+  CPTAssert(level->noObstacles() == 7);
+  CPTAssert(level->noNodes() == 6);
+  CPTAssert(level->noRoadmapNodes() == 0);
+  
+  // Every node surrounds its kids
+  for (int i = 0; i < level->noNodes(); ++i) {
+    const LevelNode& node = level->node(i);
+    int kids[2] = {node.left, node.right};
+    for (int k = 0; k < 2; ++k) {
+      Rect2 box = kids[k] < 0 ? level->polygon(-(kids[k]+1)).boundingBox() : level->node(kids[k]).box;
+      CPTAssert(node.box.surround(box) == node.box);
+    }
+  }
+  
+  // Rebuilt hierarchy finds same obstacles
+  vector<Shape*> loaded;
+  for (int i = 0; i < level->noObstacles(); ++i) {
+    MockView* view = new MockView(level->polygon(i));
+    loaded.push_back(new Sprite(view));
+    view->release();
+  }
+  CPTAssert(level->createObstacles(vector<Shape*>(3)) == 0);
+  Shape* group = level->createObstacles(loaded);
+  CPTAssert(group != 0);
+  CPTAssert(group->boundingBox() == level->boundingBox());
+  CPTAssert(static_cast<ShapeGroup*>(group)->noShapes() == 7);
+  CPTAssert(group->inside(Point2(4.5, 0.5), 0.0, 1.0));
+  CPTAssert(!group->inside(Point2(5.5, 0.5), 0.0, 1.0));
+  group->release();
+  
+  level->release();
+  remove(gPath);
+  for (size_t i = 0; i < sprites.size(); ++i) {
+    sprites[i]->release();
+    loaded[i]->release();
+  }
+  AutoreleasePool::end();
+}
+
+static LevelFileTests test1(TEST_INVOCATION(LevelFileTests, testSaveAndLoad));
+static LevelFileTests test2(TEST_INVOCATION(LevelFileTests, testHierarchy));
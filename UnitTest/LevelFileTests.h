@@ -0,0 +1,20 @@
+/*
+ *  LevelFileTests.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include <CPlusTest/CPlusTest.h>
+
+
+class LevelFileTests : public TestCase {
+public:
+  LevelFileTests(TestInvocation* invocation);
+  virtual ~LevelFileTests();
+    
+  void testSaveAndLoad();
+  void testHierarchy();
+};
@@ -0,0 +1,135 @@
+/*
+ *  PathsCache2Tests.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "PathsCache2Tests.h"
+
+#include <Geometry/PathsCache2.hpp>
+#include <Geometry/TrapezoidalMap2.hpp>
+#include <Geometry/Graph2.hpp>
+
+using namespace std;
+
+// Map with one segment across the middle, giving four trapezoids
+static TrapezoidalMap2* createMap()
+{
+  Segments2 segs;
+  segs.push_back(Segment2(Point2(2.0, 5.0), Point2(8.0, 6.0)));
+  return new TrapezoidalMap2(segs.begin(), segs.end(), Rect2(0.0, 0.0, 10.0, 10.0));
+}
+
+// Roadmap edges between every trapezoid of map and its right neighbors
+static Graph2* createGraph(TrapezoidalMap2& map)
+{
+  int tag = map.assignUniqueTags();
+  Trapezoids2 ts;
+  map.getTrapezoids(ts);
+  EdgePairs edges;
+  for (Trapezoids2::iterator it = ts.begin(); it != ts.end(); ++it) {
+    Trapezoids2 ns = (*it)->rightNeighbors();
+    for (Trapezoids2::iterator n = ns.begin(); n != ns.end(); ++n)
+      edges.push_back(roadmapEdge(*it, *n, tag++));
+  }
+  return Graph2::create(ts.size(), edges.begin(), edges.end());
+}
+
+PathsCache2Tests::PathsCache2Tests(TestInvocation *invocation)
+    : TestCase(invocation)
+{
+}
+
+
+PathsCache2Tests::~PathsCache2Tests()
+{
+}
+
+void PathsCache2Tests::testHit()
+{
+  TrapezoidalMap2* map = createMap();
+  Graph2* graph = createGraph(*map);
+  PathsCache2 cache(graph, 2);
+  Trapezoid2* left = map->locate(Point2(1.0, 5.0));
+  Trapezoid2* right = map->locate(Point2(9.0, 5.0));
+  
+  CPTAssert(!cache.contains(left));
+  Paths2* paths = cache.shortestPaths(left);
+  CPTAssert(paths != 0);
+  CPTAssert(cache.contains(left));
+  CPTAssert(cache.size() == 1);
+  
+  // Same tree is handed out again without a new search
+  CPTAssert(cache.shortestPaths(left) == paths);
+  CPTAssert(cache.size() == 1);
+  CPTAssert(paths->refCount() == 1);
+  
+  Point2 waypoint;
+  CPTAssert(paths->nextFrom(right, waypoint));
+  
+  delete graph;
+  delete map;
+}
+
+void PathsCache2Tests::testEviction()
+{
+  TrapezoidalMap2* map = createMap();
+  Graph2* graph = createGraph(*map);
+  PathsCache2 cache(graph, 2);
+  Trapezoid2* left = map->locate(Point2(1.0, 5.0));
+  Trapezoid2* above = map->locate(Point2(5.0, 8.0));
+  Trapezoid2* below = map->locate(Point2(5.0, 2.0));
+  
+  Paths2* left_paths = cache.shortestPaths(left);
+  cache.shortestPaths(above);
+  
+  // Using left makes above the least recently used, so it goes first
+  CPTAssert(cache.shortestPaths(left) == left_paths);
+  cache.shortestPaths(below);
+  CPTAssert(cache.size() == 2);
+  CPTAssert(cache.contains(left));
+  CPTAssert(cache.contains(below));
+  CPTAssert(!cache.contains(above));
+  
+  // Shrinking evicts least recently used too
+  cache.setCapacity(1);
+  CPTAssert(cache.size() == 1);
+  CPTAssert(cache.contains(below));
+  CPTAssert(!cache.contains(left));
+  
+  delete graph;
+  delete map;
+}
+
+void PathsCache2Tests::testRevision()
+{
+  TrapezoidalMap2* map = createMap();
+  Graph2* graph = createGraph(*map);
+  PathsCache2 cache(graph, 2);
+  Trapezoid2* left = map->locate(Point2(1.0, 5.0));
+  
+  Paths2* paths = cache.shortestPaths(left);
+  paths->retain();
+  
+  // Any change of the graph makes cached trees stale
+  int revision = graph->revision();
+  graph->update(vector<int>(), Trapezoids2());
+  CPTAssert(graph->revision() != revision);
+  CPTAssert(!cache.contains(left));
+  
+  Paths2* new_paths = cache.shortestPaths(left);
+  CPTAssert(new_paths != paths);
+  CPTAssert(cache.size() == 1);
+  CPTAssert(paths->refCount() == 1);
+  paths->release();
+  
+  delete graph;
+  delete map;
+}
+
+static PathsCache2Tests test1(TEST_INVOCATION(PathsCache2Tests, testHit));
+static PathsCache2Tests test2(TEST_INVOCATION(PathsCache2Tests, testEviction));
+static PathsCache2Tests test3(TEST_INVOCATION(PathsCache2Tests, testRevision));
@@ -0,0 +1,21 @@
+/*
+ *  PathsCache2Tests.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 26.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include <CPlusTest/CPlusTest.h>
+
+
+class PathsCache2Tests : public TestCase {
+public:
+  PathsCache2Tests(TestInvocation* invocation);
+  virtual ~PathsCache2Tests();
+    
+  void testHit();
+  void testEviction();
+  void testRevision();
+};
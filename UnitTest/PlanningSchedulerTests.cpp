@@ -0,0 +1,170 @@
+/*
+ *  PlanningSchedulerTests.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 21.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "PlanningSchedulerTests.h"
+
+#include "Timing.h"
+
+#include "Base/PlanningScheduler.h"
+#include "Base/RectShape2.h"
+
+#include <vector>
+
+using namespace std;
+
+// Records order it was resumed in and spins for a given time
+class CountingTask : public PlanningTask
+{
+public:
+  CountingTask(vector<int>& order, int id, int priority, real seconds = 0.0, int steps = 1000)
+    : PlanningTask(priority), iOrder(order), iId(id), iSeconds(seconds), iSteps(steps) {}
+
+  bool resume(real start_time, real deadline) {
+    iOrder.push_back(iId);
+    real end = monotonicSeconds() + iSeconds;
+    while (monotonicSeconds() < end)
+      ;
+    return --iSteps <= 0;
+  }
+
+private:
+  vector<int>& iOrder;
+  int  iId;
+  real iSeconds;
+  int  iSteps;
+};
+
+// Removes another task from the scheduler and then itself
+class RemovingTask : public PlanningTask
+{
+public:
+  RemovingTask(PlanningScheduler* scheduler, PlanningTask* other)
+    : PlanningTask(1), iScheduler(scheduler), iOther(other) {}
+
+  bool resume(real start_time, real deadline) {
+    iScheduler->remove(iOther);
+    iScheduler->remove(this);
+    return false;
+  }
+
+private:
+  PlanningScheduler* iScheduler;
+  PlanningTask*      iOther;
+};
+
+// Shape which counts how often it has been asked to plan
+class PlanningShape : public RectShape2
+{
+public:
+  PlanningShape() : RectShape2(Rect2(0.0, 0.0, 1.0, 1.0)), noPlans(0) {}
+  void doPlanning(real start_time, real delta_time) { ++noPlans; }
+  int noPlans;
+};
+
+PlanningSchedulerTests::PlanningSchedulerTests(TestInvocation *invocation)
+  : TestCase(invocation)
+{
+}
+
+
+PlanningSchedulerTests::~PlanningSchedulerTests()
+{
+}
+
+void PlanningSchedulerTests::testPriority()
+{
+  vector<int> order;
+  PlanningScheduler* scheduler = new PlanningScheduler(100000);
+  PlanningTask* tasks[3] = {
+    new CountingTask(order, 0, 0), new CountingTask(order, 1, 2), new CountingTask(order, 2, 1)
+  };
+  for (int i = 0; i < 3; ++i) {
+    scheduler->add(tasks[i]);
+    tasks[i]->release();
+  }
+  scheduler->add(tasks[0]);
+  CPTAssert(scheduler->size() == 3);
+
+  CPTAssert(scheduler->run(0.0) == 3);
+  CPTAssert(order.size() == 3);
+  CPTAssert(order[0] == 1 && order[1] == 2 && order[2] == 0);
+  scheduler->release();
+}
+
+void PlanningSchedulerTests::testBudget()
+{
+  vector<int> order;
+  PlanningScheduler* scheduler = new PlanningScheduler;
+  for (int i = 0; i < 4; ++i) {
+    PlanningTask* task = new CountingTask(order, i, 0, 0.002, 2);
+    scheduler->add(task);
+    task->release();
+  }
+
+  // Each task takes 2 ms, so a 3 ms budget only gets through two
+  CPTAssert(scheduler->run(0.0, 3000) == 2);
+  CPTAssert(scheduler->run(0.0, 3000) == 2);
+  CPTAssert(order.size() == 4);
+  CPTAssert(order[0] == 0 && order[1] == 1 && order[2] == 2 && order[3] == 3);
+
+  // Tasks waiting longest go first, and each finishes on its second resume
+  CPTAssert(scheduler->run(0.0, 100000) == 4);
+  CPTAssert(order[4] == 0 && order[5] == 1 && order[6] == 2 && order[7] == 3);
+  CPTAssert(scheduler->empty());
+  scheduler->release();
+}
+
+void PlanningSchedulerTests::testRemoveWhileRunning()
+{
+  vector<int> order;
+  PlanningScheduler* scheduler = new PlanningScheduler(100000);
+  PlanningTask* other = new CountingTask(order, 0, 0);
+  PlanningTask* remover = new RemovingTask(scheduler, other);
+  scheduler->add(other);
+  scheduler->add(remover);
+  other->release();
+  remover->release();
+
+  CPTAssert(scheduler->run(0.0) == 1);
+  CPTAssert(order.empty());
+  CPTAssert(scheduler->empty());
+  scheduler->release();
+}
+
+void PlanningSchedulerTests::testShapeTask()
+{
+  PlanningScheduler* scheduler = new PlanningScheduler(100000);
+  PlanningShape* shape = new PlanningShape;
+  PlanningTask* task = new ShapePlanningTask(shape);
+  scheduler->add(task);
+  task->release();
+
+  scheduler->run(0.0);
+  scheduler->run(0.0);
+  CPTAssert(shape->noPlans == 2);
+
+  shape->kill();
+  CPTAssert(scheduler->run(0.0) == 1);
+  CPTAssert(shape->noPlans == 2);
+  CPTAssert(scheduler->empty());
+
+  task = new ShapePlanningTask(shape);
+  scheduler->add(task);
+  task->release();
+  scheduler->remove(shape);
+  CPTAssert(scheduler->empty());
+
+  shape->release();
+  scheduler->release();
+}
+
+static PlanningSchedulerTests test1(TEST_INVOCATION(PlanningSchedulerTests, testPriority));
+static PlanningSchedulerTests test2(TEST_INVOCATION(PlanningSchedulerTests, testBudget));
+static PlanningSchedulerTests test3(TEST_INVOCATION(PlanningSchedulerTests, testRemoveWhileRunning));
+static PlanningSchedulerTests test4(TEST_INVOCATION(PlanningSchedulerTests, testShapeTask));
@@ -0,0 +1,22 @@
+/*
+ *  PlanningSchedulerTests.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 21.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include <CPlusTest/CPlusTest.h>
+
+
+class PlanningSchedulerTests : public TestCase {
+public:
+  PlanningSchedulerTests(TestInvocation* invocation);
+  virtual ~PlanningSchedulerTests();
+    
+  void testPriority();
+  void testBudget();
+  void testRemoveWhileRunning();
+  void testShapeTask();
+};
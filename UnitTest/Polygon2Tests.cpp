@@ -10,8 +10,11 @@
 #include "Polygon2Tests.h"
 
 #include "Geometry/Polygon2.hpp"
+#include "Utils/PolygonUtils.h"
 
 #include <numeric>
+#include <algorithm>
+#include <cmath>
 
 using namespace std;
 
@@ -56,7 +59,82 @@ void Polygon2Tests::testMinkowski()
 
   CPTAssert(result[0] == Vector2(-1.0, -1.0));
   CPTAssert(result[2] == Vector2(2.0, 2.0));  
+
+  // Edges of a triangle and a square make a pentagon
+  Point2 corners[] = { Point2(0.0, 0.0), Point2(1.0, 0.0), Point2(0.0, 1.0) };
+  Polygon2 triangle(corners, corners+3);
+  Polygon2 square(Rect2(0.0, 0.0, 1.0, 1.0));
+  result.clear();
+  triangle.minkowskiSum(square, result);
+  
+  CPTAssert(result.size() == 5);
+  CPTAssert(result[0] == Vector2(0.0, 0.0));
+  CPTAssert(result[1] == Vector2(2.0, 0.0));
+  CPTAssert(result[2] == Vector2(2.0, 1.0));
+  CPTAssert(result[3] == Vector2(1.0, 2.0));
+  CPTAssert(result[4] == Vector2(0.0, 2.0));
+}
+
+static real area(const Polygon2& poly)
+{
+  real a = 0.0;
+  for (int i = 0; i < poly.size(); ++i)
+    a += poly[i].cross(poly[(i+1) % poly.size()]);
+  return a/2.0;
+}
+
+void Polygon2Tests::testConvexParts()
+{
+  // U shape, clockwise and counter clockwise
+  Point2 corners[] = { 
+    Point2(0.0, 0.0), Point2(3.0, 0.0), Point2(3.0, 3.0), Point2(2.0, 3.0),
+    Point2(2.0, 1.0), Point2(1.0, 1.0), Point2(1.0, 3.0), Point2(0.0, 3.0) 
+  };
+  Polygon2 u(corners, corners+8);
+  Points2 reversed(corners, corners+8);
+  reverse(reversed.begin(), reversed.end());
+  Polygon2 u_cw(reversed.begin(), reversed.end());
+  CPTAssert(!u.isConvex());
+  
+  Polygon2* shapes[] = { &u, &u_cw };
+  for (int k = 0; k < 2; ++k) {
+    Polygons2 parts;
+    shapes[k]->convexParts(parts);
+    CPTAssert(parts.size() >= 3 && parts.size() <= 4);
+    
+    real total = 0.0;
+    for (Polygons2::iterator p = parts.begin(); p != parts.end(); ++p) {
+      CPTAssert(p->isConvex());
+      CPTAssert(area(*p) > 0.0);
+      total += area(*p);
+    }
+    CPTAssert(fabs(total - 7.0) < 1e-9);
+    
+    // Point in the gap of the U is in no part
+    int inside = 0, gap = 0;
+    for (Polygons2::iterator p = parts.begin(); p != parts.end(); ++p) {
+      inside += p->inside(Point2(0.5, 2.5));
+      gap += p->inside(Point2(1.5, 2.5));
+    }
+    CPTAssert(inside == 1);
+    CPTAssert(gap == 0);
+  }
+  
+  // Convex polygon is its own part, straight corners too
+  Point2 square[] = { Point2(0.0, 0.0), Point2(1.0, 0.0), Point2(2.0, 0.0), Point2(2.0, 2.0), Point2(0.0, 2.0) };
+  Polygon2 convex(square, square+5);
+  Polygons2 parts;
+  CPTAssert(convex.isConvex());
+  convex.convexParts(parts);
+  CPTAssert(parts.size() == 1 && parts[0] == convex);
+  
+  // Star turns the same way at every corner, but twice round
+  Points2 star;
+  for (int i = 0; i < 5; ++i)
+    star.push_back(Point2(cos(rad(90.0 + 144.0*i)), sin(rad(90.0 + 144.0*i))));
+  CPTAssert(!Polygon2(star.begin(), star.end()).isConvex());
 }
 
 static Polygon2Tests test1(TEST_INVOCATION(Polygon2Tests, testIntersections));
 static Polygon2Tests test2(TEST_INVOCATION(Polygon2Tests, testMinkowski));
+static Polygon2Tests test3(TEST_INVOCATION(Polygon2Tests, testConvexParts));
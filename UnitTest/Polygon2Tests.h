@@ -17,4 +17,5 @@ public:
     
     void testIntersections();
     void testMinkowski();    
+    void testConvexParts();
 };
\ No newline at end of file
@@ -0,0 +1,116 @@
+/*
+ *  ProfilerTests.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 23.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "ProfilerTests.h"
+
+#include "Utils/Profiler.h"
+
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+static void inner()
+{
+  PROFILE_ZONE("inner");
+  usleep(1000);
+}
+
+static void outer(int noInner)
+{
+  PROFILE_ZONE("outer");
+  for (int i = 0; i < noInner; ++i)
+    inner();
+}
+
+ProfilerTests::ProfilerTests(TestInvocation *invocation)
+    : TestCase(invocation)
+{
+}
+
+
+ProfilerTests::~ProfilerTests()
+{
+}
+
+void ProfilerTests::testNestedZones()
+{
+  setProfilingEnabled(true);
+  profileReset();
+  
+  // Frames with 2, 0 and 1 calls to inner zone
+  outer(2);
+  profileEndFrame();
+  outer(0);
+  profileEndFrame();
+  outer(1);
+  inner();
+  profileEndFrame();
+  
+  ZoneStatsList stats;
+  profileStats(stats);
+  CPTAssert(stats.size() == 3);
+  CPTAssert(stats[0].name == "outer" && stats[0].depth == 0);
+  CPTAssert(stats[1].name == "inner" && stats[1].depth == 1);
+  CPTAssert(stats[2].name == "inner" && stats[2].depth == 0);
+  
+  CPTAssert(stats[0].calls == 1.0);
+  CPTAssert(stats[1].calls == 1.0);
+  CPTAssert(stats[1].min == 0.0);
+  CPTAssert(stats[1].max >= 0.002);
+  CPTAssert(stats[1].p99 == stats[1].max);
+  CPTAssert(stats[1].avg > stats[1].min && stats[1].avg < stats[1].max);
+  CPTAssert(stats[0].max >= stats[1].max);
+  
+  // Zone first seen in last frame only counts that frame
+  CPTAssert(stats[2].calls == 1.0);
+  CPTAssert(stats[2].min == stats[2].max);
+  
+  CPTAssert(profileReport().find("  inner") != string::npos);
+  
+  profileReset();
+  profileStats(stats);
+  CPTAssert(stats.empty());
+  setProfilingEnabled(false);
+}
+
+void ProfilerTests::testDisabled()
+{
+  setProfilingEnabled(false);
+  profileReset();
+  outer(1);
+  profileEndFrame();
+  
+  ZoneStatsList stats;
+  profileStats(stats);
+  CPTAssert(stats.empty());
+}
+
+void ProfilerTests::testChromeTrace()
+{
+  setProfilingEnabled(true);
+  outer(1);
+  setProfilingEnabled(false);
+  
+  const char* path = "/tmp/lusion_profiler_test.json";
+  CPTAssert(saveChromeTrace(path));
+  ifstream in(path);
+  stringstream text;
+  text << in.rdbuf();
+  CPTAssert(text.str().find("\"traceEvents\":[") != string::npos);
+  CPTAssert(text.str().find("{\"name\":\"outer\",\"cat\":\"lusion\",\"ph\":\"X\"") != string::npos);
+  CPTAssert(text.str().find("{\"name\":\"inner\"") != string::npos);
+  remove(path);
+}
+
+static ProfilerTests test1(TEST_INVOCATION(ProfilerTests, testNestedZones));
+static ProfilerTests test2(TEST_INVOCATION(ProfilerTests, testDisabled));
+static ProfilerTests test3(TEST_INVOCATION(ProfilerTests, testChromeTrace));
@@ -0,0 +1,21 @@
+/*
+ *  ProfilerTests.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 23.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include <CPlusTest/CPlusTest.h>
+
+
+class ProfilerTests : public TestCase {
+public:
+  ProfilerTests(TestInvocation* invocation);
+  virtual ~ProfilerTests();
+    
+  void testNestedZones();
+  void testDisabled();
+  void testChromeTrace();
+};
@@ -0,0 +1,128 @@
+/*
+ *  ReplayTests.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 22.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "ReplayTests.h"
+
+#include "World.h"
+#include "Replay.h"
+
+#include "Utils/Random.h"
+
+#include <cstdio>
+
+using namespace std;
+
+ReplayTests::ReplayTests(TestInvocation *invocation)
+    : TestCase(invocation)
+{
+}
+
+
+ReplayTests::~ReplayTests()
+{
+}
+
+void ReplayTests::testRandom()
+{
+  Random a(42), b(42), c(43);
+  bool differs = false;
+  for (int i = 0; i < 100; ++i) {
+    uint32 x = a.next();
+    CPTAssert(x == b.next());
+    differs = differs || x != c.next();
+  }
+  CPTAssert(differs);
+  
+  // Reseeding restarts sequence
+  a.setSeed(7);
+  uint32 first = a.next();
+  a.setSeed(7);
+  CPTAssert(a.next() == first);
+  CPTAssert(a.seed() == 7);
+  
+  // Zero seed still gives numbers
+  Random z(0);
+  CPTAssert(z.next() != 0 || z.next() != 0);
+  
+  for (int i = 0; i < 1000; ++i) {
+    real r = a.uniform();
+    CPTAssert(r >= 0.0 && r < 1.0);
+    int n = a.uniform(-3, 3);
+    CPTAssert(n >= -3 && n <= 3);
+  }
+  CPTAssert(a.uniform(5, 5) == 5);
+}
+
+void ReplayTests::testSaveLoad()
+{
+  Replay* replay = new Replay;
+  replay->setSeed(1234);
+  replay->setTicksPerFrame(16);
+  replay->addKeyEvent(0, 'A', true);
+  replay->addKeyEvent(3, 0x01000012, true);
+  replay->addKeyEvent(3, 'A', false);
+  replay->setNoSteps(10);
+  
+  const char* path = "/tmp/lusion_replay_test.lrp";
+  CPTAssert(replay->save(path));
+  Replay* loaded = Replay::load(path);
+  CPTAssert(loaded != 0);
+  CPTAssert(loaded->seed() == 1234);
+  CPTAssert(loaded->ticksPerFrame() == 16);
+  CPTAssert(loaded->noSteps() == 10);
+  CPTAssert(loaded->keyEvents().size() == 3);
+  CPTAssert(loaded->keyEvents()[1].step == 3);
+  CPTAssert(loaded->keyEvents()[1].key == 0x01000012);
+  CPTAssert(loaded->keyEvents()[1].pressed);
+  CPTAssert(!loaded->keyEvents()[2].pressed);
+  loaded->release();
+  
+  // Any other file is rejected
+  FILE* file = fopen(path, "wb");
+  fputs("not a replay file", file);
+  fclose(file);
+  CPTAssert(Replay::load(path) == 0);
+  
+  remove(path);
+  CPTAssert(Replay::load(path) == 0);
+  replay->release();
+}
+
+void ReplayTests::testRecordAndPlay()
+{
+  Replay* recording = new Replay;
+  World world;
+  world.setRandomSeed(99);
+  world.setTicksPerFrame(20);
+  world.record(recording);
+  world.reset();
+  CPTAssert(world.run(5) == 5);
+  CPTAssert(recording->seed() == 99);
+  CPTAssert(recording->ticksPerFrame() == 20);
+  CPTAssert(recording->noSteps() == 5);
+  world.record(0);
+  
+  // Playback reseeds random numbers, sets step length and ends with replay
+  World other;
+  other.setTicksPerFrame(30);
+  other.play(recording);
+  other.reset();
+  CPTAssert(other.random().seed() == 99);
+  CPTAssert(other.run() == 5);
+  CPTAssert(other.isDone());
+  CPTAssert(other.ticksPerFrame() == 20);
+  other.play(0);
+  
+  recording->release();
+  World::mainWorld()->makeCurrent();
+}
+
+static ReplayTests test1(TEST_INVOCATION(ReplayTests, testRandom));
+static ReplayTests test2(TEST_INVOCATION(ReplayTests, testSaveLoad));
+static ReplayTests test3(TEST_INVOCATION(ReplayTests, testRecordAndPlay));
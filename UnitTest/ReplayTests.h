@@ -0,0 +1,21 @@
+/*
+ *  ReplayTests.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 22.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include <CPlusTest/CPlusTest.h>
+
+
+class ReplayTests : public TestCase {
+public:
+  ReplayTests(TestInvocation* invocation);
+  virtual ~ReplayTests();
+    
+  void testRandom();
+  void testSaveLoad();
+  void testRecordAndPlay();
+};
@@ -15,9 +15,11 @@
 #include "Base/SegmentShape2.h"
 #include "Base/ShapeGroup.h"
 #include "Base/Action.h"
+#include "Base/ContactBuffer.h"
 #include "Base/Group.h"
 
 #include "Core/AutoreleasePool.hpp"
+#include "World.h"
 
 #include "MockView.h"
 
@@ -254,8 +256,160 @@ void SpriteTests::testSpecialIntersect()
   AutoreleasePool::end();  
 }
 
+void SpriteTests::testContactBuffer()
+{
+  AutoreleasePool::begin();
+  Sprite* sprite = new Sprite(new MockView);
+  RectShape2* r1 = new RectShape2(Rect2(Vector2(0.0f, 0.0f), Vector2(6.0f, 6.0f)));
+  RectShape2* r2 = new RectShape2(Rect2(Vector2(6.0f, 6.0f), Vector2(10.0f, 10.0f)));
+  ContactBuffer* contacts = new ContactBuffer;
+  
+  // Collisions given explicit buffer are recorded, not handled
+  CPTAssert(sprite->collide(r1, t, dt, contacts));
+  CPTAssert(!sprite->collide(r2, t, dt, contacts));
+  CPTAssert(contacts->size() == 1);
+  CPTAssert(contacts->contact(0).me == sprite);
+  CPTAssert(contacts->contact(0).other == r1);
+  CPTAssert(contacts->contact(0).time == t);  
+  CPTAssert(r1->refCount() == 2);
+  
+  // Buffer as collision action of sprite
+  sprite->setCollisionAction(contacts);
+  CPTAssert(sprite->collide(r1, t+dt, dt));
+  CPTAssert(contacts->size() == 2);
+  CPTAssert(contacts->contact(1).time == t+dt);  
+  
+  contacts->clear();
+  CPTAssert(contacts->empty());
+  CPTAssert(r1->refCount() == 1);
+  
+  sprite->release();
+  r1->release();
+  r2->release();
+  contacts->release();
+  AutoreleasePool::end();  
+}
+
+void SpriteTests::testConcaveIntersect()
+{
+  AutoreleasePool::begin();
+  
+  // U shaped obstacle, things in its gap must not collide with it
+  Point2 corners[] = { 
+    Point2(0.0, 0.0), Point2(3.0, 0.0), Point2(3.0, 3.0), Point2(2.0, 3.0),
+    Point2(2.0, 1.0), Point2(1.0, 1.0), Point2(1.0, 3.0), Point2(0.0, 3.0) 
+  };
+  View* view = new MockView(Polygon2(corners, corners+8));
+  CPTAssert(view->collisionParts().size() >= 3);
+  Sprite* obstacle = new Sprite(view);
+  obstacle->setPosition(Vector2(10.0, 0.0));
+  
+  CircleShape* in_gap = new CircleShape(Circle(Vector2(11.5, 2.5), 0.3));
+  CircleShape* on_side = new CircleShape(Circle(Vector2(10.9, 2.5), 0.3));
+  CPTAssert(!obstacle->collide(in_gap, t, dt));
+  CPTAssert(obstacle->collide(on_side, t, dt));
+  CPTAssert(!obstacle->inside(Point2(11.5, 2.5), t, dt));
+  CPTAssert(obstacle->inside(Point2(12.5, 2.5), t, dt));
+  
+  SegmentShape2* across = new SegmentShape2(Segment2(Vector2(11.2, 1.5), Vector2(11.8, 2.8)));
+  CPTAssert(!obstacle->collide(across, t, dt));
+  
+  // Sprite in the gap, tested both ways
+  Sprite* ship = new Sprite(new MockView(Polygon2(Rect2(-0.3, -0.3, 0.3, 0.3))));
+  ship->setPosition(Vector2(11.5, 2.0));
+  CPTAssert(!ship->collide(obstacle, t, dt));
+  CPTAssert(!obstacle->collide(ship, t, dt));
+  ship->setPosition(Vector2(11.5, 0.5));
+  CPTAssert(ship->collide(obstacle, t, dt));
+  CPTAssert(obstacle->collide(ship, t, dt));
+  
+  // Parts move with the sprite
+  obstacle->setPosition(Vector2(0.0, 0.0));
+  ship->setPosition(Vector2(1.5, 2.0));
+  CPTAssert(obstacle->inside(Point2(0.5, 0.5), t, dt));
+  CPTAssert(!obstacle->inside(Point2(1.5, 2.5), t, dt));
+  CPTAssert(!obstacle->collide(ship, t, dt));
+  
+  ship->release();
+  across->release();
+  in_gap->release();
+  on_side->release();
+  obstacle->release();
+  
+  AutoreleasePool::end();  
+}
+
+// Keeps contact points
+struct ContactCmd : public CollisionAction {
+  bool execute(Shape* me, Shape* other, Points2& points, real start_time, real delta_time) {
+    contacts = points;
+    return true;
+  }
+  
+  Points2 contacts;
+};
+
+void SpriteTests::testGjkNarrowPhase()
+{
+  AutoreleasePool::begin();
+  World::current()->setNarrowPhase(GJK_NARROW_PHASE);
+  
+  Point2 corners[] = { 
+    Point2(0.0, 0.0), Point2(3.0, 0.0), Point2(3.0, 3.0), Point2(2.0, 3.0),
+    Point2(2.0, 1.0), Point2(1.0, 1.0), Point2(1.0, 3.0), Point2(0.0, 3.0) 
+  };
+  View* view = new MockView(Polygon2(corners, corners+8));
+  Sprite* obstacle = new Sprite(view);
+  obstacle->setPosition(Vector2(10.0, 0.0));
+  CPTAssert(obstacle->noConvexParts() == int(obstacle->collisionParts().size()));
+  
+  // Shapes are solid, so a circle wholly inside collides too
+  CircleShape* in_gap = new CircleShape(Circle(Vector2(11.5, 2.5), 0.3));
+  CircleShape* on_side = new CircleShape(Circle(Vector2(10.9, 2.5), 0.3));
+  CircleShape* within = new CircleShape(Circle(Vector2(10.5, 0.5), 0.2));
+  CPTAssert(!obstacle->collide(in_gap, t, dt));
+  CPTAssert(!in_gap->collide(obstacle, t, dt));
+  CPTAssert(obstacle->collide(on_side, t, dt));
+  CPTAssert(obstacle->collide(within, t, dt));
+  CPTAssert(within->collide(obstacle, t, dt));
+  
+  SegmentShape2* across = new SegmentShape2(Segment2(Vector2(11.2, 1.5), Vector2(11.8, 2.8)));
+  CPTAssert(!obstacle->collide(across, t, dt));
+  RectShape2* box = new RectShape2(Rect2(12.5, 2.5, 14.0, 4.0));
+  CPTAssert(obstacle->collide(box, t, dt));
+  
+  // Sprites, where contact point is in both
+  Sprite* ship = new Sprite(new MockView(Polygon2(Rect2(-0.3, -0.3, 0.3, 0.3))));
+  ContactCmd cmd;
+  for (int i = 0; i < 10; ++i) {
+    ship->setPosition(Vector2(11.5, 2.0 - 0.15*i));
+    bool hit = ship->position().y() - 0.3 < 1.0;
+    CPTAssert(ship->collide(obstacle, t, dt, &cmd) == hit);
+    CPTAssert(obstacle->collide(ship, t, dt) == hit);
+  }
+  CPTAssert(!cmd.contacts.empty());
+  CPTAssert(obstacle->collisionPolygon().inside(cmd.contacts[0]));
+  CPTAssert(ship->collisionPolygon().inside(cmd.contacts[0]));
+  
+  World::current()->setNarrowPhase(SAT_NARROW_PHASE);
+  CPTAssert(!obstacle->collide(within, t, dt));
+  
+  ship->release();
+  box->release();
+  across->release();
+  within->release();
+  in_gap->release();
+  on_side->release();
+  obstacle->release();
+  
+  AutoreleasePool::end();  
+}
+
 static SpriteTests test1(TEST_INVOCATION(SpriteTests, testIntersections));
 static SpriteTests test2(TEST_INVOCATION(SpriteTests, testTrickyIntersections));
 static SpriteTests test3(TEST_INVOCATION(SpriteTests, testMoving));
 static SpriteTests test4(TEST_INVOCATION(SpriteTests, testHierarchyIntersect));
-static SpriteTests test5(TEST_INVOCATION(SpriteTests, testSpecialIntersect));
\ No newline at end of file
+static SpriteTests test5(TEST_INVOCATION(SpriteTests, testSpecialIntersect));
+static SpriteTests test6(TEST_INVOCATION(SpriteTests, testContactBuffer));
+static SpriteTests test7(TEST_INVOCATION(SpriteTests, testConcaveIntersect));
+static SpriteTests test8(TEST_INVOCATION(SpriteTests, testGjkNarrowPhase));
\ No newline at end of file
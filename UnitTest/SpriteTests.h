@@ -20,4 +20,7 @@ public:
     void testMoving();
     void testHierarchyIntersect();
     void testSpecialIntersect();
+    void testContactBuffer();
+    void testConcaveIntersect();
+    void testGjkNarrowPhase();
 };
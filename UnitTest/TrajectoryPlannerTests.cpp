@@ -0,0 +1,283 @@
+/*
+ *  TrajectoryPlannerTests.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 16.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "TrajectoryPlannerTests.h"
+
+#include "Base/TrajectoryTable.h"
+#include "Base/TrajectoryPlanner.h"
+#include "Base/MotionState.h"
+#include "Base/RectShape2.h"
+#include "Base/Sprite.h"
+#include "UnitTest/MockView.h"
+#include "Core/AutoreleasePool.hpp"
+#include "Timing.h"
+#include "World.h"
+#include "Replay.h"
+
+#include <cmath>
+#include <cstdio>
+
+using namespace std;
+
+TrajectoryPlannerTests::TrajectoryPlannerTests(TestInvocation *invocation)
+    : TestCase(invocation)
+{
+}
+
+
+TrajectoryPlannerTests::~TrajectoryPlannerTests()
+{
+}
+
+void TrajectoryPlannerTests::testTable()
+{
+  MotionState s0(Point2(0.0, 0.0), 0.0, 10.0);
+  TrajectoryTable table(s0, -300.0, 300.0, 2, 0.1, 10);
+  
+  CPTAssert(table.size() == 3);
+  CPTAssert(table.angularVelocity(1) == 0.0);
+  CPTAssert(table.index(-300.0) == 0 && table.index(10.0) == 1 && table.index(1000.0) == 2);
+  
+  // Going straight ahead should move speed*duration along x axis
+  const Trajectory& straight = table.trajectory(1, 1);
+  CPTAssert(fabs(straight.position.x() - 10.0) < 1e-6);
+  CPTAssert(fabs(straight.position.y()) < 1e-6);
+  CPTAssert(straight.rotation == 0.0);
+  
+  // Turning trajectories should be mirror images of each other
+  const Trajectory& left = table.trajectory(1, 2);
+  const Trajectory& right = table.trajectory(1, 0);
+  CPTAssert(fabs(left.position.y() + right.position.y()) < 1e-6);
+  CPTAssert(left.angVelocity == 300.0 && right.angVelocity == -300.0);
+  
+  // End state should take start orientation into account
+  MotionState from(Point2(1.0, 1.0), 90.0, 10.0);
+  MotionState to;
+  table.endState(from, straight, to);
+  CPTAssert(fabs(to.position().x() - 1.0) < 1e-6);
+  CPTAssert(fabs(to.position().y() - 11.0) < 1e-6);
+}
+
+void TrajectoryPlannerTests::testSaveLoad()
+{
+  MotionState s0(Point2(0.0, 0.0), 0.0, 10.0);
+  TrajectoryTable* table = new TrajectoryTable(s0, -300.0, 300.0, 4, 0.1, 10);
+  CPTAssert(table->noSamples() == 11 && !table->isMapped());
+  
+  // Last sample should be end of trajectory and first at origin
+  const TrajectorySample* samples = table->samples(1, 3);
+  const Trajectory& traj = table->trajectory(1, 3);
+  CPTAssert(samples[0].position == Point2(0.0, 0.0) && samples[0].rotation == 0.0);
+  CPTAssert(samples[10].position == traj.position && samples[10].rotation == traj.rotation);
+  
+  string path = "/tmp/lusion_trajectories_test.bin";
+  CPTAssert(table->save(path));
+  
+  TrajectoryTable* loaded = TrajectoryTable::load(path);
+  CPTAssert(loaded != 0);
+  CPTAssert(loaded->isMapped());
+  CPTAssert(loaded->size() == table->size() && loaded->noSteps() == table->noSteps());
+  CPTAssert(loaded->speed() == table->speed() && loaded->index(160.0) == table->index(160.0));
+  for (int i = 0; i < table->size(); ++i) {
+    for (int j = 0; j < table->size(); ++j) {
+      CPTAssert(loaded->trajectory(i, j).position == table->trajectory(i, j).position);
+      CPTAssert(loaded->trajectory(i, j).angVelocity == table->trajectory(i, j).angVelocity);
+      CPTAssert(loaded->samples(i, j)[5].position == table->samples(i, j)[5].position);
+    }
+  }
+  loaded->release();
+  
+  CPTAssert(TrajectoryTable::load("/tmp/lusion_no_such_file.bin") == 0);
+  
+  // Table with a single angular velocity has no delta to index by
+  TrajectoryTable* flat = new TrajectoryTable(s0, 100.0, 100.0, 4, 0.1, 10);
+  CPTAssert(flat->save(path));
+  CPTAssert(TrajectoryTable::load(path) == 0);
+  flat->release();
+  
+  table->release();
+  remove(path.c_str());
+}
+
+void TrajectoryPlannerTests::testSweepCollisions()
+{
+  AutoreleasePool::begin();
+  
+  MotionState s0(Point2(0.0, 0.0), 0.0, 10.0);
+  TrajectoryTable table(s0, -90.0, 90.0, 2, 0.1, 10);
+  MockView* view = new MockView;
+  vector<real> times;
+  
+  // Wall is passed half way along straight trajectory, but not at its end
+  RectShape2* wall = new RectShape2(Rect2(Vector2(4.5, -1.0), Vector2(5.5, 1.0)));
+  uint32 mask = table.sweepCollisions(s0, view->collisionPolygon(), wall, times);
+  CPTAssert(times.size() == 3);
+  CPTAssert(mask & (1u << 1));
+  CPTAssert(times[1] > 0.0 && times[1] < table.duration());
+  
+  // Same wall seen from a state turned away from it
+  MotionState turned(Point2(0.0, 0.0), 180.0, 10.0);
+  CPTAssert(table.sweepCollisions(turned, view->collisionPolygon(), wall, times) == 0);
+  CPTAssert(times[0] == REAL_MAX && times[1] == REAL_MAX && times[2] == REAL_MAX);
+  
+  // Post stays in the notch of a concave shape and is never touched
+  Point2 channel[] = { 
+    Point2(-21.0, -3.0), Point2(0.0, -3.0), Point2(0.0, -2.0), Point2(-20.0, -2.0),
+    Point2(-20.0, 2.0), Point2(0.0, 2.0), Point2(0.0, 3.0), Point2(-21.0, 3.0)
+  };
+  MockView* post_view = new MockView(Polygon2(Rect2(-5.0, -0.5, -4.0, 0.5)));
+  Sprite* post = new Sprite(post_view);
+  table.sweepCollisions(s0, Polygon2(channel, channel+8), post, times);
+  CPTAssert(times[1] == REAL_MAX);
+  
+  // Parts cached by a view give the same result as the concave polygon
+  MockView* channel_view = new MockView(Polygon2(channel, channel+8));
+  CPTAssert(channel_view->collisionParts().size() > 1);
+  vector<real> part_times;
+  table.sweepCollisions(s0, channel_view->collisionParts(), post, part_times);
+  CPTAssert(part_times == times);
+  
+  channel_view->release();
+  post->release();
+  post_view->release();
+  wall->release();
+  view->release();
+  
+  AutoreleasePool::end();
+}
+
+void TrajectoryPlannerTests::testSeek()
+{
+  AutoreleasePool::begin();
+  
+  MotionState s0(Point2(0.0, 0.0), 0.0, 10.0);
+  TrajectoryTable* table = new TrajectoryTable(s0, -90.0, 90.0, 4, 0.1, 10);
+  RectShape2* far_away = new RectShape2(Rect2(Vector2(100.0, 100.0), Vector2(101.0, 101.0)));
+  MockView* view = new MockView;
+  
+  TrajectoryPlanner* planner = new TrajectoryPlanner(table, view, far_away);
+  SeekGoodness* seek = new SeekGoodness(Point2(0.0, 40.0));
+  planner->setGoodness(seek);
+  
+  PlanStates path;
+  CPTAssert(planner->plan(s0, 3, secondsPassed(), 10.0, path));
+  CPTAssert(!path.empty() && path.size() <= 3);
+  CPTAssert(planner->states().size() > path.size());
+  
+  // Target is straight left so we should turn left and approach it
+  CPTAssert(path.front().angVelocity > 0.0);
+  CPTAssert(path.back().position.y() > 0.0);
+  for (size_t i = 0; i < path.size(); ++i)
+    CPTAssert(path[i].depth == int(i+1) && !path[i].collides);
+  
+  seek->release();
+  planner->release();
+  view->release();
+  far_away->release();
+  table->release();
+  
+  AutoreleasePool::end();
+}
+
+void TrajectoryPlannerTests::testAvoidCollision()
+{
+  AutoreleasePool::begin();
+  
+  MotionState s0(Point2(0.0, 0.0), 0.0, 10.0);
+  TrajectoryTable* table = new TrajectoryTable(s0, -90.0, 90.0, 4, 0.1, 10);
+  RectShape2* wall = new RectShape2(Rect2(Vector2(9.5, -1.0), Vector2(10.5, 1.0)));
+  MockView* view = new MockView;
+  
+  TrajectoryPlanner* planner = new TrajectoryPlanner(table, view, wall);
+  CombinedGoodness* combined = new CombinedGoodness;
+  SeekGoodness* seek = new SeekGoodness(Point2(100.0, 0.0));
+  AvoidCollisionGoodness* avoid = new AvoidCollisionGoodness;
+  combined->add(0.1, seek);
+  combined->add(1.0, avoid);
+  planner->setGoodness(combined);
+  
+  PlanStates path;
+  CPTAssert(planner->plan(s0, 1, secondsPassed(), 10.0, path));
+  CPTAssert(path.size() == 1);
+  CPTAssert(!path.front().collides);
+  CPTAssert(path.front().angVelocity != 0.0);
+  
+  // Straight ahead should have been flagged as colliding
+  const PlanStates& states = planner->states();
+  bool straight_collides = false;
+  for (size_t i = 1; i < states.size(); ++i) {
+    if (states[i].angVelocity == 0.0)
+      straight_collides = states[i].collides;
+  }
+  CPTAssert(straight_collides);
+  
+  avoid->release();
+  seek->release();
+  combined->release();
+  planner->release();
+  view->release();
+  wall->release();
+  table->release();
+  
+  AutoreleasePool::end();
+}
+
+void TrajectoryPlannerTests::testDeterministic()
+{
+  AutoreleasePool::begin();
+  
+  MotionState s0(Point2(0.0, 0.0), 0.0, 10.0);
+  TrajectoryTable* table = new TrajectoryTable(s0, -90.0, 90.0, 4, 0.1, 10);
+  RectShape2* far_away = new RectShape2(Rect2(Vector2(100.0, 100.0), Vector2(101.0, 101.0)));
+  MockView* view = new MockView;
+  TrajectoryPlanner* planner = new TrajectoryPlanner(table, view, far_away);
+  SeekGoodness* seek = new SeekGoodness(Point2(0.0, 40.0));
+  planner->setGoodness(seek);
+  planner->setMaxExpansions(5);
+  
+  // Without time left a search normally expands nothing
+  PlanStates path;
+  planner->plan(s0, 4, 0.0, 0.0, path);
+  CPTAssert(planner->noExpanded() == 0);
+  
+  // While recording the same number of states is expanded whatever the time
+  Replay* replay = new Replay;
+  World world;
+  world.makeCurrent();
+  world.record(replay);
+  CPTAssert(world.isDeterministic());
+  CPTAssert(planner->plan(s0, 4, 0.0, 0.0, path));
+  CPTAssert(planner->noExpanded() == 5);
+  size_t no_states = planner->states().size();
+  PlanStates again;
+  CPTAssert(planner->plan(s0, 4, 0.0, 10.0, again));
+  CPTAssert(planner->noExpanded() == 5 && planner->states().size() == no_states);
+  CPTAssert(again.size() == path.size());
+  for (size_t i = 0; i < path.size(); ++i)
+    CPTAssert(again[i].position == path[i].position);
+  world.record(0);
+  CPTAssert(!world.isDeterministic());
+  World::mainWorld()->makeCurrent();
+  
+  replay->release();
+  seek->release();
+  planner->release();
+  view->release();
+  far_away->release();
+  table->release();
+  
+  AutoreleasePool::end();
+}
+
+static TrajectoryPlannerTests test1(TEST_INVOCATION(TrajectoryPlannerTests, testTable));
+static TrajectoryPlannerTests test2(TEST_INVOCATION(TrajectoryPlannerTests, testSaveLoad));
+static TrajectoryPlannerTests test3(TEST_INVOCATION(TrajectoryPlannerTests, testSweepCollisions));
+static TrajectoryPlannerTests test4(TEST_INVOCATION(TrajectoryPlannerTests, testSeek));
+static TrajectoryPlannerTests test5(TEST_INVOCATION(TrajectoryPlannerTests, testAvoidCollision));
+static TrajectoryPlannerTests test6(TEST_INVOCATION(TrajectoryPlannerTests, testDeterministic));
@@ -0,0 +1,24 @@
+/*
+ *  TrajectoryPlannerTests.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 16.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include <CPlusTest/CPlusTest.h>
+
+
+class TrajectoryPlannerTests : public TestCase {
+public:
+  TrajectoryPlannerTests(TestInvocation* invocation);
+  virtual ~TrajectoryPlannerTests();
+    
+  void testTable();
+  void testSaveLoad();
+  void testSweepCollisions();
+  void testSeek();
+  void testAvoidCollision();
+  void testDeterministic();
+};
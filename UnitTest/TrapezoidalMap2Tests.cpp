@@ -0,0 +1,450 @@
+/*
+ *  TrapezoidalMap2Tests.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 25.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "TrapezoidalMap2Tests.h"
+
+#include <Geometry/TrapezoidalMap2.hpp>
+#include <Geometry/Graph2.hpp>
+#include <Utils/Random.h>
+
+#include <set>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace std;
+
+// Neighbors must point back and share the wall point and top or bottom
+static bool isConsistent(const TrapezoidalMap2& map)
+{
+  Trapezoids2 ts;
+  map.getTrapezoids(ts);
+  for (Trapezoids2::iterator it = ts.begin(); it != ts.end(); ++it) {
+    Trapezoid2* t = *it;
+    for (int side = 0; side < 2; ++side) {
+      for (int i = 0; i < 2; ++i) {
+        Trapezoid2* n = t->neighbor(side, i);
+        if (n == 0)
+          continue;
+        if (n->neighbor(opposite(side), i) != t)
+          return false;
+        if (side == Trapezoid2::RIGHT ? t->right() != n->left() : t->left() != n->right())
+          return false;
+        if (i == 1 ? t->top() != n->top() : t->bottom() != n->bottom())
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Same trapezoid is found at random points in both maps
+static bool sameTrapezoids(const TrapezoidalMap2& map, const TrapezoidalMap2& expected, const Rect2& box)
+{
+  Random random(7);
+  for (int i = 0; i < 1000; ++i) {
+    Point2 p(box.min().x() + random.uniform()*box.width(), box.min().y() + random.uniform()*box.height());
+    Trapezoid2* t = map.locate(p);
+    Trapezoid2* et = expected.locate(p);
+    if (t == 0 || et == 0)
+      return false;
+    if (t->left() != et->left() || t->right() != et->right() || t->bottom() != et->bottom() || t->top() != et->top())
+      return false;
+  }
+  return true;
+}
+
+// Squares on a grid, counter clockwise so bottom of trapezoids inside goes left to right
+static void squareSegments(int n, Segments2& segs)
+{
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      Point2 p(i*10.0 + 2.0, j*10.0 + 2.0 + i);
+      Points2 square;
+      square.push_back(p);
+      square.push_back(p + Vector2(5.0, -1.0));
+      square.push_back(p + Vector2(5.0, 4.0));
+      square.push_back(p + Vector2(0.0, 5.0));
+      for (int k = 0; k < 4; ++k)
+        segs.push_back(Segment2(square[k], square[(k+1) % 4]));
+    }
+  }
+}
+
+// Roadmap edges between every trapezoid of map and its right neighbors
+static Graph2* createGraph(TrapezoidalMap2& map)
+{
+  int tag = map.assignUniqueTags();
+  Trapezoids2 ts;
+  map.getTrapezoids(ts);
+  EdgePairs edges;
+  for (Trapezoids2::iterator it = ts.begin(); it != ts.end(); ++it) {
+    Trapezoids2 ns = (*it)->rightNeighbors();
+    for (Trapezoids2::iterator n = ns.begin(); n != ns.end(); ++n)
+      edges.push_back(roadmapEdge(*it, *n, tag++));
+  }
+  return Graph2::create(ts.size(), edges.begin(), edges.end());
+}
+
+static real pathLength(const Points2& path)
+{
+  real length = 0.0;
+  for (size_t i = 1; i < path.size(); ++i)
+    length += (path[i]-path[i-1]).length();
+  return length;
+}
+
+TrapezoidalMap2Tests::TrapezoidalMap2Tests(TestInvocation *invocation)
+    : TestCase(invocation)
+{
+}
+
+
+TrapezoidalMap2Tests::~TrapezoidalMap2Tests()
+{
+}
+
+void TrapezoidalMap2Tests::testSingleSegment()
+{
+  Segments2 segs;
+  segs.push_back(Segment2(Point2(2.0, 5.0), Point2(8.0, 6.0)));
+  TrapezoidalMap2 map(segs.begin(), segs.end(), Rect2(0.0, 0.0, 10.0, 10.0));
+
+  Trapezoids2 ts;
+  map.getTrapezoids(ts);
+  CPTAssert(ts.size() == 4);
+  CPTAssert(isConsistent(map));
+
+  Trapezoid2* left = map.locate(Point2(1.0, 5.0));
+  Trapezoid2* above = map.locate(Point2(5.0, 8.0));
+  Trapezoid2* below = map.locate(Point2(5.0, 2.0));
+  Trapezoid2* right = map.locate(Point2(9.0, 5.0));
+  CPTAssert(above->bottom() == segs[0]);
+  CPTAssert(below->top() == segs[0]);
+  CPTAssert(left->upperRight() == above && left->lowerRight() == below);
+  CPTAssert(right->upperLeft() == above && right->lowerLeft() == below);
+  CPTAssert(above->lowerLeft() == 0 && below->upperRight() == 0);
+}
+
+void TrapezoidalMap2Tests::testPolygon()
+{
+  // Counter clockwise square with a vertical side, segments share endpoints
+  Points2 square;
+  square.push_back(Point2(3.0, 3.0));
+  square.push_back(Point2(6.0, 2.0));
+  square.push_back(Point2(6.0, 6.0));
+  square.push_back(Point2(3.0, 7.0));
+  Segments2 segs;
+  for (int i = 0; i < 4; ++i)
+    segs.push_back(Segment2(square[i], square[(i+1) % 4]));
+  TrapezoidalMap2 map(segs.begin(), segs.end(), Rect2(0.0, 0.0, 10.0, 10.0));
+
+  Trapezoids2 ts;
+  map.getTrapezoids(ts);
+  CPTAssert(ts.size() == 9);
+  CPTAssert(isConsistent(map));
+
+  // Bottom of trapezoid inside goes left to right, which roadmap uses to remove it
+  Trapezoid2* inside = map.locate(Point2(4.5, 4.5));
+  CPTAssert(inside->bottom() == segs[0] && inside->top() == segs[2]);
+  CPTAssert(inside->bottom().source().x() < inside->bottom().target().x());
+
+  map.remove(inside);
+  map.remove(inside);
+  ts.clear();
+  map.getTrapezoids(ts);
+  CPTAssert(ts.size() == 8);
+  CPTAssert(map.assignUniqueTags() == 8);
+}
+
+void TrapezoidalMap2Tests::testNeighbors()
+{
+  // Short segments on a grid, with every second sharing an endpoint with the previous
+  Random random(3);
+  Segments2 segs;
+  for (int i = 0; i < 20; ++i) {
+    for (int j = 0; j < 20; ++j) {
+      Point2 p(i*5.0 + random.uniform(), j*5.0 + random.uniform());
+      Point2 q = p + Vector2(1.0 + random.uniform()*2.0, random.uniform()*4.0 - 2.0);
+      segs.push_back(Segment2(p, q));
+      if (j % 2 == 0)
+        segs.push_back(Segment2(q, q + Vector2(random.uniform(), 1.5)));
+    }
+  }
+  TrapezoidalMap2 map(segs.begin(), segs.end(), Rect2(-1.0, -5.0, 105.0, 110.0));
+
+  Trapezoids2 ts;
+  map.getTrapezoids(ts);
+  CPTAssert(set<Trapezoid2*>(ts.begin(), ts.end()).size() == ts.size());
+  CPTAssert(ts.size() <= 3*segs.size() + 1);
+  CPTAssert(isConsistent(map));
+
+  // Every point is found in a trapezoid which contains it
+  for (int i = 0; i < 1000; ++i) {
+    Point2 p(random.uniform()*100.0, random.uniform()*100.0);
+    Trapezoid2* t = map.locate(p);
+    CPTAssert(t != 0);
+    CPTAssert(t->left().x() <= p.x() && p.x() <= t->right().x());
+    CPTAssert(!t->bottom().isAbove(p) && !t->top().isBelow(p));
+  }
+}
+
+void TrapezoidalMap2Tests::testInsertionOrder()
+{
+  // Decomposition only depends on the segments, not the order they are given in
+  Segments2 segs;
+  squareSegments(5, segs);
+  Rect2 box(0.0, 0.0, 60.0, 60.0);
+  TrapezoidalMap2 map(segs.begin(), segs.end(), box);
+  
+  Segments2 reversed(segs.rbegin(), segs.rend());
+  TrapezoidalMap2 reversed_map(reversed.begin(), reversed.end(), box);
+  
+  Trapezoids2 ts, reversed_ts;
+  map.getTrapezoids(ts);
+  reversed_map.getTrapezoids(reversed_ts);
+  CPTAssert(ts.size() == reversed_ts.size());
+  CPTAssert(isConsistent(reversed_map));
+  CPTAssert(sameTrapezoids(map, reversed_map, box));
+}
+
+void TrapezoidalMap2Tests::testSaveAndLoad()
+{
+  // Squares on a grid with the trapezoids inside them removed, like a roadmap level
+  Segments2 segs;
+  squareSegments(5, segs);
+  TrapezoidalMap2 map(segs.begin(), segs.end(), Rect2(0.0, 0.0, 50.0, 60.0));
+  Trapezoids2 ts;
+  map.getTrapezoids(ts);
+  for (Trapezoids2::iterator it = ts.begin(); it != ts.end(); ++it) {
+    Segment2 bottom = (*it)->bottom();
+    if (bottom.source().x() < bottom.target().x())
+      map.remove(*it);
+  }
+  int no_vertices = map.assignUniqueTags();
+
+  ts.clear();
+  map.getTrapezoids(ts);
+  EdgePairs edges;
+  int tag = no_vertices;
+  for (Trapezoids2::iterator it = ts.begin(); it != ts.end(); ++it) {
+    Trapezoids2 ns = (*it)->rightNeighbors();
+    for (Trapezoids2::iterator n = ns.begin(); n != ns.end(); ++n)
+      if (*n != 0)
+        edges.push_back(EdgePair(*it, *n, tag++, (*it)->centerRight()));
+  }
+
+  const char* path = "/tmp/lusion_tmap_test.ltm";
+  CPTAssert(map.save(path, edges));
+
+  EdgePairs loaded_edges;
+  TrapezoidalMap2* loaded = TrapezoidalMap2::load(path, &loaded_edges);
+  CPTAssert(loaded != 0);
+  if (loaded == 0)
+    return;
+
+  Trapezoids2 loaded_ts;
+  loaded->getTrapezoids(loaded_ts);
+  CPTAssert(loaded_ts.size() == ts.size());
+  CPTAssert(loaded_edges.size() == edges.size());
+  CPTAssert(isConsistent(*loaded));
+
+  // Same trapezoids are found, with same tags and neighbors
+  Random random(5);
+  for (int i = 0; i < 1000; ++i) {
+    Point2 p(random.uniform()*50.0, random.uniform()*60.0);
+    Trapezoid2* t = map.locate(p);
+    Trapezoid2* lt = loaded->locate(p);
+    CPTAssert((t == 0) == (lt == 0));
+    if (t == 0 || lt == 0)
+      continue;
+    CPTAssert(t->tag() == lt->tag());
+    CPTAssert(t->left() == lt->left() && t->right() == lt->right());
+    CPTAssert(t->bottom() == lt->bottom() && t->top() == lt->top());
+    for (int j = 0; j < 4; ++j)
+      CPTAssert((t->neighbor(j) == 0) == (lt->neighbor(j) == 0) &&
+                (t->neighbor(j) == 0 || t->neighbor(j)->tag() == lt->neighbor(j)->tag()));
+  }
+
+  // Graph built from loaded edges finds same paths
+  Graph2* graph = Graph2::create(no_vertices, edges.begin(), edges.end());
+  Graph2* loaded_graph = Graph2::create(no_vertices, loaded_edges.begin(), loaded_edges.end());
+  for (int i = 0; i < 20; ++i) {
+    Point2 p(random.uniform()*50.0, random.uniform()*60.0), q(random.uniform()*50.0, random.uniform()*60.0);
+    Trapezoid2 *s = map.locate(p), *t = map.locate(q);
+    if (s == 0 || t == 0)
+      continue;
+    Points2 path, loaded_path;
+    bool found = graph->shortestPath(s, t, path);
+    CPTAssert(found == loaded_graph->shortestPath(loaded->locate(p), loaded->locate(q), loaded_path));
+    CPTAssert(path == loaded_path);
+  }
+  delete graph;
+  delete loaded_graph;
+  delete loaded;
+
+  // Damaged file is refused
+  FILE* file = fopen(path, "r+b");
+  fseek(file, 8, SEEK_SET);
+  fputc(0xff, file);
+  fclose(file);
+  CPTAssert(TrapezoidalMap2::load(path) == 0);
+  remove(path);
+}
+
+void TrapezoidalMap2Tests::testInsertAndRemove()
+{
+  // Same segments as testNeighbors, so many share endpoints
+  Random random(3);
+  Segments2 segs;
+  for (int i = 0; i < 10; ++i) {
+    for (int j = 0; j < 10; ++j) {
+      Point2 p(i*5.0 + random.uniform(), j*5.0 + random.uniform());
+      Point2 q = p + Vector2(1.0 + random.uniform()*2.0, random.uniform()*4.0 - 2.0);
+      segs.push_back(Segment2(p, q));
+      if (j % 2 == 0)
+        segs.push_back(Segment2(q, q + Vector2(random.uniform(), 1.5)));
+    }
+  }
+  Rect2 box(-1.0, -5.0, 55.0, 60.0);
+  TrapezoidalMap2 map(segs.begin(), segs.end(), box);
+
+  // Every third segment removed gives the map built without them
+  Segments2 kept, removed;
+  for (size_t i = 0; i < segs.size(); ++i)
+    (i % 3 == 0 ? removed : kept).push_back(segs[i]);
+
+  Trapezoids2 created;
+  vector<int> deleted;
+  for (Segments2::iterator s = removed.begin(); s != removed.end(); ++s)
+    CPTAssert(map.remove(*s, &created, &deleted));
+  CPTAssert(isConsistent(map));
+
+  TrapezoidalMap2 expected(kept.begin(), kept.end(), box);
+  CPTAssert(sameTrapezoids(map, expected, box));
+
+  Trapezoids2 ts, expected_ts;
+  map.getTrapezoids(ts);
+  expected.getTrapezoids(expected_ts);
+  CPTAssert(ts.size() == expected_ts.size());
+  CPTAssert(set<Trapezoid2*>(created.begin(), created.end()).size() == created.size());
+  for (Trapezoids2::iterator t = created.begin(); t != created.end(); ++t)
+    CPTAssert(find(ts.begin(), ts.end(), *t) != ts.end());
+
+  // Inserting them again gives the first map back, segments going the other way are found too
+  for (Segments2::iterator s = removed.begin(); s != removed.end(); ++s)
+    CPTAssert(map.insert(*s));
+  CPTAssert(isConsistent(map));
+  TrapezoidalMap2 all(segs.begin(), segs.end(), box);
+  CPTAssert(sameTrapezoids(map, all, box));
+
+  CPTAssert(map.remove(Segment2(segs[1].target(), segs[1].source())));
+  CPTAssert(!map.remove(segs[1]));
+  CPTAssert(isConsistent(map));
+}
+
+void TrapezoidalMap2Tests::testGraphUpdate()
+{
+  // Trapezoids inside squares stay in map, they are not connected to those outside
+  Segments2 segs;
+  squareSegments(4, segs);
+  Rect2 box(0.0, 0.0, 40.0, 50.0);
+  TrapezoidalMap2 map(segs.begin(), segs.end(), box);
+  Graph2* graph = createGraph(map);
+  int revision = graph->revision();
+  Trapezoid2* corner = map.locate(Point2(1.0, 1.0));
+  Paths2* paths = graph->shortestPaths(corner);
+  CPTAssert(!paths->isStale());
+
+  // Square in second row and column is destroyed
+  Segments2 kept(segs);
+  Segments2 square(kept.begin()+20, kept.begin()+24);
+  kept.erase(kept.begin()+20, kept.begin()+24);
+  Trapezoids2 created;
+  vector<int> deleted;
+  for (Segments2::iterator s = square.begin(); s != square.end(); ++s)
+    CPTAssert(map.remove(*s, &created, &deleted));
+  graph->update(deleted, created);
+  CPTAssert(graph->revision() != revision);
+
+  // Paths searched before the update refer to vertices that may be gone
+  Point2 waypoint;
+  CPTAssert(paths->isStale());
+  CPTAssert(!paths->nextFrom(map.locate(Point2(39.0, 49.0)), waypoint));
+  CPTAssert(paths->distanceFrom(corner) == numeric_limits<real>::max());
+  paths->release();
+
+  TrapezoidalMap2 expected(kept.begin(), kept.end(), box);
+  Graph2* expected_graph = createGraph(expected);
+
+  // Paths across where the square was are as short as in graph built from scratch
+  Random random(11);
+  int no_paths = 0;
+  for (int i = 0; i < 50; ++i) {
+    Point2 p(random.uniform()*40.0, random.uniform()*50.0), q(random.uniform()*40.0, random.uniform()*50.0);
+    Points2 path, expected_path;
+    bool found = graph->shortestPath(map.locate(p), map.locate(q), path);
+    CPTAssert(found == expected_graph->shortestPath(expected.locate(p), expected.locate(q), expected_path));
+    CPTAssert(fabs(pathLength(path) - pathLength(expected_path)) < 1e-9);
+    no_paths += found;
+  }
+  CPTAssert(no_paths > 0);
+
+  // Square is put back, and the trapezoids inside it can't be reached from outside
+  created.clear();
+  deleted.clear();
+  for (Segments2::iterator s = square.begin(); s != square.end(); ++s)
+    CPTAssert(map.insert(*s, &created, &deleted));
+  graph->update(deleted, created);
+
+  Trapezoid2* inside = map.locate(Point2(14.0, 15.0));
+  Trapezoid2* outside = map.locate(Point2(1.0, 1.0));
+  Points2 path;
+  CPTAssert(inside != 0 && outside != 0);
+  CPTAssert(!graph->shortestPath(outside, inside, path));
+
+  // Unreachable is told apart from already being at the goal
+  Paths2* to_inside = graph->shortestPaths(inside);
+  CPTAssert(to_inside->reachableFrom(inside));
+  CPTAssert(!to_inside->nextFrom(inside, waypoint));
+  CPTAssert(!to_inside->reachableFrom(outside));
+  CPTAssert(!to_inside->nextFrom(outside, waypoint));
+  CPTAssert(!to_inside->pathFrom(outside, path));
+  to_inside->release();
+  CPTAssert(graph->shortestPath(outside, map.locate(Point2(39.0, 49.0)), path));
+
+  // Square keeps being destroyed and put back. The search structure is built
+  // again on the way, and must keep the trapezoids the graph refers to
+  for (int i = 0; i < 200; ++i) {
+    created.clear();
+    deleted.clear();
+    for (Segments2::iterator s = square.begin(); s != square.end(); ++s)
+      CPTAssert(map.remove(*s, &created, &deleted));
+    for (Segments2::iterator s = square.begin(); s != square.end(); ++s)
+      CPTAssert(map.insert(*s, &created, &deleted));
+    graph->update(deleted, created);
+  }
+  CPTAssert(isConsistent(map));
+  TrapezoidalMap2 all(segs.begin(), segs.end(), box);
+  CPTAssert(sameTrapezoids(map, all, box));
+  CPTAssert(!graph->shortestPath(outside, map.locate(Point2(14.0, 15.0)), path));
+  CPTAssert(graph->shortestPath(map.locate(Point2(1.0, 1.0)), map.locate(Point2(39.0, 49.0)), path));
+
+  delete expected_graph;
+  delete graph;
+}
+
+static TrapezoidalMap2Tests test1(TEST_INVOCATION(TrapezoidalMap2Tests, testSingleSegment));
+static TrapezoidalMap2Tests test2(TEST_INVOCATION(TrapezoidalMap2Tests, testPolygon));
+static TrapezoidalMap2Tests test3(TEST_INVOCATION(TrapezoidalMap2Tests, testNeighbors));
+static TrapezoidalMap2Tests test4(TEST_INVOCATION(TrapezoidalMap2Tests, testSaveAndLoad));
+static TrapezoidalMap2Tests test5(TEST_INVOCATION(TrapezoidalMap2Tests, testInsertAndRemove));
+static TrapezoidalMap2Tests test6(TEST_INVOCATION(TrapezoidalMap2Tests, testGraphUpdate));
+static TrapezoidalMap2Tests test7(TEST_INVOCATION(TrapezoidalMap2Tests, testInsertionOrder));
@@ -0,0 +1,25 @@
+/*
+ *  TrapezoidalMap2Tests.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 25.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include <CPlusTest/CPlusTest.h>
+
+
+class TrapezoidalMap2Tests : public TestCase {
+public:
+  TrapezoidalMap2Tests(TestInvocation* invocation);
+  virtual ~TrapezoidalMap2Tests();
+    
+  void testSingleSegment();
+  void testPolygon();
+  void testNeighbors();
+  void testInsertionOrder();
+  void testSaveAndLoad();
+  void testInsertAndRemove();
+  void testGraphUpdate();
+};
@@ -0,0 +1,158 @@
+/*
+ *  WorldTests.cpp
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 20.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include "WorldTests.h"
+
+#include "World.h"
+#include "Timing.h"
+
+#include "Base/Group.h"
+#include "Base/RectShape2.h"
+#include "Core/AutoreleasePool.hpp"
+
+#include <pthread.h>
+#include <unistd.h>
+#include <cmath>
+
+using namespace std;
+
+// Fills render group of its own world from a separate thread
+struct WorldTask {
+  World*            world;
+  int               noShapes;
+  Group*            group;
+  AutoreleasePool*  pool;
+  int               ticksPerFrame;
+};
+
+static void* runWorld(void* arg)
+{
+  WorldTask* task = (WorldTask*)arg;
+  task->world->makeCurrent();
+  AutoreleasePool::begin();
+  task->pool = AutoreleasePool::currentPool();
+  task->group = renderGroup();
+  setTicksPerFrame(task->noShapes);
+  for (int i = 0; i < task->noShapes; ++i) {
+    RectShape2* shape = new RectShape2(Rect2(Vector2(i, 0.0), Vector2(i+1.0, 1.0)));
+    renderGroup()->addKid(shape);
+    shape->autorelease();
+  }
+  task->ticksPerFrame = ticksPerFrame();
+  AutoreleasePool::end();
+  return 0;
+}
+
+WorldTests::WorldTests(TestInvocation *invocation)
+    : TestCase(invocation)
+{
+}
+
+
+WorldTests::~WorldTests()
+{
+}
+
+void WorldTests::testCurrentWorld()
+{
+  World* main = World::current();
+  CPTAssert(main == World::mainWorld());
+  CPTAssert(renderGroup() == main->renderGroup());
+  
+  World world;
+  world.makeCurrent();
+  CPTAssert(World::current() == &world);
+  CPTAssert(renderGroup() == world.renderGroup());
+  CPTAssert(renderGroup() != main->renderGroup());
+  
+  main->makeCurrent();
+  CPTAssert(renderGroup() == main->renderGroup());
+}
+
+void WorldTests::testWorldsOnThreads()
+{
+  AutoreleasePool::begin();
+  
+  World worlds[2];
+  WorldTask tasks[2];
+  pthread_t threads[2];
+  for (int i = 0; i < 2; ++i) {
+    tasks[i].world = &worlds[i];
+    tasks[i].noShapes = 10*(i+1);
+    pthread_create(&threads[i], 0, runWorld, &tasks[i]);
+  }
+  for (int i = 0; i < 2; ++i)
+    pthread_join(threads[i], 0);
+  
+  for (int i = 0; i < 2; ++i) {
+    CPTAssert(tasks[i].group == worlds[i].renderGroup());
+    CPTAssert(worlds[i].renderGroup()->noShapes() == tasks[i].noShapes);
+    CPTAssert(worlds[i].ticksPerFrame() == tasks[i].noShapes);
+    CPTAssert(tasks[i].ticksPerFrame == tasks[i].noShapes);
+  }
+  CPTAssert(tasks[0].pool != AutoreleasePool::currentPool());
+  CPTAssert(tasks[1].pool != AutoreleasePool::currentPool());
+  CPTAssert(renderGroup()->noShapes() == 0);
+  
+  AutoreleasePool::end();
+}
+
+void WorldTests::testFixedStep()
+{
+  World world;
+  world.setTicksPerFrame(10);
+  
+  // First advance runs one step, then steps are run as time accumulates
+  CPTAssert(world.advance(1.0) == 1);
+  CPTAssert(world.advance(1.005) == 0);
+  CPTAssert(fabs(world.interpolation() - 0.5) < 1e-9);
+  CPTAssert(world.advance(1.025) == 2);
+  CPTAssert(fabs(world.interpolation() - 0.5) < 1e-9);
+  CPTAssert(world.noSteps() == 3);
+  CPTAssert(fabs(world.simulationTime() - 0.03) < 1e-9);
+  
+  // Catching up is limited, the rest of the time is dropped
+  world.setMaxCatchUpSteps(4);
+  CPTAssert(world.advance(2.0) == 4);
+  CPTAssert(world.advance(2.0) == 0);
+  
+  // Time going backwards runs nothing
+  CPTAssert(world.advance(1.5) == 0);
+  
+  // Headless runs as fast as possible until done
+  CPTAssert(world.run(7) == 7);
+  CPTAssert(world.noSteps() == 14);
+  CPTAssert(fabs(world.interpolation() - 1.0) < 1e-9);
+  world.setDone(true);
+  CPTAssert(world.run() == 0);
+  CPTAssert(world.advance(3.0) == 0);
+  
+  // Steps are at least a millisecond, so advance() never divides by zero
+  World fast;
+  fast.setTicksPerFrame(0);
+  CPTAssert(fast.ticksPerFrame() == 1);
+  CPTAssert(fast.advance(1.0) == 1);
+  CPTAssert(fast.advance(1.0025) == 2);
+  
+  World::mainWorld()->makeCurrent();
+}
+
+void WorldTests::testWallClock()
+{
+  real start = secondsPassed();
+  int ticks = getTicks();
+  usleep(20000);
+  CPTAssert(secondsPassed()-start >= 0.019);
+  CPTAssert(getTicks()-ticks >= 19);
+}
+
+static WorldTests test1(TEST_INVOCATION(WorldTests, testCurrentWorld));
+static WorldTests test2(TEST_INVOCATION(WorldTests, testWorldsOnThreads));
+static WorldTests test3(TEST_INVOCATION(WorldTests, testFixedStep));
+static WorldTests test4(TEST_INVOCATION(WorldTests, testWallClock));
@@ -0,0 +1,22 @@
+/*
+ *  WorldTests.h
+ *  LusionEngine
+ *
+ *  Created by Erik Engheim on 20.3.09.
+ *  Copyright 2009 Translusion. All rights reserved.
+ *
+ */
+
+#include <CPlusTest/CPlusTest.h>
+
+
+class WorldTests : public TestCase {
+public:
+  WorldTests(TestInvocation* invocation);
+  virtual ~WorldTests();
+    
+  void testCurrentWorld();
+  void testWorldsOnThreads();
+  void testFixedStep();
+  void testWallClock();
+};
@@ -0,0 +1,188 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+
+#include "Utils/Counters.h"
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+
+using namespace std;
+
+/*!
+  \file Counters.cpp
+  \brief Counts of events on hot paths, per frame.
+
+  Each thread counts in its own array, so counting is a plain increment
+  with no locks or atomic instructions. Counts only ever grow. Other
+  threads read them without locking, which at worst gives a count that is
+  a few events old. countersEndFrame() sums the counts of all threads and
+  keeps how much each counter grew since the last frame. World::step() ends
+  a frame after each simulation step.
+
+  The number of most interest is broadphase efficiency: of the pairs whose
+  bounding boxes are tested in Shape::collide(), how many make it to the
+  narrow phase, and how many of those actually collide.
+*/
+
+struct CounterThread
+{
+  volatile uint32 values[NO_COUNTERS];
+};
+
+static const char* gNames[NO_COUNTERS] = {
+  "rect_tests",
+  "broadphase_tests",
+  "narrowphase_tests",
+  "contacts",
+  "polygon_tests",
+  "gjk_iterations",
+  "lua_callbacks",
+  "objects_created",
+  "autoreleased"
+};
+
+static pthread_key_t  gThreadKey;
+static pthread_once_t gThreadOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t gThreadsLock = PTHREAD_MUTEX_INITIALIZER;
+static vector<CounterThread*> gThreads;
+static CounterValues  gExited;      // Counts of threads which have exited
+static CounterValues  gReset;       // Sum at last countersReset()
+static CounterValues  gLastSum;     // Sum at end of last frame
+static CounterValues  gFrame;       // Counts in last frame
+
+/*! Counts of all threads since start. Called with gThreadsLock held */
+static void sumCounters(CounterValues& counters)
+{
+  counters = gExited;
+  vector<CounterThread*>::iterator it;
+  for (it = gThreads.begin(); it != gThreads.end(); ++it) {
+    for (int i = 0; i < NO_COUNTERS; ++i)
+      counters.values[i] += (*it)->values[i];
+  }
+}
+
+static void destroyThread(void* data)
+{
+  CounterThread* thread = (CounterThread*)data;
+  pthread_mutex_lock(&gThreadsLock);
+  for (int i = 0; i < NO_COUNTERS; ++i)
+    gExited.values[i] += thread->values[i];
+  gThreads.erase(remove(gThreads.begin(), gThreads.end(), thread), gThreads.end());
+  pthread_mutex_unlock(&gThreadsLock);
+  delete thread;
+}
+
+static void createThreadKey()
+{
+  pthread_key_create(&gThreadKey, destroyThread);
+}
+
+// Accessors
+/*! Counts of calling thread, indexed by Counter. Use the COUNT macro */
+volatile uint32* threadCounters()
+{
+  pthread_once(&gThreadOnce, createThreadKey);
+  CounterThread* thread = (CounterThread*)pthread_getspecific(gThreadKey);
+  if (thread == 0) {
+    thread = new CounterThread;
+    fill(thread->values, thread->values+NO_COUNTERS, 0);
+
+    pthread_mutex_lock(&gThreadsLock);
+    gThreads.push_back(thread);
+    pthread_mutex_unlock(&gThreadsLock);
+    pthread_setspecific(gThreadKey, thread);
+  }
+  return thread->values;
+}
+
+/*! Name of \a counter as used in reports and from Lua */
+const char* counterName(int counter)
+{
+  if (counter < 0 || counter >= NO_COUNTERS)
+    return "";
+  return gNames[counter];
+}
+
+// Request
+/*! How much each counter grew in the last frame, summed over all threads */
+void frameCounters(CounterValues& counters)
+{
+  pthread_mutex_lock(&gThreadsLock);
+  counters = gFrame;
+  pthread_mutex_unlock(&gThreadsLock);
+}
+
+/*! Counts since start or last countersReset(), summed over all threads */
+void totalCounters(CounterValues& counters)
+{
+  pthread_mutex_lock(&gThreadsLock);
+  sumCounters(counters);
+  for (int i = 0; i < NO_COUNTERS; ++i)
+    counters.values[i] -= gReset.values[i];
+  pthread_mutex_unlock(&gThreadsLock);
+}
+
+/*! Table of counts in last frame, with broadphase efficiency */
+string counterReport()
+{
+  CounterValues counters;
+  frameCounters(counters);
+
+  ostringstream out;
+  out << left << setw(28) << "counter (per frame)" << right << setw(12) << "count" << endl;
+  for (int i = 0; i < NO_COUNTERS; ++i)
+    out << left << setw(28) << gNames[i] << right << setw(12) << counters[i] << endl;
+
+  out << fixed << setprecision(1);
+  if (counters[BROADPHASE_TESTS] > 0)
+    out << left << setw(28) << "narrowphase/broadphase" << right << setw(11)
+        << 100.0*counters[NARROWPHASE_TESTS]/counters[BROADPHASE_TESTS] << "%" << endl;
+  if (counters[NARROWPHASE_TESTS] > 0)
+    out << left << setw(28) << "contacts/narrowphase" << right << setw(11)
+        << 100.0*counters[CONTACTS]/counters[NARROWPHASE_TESTS] << "%" << endl;
+  return out.str();
+}
+
+// Operations
+/*! Keeps how much each counter grew since last call, as one frame */
+void countersEndFrame()
+{
+  pthread_mutex_lock(&gThreadsLock);
+  CounterValues sum;
+  sumCounters(sum);
+  for (int i = 0; i < NO_COUNTERS; ++i)
+    gFrame.values[i] = sum.values[i] - gLastSum.values[i];
+  gLastSum = sum;
+  pthread_mutex_unlock(&gThreadsLock);
+}
+
+/*! Sets totals and counts of last frame to zero */
+void countersReset()
+{
+  pthread_mutex_lock(&gThreadsLock);
+  sumCounters(gReset);
+  gLastSum = gReset;
+  fill(gFrame.values, gFrame.values+NO_COUNTERS, 0);
+  pthread_mutex_unlock(&gThreadsLock);
+}
@@ -0,0 +1,78 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+
+#pragma once
+
+#include "Types.h"
+
+#include <string>
+
+/*!
+  Counts an event of kind \a counter on a hot path. Counters are compiled
+  out unless COUNTERS is defined, e.g. with 'qmake CONFIG+=counters'.
+
+  \code
+  bool Rect2::intersect(const Rect2 &aRect2) const
+  {
+    COUNT(RECT_TESTS);
+    ...
+  }
+  \endcode
+*/
+#ifdef COUNTERS
+#define COUNT(counter) (++threadCounters()[counter])
+#else
+#define COUNT(counter) ((void)0)
+#endif
+
+enum Counter
+{
+  RECT_TESTS,         // Rect2::intersect() calls
+  BROADPHASE_TESTS,   // Bounding box tests in Shape::collide()
+  NARROWPHASE_TESTS,  // Pairs passing bounding box test
+  CONTACTS,           // Pairs colliding in narrow phase
+  POLYGON_TESTS,      // intersect() calls in PolygonUtils
+  GJK_ITERATIONS,     // Simplex steps in gjkDistance() and friends
+  LUA_CALLBACKS,      // Calls from engine into Lua
+  OBJECTS_CREATED,    // SharedObject constructions
+  AUTORELEASED,       // AutoreleasePool::add() calls
+  NO_COUNTERS
+};
+
+/*! Value of each counter, indexed by Counter */
+struct CounterValues
+{
+  uint32 values[NO_COUNTERS];
+
+  uint32 operator[](int counter) const { return values[counter]; }
+};
+
+// Accessors
+volatile uint32* threadCounters();
+const char*      counterName(int counter);
+
+// Request
+void        frameCounters(CounterValues& counters);
+void        totalCounters(CounterValues& counters);
+std::string counterReport();
+
+// Operations
+void        countersEndFrame();
+void        countersReset();
@@ -0,0 +1,495 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "Utils/FlowField.h"
+#include "Utils/Parallel.h"
+
+#include "Base/Shape.h"
+#include "Base/Sprite.h"
+
+#include <queue>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+using namespace std;
+
+/*!
+    \class FlowField FlowField.h
+    \brief Grid over the level giving the direction to move in to reach a goal.
+
+    Navigating many sprites towards the same goal with a path per sprite
+    does not scale. A flow field does the search once. The obstacle shape
+    tree is rasterized onto a grid of cells. A dijkstra sweep out from the
+    goal then gives each free cell its distance to the goal (the integration
+    field). Each cell then gets a unit vector pointing to its neighbor closest
+    to the goal (the direction field).
+
+    Sprites only have to look up the cell they are in. sample() does this for
+    arrays of x and y coordinates, and steer() does it for all sprites in a group.
+
+    Rasterization and the direction field are split over all processors. When
+    obstacles move, update() only rasterizes the cells in the given region. The
+    fields are only recomputed if a cell actually changed, and then only for
+    cells at least as far from the goal as the cells which changed. So an
+    obstacle moving near the goal costs about as much as setGoal(), while
+    one far from it, like a door at the edge of the level, is cheap.
+*/
+
+static const int  gNoNeighbors = 8;
+static const int  gNeighborDx[gNoNeighbors] = { 1, 0, -1, 0, 1, -1, -1, 1 };
+static const int  gNeighborDy[gNoNeighbors] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+static const real gNeighborCost[gNoNeighbors] = { 1, 1, 1, 1, M_SQRT2, M_SQRT2, M_SQRT2, M_SQRT2 };
+
+/*! Marks cells within a column range and a given range of rows as blocked if they touch an obstacle */
+class RasterizeTask : public RangeTask
+{
+public:
+  RasterizeTask(FlowField& field, const vector<Shape*>& obstacles, int col_begin, int col_end)
+    : iField(field), iObstacles(obstacles), iColBegin(col_begin), iColEnd(col_end), iChanged(false)
+  {
+    
+  }
+  
+  void run(int row_begin, int row_end)
+  {
+    real s = iField.iCellSize;
+    Point2 origin = iField.iArea.min();
+    Points2 points;
+    bool changed = false;
+    
+    for (int row = row_begin; row < row_end; ++row) {
+      for (int col = iColBegin; col < iColEnd; ++col) {
+        Rect2 cell(origin.x()+col*s, origin.y()+row*s, origin.x()+(col+1)*s, origin.y()+(row+1)*s);
+        ubyte blocked = 0;
+        
+        vector<Shape*>::const_iterator i;
+        for (i = iObstacles.begin(); i != iObstacles.end() && !blocked; ++i) {
+          points.clear();
+          if ((*i)->boundingBox().intersect(cell) && (*i)->intersection(cell, points))
+            blocked = 1;
+        }
+        
+        ubyte& cur = iField.iBlocked[row*iField.iColumns+col];
+        if (cur != blocked) {
+          cur = blocked;
+          changed = true;
+        }
+      }
+    }
+    
+    // Only ever set from false to true, so race between threads is harmless
+    if (changed)
+      iChanged = true;
+  }
+  
+  bool changed() const { return iChanged; }
+  
+private:
+  FlowField& iField;
+  const vector<Shape*>& iObstacles;
+  int   iColBegin, iColEnd;
+  volatile bool iChanged;
+};
+
+/*! Points each cell in a range of rows towards its neighbor with the shortest distance to goal */
+class DirectionTask : public RangeTask
+{
+public:
+  DirectionTask(FlowField& field) : iField(field) {}
+  
+  void run(int row_begin, int row_end)
+  {
+    int w = iField.iColumns, h = iField.iRows;
+    const vector<real>&  d = iField.iDistance;
+    const vector<ubyte>& blocked = iField.iBlocked;
+    
+    for (int row = row_begin; row < row_end; ++row) {
+      for (int col = 0; col < w; ++col) {
+        int  index = row*w+col;
+        real best = d[index];
+        int  best_k = -1;
+        
+        for (int k = 0; k < gNoNeighbors; ++k) {
+          int x = col+gNeighborDx[k], y = row+gNeighborDy[k];
+          if (x < 0 || y < 0 || x >= w || y >= h)
+            continue;
+          if (k >= 4 && (blocked[row*w+x] || blocked[y*w+col]))
+            continue;
+          if (d[y*w+x] < best) {
+            best = d[y*w+x];
+            best_k = k;
+          }
+        }
+        
+        if (best_k < 0)
+          iField.iDirection[index] = Vector2(0.0, 0.0);
+        else
+          iField.iDirection[index] = Vector2(gNeighborDx[best_k], gNeighborDy[best_k]).unit();
+      }
+    }
+  }
+  
+private:
+  FlowField& iField;
+};
+
+// Constructors
+FlowField::FlowField(const Rect2& area, real cell_size)
+  : iArea(area), iCellSize(cell_size)
+{
+  assert(cell_size > 0.0);
+  iColumns = max(1, int(ceil(area.width()/cell_size)));
+  iRows    = max(1, int(ceil(area.height()/cell_size)));
+  iGoal    = area.center();
+  
+  int size = iColumns*iRows;
+  iBlocked.resize(size, 0);
+  iDistance.resize(size, REAL_MAX);
+  iDirection.resize(size, Vector2(0.0, 0.0));
+}
+
+// Accessors
+const Rect2& FlowField::area() const
+{
+  return iArea;
+}
+
+real FlowField::cellSize() const
+{
+  return iCellSize;
+}
+
+int FlowField::columns() const
+{
+  return iColumns;
+}
+
+int FlowField::rows() const
+{
+  return iRows;
+}
+
+Point2 FlowField::goal() const
+{
+  return iGoal;
+}
+
+// Request
+bool FlowField::isInside(const Point2& p) const
+{
+  return cellIndex(p) >= 0;
+}
+
+bool FlowField::isBlocked(const Point2& p) const
+{
+  int i = cellIndex(p);
+  return i >= 0 && iBlocked[i];
+}
+
+bool FlowField::isReachable(const Point2& p) const
+{
+  return distance(p) != REAL_MAX;
+}
+
+// Calculations
+/*! Distance along grid from \a p to goal. REAL_MAX if goal can't be reached */
+real FlowField::distance(const Point2& p) const
+{
+  int i = cellIndex(p);
+  return i >= 0 ? iDistance[i] : REAL_MAX;
+}
+
+/*! Unit vector pointing in direction to move from \a p to get to goal */
+Vector2 FlowField::direction(const Point2& p) const
+{
+  int i = cellIndex(p);
+  return i >= 0 ? iDirection[i] : Vector2(0.0, 0.0);
+}
+
+/*! 
+  Looks up direction for \a n positions given as separate coordinate arrays
+  \a xs and \a ys. Directions are written to \a dxs and \a dys. Positions outside
+  field get a zero direction.
+*/
+void FlowField::sample(const real* xs, const real* ys, int n, real* dxs, real* dys) const
+{
+  real x0 = iArea.xmin(), y0 = iArea.ymin();
+  real inv_size = 1.0/iCellSize;
+  
+  for (int i = 0; i < n; ++i) {
+    int col = int(floor((xs[i]-x0)*inv_size));
+    int row = int(floor((ys[i]-y0)*inv_size));
+    if (col < 0 || row < 0 || col >= iColumns || row >= iRows) {
+      dxs[i] = dys[i] = 0.0;
+    }
+    else {
+      const Vector2& dir = iDirection[row*iColumns+col];
+      dxs[i] = dir.x();
+      dys[i] = dir.y();
+    }
+  }
+}
+
+void FlowField::sample(const Points2& positions, Points2& directions) const
+{
+  directions.resize(positions.size());
+  for (size_t i = 0; i < positions.size(); ++i)
+    directions[i] = direction(positions[i]);
+}
+
+// Operations
+/*! Recomputes distance and direction fields towards \a goal */
+void FlowField::setGoal(const Point2& goal)
+{
+  iGoal = goal;
+  integrate();
+  buildDirections(0, iRows);
+}
+
+/*! Rasterize all of \a obstacles onto grid and recompute fields */
+void FlowField::rasterize(Shape* obstacles)
+{
+  assert(obstacles != 0);
+  rasterize(obstacles, 0, 0, iColumns, iRows);
+  integrate();
+  buildDirections(0, iRows);
+}
+
+/*! 
+  Rasterize only cells touching \a region. Call when obstacles in \a region
+  have moved. Fields are only recomputed if cells changed state, and only
+  for cells no closer to the goal than the changed cells. Gather the
+  regions which changed rather than updating for every sprite that moves.
+  \return true if any cell changed.
+*/
+bool FlowField::update(Shape* obstacles, const Rect2& region)
+{
+  assert(obstacles != 0);
+  real x0 = iArea.xmin(), y0 = iArea.ymin();
+  int col_begin = max(0, int(floor((region.xmin()-x0)/iCellSize)));
+  int row_begin = max(0, int(floor((region.ymin()-y0)/iCellSize)));
+  int col_end   = min(iColumns, int(floor((region.xmax()-x0)/iCellSize))+1);
+  int row_end   = min(iRows, int(floor((region.ymax()-y0)/iCellSize))+1);
+  
+  if (col_begin >= col_end || row_begin >= row_end)
+    return false;
+    
+  int noColumns = col_end-col_begin;
+  vector<ubyte> before(noColumns*(row_end-row_begin));
+  for (int row = row_begin; row < row_end; ++row)
+    copy(&iBlocked[row*iColumns+col_begin], &iBlocked[row*iColumns+col_end], &before[(row-row_begin)*noColumns]);
+    
+  if (!rasterize(obstacles, col_begin, row_begin, col_end, row_end))
+    return false;
+    
+  vector<int> changed;
+  for (int row = row_begin; row < row_end; ++row) {
+    for (int col = col_begin; col < col_end; ++col) {
+      int index = row*iColumns+col;
+      if (iBlocked[index] != before[(row-row_begin)*noColumns+col-col_begin])
+        changed.push_back(index);
+    }
+  }
+  
+  int dir_begin, dir_end;
+  integrate(changed, dir_begin, dir_end);
+  buildDirections(dir_begin, dir_end);
+  return true;
+}
+
+/*!
+  Sets direction of all sprites in \a group to the direction of the
+  field at their position. If \a speed is positive the speed of sprites is 
+  set as well. Sprites at goal or outside field are not touched.
+  \return number of sprites steered.
+*/
+int FlowField::steer(Shape* group, real speed)
+{
+  assert(group != 0);
+  vector<Sprite*> sprites;
+  vector<real>    xs, ys;
+  
+  ShapeIterator* it = group->iterator();
+  for (it->first(); !it->done(); it->next()) {
+    Sprite* sprite = dynamic_cast<Sprite*>(it->value());
+    if (sprite == 0)
+      continue;
+    Point2 p = sprite->position();
+    sprites.push_back(sprite);
+    xs.push_back(p.x());
+    ys.push_back(p.y());
+  }
+  
+  int n = sprites.size();
+  if (n == 0)
+    return 0;
+    
+  vector<real> dxs(n), dys(n);
+  sample(&xs[0], &ys[0], n, &dxs[0], &dys[0]);
+  
+  int count = 0;
+  for (int i = 0; i < n; ++i) {
+    if (dxs[i] == 0.0 && dys[i] == 0.0)
+      continue;
+    sprites[i]->setDirection(Vector2(dxs[i], dys[i]));
+    if (speed > 0.0)
+      sprites[i]->setSpeed(speed);
+    ++count;
+  }
+  return count;
+}
+
+// Private
+int FlowField::cellIndex(const Point2& p) const
+{
+  int col = int(floor((p.x()-iArea.xmin())/iCellSize));
+  int row = int(floor((p.y()-iArea.ymin())/iCellSize));
+  if (col < 0 || row < 0 || col >= iColumns || row >= iRows)
+    return -1;
+  return row*iColumns+col;
+}
+
+Point2 FlowField::cellCenter(int col, int row) const
+{
+  return iArea.min() + Vector2((col+0.5)*iCellSize, (row+0.5)*iCellSize);
+}
+
+/*! Rasterize cells in given range. Returns true if any cell changed. */
+bool FlowField::rasterize(Shape* obstacles, int col_begin, int row_begin, int col_end, int row_end)
+{
+  Rect2 region(cellCenter(col_begin, row_begin) - Vector2(iCellSize, iCellSize)*0.5,
+               cellCenter(col_end-1, row_end-1) + Vector2(iCellSize, iCellSize)*0.5);
+  
+  vector<Shape*> candidates;
+  gatherSimpleShapes(obstacles, region, candidates);
+  
+  RasterizeTask task(*this, candidates, col_begin, col_end);
+  parallelFor(row_begin, row_end, task, 8);
+  return task.changed();
+}
+
+/*! Dijkstra sweep out from goal over free cells, 8 connected. Nothing is reachable if goal is blocked */
+void FlowField::integrate()
+{
+  fill(iDistance.begin(), iDistance.end(), REAL_MAX);
+  
+  int goal = cellIndex(iGoal);
+  if (goal < 0 || iBlocked[goal])
+    return;
+    
+  iDistance[goal] = 0.0;
+  sweep(vector<int>(1, goal));
+}
+
+/*!
+  Sweeps again after the cells in \a changed were blocked or freed. A path
+  shorter than the distance to the nearest cell next to a change can't go
+  through the change, so cells closer than that keep their distance, and
+  the sweep starts out from them. Rows where directions may have changed
+  are returned as [\a row_begin, \a row_end).
+*/
+void FlowField::integrate(const vector<int>& changed, int& row_begin, int& row_end)
+{
+  int  goal = cellIndex(iGoal);
+  real limit = REAL_MAX;
+  row_begin = iRows;
+  row_end = 0;
+  
+  for (size_t i = 0; i < changed.size(); ++i) {
+    int col = changed[i] % iColumns, row = changed[i] / iColumns;
+    row_begin = min(row_begin, row);
+    row_end = max(row_end, row+1);
+    for (int y = max(0, row-1); y < min(iRows, row+2); ++y)
+      for (int x = max(0, col-1); x < min(iColumns, col+2); ++x)
+        limit = min(limit, iDistance[y*iColumns+x]);
+  }
+  
+  // Nothing to start from when the goal or a cell next to it changed
+  if (limit == 0.0 || (goal >= 0 && find(changed.begin(), changed.end(), goal) != changed.end())) {
+    integrate();
+    row_begin = 0;
+    row_end = iRows;
+    return;
+  }
+  
+  if (limit != REAL_MAX) {
+    vector<int> sources;
+    real near = limit - 2.0*iCellSize;
+    for (int i = 0; i < int(iDistance.size()); ++i) {
+      if (iDistance[i] >= limit) {
+        iDistance[i] = REAL_MAX;
+        row_begin = min(row_begin, i / iColumns);
+        row_end = max(row_end, i / iColumns + 1);
+      }
+      else if (iDistance[i] >= near) {
+        sources.push_back(i);   // Closer cells can't reach past limit in one move
+      }
+    }
+    sweep(sources);
+  }
+  
+  // Neighbors of cells which changed direction are one row further out
+  row_begin = max(0, row_begin-1);
+  row_end = min(iRows, row_end+1);
+}
+
+/*! Dijkstra sweep out from \a sources, which already have their distance set */
+void FlowField::sweep(const vector<int>& sources)
+{
+  typedef pair<real, int> Item;
+  priority_queue<Item, vector<Item>, greater<Item> > open;
+  
+  for (size_t i = 0; i < sources.size(); ++i)
+    open.push(Item(iDistance[sources[i]], sources[i]));
+  
+  while (!open.empty()) {
+    Item item = open.top();
+    open.pop();
+    int index = item.second;
+    if (item.first > iDistance[index])
+      continue; // Stale entry
+      
+    int col = index % iColumns, row = index / iColumns;
+    for (int k = 0; k < gNoNeighbors; ++k) {
+      int x = col+gNeighborDx[k], y = row+gNeighborDy[k];
+      if (x < 0 || y < 0 || x >= iColumns || y >= iRows)
+        continue;
+      int next = y*iColumns+x;
+      if (iBlocked[next])
+        continue;
+      // Don't cut corners of obstacles when moving diagonally
+      if (k >= 4 && (iBlocked[row*iColumns+x] || iBlocked[y*iColumns+col]))
+        continue;
+        
+      real d = item.first + gNeighborCost[k]*iCellSize;
+      if (d < iDistance[next]) {
+        iDistance[next] = d;
+        open.push(Item(d, next));
+      }
+    }
+  }
+}
+
+/*! Rebuilds direction field for rows [\a row_begin, \a row_end) */
+void FlowField::buildDirections(int row_begin, int row_end)
+{
+  DirectionTask task(*this);
+  parallelFor(row_begin, row_end, task, 16);
+}
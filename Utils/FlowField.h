@@ -0,0 +1,82 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#pragma once
+
+#include "Types.h"
+
+#include <Geometry/Vector2.hpp>
+#include <Geometry/Rect2.hpp>
+
+#include <vector>
+
+// Forward references
+class Shape;
+
+class FlowField
+{
+public:
+  // Constructors
+  FlowField(const Rect2& area, real cell_size);
+  
+  // Accessors
+  const Rect2& area() const;
+  real    cellSize() const;
+  int     columns() const;
+  int     rows() const;
+  Point2  goal() const;
+  
+  // Request
+  bool    isInside(const Point2& p) const;
+  bool    isBlocked(const Point2& p) const;
+  bool    isReachable(const Point2& p) const;
+  
+  // Calculations
+  real    distance(const Point2& p) const;
+  Vector2 direction(const Point2& p) const;
+  void    sample(const real* xs, const real* ys, int n, real* dxs, real* dys) const;
+  void    sample(const Points2& positions, Points2& directions) const;
+  
+  // Operations
+  void    setGoal(const Point2& goal);
+  void    rasterize(Shape* obstacles);
+  bool    update(Shape* obstacles, const Rect2& region);
+  int     steer(Shape* group, real speed = 0.0);
+
+private:
+  int     cellIndex(const Point2& p) const;
+  Point2  cellCenter(int col, int row) const;
+  bool    rasterize(Shape* obstacles, int col_begin, int row_begin, int col_end, int row_end);
+  void    integrate();
+  void    integrate(const std::vector<int>& changed, int& row_begin, int& row_end);
+  void    sweep(const std::vector<int>& sources);
+  void    buildDirections(int row_begin, int row_end);
+  
+  friend class RasterizeTask;
+  friend class DirectionTask;
+  
+private:
+  Rect2   iArea;
+  real    iCellSize;
+  int     iColumns, iRows;
+  Point2  iGoal;
+  
+  std::vector<ubyte>    iBlocked;
+  std::vector<real>     iDistance;    // Integration field, REAL_MAX where goal can't be reached
+  std::vector<Vector2>  iDirection;   // Unit vectors towards goal, zero when at goal or unreachable
+};
@@ -21,6 +21,16 @@
 
 #include "Types.h"
 
+#ifdef HEADLESS
+// No OpenGL in headless builds, but views still keep their draw style
+typedef unsigned int GLenum;
+#define GL_LINE_LOOP  0x0002
+#define GL_LINE_STRIP 0x0003
+#define GL_POLYGON    0x0009
+#else
+#include <OpenGL/gl.h>
+#endif
+
 void gltTranslate(const Point2& pos);
 void gltVertex(const Point2& pos);
 void gltVertex(const Rect2& rect);
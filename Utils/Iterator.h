@@ -15,6 +15,8 @@
 
 #include <vector>
 #include <set>
+#include <map>
+#include <cassert>
 /*!
   Thrown when trying to dereference an iterator and it is pointing beyond end
   or before beginning. 
@@ -128,6 +130,36 @@ private:
   iterator i;  
 };
 
+/*!
+  Iterates over the values of a map, in the order of their keys.
+*/
+template<class K, class T>
+class MapValueIterator : public Iterator<T>
+{
+public:
+  typedef typename std::map<K, T>::const_iterator iterator;
+  
+public:
+  MapValueIterator(const std::map<K, T>& container) 
+    : c(container),
+      i(container.begin()) {}
+  
+  void first()      { i = c.begin(); } 
+  bool done() const { return i == c.end(); } 
+  void next()       { ++i; } 
+
+  /*! \throw IteratorOutOfBoundsException */
+  const T& value() const { 
+    if (done())
+      throw IteratorOutOfBoundsException();
+    return i->second;
+  }
+
+private:
+  const std::map<K, T>& c;
+  iterator i;  
+};
+
 /*!
   Subclass mean to wrap an STL type of iterator. You provide
   in the constructor the range you want to iterate over with this
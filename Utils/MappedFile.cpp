@@ -0,0 +1,105 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+
+#include "Utils/MappedFile.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/*!
+  \class MappedFile MappedFile.h
+  \brief Read only memory mapped file.
+  
+  Used for loading precomputed binary data at startup without reading
+  and parsing it. Mapping is released when object is destroyed.
+*/
+
+// Constructors
+MappedFile::MappedFile() : iData(0), iSize(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+// Accessors
+const char* MappedFile::data() const
+{
+  return iData;
+}
+
+size_t MappedFile::size() const
+{
+  return iSize;
+}
+
+// Request
+bool MappedFile::isOpen() const
+{
+  return iData != 0;
+}
+
+// Operations
+/*! Map file at \a path. Returns false if it could not be opened or is empty */
+bool MappedFile::open(const std::string& path)
+{
+  close();
+  
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+    
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+    ::close(fd);
+    return false;
+  }
+  
+  void* data = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);  // Mapping stays valid after file is closed
+  if (data == MAP_FAILED)
+    return false;
+    
+  iData = (const char*)data;
+  iSize = info.st_size;
+  return true;
+}
+
+void MappedFile::close()
+{
+  if (iData != 0)
+    munmap((void*)iData, iSize);
+  iData = 0;
+  iSize = 0;
+}
+
+/*!
+  Ask the OS to read the whole mapping in ahead of time, so later access
+  does not page fault. Returns at once, reading is done in the background.
+*/
+void MappedFile::prefetch() const
+{
+  if (iData != 0)
+    madvise((void*)iData, iSize, MADV_WILLNEED);
+}
@@ -0,0 +1,56 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+/*!
+  Read only memory mapping of a whole file. Contents are paged in by
+  the OS on demand, so opening even a large file is cheap.
+*/
+class MappedFile
+{
+public:
+  // Constructors
+  MappedFile();
+  ~MappedFile();
+  
+  // Accessors
+  const char* data() const;
+  size_t      size() const;
+  
+  // Request
+  bool  isOpen() const;
+  
+  // Operations
+  bool  open(const std::string& path);
+  void  close();
+  void  prefetch() const;
+  
+private:
+  MappedFile(const MappedFile&);
+  MappedFile& operator=(const MappedFile&);
+  
+private:
+  const char* iData;
+  size_t      iSize;
+};
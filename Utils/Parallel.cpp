@@ -0,0 +1,151 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "Utils/Parallel.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <vector>
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+
+/*!
+  \file Parallel.cpp
+  \brief Minimal data parallel helpers built on pthreads.
+  
+  Chunks are run by a pool with one thread per extra processor, started
+  on first use and kept for the rest of the program, so calls don't pay
+  for starting threads. Only one parallelFor() uses the pool at a time.
+  A call made while it is busy, from another thread or from within a
+  task, runs its whole range on the calling thread.
+*/
+
+struct RangeJob 
+{
+  RangeTask* task;
+  int begin, end;
+};
+
+static pthread_mutex_t  gPoolLock  = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   gWorkReady = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t   gWorkDone  = PTHREAD_COND_INITIALIZER;
+static vector<RangeJob> gJobs;            // Chunks of the running parallelFor()
+static size_t           gNextJob = 0;     // First chunk not yet taken
+static int              gNoPending = 0;   // Chunks taken or not, still running
+static int              gNoWorkers = 0;
+static bool             gBusy = false;
+
+/*! Runs chunks of the current call until none are left. Called with gPoolLock held */
+static void runJobs()
+{
+  while (gNextJob < gJobs.size()) {
+    RangeJob job = gJobs[gNextJob++];
+    pthread_mutex_unlock(&gPoolLock);
+    job.task->run(job.begin, job.end);
+    pthread_mutex_lock(&gPoolLock);
+    if (--gNoPending == 0)
+      pthread_cond_signal(&gWorkDone);
+  }
+}
+
+static void* runWorker(void*)
+{
+  pthread_mutex_lock(&gPoolLock);
+  for (;;) {
+    while (gNextJob >= gJobs.size())
+      pthread_cond_wait(&gWorkReady, &gPoolLock);
+    runJobs();
+  }
+  return 0;
+}
+
+/*! Starts pool threads up to one per extra processor. Called with gPoolLock held */
+static void startWorkers()
+{
+  while (gNoWorkers < noProcessors()-1) {
+    pthread_t thread;
+    if (pthread_create(&thread, 0, runWorker, 0) != 0)
+      break;  // Calling thread does the work of missing threads
+    pthread_detach(thread);
+    ++gNoWorkers;
+  }
+}
+
+/*! Number of processors online, at least 1 */
+int noProcessors()
+{
+  static int count = 0;
+  if (count == 0) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    count = n > 0 ? int(n) : 1;
+  }
+  return count;
+}
+
+/*!
+  Splits range [begin, end) into one chunk per processor and calls
+  task.run() for each of them on the pool threads and the calling thread.
+  No chunk will be smaller than 'min_range' so small ranges run
+  on calling thread only. Returns when all chunks are done.
+*/
+void parallelFor(int begin, int end, RangeTask& task, int min_range)
+{
+  assert(min_range > 0);
+  int size = end - begin;
+  if (size <= 0)
+    return;
+    
+  int noChunks = min(noProcessors(), max(1, size / min_range));
+  if (noChunks == 1) {
+    task.run(begin, end);
+    return;
+  }
+  
+  pthread_mutex_lock(&gPoolLock);
+  if (gBusy) {
+    pthread_mutex_unlock(&gPoolLock);
+    task.run(begin, end);
+    return;
+  }
+  gBusy = true;
+  startWorkers();
+  
+  gJobs.resize(noChunks);
+  int chunk = size / noChunks;
+  for (int i = 0; i < noChunks; ++i) {
+    gJobs[i].task  = &task;
+    gJobs[i].begin = begin + i*chunk;
+    gJobs[i].end   = i == noChunks-1 ? end : gJobs[i].begin + chunk;
+  }
+  gNextJob = 0;
+  gNoPending = noChunks;
+  pthread_cond_broadcast(&gWorkReady);
+  
+  runJobs();
+  while (gNoPending > 0)
+    pthread_cond_wait(&gWorkDone, &gPoolLock);
+    
+  gJobs.clear();
+  gNextJob = 0;
+  gBusy = false;
+  pthread_mutex_unlock(&gPoolLock);
+}
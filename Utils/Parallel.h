@@ -0,0 +1,35 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+/*!
+  Implement run() to do work on the half open range [begin, end). 
+  parallelFor() may call run() from several threads at once on
+  non overlapping ranges, so it should not modify shared state.
+*/
+class RangeTask
+{
+public:
+  virtual ~RangeTask() {}
+  virtual void run(int begin, int end) = 0;
+};
+
+int   noProcessors();
+void  parallelFor(int begin, int end, RangeTask& task, int min_range = 1);
@@ -18,10 +18,13 @@
 */
 
 #include "Utils/PolygonUtils.h"
+#include "Utils/Counters.h"
 #include <Geometry/IO.hpp>
 #include <Geometry/Ray2.hpp>
 
 #include <numeric>
+#include <limits>
+#include <iterator>
 #include <iostream>
 
 using namespace std;
@@ -61,6 +64,7 @@ bool intersect(
   ConstPointIterator2 qb, // Start of second polygon
   ConstPointIterator2 qe)
 {
+  COUNT(POLYGON_TESTS);
   Points2 d1(pe-pb), d2(qe-qb);  // holds directions
   
   // Find direction of each edge in polygons
@@ -86,6 +90,7 @@ bool intersect(const Points2& p1, const Points2& p2)
 
 bool intersect(const Segment2& s, ConstPointIterator2 begin, ConstPointIterator2 end)
 {
+  COUNT(POLYGON_TESTS);
   ConstPointIterator2 it = begin, prev = begin;
   for (++it; it != end; ++it, ++prev) {
     if (s.intersect(Segment2(*prev, *it)))
@@ -96,6 +101,7 @@ bool intersect(const Segment2& s, ConstPointIterator2 begin, ConstPointIterator2
 
 bool intersect(const Rect2& rect, ConstPointIterator2 begin, ConstPointIterator2 end)
 {
+  COUNT(POLYGON_TESTS);
   Segment2 bottom(rect.bottomLeft(), rect.bottomRight());
   Segment2 top(rect.topLeft(), rect.topRight());
   Segment2 left(rect.bottomLeft(), rect.topLeft());
@@ -112,22 +118,6 @@ bool intersect(const Rect2& rect, ConstPointIterator2 begin, ConstPointIterator2
   return false;  
 }
 
-/**
- * Only works for convex shapes which are counter clockwise
- */
-static bool fastInside(ConstPointIterator2 pb, ConstPointIterator2 pe, const Point2& q)
-{
-  Points2::const_iterator p;
-  for (p = pb+1; p != pe; ++p) {
-    if ((*p - *(p-1)).cross(q - *(p-1)) <= 0.0)
-      return false;
-  }
-  if ((*pb - *(p-1)).cross(q - *(p-1)) <= 0.0)
-    return false;
-
-  return true;
-}
-
 /**
  * Only works for convex shapes but we can easily improve it to work for others
  */
@@ -0,0 +1,386 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+
+#include "Utils/Profiler.h"
+#include "Utils/Counters.h"
+
+#include "Timing.h"
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <cmath>
+
+using namespace std;
+
+/*!
+  \file Profiler.cpp
+  \brief Hierarchical zone profiler with per frame statistics.
+
+  Each thread writes a timing event into its own ring buffer when a
+  PROFILE_ZONE ends. Only the owning thread writes to a buffer, so no locks
+  are taken while profiling. profileEndFrame() folds the events of the
+  frame into a tree of zones on the calling thread, which keeps the time
+  spent per frame in each zone for the last frames. World::step() ends a
+  frame after each simulation step.
+
+  profileStats() and profileReport() give min, average, 99th percentile and
+  max time per frame for each zone, and saveChromeTrace() writes the events
+  still in the buffers as a Chrome trace, which can be opened at
+  chrome://tracing.
+
+  Profiling is off until setProfilingEnabled() is called, in which case
+  a zone costs a branch.
+*/
+
+static const uint32 gBufferSize = 1 << 16;   // Events per thread, power of two
+static const uint32 gHistorySize = 256;      // Frames kept for statistics
+
+struct ProfileEvent
+{
+  const char* name;
+  real        start;
+  real        end;
+  int         depth;
+};
+
+/*! Zone in tree of zones, which is called from zone \a parent */
+struct ProfileNode
+{
+  const char*     name;
+  int             parent;
+  int             depth;
+  vector<int>     children;
+  uint32          firstFrame;
+  real            frameTime;
+  uint32          frameCalls;
+  vector<real>    times;
+  vector<uint32>  calls;
+};
+
+struct ProfileThread
+{
+  vector<ProfileEvent>  events;
+  volatile uint32       noWritten;
+  uint32                noAggregated;
+  int                   depth;
+  int                   id;
+  uint32                noFrames;
+  vector<ProfileNode>   nodes;     // Node 0 is root of tree
+};
+
+static volatile bool  gEnabled = false;
+static pthread_key_t  gThreadKey;
+static pthread_once_t gThreadOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t gThreadsLock = PTHREAD_MUTEX_INITIALIZER;
+static vector<ProfileThread*> gThreads;
+static int            gNextThreadId = 1;
+
+static void clearNodes(ProfileThread* thread)
+{
+  ProfileNode root = { "", -1, -1, vector<int>(), 0, 0.0, 0, vector<real>(), vector<uint32>() };
+  thread->nodes.assign(1, root);
+  thread->noFrames = 0;
+}
+
+static void destroyThread(void* data)
+{
+  ProfileThread* thread = (ProfileThread*)data;
+  pthread_mutex_lock(&gThreadsLock);
+  gThreads.erase(remove(gThreads.begin(), gThreads.end(), thread), gThreads.end());
+  pthread_mutex_unlock(&gThreadsLock);
+  delete thread;
+}
+
+static void createThreadKey()
+{
+  pthread_key_create(&gThreadKey, destroyThread);
+}
+
+/*! Profiling state of calling thread. Created if \a create is true */
+static ProfileThread* currentThread(bool create)
+{
+  pthread_once(&gThreadOnce, createThreadKey);
+  ProfileThread* thread = (ProfileThread*)pthread_getspecific(gThreadKey);
+  if (thread == 0 && create) {
+    thread = new ProfileThread;
+    thread->events.resize(gBufferSize);
+    thread->noWritten = 0;
+    thread->noAggregated = 0;
+    thread->depth = 0;
+    clearNodes(thread);
+
+    pthread_mutex_lock(&gThreadsLock);
+    thread->id = gNextThreadId++;
+    gThreads.push_back(thread);
+    pthread_mutex_unlock(&gThreadsLock);
+    pthread_setspecific(gThreadKey, thread);
+  }
+  return thread;
+}
+
+/*! Index of child zone \a name of node \a parent, added if missing */
+static int childNode(ProfileThread* thread, int parent, const char* name)
+{
+  vector<int>& children = thread->nodes[parent].children;
+  for (vector<int>::iterator it = children.begin(); it != children.end(); ++it) {
+    const char* other = thread->nodes[*it].name;
+    if (other == name || strcmp(other, name) == 0)
+      return *it;
+  }
+
+  ProfileNode node = { name, parent, thread->nodes[parent].depth+1, vector<int>(),
+                       thread->noFrames, 0.0, 0, vector<real>(gHistorySize), vector<uint32>(gHistorySize) };
+  int index = thread->nodes.size();
+  thread->nodes.push_back(node);
+  thread->nodes[parent].children.push_back(index);
+  return index;
+}
+
+struct CompareEventStart : public binary_function<ProfileEvent, ProfileEvent, bool>
+{
+  bool operator()(const ProfileEvent& first, const ProfileEvent& second) const {
+    if (first.start != second.start)
+      return first.start < second.start;
+    return first.depth < second.depth;
+  }
+};
+
+static void nodeStats(const ProfileThread* thread, int index, ZoneStatsList& stats)
+{
+  const ProfileNode& node = thread->nodes[index];
+  uint32 n = index == 0 ? 0 : min(thread->noFrames-node.firstFrame, gHistorySize);
+  if (n > 0) {
+    // Last n frames, which wrap around in history
+    vector<real> times(n);
+    real total = 0.0;
+    uint32 calls = 0;
+    for (uint32 i = 0; i < n; ++i) {
+      uint32 slot = (thread->noFrames-1-i) % gHistorySize;
+      times[i] = node.times[slot];
+      total += times[i];
+      calls += node.calls[slot];
+    }
+
+    ZoneStats s;
+    s.name = node.name;
+    s.depth = node.depth;
+    s.calls = real(calls)/n;
+    s.avg = total/n;
+    s.min = *min_element(times.begin(), times.end());
+    s.max = *max_element(times.begin(), times.end());
+    vector<real>::iterator p99 = times.begin() + (uint32)ceil(0.99*n) - 1;
+    nth_element(times.begin(), p99, times.end());
+    s.p99 = *p99;
+    stats.push_back(s);
+  }
+
+  vector<int>::const_iterator it;
+  for (it = node.children.begin(); it != node.children.end(); ++it)
+    nodeStats(thread, *it, stats);
+}
+
+static void writeJsonString(ostream& out, const char* s)
+{
+  out << '"';
+  for (; *s; ++s) {
+    if (*s == '"' || *s == '\\')
+      out << '\\';
+    out << *s;
+  }
+  out << '"';
+}
+
+/*!
+    \class ProfileZone Profiler.h
+    \brief Times the scope it lives in. Use the PROFILE_ZONE macro.
+*/
+
+// Constructors
+ProfileZone::ProfileZone(const char* name) : iName(name), iStart(0.0), iThread(0)
+{
+  if (!gEnabled)
+    return;
+  iThread = currentThread(true);
+  ++iThread->depth;
+  iStart = monotonicSeconds();
+}
+
+ProfileZone::~ProfileZone()
+{
+  if (iThread == 0)
+    return;
+  ProfileThread* thread = iThread;
+  ProfileEvent& e = thread->events[thread->noWritten & (gBufferSize-1)];
+  e.name = iName;
+  e.start = iStart;
+  e.end = monotonicSeconds();
+  e.depth = --thread->depth;
+  __sync_synchronize();   // Event is written before other threads see it
+  ++thread->noWritten;
+}
+
+// Accessors
+/*! Turns recording of zones on or off for all threads */
+void setProfilingEnabled(bool enabled)
+{
+  gEnabled = enabled;
+}
+
+bool isProfilingEnabled()
+{
+  return gEnabled;
+}
+
+// Request
+/*!
+  Statistics for each zone run on calling thread, in seconds per frame over
+  the last frames. Zones are listed depth first, children after parents.
+*/
+void profileStats(ZoneStatsList& stats)
+{
+  stats.clear();
+  ProfileThread* thread = currentThread(false);
+  if (thread)
+    nodeStats(thread, 0, stats);
+}
+
+/*!
+  Table of profileStats() in milliseconds, with children indented. When
+  built with COUNTERS it is followed by the counts of the last frame.
+*/
+string profileReport()
+{
+  ZoneStatsList stats;
+  profileStats(stats);
+
+  ostringstream out;
+  out << left << setw(28) << "zone (ms per frame)" << right
+      << setw(8) << "calls" << setw(9) << "min" << setw(9) << "avg"
+      << setw(9) << "p99" << setw(9) << "max" << endl;
+  out << fixed;
+  ZoneStatsList::iterator s;
+  for (s = stats.begin(); s != stats.end(); ++s) {
+    out << left << setw(28) << string(2*s->depth, ' ') + s->name << right
+        << setprecision(1) << setw(8) << s->calls << setprecision(3)
+        << setw(9) << s->min*1000.0 << setw(9) << s->avg*1000.0
+        << setw(9) << s->p99*1000.0 << setw(9) << s->max*1000.0 << endl;
+  }
+#ifdef COUNTERS
+  out << endl << counterReport();
+#endif
+  return out.str();
+}
+
+// Operations
+/*!
+  Adds time spent in each zone since last call to the statistics of
+  calling thread, as one frame.
+*/
+void profileEndFrame()
+{
+  ProfileThread* thread = currentThread(false);
+  if (thread == 0)
+    return;
+
+  uint32 end = thread->noWritten;
+  uint32 begin = thread->noAggregated;
+  if (end-begin > gBufferSize)
+    begin = end-gBufferSize;   // Oldest events were overwritten
+
+  vector<ProfileEvent> events;
+  events.reserve(end-begin);
+  for (uint32 i = begin; i != end; ++i)
+    events.push_back(thread->events[i & (gBufferSize-1)]);
+  sort(events.begin(), events.end(), CompareEventStart());
+
+  // Parent of a zone is the last zone started before it at lower depth
+  vector< pair<int, int> > open;   // Depth and node of enclosing zones
+  vector<ProfileEvent>::iterator e;
+  for (e = events.begin(); e != events.end(); ++e) {
+    while (!open.empty() && open.back().first >= e->depth)
+      open.pop_back();
+    int parent = open.empty() ? 0 : open.back().second;
+    int index = childNode(thread, parent, e->name);
+    thread->nodes[index].frameTime += e->end-e->start;
+    ++thread->nodes[index].frameCalls;
+    open.push_back(make_pair(e->depth, index));
+  }
+
+  uint32 slot = thread->noFrames % gHistorySize;
+  vector<ProfileNode>::iterator node;
+  for (node = thread->nodes.begin()+1; node != thread->nodes.end(); ++node) {
+    node->times[slot] = node->frameTime;
+    node->calls[slot] = node->frameCalls;
+    node->frameTime = 0.0;
+    node->frameCalls = 0;
+  }
+  ++thread->noFrames;
+  thread->noAggregated = end;
+}
+
+/*! Forgets statistics of calling thread */
+void profileReset()
+{
+  ProfileThread* thread = currentThread(false);
+  if (thread == 0)
+    return;
+  thread->noAggregated = thread->noWritten;
+  clearNodes(thread);
+}
+
+/*!
+  Writes zones still in the buffers of all threads to \a path in the Chrome
+  trace event format. Returns false if file could not be written.
+*/
+bool saveChromeTrace(const string& path)
+{
+  ofstream out(path.c_str());
+  if (!out)
+    return false;
+
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  out << fixed << setprecision(3);
+  bool first = true;
+  pthread_mutex_lock(&gThreadsLock);
+  vector<ProfileThread*>::iterator it;
+  for (it = gThreads.begin(); it != gThreads.end(); ++it) {
+    ProfileThread* thread = *it;
+    uint32 end = thread->noWritten;
+    __sync_synchronize();
+    uint32 begin = end > gBufferSize ? end-gBufferSize : 0;
+    for (uint32 i = begin; i != end; ++i) {
+      const ProfileEvent& e = thread->events[i & (gBufferSize-1)];
+      out << (first ? "\n" : ",\n") << "{\"name\":";
+      writeJsonString(out, e.name);
+      out << ",\"cat\":\"lusion\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->id
+          << ",\"ts\":" << e.start*1e6 << ",\"dur\":" << (e.end-e.start)*1e6 << "}";
+      first = false;
+    }
+  }
+  pthread_mutex_unlock(&gThreadsLock);
+  out << "\n]}" << endl;
+  return out.good();
+}
@@ -0,0 +1,92 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+
+#pragma once
+
+#include "Types.h"
+
+#include <string>
+#include <vector>
+
+/*!
+  Profiles the enclosing scope as a zone called \a name, which must be a
+  string literal. Zones nest, so a zone opened while another is open is
+  reported as its child. Define NO_PROFILE to compile all zones out.
+
+  \code
+  void Group::update(real start_time, real delta_time)
+  {
+    PROFILE_ZONE("shape update");
+    ...
+  }
+  \endcode
+*/
+#ifdef NO_PROFILE
+#define PROFILE_ZONE(name)
+#else
+#define PROFILE_ZONE_CONCAT2(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT2(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_ZONE_CONCAT(profileZone, __LINE__)(name)
+#endif
+
+struct ProfileThread;
+
+/*! Timing of one zone over the last frames, in seconds per frame */
+struct ZoneStats
+{
+  std::string name;
+  int         depth;
+  real        calls;   // Average calls per frame
+  real        min;
+  real        avg;
+  real        p99;
+  real        max;
+};
+
+typedef std::vector<ZoneStats> ZoneStatsList;
+
+class ProfileZone
+{
+public:
+  // Constructors
+  ProfileZone(const char* name);
+  ~ProfileZone();
+
+private:
+  ProfileZone(const ProfileZone&);
+  ProfileZone& operator=(const ProfileZone&);
+
+  const char*     iName;
+  real            iStart;
+  ProfileThread*  iThread;
+};
+
+// Accessors
+void   setProfilingEnabled(bool enabled);
+bool   isProfilingEnabled();
+
+// Request
+void        profileStats(ZoneStatsList& stats);
+std::string profileReport();
+
+// Operations
+void   profileEndFrame();
+void   profileReset();
+bool   saveChromeTrace(const std::string& path);
@@ -0,0 +1,86 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+
+#include "Utils/Random.h"
+
+#include <cassert>
+
+/*!
+  \class Random Random.h
+  \brief Seeded pseudo random number generator.
+
+  Uses xorshift128, which is fast, has a period of 2^128-1 and only needs
+  32 bit integer arithmetic. Each World has its own generator which replaces
+  math.random in Lua, so a recorded session gives the same random numbers
+  when it is played back.
+*/
+
+// Constructors
+Random::Random(uint32 seed)
+{
+  setSeed(seed);
+}
+
+// Accessors
+/*! Restarts sequence from \a seed */
+void Random::setSeed(uint32 seed)
+{
+  iSeed = seed;
+
+  // Spread seed over state with a linear congruential generator, since
+  // xorshift must not start from an all zero state
+  uint32 x = seed;
+  for (int i = 0; i < 4; ++i) {
+    x = x*1664525u + 1013904223u;
+    iState[i] = x ^ (x >> 16);
+  }
+  if ((iState[0] | iState[1] | iState[2] | iState[3]) == 0)
+    iState[0] = 1;
+}
+
+uint32 Random::seed() const
+{
+  return iSeed;
+}
+
+// Operations
+/*! Next 32 bit number in sequence */
+uint32 Random::next()
+{
+  uint32 t = iState[0] ^ (iState[0] << 11);
+  iState[0] = iState[1];
+  iState[1] = iState[2];
+  iState[2] = iState[3];
+  iState[3] = iState[3] ^ (iState[3] >> 19) ^ t ^ (t >> 8);
+  return iState[3];
+}
+
+/*! Uniformly distributed number in [0, 1) */
+real Random::uniform()
+{
+  return next()*(1.0/4294967296.0);
+}
+
+/*! Uniformly distributed integer in [lower, upper] */
+int Random::uniform(int lower, int upper)
+{
+  assert(lower <= upper);
+  return lower + static_cast<int>(uniform()*(real(upper)-real(lower)+1.0));
+}
@@ -0,0 +1,47 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+
+#pragma once
+
+#include "Types.h"
+
+/*!
+  Seeded pseudo random number generator. The same seed always gives the
+  same sequence on every platform, unlike rand().
+*/
+class Random
+{
+public:
+  // Constructors
+  Random(uint32 seed = 0);
+
+  // Accessors
+  void   setSeed(uint32 seed);
+  uint32 seed() const;
+
+  // Operations
+  uint32 next();
+  real   uniform();
+  int    uniform(int lower, int upper);
+
+private:
+  uint32 iSeed;
+  uint32 iState[4];
+};
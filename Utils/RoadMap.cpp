@@ -19,10 +19,13 @@
 #include <Utils/RoadMap.h>
 #include <Base/CircleShape.h>
 #include <Engine.h>
+#include <World.h>
 
 #include <Geometry/IO.hpp>
 
 #include <cassert>
+#include <limits>
+#include <algorithm>
 
 #include "Timing.h"
 
@@ -51,7 +54,12 @@ Shape* minkowskiSum(const Shape* group) {
 
 
 // Constructors
-ClosestPointFinder::ClosestPointFinder(Shape* obstacles, const Rect2& bbox) : iBBox(bbox), iObstacles(obstacles) {
+/*!
+  \a narrowPhase is passed in rather than read from the current world, since
+  a finder may be used on a worker thread which has no world of its own.
+*/
+ClosestPointFinder::ClosestPointFinder(Shape* obstacles, const Rect2& bbox, NarrowPhase narrowPhase) 
+  : iBBox(bbox), iObstacles(obstacles), iGathered(false), iNarrowPhase(narrowPhase) {
   assert(iObstacles != 0);
   iT = secondsPassed();
   iDt = 1.0;
@@ -72,8 +80,65 @@ bool ClosestPointFinder::execute(Shape* , Shape* , Points2& points, real, real)
   return true;
 }
 
+/*!
+  Gathers the simple shapes of the obstacles the first time it is called.
+  False if there are none or any of them has no convex parts, so GJK can't
+  be used.
+*/
+bool ClosestPointFinder::gatherConvexShapes()
+{
+  if (!iGathered) {
+    gatherSimpleShapes(iObstacles, iObstacles->boundingBox(), iShapes);
+    iGathered = true;
+    for (vector<Shape*>::iterator it = iShapes.begin(); it != iShapes.end(); ++it)
+      if ((*it)->noConvexParts() == 0) {
+        iShapes.clear();
+        break;
+      }
+  }
+  return !iShapes.empty();
+}
+
+/*!
+  Finds nearest obstacle from GJK distances instead of growing and shrinking
+  a disc. Shapes whose bounding box is further away than the nearest shape
+  found so far are skipped. If \a c is inside an obstacle it is the result.
+*/
+bool ClosestPointFinder::nearestConvexObstacle(const Point2& c, Point2& point_result)
+{
+  ConvexShape2 point(c);
+  real best = numeric_limits<real>::max();
+  for (vector<Shape*>::iterator it = iShapes.begin(); it != iShapes.end(); ++it) {
+    Rect2 box = (*it)->boundingBox();
+    Vector2 outside(max(max(box.xmin() - c.x(), c.x() - box.xmax()), 0.0),
+                    max(max(box.ymin() - c.y(), c.y() - box.ymax()), 0.0));
+    if (outside.squaredLength() >= best*best)
+      continue;
+
+    Point2 closest;
+    real dist = convexDistance(*it, point, &closest);
+    if (dist < best) {
+      best = dist;
+      point_result = closest;
+    }
+    if (best == 0.0) {
+      point_result = c;
+      break;
+    }
+  }
+  return best < numeric_limits<real>::max();
+}
+
+/*!
+  Finds point on obstacles closest to \a c. With GJK_NARROW_PHASE given to
+  the constructor it is computed from GJK distances, otherwise it is searched
+  for with disc collisions.
+*/
 bool ClosestPointFinder::nearestObstacle(const Point2& c, Point2& point_result)
 {
+  if (iNarrowPhase == GJK_NARROW_PHASE && gatherConvexShapes())
+    return nearestConvexObstacle(c, point_result);
+
   bool is_collision = false;
   real radius = 0.0;
 	
@@ -23,6 +23,7 @@
 #include <Base/Action.h>
 #include <Geometry/Vector2.hpp>
 #include <Geometry/Circle.hpp>
+#include <World.h>
 
 // Forward references
 class Shape;
@@ -34,7 +35,7 @@ class ClosestPointFinder : public CollisionAction
 {
 public:
   // Constructors
-  ClosestPointFinder(Shape* obstacles, const Rect2& bbox);
+  ClosestPointFinder(Shape* obstacles, const Rect2& bbox, NarrowPhase narrowPhase);
   
   // Operations
   void discCollision(const Circle& circle, Shape* shape, Points2& points);
@@ -43,9 +44,16 @@ public:
   bool equidistantVertex(const Vector2& c1, const Vector2&  c2, Vector2& c_v);
   bool retractSample(const Vector2& c, Vector2& c_v);
   
+private:
+  bool gatherConvexShapes();
+  bool nearestConvexObstacle(const Point2& c, Point2& point_result);
+  
 private:
   real iT, iDt;
   Points2 iPoints;
   Rect2   iBBox;
   Shape* iObstacles;
+  std::vector<Shape*> iShapes;  // Simple shapes of obstacles, for GJK
+  bool   iGathered;
+  NarrowPhase iNarrowPhase;
 };
@@ -0,0 +1,499 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "World.h"
+#include "LuaEngine.h"
+#include "Timing.h"
+#include "Replay.h"
+
+#include "Base/Group.h"
+#include "Base/Job.h"
+#include "Utils/Profiler.h"
+#include "Utils/Counters.h"
+#include "Utils/Parallel.h"
+
+#include <Core/AutoreleasePool.hpp>
+
+#include <pthread.h>
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+
+/*!
+    \class World World.h
+    \brief State of one running game instance.
+
+    Holds what used to be process wide state of the engine: the Lua state with
+    the game scripts, the group of shapes to render and simulate, the view and
+    frame timing. Global functions such as luaState(), renderGroup(),
+    worldView() and ticksPerFrame() operate on the current world of the
+    calling thread.
+
+    Each thread has its own current world, set with makeCurrent(), and its own
+    stack of autorelease pools. Thus independent worlds can be simulated on
+    separate threads, e.g. to run batches of headless AI simulations:
+
+    \code
+    World world;
+    world.start();              // Loads game scripts
+    world.run(10000);           // Simulates 10000 steps as fast as possible
+    world.stop();
+    \endcode
+
+    Threads which never call makeCurrent() use the main world, which is
+    the one driven by the GUI.
+
+    Random numbers used by scripts come from random(), which is reseeded
+    with randomSeed() each time the world is started. Together with the
+    fixed time step this makes a session repeatable, so it can be recorded
+    and played back with a Replay, see record() and play().
+
+    Slow work such as loading a level or building a roadmap is added as a
+    Job to jobs(), so it runs on a worker thread while the world keeps
+    updating. The result is published at the start of the first update()
+    after the job is done.
+*/
+
+static pthread_key_t  gCurrentWorldKey;
+static pthread_once_t gCurrentWorldOnce = PTHREAD_ONCE_INIT;
+
+static void createCurrentWorldKey()
+{
+  pthread_key_create(&gCurrentWorldKey, 0);
+}
+
+// Constructors
+World::World()
+  : iLuaState(0),
+    iRenderGroup(new Group),
+    iView(-20.0, -20.0, 20.0, 20.0),
+    iTicksPerFrame(30),
+    iDone(false),
+    iTimerStart(0),
+    iMaxCatchUpSteps(5),
+    iSimulationTime(0.0),
+    iStepping(false),
+    iNoSteps(0),
+    iAccumulator(0.0),
+    iLastAdvance(-1.0),
+    iInterpolation(1.0),
+    iRandomSeed(0),
+    iRecording(0),
+    iPlayback(0),
+    iPlaybackEvent(0),
+    iNarrowPhase(SAT_NARROW_PHASE),
+    iJobs(0)
+{
+  iJobs = new JobQueue(this, max(noProcessors()-1, 1));
+}
+
+World::~World()
+{
+  if (iLuaState)
+    stop();
+  iJobs->release();
+  iRenderGroup->release();
+  if (iRecording)
+    iRecording->release();
+  if (iPlayback)
+    iPlayback->release();
+  if (current() == this)
+    pthread_setspecific(gCurrentWorldKey, 0);
+}
+
+// Accessors
+lua_State* World::luaState() const
+{
+  return iLuaState;
+}
+
+void World::setLuaState(lua_State* L)
+{
+  iLuaState = L;
+}
+
+/*! All shapes in the world. They are drawn and updated each frame */
+Group* World::renderGroup() const
+{
+  return iRenderGroup;
+}
+
+void World::setView(const Rect2& view)
+{
+  iView = view;
+}
+
+Rect2 World::view() const
+{
+  return iView;
+}
+
+/*!
+  Milliseconds per frame. At least 1, since advance() divides by the step
+  length, so frame rates above 1000 run at 1000.
+*/
+void World::setTicksPerFrame(int ticks)
+{
+  iTicksPerFrame = max(ticks, 1);
+}
+
+int World::ticksPerFrame() const
+{
+  return iTicksPerFrame;
+}
+
+void World::setDone(bool done)
+{
+  iDone = done;
+}
+
+bool World::isDone() const
+{
+  return iDone;
+}
+
+void World::setTimerStart(int ticks)
+{
+  iTimerStart = ticks;
+}
+
+int World::timerStart() const
+{
+  return iTimerStart;
+}
+
+/*!
+  Most simulation steps advance() runs to catch up when frames are late.
+  Time beyond that is dropped, so the game slows down instead of spending
+  ever more time catching up.
+*/
+void World::setMaxCatchUpSteps(int steps)
+{
+  iMaxCatchUpSteps = steps;
+}
+
+int World::maxCatchUpSteps() const
+{
+  return iMaxCatchUpSteps;
+}
+
+/*! Seconds simulated so far, one ticksPerFrame() per step */
+real World::simulationTime() const
+{
+  return iSimulationTime;
+}
+
+/*!
+  Current time as seen by game code. While step() runs this is the
+  simulation time, so a replay sees the same times as the recording.
+  Otherwise it is wall clock time.
+*/
+real World::seconds() const
+{
+  return iStepping ? iSimulationTime : secondsPassed();
+}
+
+/*! Number of simulation steps run */
+uint32 World::noSteps() const
+{
+  return iNoSteps;
+}
+
+/*! Fraction of a step of time left over after last advance(), from 0 to 1 */
+real World::interpolation() const
+{
+  return iInterpolation;
+}
+
+/*! Seed random() is given when world is started */
+void World::setRandomSeed(uint32 seed)
+{
+  iRandomSeed = seed;
+}
+
+uint32 World::randomSeed() const
+{
+  return iRandomSeed;
+}
+
+/*! Random number generator used by math.random in Lua */
+Random& World::random()
+{
+  return iRandom;
+}
+
+/*!
+  How shapes which pass the bounding box test are tested for contact. With
+  GJK_NARROW_PHASE shapes with convex parts, see Shape::convexPart(), are
+  tested as solid with GJK, so a shape wholly inside another collides too.
+  Sprites keep the simplex of each pair to start from next step.
+*/
+void World::setNarrowPhase(NarrowPhase phase)
+{
+  iNarrowPhase = phase;
+}
+
+NarrowPhase World::narrowPhase() const
+{
+  return iNarrowPhase;
+}
+
+/*! Replay being recorded or 0 */
+Replay* World::recording() const
+{
+  return iRecording;
+}
+
+/*! Replay being played back or 0 */
+Replay* World::playback() const
+{
+  return iPlayback;
+}
+
+/*!
+  True while recording or playing back a replay. Planning then limits its
+  searches by number of expansions instead of by time, so it repeats.
+*/
+bool World::isDeterministic() const
+{
+  return iRecording != 0 || iPlayback != 0;
+}
+
+/*! Runs jobs such as level loading on worker threads, see Job */
+JobQueue* World::jobs() const
+{
+  return iJobs;
+}
+
+// Operations
+/*! Make this the world global engine functions operate on in calling thread */
+void World::makeCurrent()
+{
+  pthread_once(&gCurrentWorldOnce, createCurrentWorldKey);
+  pthread_setspecific(gCurrentWorldKey, this);
+}
+
+/*!
+  Rewinds simulation clock, reseeds random() and starts recording or
+  playback from the beginning. Called before game scripts are loaded.
+*/
+void World::reset()
+{
+  iDone = false;
+  iSimulationTime = 0.0;
+  iNoSteps = 0;
+  iAccumulator = 0.0;
+  iLastAdvance = -1.0;
+  iInterpolation = 1.0;
+
+  if (iPlayback)
+    iRandomSeed = iPlayback->seed();
+  iRandom.setSeed(iRandomSeed);
+  iPlaybackEvent = 0;
+  if (iRecording) {
+    iRecording->clear();
+    iRecording->setSeed(iRandomSeed);
+  }
+}
+
+/*!
+  Makes world current and loads the engine and game scripts into a new Lua
+  state. Does no rendering setup, so it can be used for headless worlds.
+*/
+void World::start()
+{
+  makeCurrent();
+  AutoreleasePool::begin();
+  reset();
+  initLua();
+  initGame();
+  AutoreleasePool::end();
+}
+
+/*!
+  Makes world current and advances it one frame by calling Engine.update in
+  Lua. Jobs which finished since last frame are published first.
+*/
+void World::update(real start_time)
+{
+  makeCurrent();
+  AutoreleasePool::begin();
+  iJobs->publish();
+  luaUpdate(start_time);
+  AutoreleasePool::end();
+}
+
+/*!
+  Runs one simulation step of ticksPerFrame() milliseconds. Engine.update
+  is called with simulationTime(), never wall clock time, so steps are
+  repeatable. When playing a replay the key events recorded before this
+  step are sent first, and the world is done once the replay ends. Each
+  step is one profiler frame.
+*/
+void World::step()
+{
+  {
+    PROFILE_ZONE("step");
+    if (iPlayback) {
+      if (iPlayback->ticksPerFrame() > 0)
+        iTicksPerFrame = iPlayback->ticksPerFrame();
+
+      const KeyEvents& events = iPlayback->keyEvents();
+      makeCurrent();
+      for (; iPlaybackEvent < events.size() && events[iPlaybackEvent].step <= iNoSteps; ++iPlaybackEvent)
+        luaSetEngineBoolean("keystate", events[iPlaybackEvent].key, events[iPlaybackEvent].pressed);
+    }
+    if (iRecording && iNoSteps == 0)
+      iRecording->setTicksPerFrame(iTicksPerFrame);
+
+    iStepping = true;
+    update(iSimulationTime);
+    iStepping = false;
+  }
+  profileEndFrame();
+  countersEndFrame();
+  iSimulationTime += iTicksPerFrame*(1.0/1000.0);
+  ++iNoSteps;
+
+  if (iRecording)
+    iRecording->setNoSteps(iNoSteps);
+  if (iPlayback && iNoSteps >= iPlayback->noSteps())
+    iDone = true;
+}
+
+/*!
+  Fixed time step loop. Accumulates the time since the last call, given as
+  wall clock time \a now, and runs as many steps of ticksPerFrame() as fit in
+  it, but no more than maxCatchUpSteps(). Time left over is kept for the
+  next call and gives interpolation() for rendering between the last two
+  steps. Returns number of steps run.
+
+  \code
+  world.advance(secondsPassed());
+  renderFrame(secondsPassed());   // Draws sprites at interpolated positions
+  \endcode
+*/
+uint32 World::advance(real now)
+{
+  real dt = iTicksPerFrame*(1.0/1000.0);
+  if (iLastAdvance < 0.0)
+    iLastAdvance = now-dt;   // First call runs one step
+  real elapsed = max(0.0, now-iLastAdvance);
+  iLastAdvance = now;
+  iAccumulator = min(iAccumulator+elapsed, iMaxCatchUpSteps*dt);
+
+  // Tolerance keeps rounding from losing a step
+  uint32 due = static_cast<uint32>(iAccumulator/dt + 1e-9);
+  iAccumulator = max(0.0, iAccumulator-due*dt);
+
+  uint32 steps = 0;
+  while (steps < due && !iDone) {
+    step();
+    ++steps;
+  }
+  iInterpolation = iAccumulator/dt;
+  return steps;
+}
+
+/*!
+  Runs steps back to back without waiting for a timer, until the game sets
+  done or \a max_steps steps have run. \a max_steps of 0 means no limit.
+  Used to run headless simulations as fast as possible. Returns number of
+  steps run.
+*/
+uint32 World::run(uint32 max_steps)
+{
+  uint32 steps = 0;
+  while (!iDone && (max_steps == 0 || steps < max_steps)) {
+    step();
+    ++steps;
+  }
+  iInterpolation = 1.0;
+  return steps;
+}
+
+/*!
+  Records key events and steps into \a replay, which is cleared when the
+  world is started. Call before start(). 0 stops recording.
+*/
+void World::record(Replay* replay)
+{
+  if (replay)
+    replay->retain();
+  if (iRecording)
+    iRecording->release();
+  iRecording = replay;
+}
+
+/*!
+  Plays back \a replay from when the world is started. Call before start().
+  Live key events are ignored while playing. 0 stops playback.
+*/
+void World::play(Replay* replay)
+{
+  if (replay)
+    replay->retain();
+  if (iPlayback)
+    iPlayback->release();
+  iPlayback = replay;
+}
+
+/*!
+  Sends key event to scripts as Engine.setKeystate(key, pressed), and
+  records it to be sent before the next step when playing back.
+*/
+void World::keyEvent(int key, bool pressed)
+{
+  if (iPlayback)
+    return;
+  if (iRecording)
+    iRecording->addKeyEvent(iNoSteps, key, pressed);
+  makeCurrent();
+  luaSetEngineBoolean("keystate", key, pressed);
+}
+
+/*!
+  Cancels jobs and closes Lua state. Shapes in render group are kept.
+  Jobs are waited for since they may refer to shapes made by scripts.
+*/
+void World::stop()
+{
+  makeCurrent();
+  iJobs->cancel();
+  iJobs->wait();
+  iJobs->publish();
+  closeLua();
+}
+
+// Static access
+/*! World of calling thread, or main world if thread has not made one current */
+World* World::current()
+{
+  pthread_once(&gCurrentWorldOnce, createCurrentWorldKey);
+  World* world = (World*)pthread_getspecific(gCurrentWorldKey);
+  return world ? world : mainWorld();
+}
+
+/*! World driven by the GUI */
+World* World::mainWorld()
+{
+  static World world;
+  return &world;
+}
@@ -0,0 +1,128 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#pragma once
+
+#include "Types.h"
+
+#include <Utils/Random.h>
+
+#include <Geometry/Rect2.hpp>
+
+class Group;
+class JobQueue;
+class Replay;
+struct lua_State;
+
+enum NarrowPhase
+{
+  SAT_NARROW_PHASE,   // Separating axes and edge intersections
+  GJK_NARROW_PHASE    // GJK distance and EPA on convex parts
+};
+
+class World
+{
+public:
+  // Constructors
+  World();
+  virtual ~World();
+
+  // Accessors
+  lua_State*  luaState() const;
+  void        setLuaState(lua_State* L);
+  Group*      renderGroup() const;
+
+  void        setView(const Rect2& view);
+  Rect2       view() const;
+
+  void        setTicksPerFrame(int ticks);
+  int         ticksPerFrame() const;
+
+  void        setDone(bool done);
+  bool        isDone() const;
+
+  void        setTimerStart(int ticks);
+  int         timerStart() const;
+
+  void        setMaxCatchUpSteps(int steps);
+  int         maxCatchUpSteps() const;
+  real        simulationTime() const;
+  real        seconds() const;
+  uint32      noSteps() const;
+  real        interpolation() const;
+
+  void        setRandomSeed(uint32 seed);
+  uint32      randomSeed() const;
+  Random&     random();
+
+  void        setNarrowPhase(NarrowPhase phase);
+  NarrowPhase narrowPhase() const;
+
+  Replay*     recording() const;
+  Replay*     playback() const;
+  bool        isDeterministic() const;
+
+  JobQueue*   jobs() const;
+
+  // Operations
+  void        makeCurrent();
+  void        reset();
+  void        start();
+  void        record(Replay* replay);
+  void        play(Replay* replay);
+  void        keyEvent(int key, bool pressed);
+  void        update(real start_time);
+  void        step();
+  uint32      advance(real now);
+  uint32      run(uint32 max_steps = 0);
+  void        stop();
+
+  // Static access
+  static World* current();
+  static World* mainWorld();
+
+private:
+  World(const World&);
+  World& operator=(const World&);
+
+  lua_State*  iLuaState;
+  Group*      iRenderGroup;
+  Rect2       iView;
+  int         iTicksPerFrame;
+  bool        iDone;
+  int         iTimerStart;
+
+  int         iMaxCatchUpSteps;
+  real        iSimulationTime;
+  bool        iStepping;
+  uint32      iNoSteps;
+  real        iAccumulator;
+  real        iLastAdvance;
+  real        iInterpolation;
+
+  uint32      iRandomSeed;
+  Random      iRandom;
+  Replay*     iRecording;
+  Replay*     iPlayback;
+  uint32      iPlaybackEvent;
+
+  NarrowPhase iNarrowPhase;
+
+  JobQueue*   iJobs;
+};
@@ -0,0 +1,163 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+
+/*
+  Runs the benchmarks in Benchmark/ and reports nanoseconds per call:
+
+    lusionbench                               Run all benchmarks
+    lusionbench -f Polygon2                   Only those with Polygon2 in name
+    lusionbench -b Benchmark/baseline.json    Compare against baseline
+    lusionbench -o Benchmark/baseline.json    Save results as new baseline
+    lusionbench -n 100000 -c chart.csv        Scenes up to 100k, chart over size
+
+  When comparing, it exits with status 1 if a benchmark is slower than the
+  baseline by more than the tolerance given with -t, 15% by default.
+  Timings only compare between runs on the same machine and build.
+
+  Scene benchmarks run at sizes from 100 up to the size given with -n,
+  10000 by default since the largest scenes take a while to build. The
+  chart written with -c has one row per scene benchmark and size, with
+  throughput in items per second, so scaling can be plotted over size.
+  Scene benchmarks read script/levels, so run from the engine directory.
+*/
+
+#include "Benchmark/Benchmark.h"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+static void usage()
+{
+  cerr << "usage: lusionbench [-f filter] [-b baseline] [-o output] [-t tolerance] [-s seed] [-n max_size] [-c chart]" << endl
+       << "  -f filter     Only run benchmarks with filter in their name" << endl
+       << "  -b baseline   Compare with results in baseline JSON file" << endl
+       << "  -o output     Write results to JSON file" << endl
+       << "  -t tolerance  Percent slower than baseline counted as regression, default 15" << endl
+       << "  -s seed       Seed for random inputs, default 0" << endl
+       << "  -n max_size   Largest scene size to run, default 10000" << endl
+       << "  -c chart      Write scene throughput by size to CSV file" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+  const char* filter = 0;
+  const char* baseline_path = 0;
+  const char* output_path = 0;
+  real tolerance = 15.0;
+  uint32 seed = 0;
+  uint32 max_size = 10000;
+  const char* chart_path = 0;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-f") == 0 && i+1 < argc)
+      filter = argv[++i];
+    else if (strcmp(argv[i], "-b") == 0 && i+1 < argc)
+      baseline_path = argv[++i];
+    else if (strcmp(argv[i], "-o") == 0 && i+1 < argc)
+      output_path = argv[++i];
+    else if (strcmp(argv[i], "-t") == 0 && i+1 < argc)
+      tolerance = atof(argv[++i]);
+    else if (strcmp(argv[i], "-s") == 0 && i+1 < argc)
+      seed = strtoul(argv[++i], 0, 10);
+    else if (strcmp(argv[i], "-n") == 0 && i+1 < argc)
+      max_size = strtoul(argv[++i], 0, 10);
+    else if (strcmp(argv[i], "-c") == 0 && i+1 < argc)
+      chart_path = argv[++i];
+    else {
+      usage();
+      return 1;
+    }
+  }
+
+  BenchmarkResults baseline;
+  if (baseline_path && !loadBenchmarkResults(baseline_path, baseline)) {
+    cerr << "Error could not read baseline " << baseline_path << endl;
+    return 1;
+  }
+
+  ofstream chart;
+  if (chart_path) {
+    chart.open(chart_path);
+    if (!chart) {
+      cerr << "Error could not write chart " << chart_path << endl;
+      return 1;
+    }
+    chart << "benchmark,size,ns/op,items/s" << endl << fixed;
+  }
+
+  cout << left << setw(44) << "benchmark" << right << setw(12) << "ns/op";
+  if (baseline_path)
+    cout << setw(12) << "baseline" << setw(10) << "change";
+  cout << endl << fixed;
+
+  BenchmarkResults results;
+  int noRegressions = 0;
+  Benchmarks& benchmarks = Benchmark::all();
+  for (Benchmarks::iterator it = benchmarks.begin(); it != benchmarks.end(); ++it) {
+    Benchmark* benchmark = *it;
+    if (filter && strstr(benchmark->name(), filter) == 0)
+      continue;
+    if (benchmark->size() > max_size)
+      continue;
+
+    // Large scenes take long per call, so fewer samples
+    Random random(seed);
+    benchmark->setUp(random);
+    real ns = benchmark->measure(0.1, benchmark->size() > 0 ? 3 : 7);
+    uint32 noItems = benchmark->itemsPerCall();
+    benchmark->tearDown();
+    results[benchmark->name()] = ns;
+
+    if (chart_path && benchmark->size() > 0) {
+      string name = benchmark->name();
+      chart << name.substr(0, name.rfind('/')) << "," << benchmark->size() << ","
+            << setprecision(2) << ns << "," << setprecision(0) << noItems*1e9/ns << endl;
+    }
+
+    cout << left << setw(44) << benchmark->name() << right
+         << setprecision(2) << setw(12) << ns;
+    BenchmarkResults::iterator base = baseline.find(benchmark->name());
+    if (base != baseline.end() && base->second > 0.0) {
+      real change = 100.0*(ns/base->second - 1.0);
+      cout << setw(12) << base->second << setprecision(1) << setw(9) << showpos << change << noshowpos << "%";
+      if (change > tolerance) {
+        cout << "  REGRESSION";
+        ++noRegressions;
+      }
+    }
+    cout << endl;
+  }
+
+  if (output_path && !saveBenchmarkResults(output_path, results)) {
+    cerr << "Error could not write results " << output_path << endl;
+    return 1;
+  }
+  if (noRegressions > 0) {
+    cout << noRegressions << " benchmarks slower than baseline by more than "
+         << setprecision(0) << tolerance << "%" << endl;
+    return 1;
+  }
+  return 0;
+}
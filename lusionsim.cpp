@@ -0,0 +1,172 @@
+/*
+	LusionEngine- 2D game engine written in C++ with Lua interface.
+	Copyright (C) 2006  Erik Engheim
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License along
+	with this program; if not, write to the Free Software Foundation, Inc.,
+	51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+/*
+  Command line driver for headless simulations. Loads the engine scripts
+  and a game script, then steps the world as fast as possible without
+  rendering and reports how long it took:
+
+    lusionsim -n 10000 script/game.lua
+
+  A session recorded with 'LusionEngine -record session.lrp' is played back
+  as fast as possible with:
+
+    lusionsim -p session.lrp
+
+  With -P the time spent in each profiler zone is reported as well, and
+  written as a Chrome trace to the given file.
+
+  Must be run from the directory containing script/, like the GUI.
+*/
+
+#include "World.h"
+#include "Timing.h"
+#include "Replay.h"
+
+#include "Lua/LuaEngine.h"
+#include "Utils/Profiler.h"
+
+#include <Core/AutoreleasePool.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+static void usage()
+{
+  cerr << "usage: lusionsim [-n steps] [-t ticks_per_frame] [-s seed] [-r file | -p file] [-P trace] [game_script]" << endl
+       << "  -n steps            Number of steps to simulate, default 1000. 0 runs until done" << endl
+       << "  -t ticks_per_frame  Milliseconds simulated per step, default set by scripts" << endl
+       << "  -s seed             Seed for math.random, default 0" << endl
+       << "  -r file             Record replay of simulation to file" << endl
+       << "  -p file             Play back replay in file until it ends" << endl
+       << "  -P trace            Profile zones and write Chrome trace to file" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+  uint32 max_steps = 1000;
+  int    ticks_per_frame = 0;
+  uint32 seed = 0;
+  const char* record_path = 0;
+  const char* play_path = 0;
+  const char* trace_path = 0;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-n") == 0 && i+1 < argc)
+      max_steps = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-t") == 0 && i+1 < argc)
+      ticks_per_frame = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-s") == 0 && i+1 < argc)
+      seed = strtoul(argv[++i], 0, 10);
+    else if (strcmp(argv[i], "-r") == 0 && i+1 < argc)
+      record_path = argv[++i];
+    else if (strcmp(argv[i], "-p") == 0 && i+1 < argc)
+      play_path = argv[++i];
+    else if (strcmp(argv[i], "-P") == 0 && i+1 < argc)
+      trace_path = argv[++i];
+    else if (argv[i][0] == '-') {
+      usage();
+      return 1;
+    }
+    else
+      setGameScript(argv[i]);
+  }
+
+  AutoreleasePool::begin();
+  World* world = World::mainWorld();
+  world->setRandomSeed(seed);
+
+  Replay* recording = 0;
+  if (record_path) {
+    recording = new Replay;
+    world->record(recording);
+  }
+  if (play_path) {
+    Replay* replay = Replay::load(play_path);
+    if (replay == 0) {
+      cerr << "Error could not load replay " << play_path << endl;
+      return 1;
+    }
+    world->play(replay);
+    replay->release();
+    if (ticks_per_frame > 0)
+      cerr << "Ignoring -t, replay decides step length" << endl;
+    max_steps = 0;  // Run until replay ends
+  }
+
+  real load_start = monotonicSeconds();
+  world->start();
+  real load_time = monotonicSeconds()-load_start;
+  if (ticks_per_frame > 0)
+    world->setTicksPerFrame(ticks_per_frame);
+
+  // Leave out loading from profile
+  if (trace_path) {
+    setProfilingEnabled(true);
+    profileReset();
+  }
+
+  // Step one at a time to find the slowest step
+  uint32 steps = 0;
+  real min_step = 0.0, max_step = 0.0;
+  real run_start = monotonicSeconds();
+  while (!world->isDone() && (max_steps == 0 || steps < max_steps)) {
+    real step_start = monotonicSeconds();
+    world->step();
+    real step_time = monotonicSeconds()-step_start;
+    min_step = steps == 0 ? step_time : min(min_step, step_time);
+    max_step = max(max_step, step_time);
+    ++steps;
+  }
+  real run_time = monotonicSeconds()-run_start;
+
+  world->stop();
+  AutoreleasePool::end();
+
+  if (recording) {
+    if (!recording->save(record_path))
+      cerr << "Error could not save replay " << record_path << endl;
+    world->record(0);
+    recording->release();
+  }
+
+  real mean_step = steps > 0 ? run_time/steps : 0.0;
+  cout << dec << fixed << setprecision(3)
+       << "load:       " << load_time*1000.0 << " ms" << endl
+       << "steps:      " << steps << endl
+       << "total:      " << run_time*1000.0 << " ms" << endl
+       << "per step:   " << mean_step*1000.0 << " ms mean, "
+                         << min_step*1000.0 << " ms min, "
+                         << max_step*1000.0 << " ms max" << endl
+       << "steps/s:    " << (run_time > 0.0 ? steps/run_time : 0.0) << endl
+       << "simulated:  " << world->simulationTime() << " s, "
+                         << (run_time > 0.0 ? world->simulationTime()/run_time : 0.0) << "x real time" << endl;
+
+  if (trace_path) {
+    cout << endl << profileReport();
+    if (!saveChromeTrace(trace_path))
+      cerr << "Error could not save trace " << trace_path << endl;
+  }
+  return 0;
+}
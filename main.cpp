@@ -18,6 +18,8 @@
 */
 
 #include "Engine.h"
+#include "World.h"
+#include "Replay.h"
 
 #include <QtGui/QApplication>
 
@@ -25,10 +27,36 @@
 
 #include <Core/AutoreleasePool.hpp>
 
+#include <iostream>
+#include <cstring>
+
+using namespace std;
+
 int main(int argc, char *argv[])
 {  
   AutoreleasePool::begin();
     QApplication a(argc, argv);
+
+    // -record file saves the session as a replay, -play file plays one back
+    Replay* recording = 0;
+    const char* record_path = 0;
+    for (int i = 1; i+1 < argc; ++i) {
+      if (strcmp(argv[i], "-record") == 0) {
+        record_path = argv[++i];
+        if (recording)
+          recording->release();
+        recording = new Replay;
+        World::mainWorld()->record(recording);
+      }
+      else if (strcmp(argv[i], "-play") == 0) {
+        Replay* replay = Replay::load(argv[++i]);
+        if (replay == 0)
+          cerr << "Error could not load replay " << argv[i] << endl;
+        World::mainWorld()->play(replay);
+        if (replay)
+          replay->release();
+      }
+    }
   
     QWidget* w = new MainForm;
     w->resize(640, 480);
@@ -37,6 +65,13 @@ int main(int argc, char *argv[])
     
     int result = a.exec();
     delete w;
+
+    if (recording) {
+      if (!recording->save(record_path))
+        cerr << "Error could not save replay " << record_path << endl;
+      World::mainWorld()->record(0);
+      recording->release();
+    }
   AutoreleasePool::end();
           
   return result;
@@ -9,8 +9,14 @@ require("script/keyboard")
 require("script/table")
 require("script/functional")
 
+-- Running on LuaJIT. Bind engine C API for use in hot loops
+if jit then
+  require("script/ffi")
+end
+
+-- Steps are whole milliseconds, so rates above 1000 run at 1000
 function Engine.setFrameRate(rate)
-  Engine.setTicksPerFrame(1000/rate)
+  Engine.setTicksPerFrame(math.max(1, math.floor(1000/rate)))
 end
 
 function Engine.handleEvents()
@@ -54,6 +60,29 @@ function ShapeGroup:new(group)
   return Shape:newShapeGroup(group)
 end
 
+--[[
+	LevelFile class
+	-------------------------
+	
+	Extra methods for binary levels.
+--]]
+
+--[[
+  Creates a sprite for each obstacle in level and groups them in the
+  bounding volume hierarchy stored in the level file.
+]]--
+function LevelFile:obstacles()
+  local sprites = {}
+  for i=1,self:noObstacles() do
+    local view = PolygonView:new(self:polygon(i))
+    view:setColor(self:color(i))
+    local obstacle = Sprite:new(view)
+    obstacle:setPosition(0, 0)
+    sprites[i] = obstacle
+  end
+  return Shape:newShapeGroup(self, sprites)
+end
+
 --[[
 	Sprite class
 	-------------------------
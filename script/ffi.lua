@@ -0,0 +1,59 @@
+--[[
+  Created by Erik Engheim on 20/03/2009
+  Copyright 2009 Translusion. All rights reserved.
+
+  Binds the C API in LusionAPI.h through LuaJIT's FFI. Only loaded when the
+  engine is built with CONFIG+=luajit. Calls through FFI are compiled by the
+  JIT, avoiding the Lua C API glue for scripts with hot loops:
+
+    local C, npc = FFI.C, FFI.sprite(currentNPC())
+    for i = 1,n do
+      local p = C.lusionSpritePosition(npc)
+      ...
+    end
+]]--
+
+local ffi = require("ffi")
+
+-- Declarations are read straight from the header so they can not go out of sync
+local file = assert(io.open("LusionAPI.h"))
+local header = file:read("*a")
+file:close()
+ffi.cdef(assert(header:match("// FFI BEGIN(.-)// FFI END")))
+
+FFI = {}
+FFI.C = ffi.C
+
+-- Handles for engine objects wrapped by Lua objects
+function FFI.shape(obj)
+  return ffi.cast("LusionShape*", Engine.handle(obj))
+end
+
+function FFI.sprite(obj)
+  return ffi.cast("LusionSprite*", Engine.handle(obj))
+end
+
+function FFI.group(obj)
+  return ffi.cast("LusionGroup*", Engine.handle(obj))
+end
+
+function FFI.motionState(obj)
+  return ffi.cast("LusionMotionState*", Engine.handle(obj))
+end
+
+function FFI.contacts(obj)
+  return ffi.cast("LusionContactBuffer*", Engine.handle(obj))
+end
+
+-- Point buffers are passed to FFI as the Points2 they hold
+function FFI.points(buffer)
+  return ffi.cast("LusionPoints*", buffer)
+end
+
+function FFI.vec(x, y)
+  return ffi.new("LusionVector2", x, y)
+end
+
+function FFI.rect(xmin, ymin, xmax, ymax)
+  return ffi.new("LusionRect2", {{xmin, ymin}, {xmax, ymax}})
+end
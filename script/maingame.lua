@@ -148,7 +148,7 @@ function update(start_time)
   actors:update(start_time, delta_time)
   Engine.lookAt(currentNPC():position())
   -- drawTrailingLine()
-  actors:doPlanning(start_time, delta_time)
+  planner:run(start_time)
   -- actors:collide(obstacles, start_time, delta_time, function(self, other, t, dt) print("collision!") end)
   actors:collide(obstacles, start_time, delta_time)
   -- if obstacles:collide(currentNPC(), start_time, Engine.secondsPerFrame()) then print("collision") end
@@ -163,11 +163,7 @@ function setupRRTSearch()
   local t = dt*steps
   local s0 = MotionState:new(pos, dir, speed)
 
-  local trajectories = Geometry.createTrajectories(s0, -300, 300, 2, dt, steps)  
-
-  local sprite_state = Sprite:new()
-  sprite_state:setVisible(false)
-  sprite_state:setName("sprite state")
+  local trajectories = Geometry.createTrajectoryTable(s0, -300, 300, 2, dt, steps, "trajectories.cache")  
   
   -- Generate a path to other NPC when p is clicked
   Engine.registerKeyClickEvent(Key.p, function()
@@ -178,35 +174,24 @@ function setupRRTSearch()
     local start_time = Engine.seconds()
     local delta_time = 0.1
 
-    sprite_state:setView(npc:view())
-    
-    function avoidCollision(s0, s1)
-      sprite_state:setMotionState(s1)
-      if sprite_state:collide(obstacles, start_time, delta_time) then
-        return -1
-      end
-      return 0
-    end
-    
-    local flank = Geometry.makeFlank(otherNPC(), 10)
-    local seek = Geometry.makeSeek(otherNPC():position())
-    -- local combo = Geometry.combineBehavior({1,flank})
-    -- local combo = Geometry.combineBehavior({1,flank}, {0.001,seek})
-    local combo = Geometry.combineBehavior({0.001,seek}, {1,flank}, {1,avoidCollision})
+    local planner = TrajectoryPlanner:new(trajectories, npc:view(), obstacles)
+    -- planner:setScore{flank = {1, otherNPC(), 10}}
+    -- planner:setScore{seek = {0.001, otherNPC():position()}, flank = {1, otherNPC(), 10}}
+    planner:setScore{seek = {0.001, otherNPC():position()}, flank = {1, otherNPC(), 10}, avoid = {1}}
+    planner:setDiscount(0.5)
+    planner:setOptimism(0)
     
-    local eval = Geometry.makeEval(combo, 0.5, 0)
-    -- Create a comparator that will return true if eval(a) > eval(b)
-    local larger = makeBinary(eval, greaterThan)
-    local states = Geometry.rrtSearch(s0, trajectories, larger, 20, start_time, delta_time)
+    local states = Geometry.plannerStates(planner, s0, 20, start_time, delta_time)
 
     if state_paths then state_paths:setVisible(false) end
-    state_paths = Geometry.showStatePaths(states, dt, steps)   
+    state_paths = Geometry.showStatePaths(Geometry.plannerVisited(planner), dt, steps)   
     state_paths:view():setColor(0,0,1)
     
-    states = Geometry.bestPath(s0, states, eval)    
     if best_path then best_path:setVisible(false) end
-    best_path = Geometry.showStatePaths(states, dt, steps)   
-    best_path:view():setColor(1,0,0)
+    if states then
+      best_path = Geometry.showStatePaths(states, dt, steps)   
+      best_path:view():setColor(1,0,0)
+    end
   end) 
 end
 
@@ -230,9 +215,9 @@ function setupSeek()
   s0:setPosition(pos)
   
   
-  local trajectories = Geometry.createTrajectories(s0, angvel_min, angvel_max, angvel_steps, dt, steps)  
+  local trajectories = Geometry.createTrajectoryTable(s0, angvel_min, angvel_max, angvel_steps, dt, steps, "trajectories.cache")  
   
-  -- local trajectories = Geometry.createTrajectories(s0, -400, 400, 10, dt, steps)  
+  -- local trajectories = Geometry.createTrajectoryTable(s0, -400, 400, 10, dt, steps)  
 
   path_sprite = Sprite:new(PathView:new())
   path_sprite:view():setPolygon({vec(0,0), vec(1,0), vec(1,1)})
@@ -243,10 +228,9 @@ function setupSeek()
   npc.nextState = npc:motionState():copy()
   -- npc.nextState:integrate(dt, steps)
   
-  local sprite_state = Sprite:new()
-  sprite_state:setVisible(false)
-  sprite_state:setName("sprite state")
-  sprite_state:setView(npc:view())
+  local planner = TrajectoryPlanner:new(trajectories, npc:view(), obstacles)
+  planner:setDiscount(0.5)
+  planner:setOptimism(0)
   
   npc:setUpdateHandler(function(self, start_time, dt)  
     self.currentStep = self.currentStep+1
@@ -268,27 +252,13 @@ function setupSeek()
   
   
   npc:setPlanningHandler(function(self, start_time, dt)
-    -- Return low value for collision paths
-    function avoidCollision(s0, s1)
-      sprite_state:setMotionState(s1)
-      if sprite_state:collide(obstacles, start_time, dt) then
-        return -1
-      end
-      return 0
-    end
-
-    local flank = Geometry.makeFlank(currentNPC(), 12)
-    local seek = Geometry.makeSeek(currentNPC():position())
-    -- local combo = Geometry.combineBehavior({1,flank}, {0.001,seek})
-    -- local combo = Geometry.combineBehavior({1,seek})
-    -- local combo = Geometry.combineBehavior({0.1,seek}, {1,avoidCollision})    
-    local combo = Geometry.combineBehavior({0.001,seek}, {1,flank}, {1,avoidCollision})
-    
-    local eval = Geometry.makeEval(combo, 0.5, 0)
-    -- Create a comparator that will return true if eval(a) > eval(b)
-    local larger = makeBinary(eval, greaterThan)
+    -- Native goodness functions. 'avoid' returns low value for collision paths
+    -- planner:setScore{flank = {1, currentNPC(), 12}, seek = {0.001, currentNPC():position()}}
+    -- planner:setScore{seek = {1, currentNPC():position()}}
+    -- planner:setScore{seek = {0.1, currentNPC():position()}, avoid = {1}}
+    planner:setScore{seek = {0.001, currentNPC():position()}, flank = {1, currentNPC(), 12}, avoid = {1}}
 
-    local states = Geometry.rrtStates(self.nextState, trajectories, larger, 15, start_time, dt)
+    local states = Geometry.plannerStates(planner, self.nextState, 15, start_time, dt)
     if states then 
       self.statePath = states
       local path = Geometry.statesToPath(states, dt, steps) 
@@ -411,8 +381,14 @@ end
 
 function setupWorld()
   --obstacles = createRandomObstacles(10):toGroup()
-  obstacle_collection = dofile("script/levels/level2.lua") -- loads sprites from level file
-  obstacles = ShapeGroup:new(obstacle_collection:toGroup())
+  -- Binary level exported with 'x' loads without rebuilding obstacle hierarchy
+  level = LevelFile:load("script/levels/level2.lvl")
+  if level then
+    obstacles = level:obstacles()
+  else
+    obstacle_collection = dofile("script/levels/level2.lua") -- loads sprites from level file
+    obstacles = ShapeGroup:new(obstacle_collection:toGroup())
+  end
   
   actors = Group:new()
 
@@ -423,6 +399,10 @@ function setupWorld()
   npcs[2] = actors:addNPC(view)  
   npcs[2]:setSpeed(0.5)
 
+  -- Plan for NPCs in the time left of each frame
+  planner = PlanningScheduler:new()
+  for _,npc in ipairs(npcs) do planner:add(npc) end
+
   selectedNPC = 2
   -- trailingLine = Sprite:new()
   -- trailingLine:setView(SegmentView:new())
@@ -451,11 +431,21 @@ end
 function setupRoadMap()
   roadmap = ProbablisticRoadMap:new(obstacles, obstacles:boundingBox())
   -- roadmap = ProbablisticRoadMap:new(obstacles, Engine.view())
+  if level then
+    roadmap:fromArrays(level:roadmap())
+  end
 
+  -- Built on a worker thread, so the game keeps running meanwhile
   Engine.registerKeyClickEvent(Key.k, function()
-    roadmap:construct(25*25, 1)
-    roadmap:displayRoadMap()    
-    print("roadmap constructed")    
+    if roadmap_job and not roadmap_job:isPublished() then
+      print("roadmap", math.floor(roadmap_job:progress()*100).."% done")
+      return
+    end
+    roadmap_job = Job:buildRoadmap(obstacles, obstacles:boundingBox(), 25*25, 1, function(node_data, neighbors)
+      roadmap:fromArrays(node_data, neighbors)
+      roadmap:displayRoadMap()
+      print("roadmap constructed")
+    end)
   end)
 
   -- Visualize contained circle somehow when c is hit
@@ -479,11 +469,16 @@ function setupRoadMap()
   
   -- Load roadmap
   Engine.registerKeyClickEvent(Key.l, function()
-    roadmap = ProbablisticRoadMap:new(obstacles, Engine.view())
-    roadmap:load('script/RoadMaps/roadmap1.lua')
-    print("roadmap loaded")
-    roadmap:displayRoadMap()    
-        
+    Job:loadLevel('script/levels/level2.lvl', function(level)
+      roadmap = ProbablisticRoadMap:new(obstacles, Engine.view())
+      if level then
+        roadmap:fromArrays(level:roadmap())
+      else
+        roadmap:load('script/RoadMaps/roadmap1.lua')
+      end
+      print("roadmap loaded")
+      roadmap:displayRoadMap()
+    end)
   end)
   
   -- Store current roadmap to file 
@@ -491,6 +486,13 @@ function setupRoadMap()
     roadmap:save('script/RoadMaps/roadmap3.lua')
     print("roadmap saved")
   end)
+
+  -- Export obstacles and current roadmap as binary level
+  Engine.registerKeyClickEvent(Key.x, function()    
+    if LevelFile:save('script/levels/level2.lvl', obstacles, roadmap:toArrays()) then
+      print("level exported")
+    end
+  end)
   
   -- For debugging bad point
   Engine.registerKeyClickEvent(Key.g, function()    
@@ -76,7 +76,7 @@ end
 
 function Map:toString()
   local strings = self:map(function(e)    
-    if type(e) == "table" and e.toString then 
+    if (type(e) == "table" or type(e) == "userdata") and e.toString then 
       return e:toString() 
     elseif type(e) == "string" then
       return "\""..e.."\""
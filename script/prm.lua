@@ -307,6 +307,46 @@ function ProbablisticRoadMap:load(filename)
   self:makeNodeSearchStructure()  
 end
 
+--[[
+  Returns roadmap as 'node_data, neighbors' where node_data[i] is
+  {position, radius} of i'th node and neighbors[i] the indices of
+  nodes connected to it. This is what LevelFile:save() takes.
+]]--
+function ProbablisticRoadMap:toArrays()
+  local node_data = {}
+  local neighbors = {}
+  local node_mapping = {}
+  for i, n in ipairs(self.nodes) do
+    node_data[i] = {n:position(), n:radius()}
+    node_mapping[tableToNumber(n)] = i
+  end
+  for i, n in ipairs(self.nodes) do
+    neighbors[i] = {}
+    for _, m in pairs(n:neighbors()) do
+      table.insert(neighbors[i], node_mapping[tableToNumber(m)])
+    end
+  end
+  return node_data, neighbors
+end
+
+--[[
+  Replace roadmap with one given as returned by toArrays(), e.g. from
+  LevelFile:roadmap().
+]]--
+function ProbablisticRoadMap:fromArrays(node_data, neighbors)
+  local nodes = Collection:new()
+  for _, n in ipairs(node_data) do
+    nodes:append(PrmNode:newNode(n[1], n[2]))
+  end
+  for i, indices in ipairs(neighbors) do
+    for _, j in ipairs(indices) do
+      nodes[i]:insertNeighbors(nodes[j])
+    end
+  end
+  self.nodes = nodes
+  self:makeNodeSearchStructure()  
+end
+
 --[[
   Can be removed later. Only used for displaying roadmap.
 ]]--
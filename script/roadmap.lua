@@ -58,8 +58,29 @@ function RoadMap:init(sprites, boundingbox)
 
   local noTrapezoids = self.map:assignUniqueTags()
   
-  local edges = last_t:edgeData(noTrapezoids)
-  self.graph = Graph:new(noTrapezoids, edges)
+  self.edges = last_t:edgeData(noTrapezoids)
+  self.graph = Graph:new(noTrapezoids, self.edges)
+end
+
+-- Roadmap saved with save(), or nil. Nothing is computed, so it is much faster than new()
+function RoadMap:load(path)
+  local map, edges = TrapezoidalMap:load(path)
+  if not map then
+    return nil
+  end
+
+  local roadmap = {}
+  setmetatable(roadmap, self)
+  self.__index = self
+
+  roadmap.map = map
+  roadmap.edges = edges
+  roadmap.graph = Graph:new(#map:trapezoids(), edges)
+  return roadmap
+end
+
+function RoadMap:save(path)
+  return self.map:save(path, self.edges)
 end
 
 function RoadMap:locate(point)
@@ -82,8 +103,24 @@ function RoadMap:shortestPath(source, target)
   -- return self.graph:shortestPath(source, target)
 end
 
+-- Shortest paths from all trapezoids to target. Paths are
+-- shared between all callers with same target
 function RoadMap:shortestPaths(target)
-  return self.graph:shortestPaths(target)
+  return self.graph:cachedShortestPaths(target)
+end
+
+-- Next point to move towards to reach target from position, nil if
+-- target can't be reached
+function RoadMap:nextWaypoint(position, target)
+  local paths = self:shortestPaths(self.map:locate(target))
+  local waypoint, more = paths:nextFrom(self.map:locate(position))
+  if not waypoint then
+    return nil
+  end
+  if not more then
+    return target
+  end
+  return waypoint
 end
 
 function RoadMap:printGraph()
@@ -49,6 +49,34 @@ function Geometry.createTrajectories(s0, angvel_min, angvel_max, angvel_steps, d
   return interpolate
 end
 
+--[[
+  Same as Geometry.createTrajectories() but precomputes trajectories in native code.
+  Result is used with TrajectoryPlanner:new(table, view, obstacles), which performs
+  the search done by Geometry.rrtSearch() natively.
+  
+  If 'cache_file' is given, the table is loaded from it when it was made with the 
+  same parameters. Otherwise the table is computed and written to 'cache_file'.
+--]]
+function Geometry.createTrajectoryTable(s0, angvel_min, angvel_max, angvel_steps, dt, steps, cache_file)
+  function matches(t)
+    local eps = 1e-9
+    return t:size() == angvel_steps+1 and t:noSteps() == steps and
+           math.abs(t:minAngularVelocity()-angvel_min) < eps and
+           math.abs(t:maxAngularVelocity()-angvel_max) < eps and
+           math.abs(t:timeStep()-dt) < eps and
+           math.abs(t:speed()-s0:speed()) < eps
+  end
+  
+  if cache_file then
+    local trajectories = TrajectoryTable:load(cache_file)
+    if trajectories and matches(trajectories) then return trajectories end
+  end
+  
+  local trajectories = TrajectoryTable:new(s0, angvel_min, angvel_max, angvel_steps, dt, steps)
+  if cache_file then trajectories:save(cache_file) end
+  return trajectories
+end
+
 --[[ 
   Geometry.combineBehavior({weight_0, function_0}, {weight_1, function_1},...)
 
@@ -143,6 +171,9 @@ function Geometry.makeEval(goodness, discount, optimism)
   return eval
 end
 
+-- States expanded per search while recording or playing back a replay
+Geometry.rrtMaxExpansions = 64
+
 --[[
   Uses rapidly expanding random trees to find a path to a goal.
   's_0' is start state for search.
@@ -176,8 +207,17 @@ function Geometry.rrtSearch(s_0, trajectories, eval, max_depth, start_time, delt
   s_0.depth = 0
   s_0.value = 0
 
-  -- Actual algorithm, a sort of A* search
-  while Engine.seconds() < start_time+delta_time and not candidates:empty() do
+  -- Actual algorithm, a sort of A* search. Engine.seconds() stands still
+  -- during a step, so the time limit is measured on the monotonic clock.
+  -- Replays must repeat whatever the machine, so they count expansions
+  local deadline = Engine.monotonicSeconds()+delta_time
+  local function hasTime()
+    if Engine.isDeterministic() then
+      return expanded:size() < Geometry.rrtMaxExpansions
+    end
+    return Engine.monotonicSeconds() < deadline
+  end
+  while hasTime() and not candidates:empty() do
     local s_m = candidates:removeMax(eval)
     local succ = nil
     if s_m.depth < max_depth then
@@ -272,4 +312,33 @@ function Geometry.localStatesToPath(states)
   end
   
   return path
-end
\ No newline at end of file
+end
+
+--[[
+  Native version of Geometry.rrtStates(). Returns queue of states leading
+  from 's_0' to best state found by 'planner' or nil if none was found.
+--]]
+function Geometry.plannerStates(planner, s_0, max_depth, start_time, delta_time)
+  local path = planner:plan(s_0, max_depth, start_time, delta_time)
+  if not path then return nil end
+  local states = Queue:new()
+  local parent = s_0
+  for _,s in ipairs(path) do
+    s.parent = parent
+    states:append(s)
+    parent = s
+  end
+  return states
+end
+
+--[[
+  Returns all states visited by last search of 'planner' with the 'parent' 
+  field of each state referring to its parent state.
+--]]
+function Geometry.plannerVisited(planner)
+  local states = planner:visited()
+  for _,s in ipairs(states) do
+    if s.parent then s.parent = states[s.parent] end
+  end
+  return states
+end